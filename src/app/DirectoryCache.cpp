@@ -0,0 +1,144 @@
+#include <QCoreApplication>
+#include "DirectoryCache.h"
+#include "DirectoryWatcher.h"
+#include "Trace.h"
+
+#include <limits>
+
+DirectoryCache *DirectoryCache::instance()
+{
+    static DirectoryCache *cache = new DirectoryCache(QCoreApplication::instance());
+    return cache;
+}
+
+DirectoryCache::DirectoryCache(QObject *parent)
+    : QObject(parent)
+{
+    connect(DirectoryWatcher::instance(), &DirectoryWatcher::directoryTouched,
+            this, &DirectoryCache::onDirectoryTouched);
+}
+
+bool DirectoryCache::isEnabled() const
+{
+    return DirectoryWatcher::instance()->isEnabled();
+}
+
+bool DirectoryCache::acquire(const QString &path, DirectoryListing &out, quint64 &token,
+                             bool allowCached)
+{
+    token = 0;
+    if (!isEnabled())
+        return false;
+
+    Entry &e = m_entries[path];
+    e.lastUse = ++m_tick;
+    ++e.users;
+
+    if (!e.watched) {
+        // ссылка на watch берётся и при неудаче — снимается в removeEntry
+        DirectoryWatcher::instance()->watch(path);
+        e.watched = true;
+    }
+    if (!DirectoryWatcher::instance()->isWatched(path))
+        dropListing(e);
+
+    token = e.changes;
+
+    if (!allowCached || !e.hasListing)
+        return false;
+
+    BELKIN_TRACE_SCOPE("cache.hit");
+    out = e.listing;
+    return true;
+}
+
+void DirectoryCache::release(const QString &path, const DirectoryListing *listing, quint64 token)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end())
+        return;
+
+    Entry &e = *it;
+    e.users = qMax(0, e.users - 1);
+    e.lastUse = ++m_tick;
+
+    // листинг годится, только если watch стоял всё время чтения и показа
+    if (listing && e.changes == token && DirectoryWatcher::instance()->isWatched(path)) {
+        dropListing(e);
+        e.listing = *listing;
+        e.bytes = e.listing.memoryUsage();
+        e.hasListing = true;
+        m_usage += e.bytes;
+    }
+
+    if (e.users == 0 && !e.hasListing)
+        removeEntry(path);
+
+    evict();
+}
+
+quint64 DirectoryCache::token(const QString &path) const
+{
+    auto it = m_entries.constFind(path);
+    return it == m_entries.cend() ? 0 : it->changes;
+}
+
+void DirectoryCache::setBudget(qint64 bytes)
+{
+    m_budget = qMax<qint64>(0, bytes);
+    evict();
+}
+
+void DirectoryCache::dropListing(Entry &e)
+{
+    if (!e.hasListing)
+        return;
+    m_usage -= e.bytes;
+    e.listing = DirectoryListing();
+    e.bytes = 0;
+    e.hasListing = false;
+}
+
+void DirectoryCache::removeEntry(const QString &path)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end())
+        return;
+
+    dropListing(*it);
+    if (it->watched)
+        DirectoryWatcher::instance()->unwatch(path);
+    m_entries.erase(it);
+}
+
+void DirectoryCache::evict()
+{
+    // вытесняем самые давние неиспользуемые листинги, пока не влезем в бюджет
+    while (m_usage > m_budget) {
+        QString victim;
+        quint64 oldest = std::numeric_limits<quint64>::max();
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            if (it->hasListing && it->users == 0 && it->lastUse < oldest) {
+                oldest = it->lastUse;
+                victim = it.key();
+            }
+        }
+        if (victim.isEmpty())
+            break;   // всё, что осталось, сейчас на экране
+        removeEntry(victim);
+    }
+}
+
+void DirectoryCache::onDirectoryTouched(const QString &path)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end())
+        return;
+
+    ++it->changes;
+    dropListing(*it);
+
+    // никто не показывает — незачем держать ни запись, ни watch
+    if (it->users == 0)
+        removeEntry(path);
+}
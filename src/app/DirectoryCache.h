@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include "DirectoryListing.h"
+
+// Общий для обеих панелей LRU-кэш листингов каталогов.
+// Актуальность держится на DirectoryWatcher (inotify): каталог ставится
+// на watch до чтения, любое событие в нём сбрасывает закэшированный
+// листинг. Без inotify (не Linux) кэш выключен — отдавать непроверяемые
+// данные нельзя. Объём ограничен бюджетом в байтах
+// (DirectoryListing::memoryUsage), а не числом каталогов.
+// Используется только из GUI-потока.
+class DirectoryCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DirectoryCache *instance();
+
+    // Панель начинает показывать каталог. Ставит watch; если в кэше есть
+    // актуальный листинг — копирует его в out и возвращает true.
+    // token нужно вернуть в release().
+    bool acquire(const QString &path, DirectoryListing &out, quint64 &token,
+                 bool allowCached = true);
+
+    // Панель ушла из каталога. Полный листинг сохраняется в кэш, только если
+    // с момента acquire() (или token()) в каталоге не было событий;
+    // nullptr — не сохранять.
+    void release(const QString &path, const DirectoryListing *listing, quint64 token);
+
+    // текущий счётчик событий каталога: панель, применившая все изменения
+    // из DirectoryWatcher::directoryChanged, может обновить свой token
+    quint64 token(const QString &path) const;
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_budget; }
+    qint64 usage() const { return m_usage; }
+
+    bool isEnabled() const;
+
+private slots:
+    void onDirectoryTouched(const QString &path);
+
+private:
+    explicit DirectoryCache(QObject *parent = nullptr);
+
+    struct Entry {
+        bool watched = false;
+        int users = 0;              // сколько панелей показывают каталог
+        quint64 changes = 0;        // счётчик событий inotify
+        quint64 lastUse = 0;
+        bool hasListing = false;
+        DirectoryListing listing;
+        qint64 bytes = 0;
+    };
+
+    void dropListing(Entry &e);
+    void removeEntry(const QString &path);
+    void evict();
+
+    QHash<QString, Entry> m_entries;
+
+    qint64  m_budget = 64ll * 1024 * 1024;
+    qint64  m_usage = 0;
+    quint64 m_tick = 0;
+};
@@ -0,0 +1,107 @@
+#include <QElapsedTimer>
+#include <algorithm>
+#include "DirectoryLoader.h"
+#include "MetadataFetcher.h"
+#include "Trace.h"
+
+namespace {
+
+constexpr int FirstBatchEntries = 256;      // хватает на первый экран
+constexpr int MaxBatchEntries   = 16384;
+// пачку, которую копили дольше, отдаём сразу — медленная ФС не держит экран пустым
+constexpr qint64 MaxBatchDelayMs = 30;
+
+} // namespace
+
+DirectoryLoader::DirectoryLoader(std::shared_ptr<const std::atomic<quint64>> generation,
+                                 QObject *parent)
+    : QObject(parent)
+    , m_generation(std::move(generation))
+{
+}
+
+void DirectoryLoader::load(quint64 generation, const QString &path, bool includeHidden)
+{
+    // в очереди могли скопиться устаревшие запросы — их просто пропускаем
+    if (cancelled(generation))
+        return;
+
+    BELKIN_TRACE_SCOPE("loader.load");
+
+    DirectoryReader reader(path, includeHidden);
+    if (!reader.isOpen()) {
+        emit finished(generation, false);
+        return;
+    }
+
+    int batchSize = FirstBatchEntries;
+    bool more = true;
+
+    while (more) {
+        DirectoryListing batch;
+        QElapsedTimer timer;
+        timer.start();
+
+        // добираем пачку мелкими порциями, чтобы вовремя заметить отмену и задержку
+        while (more && batch.count() < batchSize && timer.elapsed() < MaxBatchDelayMs) {
+            more = reader.readBatch(batch, std::min(1024, batchSize - batch.count()));
+            if (cancelled(generation))
+                return;
+        }
+
+        if (batch.count() > 0)
+            emit batchReady(generation, batch);
+
+        batchSize = std::min(batchSize * 4, MaxBatchEntries);
+    }
+
+    emit finished(generation, true);
+}
+
+void DirectoryLoader::loadBranch(quint64 generation, const QString &path)
+{
+    if (cancelled(generation))
+        return;
+
+    BELKIN_TRACE_SCOPE("loader.loadBranch");
+
+    // обход проверяет отмену между каталогами и после каждого getdents64
+    std::atomic<bool> stop{false};
+    const bool ok = BranchWalker::walk(path, [&](BranchWalker::Batch &batch) {
+        if (cancelled(generation)) {
+            stop = true;
+            return;
+        }
+        emit branchBatchReady(generation, std::make_shared<BranchWalker::Batch>(std::move(batch)));
+    }, &stop);
+
+    if (!cancelled(generation))
+        emit finished(generation, ok);
+}
+
+void DirectoryLoader::stat(quint64 generation, QList<EntryStat> entries)
+{
+    BELKIN_TRACE_SCOPE("loader.stat");
+
+    std::vector<QByteArray> paths;
+    paths.reserve(size_t(entries.size()));
+    for (const EntryStat &e : entries)
+        paths.push_back(e.path);
+
+    // отмена — между окнами запросов
+    std::atomic<bool> stop{false};
+    MetadataFetcher fetcher(MetadataFetcher::Mode | MetadataFetcher::Size | MetadataFetcher::MTime,
+                            MetadataFetcher::Links::FollowOrSelf);
+    fetcher.fetch(paths, [&](const MetadataFetcher::Result &r) {
+        EntryStat &e = entries[r.index];
+        e.ok = r.ok();
+        e.size = r.isDir() ? 0 : r.size;
+        e.mtime = r.mtime;
+        e.mode = r.mode;
+        if (cancelled(generation))
+            stop = true;
+    }, &stop);
+    if (cancelled(generation))
+        return;
+    emit statReady(generation, entries);
+}
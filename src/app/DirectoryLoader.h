@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include "DirectoryListing.h"
+#include "BranchWalker.h"
+
+// stat одной записи листинга, сделанный в IoPool
+struct EntryStat {
+    int        entry = -1;
+    QByteArray path;          // в кодировке ФС (DirectoryListing::encodedFilePath)
+    bool       ok = false;
+    qint64     size = -1;
+    qint64     mtime = 0;
+    quint32    mode = 0;
+};
+
+Q_DECLARE_METATYPE(EntryStat)
+
+// Читает каталог в фоновом потоке и отдаёт записи пачками.
+// Первая пачка маленькая (первый экран), дальше пачки растут.
+// Загрузка отменяется, как только модель сменила поколение (новая навигация):
+// проверка идёт между пачками, т.е. не позже одного getdents64.
+// Методы вызываются прямо из потоков IoPool (сигналы уходят модели
+// очередью); зависший вызов держит только свой поток, а объект и счётчик
+// поколений живут, пока он не вернётся (shared_ptr в задаче).
+class DirectoryLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DirectoryLoader(std::shared_ptr<const std::atomic<quint64>> generation,
+                             QObject *parent = nullptr);
+
+    void load(quint64 generation, const QString &path, bool includeHidden);
+    // все файлы поддерева path (режим «ветка»), параллельным обходом
+    void loadBranch(quint64 generation, const QString &path);
+    // stat пачки записей (видимые строки сетевого каталога)
+    void stat(quint64 generation, QList<EntryStat> entries);
+
+signals:
+    void batchReady(quint64 generation, const DirectoryListing &batch);
+    void branchBatchReady(quint64 generation, const BranchBatchPtr &batch);
+    void finished(quint64 generation, bool ok);
+    void statReady(quint64 generation, const QList<EntryStat> &entries);
+
+private:
+    bool cancelled(quint64 generation) const
+    {
+        return m_generation->load(std::memory_order_relaxed) != generation;
+    }
+
+    std::shared_ptr<const std::atomic<quint64>> m_generation;
+};
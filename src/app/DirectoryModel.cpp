@@ -0,0 +1,896 @@
+#include <QDateTime>
+#include <QDir>
+#include <QFileIconProvider>
+#include <QFileInfo>
+#include <QLocale>
+#include <QMimeData>
+#include <QUrl>
+#include <algorithm>
+#include "DirectoryModel.h"
+#include "DirectorySort.h"
+#include "FolderSizeService.h"
+#include "FileTypeResolver.h"
+#include "ThumbnailService.h"
+#include "Trace.h"
+
+namespace {
+
+// Сравнение имён без учёта регистра ASCII прямо по UTF-8, без декодирования
+int compareNames(QByteArrayView a, QByteArrayView b)
+{
+    const qsizetype n = std::min(a.size(), b.size());
+    for (qsizetype i = 0; i < n; ++i) {
+        uchar ca = uchar(a[i]);
+        uchar cb = uchar(b[i]);
+        if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+        if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+        if (ca != cb)
+            return ca < cb ? -1 : 1;
+    }
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    return a.compare(b);
+}
+
+// меньше — ключи и перестановка считаются сразу в GUI-потоке
+constexpr int AsyncSortThreshold = 5000;
+
+} // namespace
+
+DirectoryModel::DirectoryModel(QObject *parent)
+    : PanelModel(parent)
+    , m_sorter(new DirectorySorter(&m_sortTicket))
+{
+    QFileIconProvider icons;
+    m_dirIcon  = icons.icon(QFileIconProvider::Folder);
+    m_fileIcon = icons.icon(QFileIconProvider::File);
+
+    qRegisterMetaType<DirectorySortResultPtr>();
+
+    m_sorterThread.setObjectName("directory sorter");
+    m_sorter->moveToThread(&m_sorterThread);
+    connect(&m_sorterThread, &QThread::finished, m_sorter, &QObject::deleteLater);
+    connect(m_sorter, &DirectorySorter::sorted, this, &DirectoryModel::onSorted);
+    m_sorterThread.start();
+
+    connect(FolderSizeService::instance(), &FolderSizeService::sizeReady,
+            this, &DirectoryModel::onFolderSizeReady);
+    // определённые типы: перерисовать иконки и колонку типа (рисуются
+    // всё равно только видимые строки)
+    connect(FileTypeResolver::instance(), &FileTypeResolver::typesResolved,
+            this, [this]() {
+                if (!m_order.empty())
+                    emit dataChanged(index(0, NameColumn), index(rowCount() - 1, TypeColumn),
+                                     { Qt::DecorationRole, Qt::DisplayRole });
+            });
+    connect(ThumbnailService::instance(), &ThumbnailService::thumbnailReady,
+            this, &DirectoryModel::onThumbnailReady);
+}
+
+DirectoryModel::~DirectoryModel()
+{
+    // каталог отпускается вместе с m_state: если панель была последней,
+    // его чтение отменяется, а листинг уходит в кэш
+    ++m_sortTicket;
+    m_sorterThread.quit();
+    m_sorterThread.wait();
+}
+
+DirectoryListing &DirectoryModel::listing() const
+{
+    static DirectoryListing empty;
+    return m_state ? m_state->listing() : empty;
+}
+
+void DirectoryModel::setRootPath(const QString &path)
+{
+    const QString clean = QDir::cleanPath(path);
+    attach(DirectoryState::acquire(clean));
+    emit rootPathChanged(clean);
+}
+
+void DirectoryModel::refresh()
+{
+    // явное обновление всегда идёт на диск, мимо кэша; каталог
+    // перечитывается для всех панелей, которые его показывают
+    if (m_state)
+        m_state->reload();
+}
+
+void DirectoryModel::showSnapshot(const DirectoryListing &snapshot)
+{
+    // снимок нужен, только если каталог ещё никем не открыт
+    const QString clean = QDir::cleanPath(snapshot.path());
+    attach(DirectoryState::acquire(clean, &snapshot));
+    emit rootPathChanged(clean);
+}
+
+bool DirectoryModel::snapshot(DirectoryListing &out) const
+{
+    // ветка в снимок не идёт: при запуске панель откроет сам каталог
+    if (isLoading() || rootPath().isEmpty() || isBranchView())
+        return false;
+    out = listing();
+    return true;
+}
+
+void DirectoryModel::setBranchView(bool enabled)
+{
+    if (!m_state || enabled == isBranchView())
+        return;
+    // выход из ветки — обычный каталог, обычно ещё лежащий в кэше
+    attach(enabled ? DirectoryState::acquireBranch(rootPath())
+                   : DirectoryState::acquire(rootPath()));
+}
+
+void DirectoryModel::attach(std::shared_ptr<DirectoryState> state)
+{
+    BELKIN_TRACE_SCOPE("model.attach");
+
+    // строки ссылаются на записи листинга — каталог меняется внутри reset
+    beginResetModel();
+    if (m_state)
+        disconnect(m_state.get(), nullptr, this, nullptr);
+    // прежний каталог отпускается здесь
+    m_state = std::move(state);
+    connect(m_state.get(), &DirectoryState::reset, this, &DirectoryModel::onStateReset);
+    connect(m_state.get(), &DirectoryState::entriesAppended, this, &DirectoryModel::onEntriesAppended);
+    connect(m_state.get(), &DirectoryState::loadFinished, this, &DirectoryModel::onLoadFinished);
+    connect(m_state.get(), &DirectoryState::entriesChanged, this, &DirectoryModel::onEntriesChanged);
+    connect(m_state.get(), &DirectoryState::statsUpdated, this, &DirectoryModel::onStatsUpdated);
+    resetEntries();
+    endResetModel();
+    showEntries();
+}
+
+void DirectoryModel::onStateReset()
+{
+    beginResetModel();
+    resetEntries();
+    endResetModel();
+    showEntries();
+}
+
+void DirectoryModel::resetEntries()
+{
+    // прежняя фоновая сортировка, если ещё идёт, отменяется
+    ++m_sortTicket;
+    m_sorting = false;
+    m_keysReady = false;
+    m_pendingChanges = {};
+
+    const DirectoryListing &entries = listing();
+    m_sorted.clear();
+    m_sorted.reserve(entries.count());
+    for (int i = 0; i < entries.count(); ++i) {
+        if (!entries.isRemoved(i))
+            m_sorted.push_back(i);
+    }
+
+    m_loading = m_state->isLoading();
+    // к читаемому каталогу подключились посреди чтения: до его конца
+    // порядок как у пачек
+    if (m_loading && !m_state->isReconciling())
+        std::sort(m_sorted.begin(), m_sorted.end(),
+                  [this](int a, int b) { return batchLess(a, b); });
+    m_order = filtered(m_sorted);
+}
+
+void DirectoryModel::showEntries()
+{
+    m_announceLoaded = true;
+    // прочитанный каталог (из кэша или другой панели) и снимок сортируются
+    // сразу — порядок колонки у этой панели свой; читаемый — по окончании
+    if (!m_loading || m_state->isReconciling())
+        startSort();
+}
+
+void DirectoryModel::onEntriesAppended(int first, int count)
+{
+    BELKIN_TRACE_SCOPE("model.appendBatch");
+
+    // внутри пачки — каталоги и имена, окончательный порядок — после onLoadFinished
+    std::vector<int> entries(count);
+    for (int i = 0; i < count; ++i)
+        entries[i] = first + i;
+    std::sort(entries.begin(), entries.end(),
+              [this](int a, int b) { return batchLess(a, b); });
+    m_sorted.insert(m_sorted.end(), entries.begin(), entries.end());
+
+    const std::vector<int> rows = filtered(entries);
+    if (rows.empty())
+        return;
+
+    // строки только дописываются в конец — выделение и прокрутка не сбрасываются
+    const int row = int(m_order.size());
+    beginInsertRows(QModelIndex(), row, row + int(rows.size()) - 1);
+    m_order.insert(m_order.end(), rows.begin(), rows.end());
+    endInsertRows();
+}
+
+void DirectoryModel::onLoadFinished(bool)
+{
+    // прочитан (или сверен со снимком): ключи по размеру и дате могли
+    // устареть, а недочитанные строки стоят в порядке пачек
+    m_loading = false;
+    startSort();
+}
+
+void DirectoryModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= ColumnCount)
+        return;
+    if (column == m_sortColumn && order == m_sortOrder)
+        return;
+
+    m_sortColumn = column;
+    m_sortOrder = order;
+
+    // во время чтения отсортируется по его окончании
+    if (!m_loading && m_state)
+        startSort();
+}
+
+void DirectoryModel::startSort()
+{
+    BELKIN_TRACE_SCOPE("model.startSort");
+
+    // прежняя фоновая сортировка, если ещё идёт, отменяется; ключи строятся
+    // по текущему листингу, так что отложенные изменения в нём уже учтены
+    const quint64 ticket = ++m_sortTicket;
+    m_pendingChanges = {};
+    DirectoryListing &entries = listing();
+
+    std::vector<qint64> folderSizes;
+    if (m_sortColumn == SizeColumn) {
+        folderSizes.assign(entries.count(), -1);
+        for (int i = 0; i < entries.count(); ++i) {
+            if (entries.isDir(i) && !entries.isRemoved(i))
+                folderSizes[i] = folderSizeOf(i);
+        }
+    }
+
+    // ключи по размеру и дате — это stat каждой записи: на сетевом ресурсе
+    // они собираются только в потоке сортировки
+    const bool keysNeedStat = m_sortColumn == SizeColumn || m_sortColumn == DateColumn;
+    if (entries.count() < AsyncSortThreshold && !(m_state->statAsync() && keysNeedStat)) {
+        DirectorySortKeys keys;
+        keys.build(entries, m_sortColumn, m_sortOrder, folderSizes);
+        std::vector<int> order = keys.sortedOrder(entries);
+        m_keys = std::move(keys);
+        m_sorting = false;
+        applyOrder(std::move(order));
+        finishUpdate();
+        return;
+    }
+
+    // сортируется копия; изменения каталога до подмены копятся в m_pendingChanges
+    m_sorting = true;
+    QMetaObject::invokeMethod(m_sorter,
+        [sorter = m_sorter, ticket, copy = entries, column = m_sortColumn,
+         order = m_sortOrder, sizes = std::move(folderSizes)]() mutable {
+            sorter->sort(ticket, std::move(copy), column, order, std::move(sizes));
+        }, Qt::QueuedConnection);
+}
+
+void DirectoryModel::onSorted(quint64 ticket, const DirectorySortResultPtr &result)
+{
+    if (ticket != m_sortTicket)
+        return;
+
+    BELKIN_TRACE_SCOPE("model.applySort");
+
+    // копия совпадает с листингом по первым записям и несёт stat, сделанные
+    // для ключей; у изменившихся с тех пор записей они устарели
+    m_sorting = false;
+    DirectoryListing &entries = listing();
+    entries.mergeStats(result->listing);
+    for (int e : std::as_const(m_pendingChanges.modified))
+        entries.resetStat(e);
+
+    m_keys = std::move(result->keys);
+    applyOrder(std::move(result->order));
+    finishUpdate();
+}
+
+void DirectoryModel::finishUpdate()
+{
+    // изменения, пришедшие во время сортировки: записи из копии уже
+    // в m_keys, дописанные после неё получат ключи здесь
+    if (!m_pendingChanges.isEmpty()) {
+        const DirectoryChanges changes = std::move(m_pendingChanges);
+        m_pendingChanges = {};
+        applyChanges(changes);
+    }
+
+    if (m_announceLoaded) {
+        m_announceLoaded = false;
+        emit directoryLoaded(rootPath());
+    }
+}
+
+void DirectoryModel::onEntriesChanged(const DirectoryChanges &changes)
+{
+    if (m_sorting) {
+        m_pendingChanges.removed  += changes.removed;
+        m_pendingChanges.added    += changes.added;
+        m_pendingChanges.modified += changes.modified;
+        return;
+    }
+    // строки ещё в порядке пачек — всё учтёт сортировка по окончании чтения
+    if (!m_keysReady)
+        return;
+
+    applyChanges(changes);
+}
+
+void DirectoryModel::onFolderSizeReady(const QString &path, const FolderSize &)
+{
+    const QFileInfo info(path);
+    if (isLoading() || isBranchView()
+        || QDir::cleanPath(info.path()) != QDir::cleanPath(rootPath()))
+        return;
+
+    const int e = m_keys.find(listing(), info.fileName().toUtf8(), true);
+    if (e < 0)
+        return;
+
+    // при сортировке по размеру каталог переезжает на своё место
+    const int row = m_sortColumn == SizeColumn ? updateKey(e) : rowOfEntry(e);
+    if (row >= 0)
+        emit dataChanged(index(row, SizeColumn), index(row, SizeColumn));
+}
+
+void DirectoryModel::onThumbnailReady(const QString &path)
+{
+    if (!m_thumbnails || isLoading())
+        return;
+    // в ветке файл ищется не по имени в каталоге — перерисовываем иконки
+    // (рисуются всё равно только видимые строки)
+    if (isBranchView()) {
+        if (!m_order.empty())
+            emit dataChanged(index(0, NameColumn), index(rowCount() - 1, NameColumn),
+                             { Qt::DecorationRole });
+        return;
+    }
+    const QFileInfo info(path);
+    if (QDir::cleanPath(info.path()) != QDir::cleanPath(rootPath()))
+        return;
+
+    const int e = m_keys.find(listing(), info.fileName().toUtf8(), false);
+    const int row = e >= 0 ? rowOfEntry(e) : -1;
+    if (row >= 0)
+        emit dataChanged(index(row, NameColumn), index(row, NameColumn), { Qt::DecorationRole });
+}
+
+void DirectoryModel::updatePaths(const QStringList &paths)
+{
+    const QString root = QDir::cleanPath(rootPath());
+
+    // ветка — снимок обхода: изменение где-то в поддереве обходит его заново
+    if (isBranchView()) {
+        const QString prefix = root.endsWith('/') ? root : root + '/';
+        for (const QString &p : paths) {
+            if (QDir::cleanPath(p).startsWith(prefix)) {
+                m_state->reload();
+                return;
+            }
+        }
+        return;
+    }
+
+    QStringList names;
+    for (const QString &p : paths) {
+        const QFileInfo info(p);
+        if (QDir::cleanPath(info.absolutePath()) == root)
+            names << info.fileName();
+    }
+    // изменения применит общий каталог — увидят все панели, где он открыт
+    if (!names.isEmpty())
+        m_state->updateNames(names);
+}
+
+int DirectoryModel::rowOfEntry(int entry) const
+{
+    // m_order отсортирован теми же ключами: порядок строгий, строка одна
+    auto it = std::lower_bound(m_order.begin(), m_order.end(), entry,
+                               [this](int a, int b) { return m_keys.lessThan(a, b); });
+    if (it == m_order.end() || *it != entry)
+        return -1;   // скрыта фильтром
+    return int(it - m_order.begin());
+}
+
+int DirectoryModel::updateKey(int entry)
+{
+    const auto less = [this](int a, int b) { return m_keys.lessThan(a, b); };
+
+    // старые позиции ищутся по старому ключу
+    const auto sortedIt = std::lower_bound(m_sorted.begin(), m_sorted.end(), entry, less);
+    if (sortedIt != m_sorted.end() && *sortedIt == entry)
+        m_sorted.erase(sortedIt);
+    const int row = rowOfEntry(entry);
+
+    m_keys.update(listing(), entry, folderSizeOf(entry));
+    m_sorted.insert(std::lower_bound(m_sorted.begin(), m_sorted.end(), entry, less), entry);
+
+    if (row < 0)
+        return -1;
+
+    m_order.erase(m_order.begin() + row);
+    const int to = int(std::lower_bound(m_order.begin(), m_order.end(), entry, less)
+                       - m_order.begin());
+    m_order.insert(m_order.begin() + row, entry);
+
+    if (to == row)
+        return row;
+
+    // destinationChild считается в нумерации до перемещения
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), to > row ? to + 1 : to);
+    m_order.erase(m_order.begin() + row);
+    m_order.insert(m_order.begin() + to, entry);
+    endMoveRows();
+    return to;
+}
+
+void DirectoryModel::applyChanges(const DirectoryChanges &changes)
+{
+    BELKIN_TRACE_SCOPE("model.applyChanges");
+
+    DirectoryListing &entries = listing();
+    const auto less = [this](int a, int b) { return m_keys.lessThan(a, b); };
+
+    // записи уже помечены удалёнными, но ключи и данные у них прежние
+    for (int e : changes.removed) {
+        if (e >= m_keys.count())
+            continue;   // дописана и удалена, пока шла сортировка
+
+        const auto sortedIt = std::lower_bound(m_sorted.begin(), m_sorted.end(), e, less);
+        if (sortedIt != m_sorted.end() && *sortedIt == e)
+            m_sorted.erase(sortedIt);
+
+        const int row = rowOfEntry(e);
+        if (row >= 0) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_order.erase(m_order.begin() + row);
+            endRemoveRows();
+        }
+    }
+
+    // изменился сам файл: при сортировке по размеру/дате ключ перечитывается сразу
+    for (int e : changes.modified) {
+        if (e >= m_keys.count() || entries.isRemoved(e))
+            continue;
+        const int row = (m_sortColumn == SizeColumn || m_sortColumn == DateColumn)
+                            ? updateKey(e) : rowOfEntry(e);
+        if (row >= 0)
+            emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    }
+
+    for (int e : changes.added) {
+        if (e < m_keys.count())
+            continue;   // уже в ключах: сортировка шла по листингу с этой записью
+
+        // ключи нумеруются подряд — и у записей, удалённых сразу после появления
+        const bool removed = entries.isRemoved(e);
+        m_keys.append(entries, e, removed ? -1 : folderSizeOf(e));
+        if (removed)
+            continue;
+        m_sorted.insert(std::lower_bound(m_sorted.begin(), m_sorted.end(), e, less), e);
+
+        if (!m_filter.matches(entries.nameUtf8(e)))
+            continue;
+
+        const auto pos = std::lower_bound(m_order.begin(), m_order.end(), e, less);
+        const int insertRow = int(pos - m_order.begin());
+
+        beginInsertRows(QModelIndex(), insertRow, insertRow);
+        m_order.insert(m_order.begin() + insertRow, e);
+        endInsertRows();
+    }
+}
+
+bool DirectoryModel::batchLess(int a, int b) const
+{
+    // пока каталог читается, ключей ещё нет: каталоги, затем имена по байтам
+    const bool da = listing().isDir(a);
+    const bool db = listing().isDir(b);
+    if (da != db)
+        return da;
+    return compareNames(listing().nameUtf8(a), listing().nameUtf8(b)) < 0;
+}
+
+void DirectoryModel::applyOrder(std::vector<int> sorted)
+{
+    m_sorted = std::move(sorted);
+    m_keysReady = true;
+    setVisible(filtered(m_sorted), QAbstractItemModel::VerticalSortHint);
+}
+
+std::vector<int> DirectoryModel::filtered(const std::vector<int> &entries) const
+{
+    if (m_filter.isEmpty())
+        return entries;
+
+    std::vector<int> rows;
+    for (int e : entries) {
+        if (m_filter.matches(listing().nameUtf8(e)))
+            rows.push_back(e);
+    }
+    return rows;
+}
+
+void DirectoryModel::setNameFilter(const QString &pattern)
+{
+    if (pattern == m_filter.pattern())
+        return;
+
+    BELKIN_TRACE_SCOPE("model.filter");
+
+    NameFilter filter(pattern);
+    // дописали символ к подстроке — перепроверяем только то, что уже видно
+    const std::vector<int> &source = filter.narrows(m_filter) ? m_order : m_sorted;
+
+    std::vector<int> rows;
+    rows.reserve(source.size());
+    for (int e : source) {
+        if (filter.matches(listing().nameUtf8(e)))
+            rows.push_back(e);
+    }
+
+    m_filter = std::move(filter);
+    setVisible(std::move(rows), QAbstractItemModel::NoLayoutChangeHint);
+}
+
+void DirectoryModel::setVisible(std::vector<int> rows, QAbstractItemModel::LayoutChangeHint hint)
+{
+    if (rows == m_order)
+        return;
+
+    // перестановка/отбор строк без reset: persistent-индексы (выделение,
+    // текущая строка) переезжают вслед за своими записями, скрытые — гаснут
+    emit layoutAboutToBeChanged({}, hint);
+
+    std::vector<int> rowOf(listing().count(), -1);
+    for (int row = 0; row < int(rows.size()); ++row)
+        rowOf[rows[row]] = row;
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &idx : from) {
+        const int row = rowOf[m_order[idx.row()]];
+        to << (row >= 0 ? createIndex(row, idx.column()) : QModelIndex());
+    }
+
+    m_order = std::move(rows);
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged({}, hint);
+}
+
+int DirectoryModel::entryAt(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.model() != this || index.row() >= int(m_order.size()))
+        return -1;
+    return m_order[index.row()];
+}
+
+QString DirectoryModel::filePath(const QModelIndex &index) const
+{
+    const int e = entryAt(index);
+    return e < 0 ? QString() : listing().filePath(e);
+}
+
+QString DirectoryModel::fileName(const QModelIndex &index) const
+{
+    const int e = entryAt(index);
+    return e < 0 ? QString() : listing().name(e);
+}
+
+bool DirectoryModel::isDir(const QModelIndex &index) const
+{
+    const int e = entryAt(index);
+    return e >= 0 && listing().isDir(e);
+}
+
+QModelIndex DirectoryModel::indexOf(const QString &path, int column) const
+{
+    const QFileInfo info(path);
+    const QByteArray name = info.fileName().toUtf8();
+    const QString clean = QDir::cleanPath(path);
+    if (!isBranchView() && QDir::cleanPath(info.absolutePath()) != QDir::cleanPath(rootPath()))
+        return {};
+
+    // строки в порядке m_keys: запись — по имени, строка — двоичным поиском
+    if (m_keysReady) {
+        std::function<bool(int)> match;
+        if (isBranchView())
+            match = [&](int e) { return listing().filePath(e) == clean; };
+        int e = m_keys.find(listing(), name, true, match);
+        if (e < 0)
+            e = m_keys.find(listing(), name, false, match);
+        const int row = e >= 0 ? rowOfEntry(e) : -1;
+        return row >= 0 ? createIndex(row, column) : QModelIndex();
+    }
+
+    // каталог ещё читается, строки в порядке пачек — просматриваем их
+    for (int row = 0; row < int(m_order.size()); ++row) {
+        const int e = m_order[row];
+        if (listing().nameUtf8(e) == QByteArrayView(name)
+            && (!isBranchView() || listing().filePath(e) == clean))
+            return createIndex(row, column);
+    }
+    return {};
+}
+
+QModelIndex DirectoryModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= int(m_order.size())
+        || column < 0 || column >= ColumnCount)
+        return {};
+    return createIndex(row, column);
+}
+
+QModelIndex DirectoryModel::parent(const QModelIndex &) const
+{
+    return {};
+}
+
+int DirectoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_order.size());
+}
+
+int DirectoryModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+bool DirectoryModel::hasChildren(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !m_order.empty();
+}
+
+bool DirectoryModel::fileType(int entry, FileTypeResolver::Type &type) const
+{
+    // тип определяется в фоне; до ответа — запрос и «нет данных»
+    const QString name = listing().name(entry);
+    const QString path = listing().filePath(entry);
+    const QString suffix = FileTypeResolver::suffixOf(name);
+
+    FileTypeResolver *resolver = FileTypeResolver::instance();
+    if (resolver->lookup(path, suffix, type))
+        return true;
+    resolver->request(path, suffix);
+    return false;
+}
+
+void DirectoryModel::prefetchTypes(int firstRow, int lastRow)
+{
+    firstRow = std::max(firstRow, 0);
+    lastRow = std::min(lastRow, int(m_order.size()) - 1);
+
+    FileTypeResolver::Type type;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const int e = m_order[row];
+        if (!listing().isDir(e))
+            fileType(e, type);
+    }
+}
+
+void DirectoryModel::setThumbnailsEnabled(bool enabled)
+{
+    if (m_thumbnails == enabled)
+        return;
+    m_thumbnails = enabled;
+    if (!enabled)
+        ThumbnailService::instance()->setWanted({}, {});
+    if (!m_order.empty())
+        emit dataChanged(index(0, NameColumn), index(rowCount() - 1, NameColumn),
+                         { Qt::DecorationRole });
+}
+
+bool DirectoryModel::thumbnailRequest(int entry, ThumbnailService::Request &req) const
+{
+    if (listing().isDir(entry)
+        || !ThumbnailService::canThumbnail(FileTypeResolver::suffixOf(listing().name(entry)))
+        || !statEntry(entry))
+        return false;
+    req.path = listing().filePath(entry);
+    req.mtime = listing().mtime(entry);
+    return true;
+}
+
+bool DirectoryModel::thumbnail(int entry, QIcon &icon) const
+{
+    ThumbnailService::Request req;
+    if (!thumbnailRequest(entry, req))
+        return false;
+    ThumbnailService *service = ThumbnailService::instance();
+    if (service->lookup(req.path, req.mtime, icon))
+        return true;
+    service->request(req);
+    return false;
+}
+
+void DirectoryModel::prefetchThumbnails(int visibleFirst, int visibleLast, int firstRow, int lastRow)
+{
+    if (!m_thumbnails)
+        return;
+
+    const int count = int(m_order.size());
+    QList<ThumbnailService::Request> visible;
+    QList<ThumbnailService::Request> around;
+    ThumbnailService::Request req;
+
+    for (int row = std::max(visibleFirst, 0); row <= std::min(visibleLast, count - 1); ++row) {
+        if (thumbnailRequest(m_order[row], req))
+            visible << req;
+    }
+    // запас: сначала вниз (туда обычно листают), потом вверх
+    for (int row = std::max(visibleLast + 1, 0); row <= std::min(lastRow, count - 1); ++row) {
+        if (thumbnailRequest(m_order[row], req))
+            around << req;
+    }
+    for (int row = std::min(visibleFirst - 1, count - 1); row >= std::max(firstRow, 0); --row) {
+        if (thumbnailRequest(m_order[row], req))
+            around << req;
+    }
+
+    ThumbnailService::instance()->setWanted(visible, around);
+}
+
+QString DirectoryModel::typeName(int entry) const
+{
+    if (listing().isDir(entry))
+        return tr("Folder");
+
+    FileTypeResolver::Type type;
+    if (fileType(entry, type) && !type.comment.isEmpty())
+        return type.comment;
+
+    const QString suffix = FileTypeResolver::suffixOf(listing().name(entry));
+    return suffix.isEmpty() ? tr("File") : tr("%1 File").arg(suffix);
+}
+
+qint64 DirectoryModel::folderSizeOf(int entry) const
+{
+    // размер каталога известен, только если его посчитал FolderSizeService
+    if (!listing().isDir(entry))
+        return -1;
+
+    const QString path = listing().filePath(entry);
+    // для ссылки на каталог нужно mtime цели, а не самой ссылки (на
+    // сетевом ресурсе ссылку не разыменовываем — размер просто неизвестен)
+    qint64 mtime = -1;
+    if (listing().isLink(entry)) {
+        if (!m_state->statAsync())
+            mtime = QFileInfo(path).lastModified().toSecsSinceEpoch();
+    } else if (statEntry(entry)) {
+        mtime = listing().mtime(entry);
+    }
+
+    FolderSize size;
+    return FolderSizeService::instance()->lookup(path, mtime, size) ? size.bytes : -1;
+}
+
+bool DirectoryModel::statEntry(int entry) const
+{
+    return m_state && m_state->statEntry(entry);
+}
+
+void DirectoryModel::onStatsUpdated()
+{
+    // перерисуются только видимые строки
+    if (!m_order.empty())
+        emit dataChanged(index(0, SizeColumn), index(rowCount() - 1, DateColumn));
+}
+
+QVariant DirectoryModel::folderSizeText(int entry) const
+{
+    const qint64 bytes = folderSizeOf(entry);
+    if (bytes >= 0)
+        return QLocale::system().formattedDataSize(bytes);
+    if (FolderSizeService::instance()->isPending(listing().filePath(entry)))
+        return QStringLiteral("…");
+    return QString();
+}
+
+QVariant DirectoryModel::data(const QModelIndex &index, int role) const
+{
+    const int e = entryAt(index);
+    if (e < 0)
+        return {};
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        switch (index.column()) {
+        case NameColumn:
+            // в ветке — с путём от каталога панели
+            if (role == Qt::DisplayRole && isBranchView())
+                return listing().relativePath(e);
+            return listing().name(e);
+        case SizeColumn:
+            if (listing().isDir(e))
+                return folderSizeText(e);
+            if (!statEntry(e))
+                return QString();
+            return QLocale::system().formattedDataSize(listing().size(e));
+        case TypeColumn:
+            return typeName(e);
+        case DateColumn:
+            if (!statEntry(e))
+                return QString();
+            return QLocale::system().toString(
+                QDateTime::fromSecsSinceEpoch(listing().mtime(e)), QLocale::ShortFormat);
+        }
+        break;
+
+    case Qt::DecorationRole:
+        if (index.column() == NameColumn) {
+            if (listing().isDir(e))
+                return m_dirIcon;
+            QIcon icon;
+            if (m_thumbnails && thumbnail(e, icon))
+                return icon;
+            FileTypeResolver::Type type;
+            if (fileType(e, type) && !type.icon.isNull())
+                return type.icon;
+            return m_fileIcon;
+        }
+        break;
+
+    case Qt::TextAlignmentRole:
+        if (index.column() == SizeColumn)
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        break;
+    }
+
+    return {};
+}
+
+QVariant DirectoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return PanelModel::headerData(section, orientation, role);
+
+    switch (section) {
+    case NameColumn: return tr("Name");
+    case SizeColumn: return tr("Size");
+    case TypeColumn: return tr("Type");
+    case DateColumn: return tr("Date Modified");
+    }
+    return {};
+}
+
+Qt::ItemFlags DirectoryModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled
+         | Qt::ItemNeverHasChildren;
+}
+
+QStringList DirectoryModel::mimeTypes() const
+{
+    return { QStringLiteral("text/uri-list") };
+}
+
+QMimeData *DirectoryModel::mimeData(const QModelIndexList &indexes) const
+{
+    QList<QUrl> urls;
+    for (const QModelIndex &idx : indexes) {
+        if (idx.column() == NameColumn)
+            urls << QUrl::fromLocalFile(filePath(idx));
+    }
+
+    auto *data = new QMimeData;
+    data->setUrls(urls);
+    return data;
+}
+
+Qt::DropActions DirectoryModel::supportedDragActions() const
+{
+    return Qt::CopyAction | Qt::MoveAction;
+}
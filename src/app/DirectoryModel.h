@@ -0,0 +1,158 @@
+#pragma once
+
+#include <QIcon>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "PanelModel.h"
+#include "DirectoryListing.h"
+#include "FolderSize.h"
+#include "DirectorySort.h"
+#include "NameFilter.h"
+#include "FileTypeResolver.h"
+#include "ThumbnailService.h"
+#include "DirectoryState.h"
+
+class DirectorySorter;
+
+// Модель панели поверх DirectoryListing вместо QFileSystemModel:
+// показывает один каталог (или ветку — всё поддерево списком), без дерева
+// узлов и QFileSystemWatcher.
+// Листинг, чтение и watch — в общем DirectoryState (один на каталог для
+// всех панелей), у модели только свои сортировка, фильтр и строки.
+class DirectoryModel : public PanelModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn,
+        SizeColumn,
+        TypeColumn,
+        DateColumn,
+        ColumnCount
+    };
+
+    explicit DirectoryModel(QObject *parent = nullptr);
+    ~DirectoryModel() override;
+
+    // PanelModel
+    QString rootPath() const override { return m_state ? m_state->path() : QString(); }
+    void setRootPath(const QString &path) override;
+    void refresh() override;
+    void updatePaths(const QStringList &paths) override;
+    // пока идёт чтение или фоновая сортировка, строки ещё не на своих местах
+    bool isLoading() const override { return m_loading || m_sorting; }
+    QString filePath(const QModelIndex &index) const override;
+    QString fileName(const QModelIndex &index) const override;
+    bool isDir(const QModelIndex &index) const override;
+    QModelIndex indexOf(const QString &path, int column = 0) const override;
+
+    // QAbstractItemModel
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    Qt::DropActions supportedDragActions() const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // показать сохранённый листинг (снимок сессии) сразу, а каталог
+    // перечитать в фоне и применить разницу строками (без сброса модели)
+    void showSnapshot(const DirectoryListing &snapshot);
+    // текущий листинг для снимка сессии; false — каталог ещё читается
+    bool snapshot(DirectoryListing &out) const;
+
+    // режим «ветка» (Ctrl+B): все файлы поддерева текущего каталога одним
+    // списком, строки приходят по мере обхода; имя показывается с путём
+    // от каталога. Переход в другой каталог выключает режим
+    void setBranchView(bool enabled);
+    bool isBranchView() const { return m_state && m_state->isBranch(); }
+
+    // быстрый фильтр: показываются только записи, подходящие под шаблон
+    // (см. NameFilter); пустой шаблон — все
+    void setNameFilter(const QString &pattern);
+    QString nameFilter() const { return m_filter.pattern(); }
+
+    // заранее определить типы файлов в строках [firstRow, lastRow]
+    // (видимая область с запасом) — при прокрутке иконки уже готовы
+    void prefetchTypes(int firstRow, int lastRow);
+
+    // режим миниатюр: у изображений вместо иконки типа — уменьшенная копия
+    // (ThumbnailService); пока её нет, рисуется иконка типа
+    void setThumbnailsEnabled(bool enabled);
+    bool thumbnailsEnabled() const { return m_thumbnails; }
+    // видимые строки [visibleFirst, visibleLast] декодируются первыми, запас
+    // [firstRow, lastRow] — следом, остальное снимается с очереди
+    void prefetchThumbnails(int visibleFirst, int visibleLast, int firstRow, int lastRow);
+
+private slots:
+    void onStateReset();
+    void onEntriesAppended(int first, int count);
+    void onLoadFinished(bool ok);
+    void onEntriesChanged(const DirectoryChanges &changes);
+    void onStatsUpdated();
+    void onFolderSizeReady(const QString &path, const FolderSize &size);
+    void onThumbnailReady(const QString &path);
+    void onSorted(quint64 ticket, const DirectorySortResultPtr &result);
+
+private:
+    // листинг каталога (пустой, пока каталог не задан)
+    DirectoryListing &listing() const;
+    void attach(std::shared_ptr<DirectoryState> state);
+    void resetEntries();
+    void showEntries();
+    void applyChanges(const DirectoryChanges &changes);
+    int rowOfEntry(int entry) const;
+    // перечитать ключ записи и переставить её; возвращает новую строку или -1
+    int updateKey(int entry);
+    std::vector<int> filtered(const std::vector<int> &entries) const;
+    void setVisible(std::vector<int> rows, QAbstractItemModel::LayoutChangeHint hint);
+    bool batchLess(int a, int b) const;
+    void startSort();
+    void applyOrder(std::vector<int> sorted);
+    void finishUpdate();
+    qint64 folderSizeOf(int entry) const;
+    bool statEntry(int entry) const;
+    int entryAt(const QModelIndex &index) const;
+    QString typeName(int entry) const;
+    bool fileType(int entry, FileTypeResolver::Type &type) const;
+    QVariant folderSizeText(int entry) const;
+    bool thumbnailRequest(int entry, ThumbnailService::Request &req) const;
+    bool thumbnail(int entry, QIcon &icon) const;
+
+    // stat() делается из data(), т.е. только для видимых строк; на сетевых
+    // и FUSE-ресурсах — пачками в IoPool (DirectoryState::statEntry)
+    std::shared_ptr<DirectoryState> m_state;
+    std::vector<int> m_sorted;      // все записи в порядке сортировки
+    std::vector<int> m_order;       // строка -> индекс в листинге (m_sorted после фильтра)
+    NameFilter m_filter;
+
+    // каталог ещё читается (или сверяется со снимком)
+    bool m_loading = false;
+
+    // ключи сортировки строятся один раз на листинг; большие листинги
+    // сортируются в своём потоке, перестановка подменяется целиком
+    int           m_sortColumn = NameColumn;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+    DirectorySortKeys m_keys;
+    bool m_keysReady = false;        // m_sorted упорядочен по m_keys
+    std::atomic<quint64> m_sortTicket{0};
+    bool m_sorting = false;
+    bool m_announceLoaded = false;   // после сортировки послать directoryLoaded
+    // изменения каталога во время фоновой сортировки — после подмены порядка
+    DirectoryChanges m_pendingChanges;
+    QThread m_sorterThread;
+    DirectorySorter *m_sorter;
+
+    bool m_thumbnails = false;
+
+    QIcon m_dirIcon;
+    QIcon m_fileIcon;
+};
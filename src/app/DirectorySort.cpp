@@ -0,0 +1,353 @@
+#include <QLocale>
+#include <QSet>
+#include <QThread>
+#include <algorithm>
+#include <thread>
+#include "DirectorySort.h"
+#include "ParallelSort.h"
+#include "Trace.h"
+
+namespace {
+
+// меньше — ключи строятся в одном потоке
+constexpr int ParallelKeysThreshold = 8192;
+// stat для ключей по размеру/дате отправляется пачками такого размера
+constexpr int StatChunk = 4096;
+// зазор между соседними рангами: столько вставок между двумя записями
+// обходится без пересортировки, дальше порядок соседей добирает индекс
+constexpr qint64 RankGap = qint64(1) << 20;
+
+QCollator makeCollator()
+{
+    QCollator collator{QLocale()};
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    // числа сравнивает naturalText: numericMode в sortKey поддержан не везде
+    collator.setNumericMode(false);
+    return collator;
+}
+
+QString extensionOf(const QString &name)
+{
+    const qsizetype dot = name.lastIndexOf('.');
+    return dot > 0 ? name.mid(dot + 1) : QString();
+}
+
+// fn(thread, begin, end) для равных кусков [0, n)
+template <typename Fn>
+void forChunks(int n, int threads, Fn fn)
+{
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back([&fn, n, threads, t]() {
+            fn(t, int(qint64(n) * t / threads), int(qint64(n) * (t + 1) / threads));
+        });
+    fn(0, 0, int(qint64(n) / threads));
+    for (std::thread &th : pool)
+        th.join();
+}
+
+// ранг посередине между соседями при вставке в позицию pos
+template <typename It, typename RankOf>
+qint64 rankBetween(It begin, It pos, It end, RankOf rankOf)
+{
+    if (begin == end)
+        return RankGap;
+    const qint64 prev = pos == begin ? rankOf(*pos) - 2 * RankGap : rankOf(*(pos - 1));
+    const qint64 next = pos == end ? prev + 2 * RankGap : rankOf(*pos);
+    return prev + (next - prev) / 2;
+}
+
+} // namespace
+
+DirectorySortKeys::DirectorySortKeys()
+    : m_collator(makeCollator())
+{
+}
+
+QString DirectorySortKeys::naturalText(const QString &name)
+{
+    QString out;
+    out.reserve(name.size() + 8);
+
+    const qsizetype n = name.size();
+    for (qsizetype i = 0; i < n;) {
+        if (!name[i].isDigit()) {
+            out += name[i++];
+            continue;
+        }
+
+        qsizetype j = i;
+        while (j < n && name[j].isDigit())
+            ++j;
+        qsizetype k = i;
+        while (k < j - 1 && name[k] == QLatin1Char('0'))
+            ++k;
+
+        // длина числа впереди: более короткое число меньше
+        const qsizetype len = std::min<qsizetype>(j - k, 99);
+        out += QLatin1Char(char('0' + len / 10));
+        out += QLatin1Char(char('0' + len % 10));
+        out += QStringView(name).mid(k, j - k);
+        i = j;
+    }
+    return out;
+}
+
+int DirectorySortKeys::compareText(const QString &a, const QString &b) const
+{
+    return m_collator.compare(a, b);
+}
+
+qint64 DirectorySortKeys::numberFor(DirectoryListing &listing, int entry, qint64 folderSize) const
+{
+    if (m_column == SizeColumn) {
+        if (listing.isDir(entry))
+            return folderSize;
+        return listing.ensureStat(entry) ? listing.size(entry) : -1;
+    }
+    return listing.ensureStat(entry) ? listing.mtime(entry) : -1;
+}
+
+bool DirectorySortKeys::build(DirectoryListing &listing, int column, Qt::SortOrder order,
+                              const std::vector<qint64> &folderSizes,
+                              const std::function<bool()> &cancelled)
+{
+    BELKIN_TRACE_SCOPE("sort.buildKeys");
+
+    m_column = column;
+    m_order = order;
+
+    const int n = listing.count();
+    const bool numeric = column == SizeColumn || column == DateColumn;
+    const bool byType  = column == TypeColumn;
+
+    m_dir.assign(n, 0);
+    m_nameRank.assign(n, 0);
+    m_number.assign(numeric ? n : 0, -1);
+    m_extRank.assign(byType ? n : 0, 0);
+    m_exts.clear();
+    m_extRanks.clear();
+
+    const int threads = n < ParallelKeysThreshold
+                            ? 1 : qBound(1, QThread::idealThreadCount(), 16);
+    std::atomic<bool> stop{false};
+
+    // stat для числовых ключей — пачками (io_uring), а не по одному в цикле ниже;
+    // между пачками проверяется отмена
+    if (numeric) {
+        for (int begin = 0; begin < n; begin += StatChunk) {
+            if (cancelled && cancelled())
+                return false;
+            listing.ensureStats(begin, std::min(n, begin + StatChunk));
+        }
+    }
+
+    // sortKey считается один раз на запись; QCollator не потокобезопасен —
+    // у каждого потока свой
+    std::vector<std::vector<QCollatorSortKey>> chunkKeys(threads);
+    std::vector<QSet<QString>> chunkExts(threads);
+
+    forChunks(n, threads, [&](int t, int begin, int end) {
+        const QCollator collator = makeCollator();
+        std::vector<QCollatorSortKey> &keys = chunkKeys[t];
+        keys.reserve(end - begin);
+
+        for (int i = begin; i < end; ++i) {
+            if ((i & 1023) == 0 && cancelled && (stop || cancelled())) {
+                stop = true;
+                return;
+            }
+
+            const QString name = listing.name(i);
+            m_dir[i] = listing.isDir(i);
+            keys.push_back(collator.sortKey(naturalText(name)));
+            if (numeric)
+                m_number[i] = numberFor(listing, i,
+                                        folderSizes.empty() ? -1 : folderSizes[i]);
+            if (byType && !listing.isDir(i))
+                chunkExts[t].insert(extensionOf(name));
+        }
+    });
+    if (stop)
+        return false;
+
+    std::vector<QCollatorSortKey> keys;
+    keys.reserve(n);
+    for (std::vector<QCollatorSortKey> &chunk : chunkKeys) {
+        for (QCollatorSortKey &key : chunk)
+            keys.push_back(std::move(key));
+        chunk = {};
+    }
+
+    // один раз сортируем по ключам и запоминаем позиции как ранги
+    m_byName.resize(n);
+    for (int i = 0; i < n; ++i)
+        m_byName[i] = i;
+    parallelSort(m_byName.begin(), m_byName.end(), [&](int a, int b) {
+        const int c = keys[a].compare(keys[b]);
+        if (c != 0)
+            return c < 0;
+        const int raw = listing.nameUtf8(a).compare(listing.nameUtf8(b));
+        return raw != 0 ? raw < 0 : a < b;
+    }, threads);
+    for (int pos = 0; pos < n; ++pos)
+        m_nameRank[m_byName[pos]] = qint64(pos) * RankGap;
+
+    if (byType) {
+        // различных расширений мало: их ранжируем последовательно
+        QSet<QString> all;
+        for (const QSet<QString> &exts : chunkExts)
+            all.unite(exts);
+        m_exts = QStringList(all.cbegin(), all.cend());
+        std::sort(m_exts.begin(), m_exts.end(), [this](const QString &a, const QString &b) {
+            return compareText(naturalText(a), naturalText(b)) < 0;
+        });
+        for (int i = 0; i < m_exts.size(); ++i)
+            m_extRanks.insert(m_exts[i], qint64(i + 1) * RankGap);
+
+        for (int i = 0; i < n; ++i) {
+            if (!m_dir[i])
+                m_extRank[i] = m_extRanks.value(extensionOf(listing.name(i)));
+        }
+    }
+
+    return !(cancelled && cancelled());
+}
+
+qint64 DirectorySortKeys::extRankFor(const QString &ext)
+{
+    auto it = m_extRanks.constFind(ext);
+    if (it != m_extRanks.cend())
+        return *it;
+
+    const QString text = naturalText(ext);
+    auto pos = std::upper_bound(m_exts.begin(), m_exts.end(), text,
+                                [this](const QString &t, const QString &e) {
+                                    return compareText(t, naturalText(e)) < 0;
+                                });
+    const qint64 rank = rankBetween(m_exts.begin(), pos, m_exts.end(),
+                                    [this](const QString &e) { return m_extRanks.value(e); });
+    m_exts.insert(pos, ext);
+    m_extRanks.insert(ext, rank);
+    return rank;
+}
+
+void DirectorySortKeys::append(DirectoryListing &listing, int entry, qint64 folderSize)
+{
+    Q_ASSERT(entry == count());
+
+    const QString name = listing.name(entry);
+    const QString text = naturalText(name);
+
+    m_dir.push_back(listing.isDir(entry));
+
+    auto pos = std::upper_bound(m_byName.begin(), m_byName.end(), text,
+                                [&](const QString &t, int e) {
+                                    return compareText(t, naturalText(listing.name(e))) < 0;
+                                });
+    m_nameRank.push_back(rankBetween(m_byName.begin(), pos, m_byName.end(),
+                                     [this](int e) { return m_nameRank[e]; }));
+    m_byName.insert(pos, entry);
+
+    if (m_column == SizeColumn || m_column == DateColumn)
+        m_number.push_back(numberFor(listing, entry, folderSize));
+    if (m_column == TypeColumn)
+        m_extRank.push_back(listing.isDir(entry) ? 0 : extRankFor(extensionOf(name)));
+}
+
+void DirectorySortKeys::update(DirectoryListing &listing, int entry, qint64 folderSize)
+{
+    if (m_column == SizeColumn || m_column == DateColumn)
+        m_number[entry] = numberFor(listing, entry, folderSize);
+}
+
+bool DirectorySortKeys::lessThan(int a, int b) const
+{
+    if (m_dir[a] != m_dir[b])
+        return m_dir[a] > m_dir[b];   // каталоги первыми в любом направлении
+
+    qint64 x = 0, y = 0;
+    switch (m_column) {
+    case SizeColumn:
+    case DateColumn:
+        x = m_number[a];
+        y = m_number[b];
+        break;
+    case TypeColumn:
+        x = m_extRank[a];
+        y = m_extRank[b];
+        break;
+    }
+    if (x == y) {
+        x = m_nameRank[a];
+        y = m_nameRank[b];
+    }
+    if (x == y) {
+        x = a;
+        y = b;
+    }
+    return m_order == Qt::AscendingOrder ? x < y : x > y;
+}
+
+std::vector<int> DirectorySortKeys::sortedOrder(const DirectoryListing &listing) const
+{
+    BELKIN_TRACE_SCOPE("sort.order");
+
+    std::vector<int> order;
+    order.reserve(listing.count());
+    for (int i = 0; i < count(); ++i) {
+        if (!listing.isRemoved(i))
+            order.push_back(i);
+    }
+    parallelSort(order.begin(), order.end(), [this](int a, int b) { return lessThan(a, b); });
+    return order;
+}
+
+int DirectorySortKeys::find(const DirectoryListing &listing, QByteArrayView name, bool isDir,
+                            const std::function<bool(int entry)> &match) const
+{
+    const QString text = naturalText(QString::fromUtf8(name));
+
+    auto it = std::lower_bound(m_byName.begin(), m_byName.end(), text,
+                               [&](int e, const QString &t) {
+                                   return compareText(naturalText(listing.name(e)), t) < 0;
+                               });
+    // равные для QCollator имена (регистр) стоят подряд — ищем точное
+    for (; it != m_byName.end(); ++it) {
+        const int e = *it;
+        if (listing.nameUtf8(e) == name && listing.isDir(e) == isDir && !listing.isRemoved(e)
+            && (!match || match(e)))
+            return e;
+        if (compareText(naturalText(listing.name(e)), text) != 0)
+            break;
+    }
+    return -1;
+}
+
+DirectorySorter::DirectorySorter(const std::atomic<quint64> *ticket, QObject *parent)
+    : QObject(parent)
+    , m_ticket(ticket)
+{
+}
+
+void DirectorySorter::sort(quint64 ticket, DirectoryListing listing, int column,
+                           Qt::SortOrder order, std::vector<qint64> folderSizes)
+{
+    auto cancelled = [this, ticket]() {
+        return m_ticket->load(std::memory_order_relaxed) != ticket;
+    };
+    // в очереди могли скопиться устаревшие запросы — их просто пропускаем
+    if (cancelled())
+        return;
+
+    BELKIN_TRACE_SCOPE("sorter.sort");
+
+    auto result = std::make_shared<DirectorySortResult>();
+    result->listing = std::move(listing);
+    if (!result->keys.build(result->listing, column, order, folderSizes, cancelled))
+        return;
+    result->order = result->keys.sortedOrder(result->listing);
+
+    if (!cancelled())
+        emit sorted(ticket, result);
+}
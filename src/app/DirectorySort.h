@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QCollator>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "DirectoryListing.h"
+
+// Ключи сортировки панели, посчитанные один раз на запись.
+// Имена (и расширения) приводятся к «естественному» виду (числа сравниваются
+// как числа), прогоняются через QCollator::sortKey в нескольких потоках,
+// сортируются один раз и сводятся к целочисленным рангам с зазорами —
+// дальше любое сравнение строк это сравнение qint64, а сами sortKey
+// не держатся в памяти. Каталоги всегда идут первыми, внутри группы —
+// по выбранной колонке, при равенстве — по имени.
+class DirectorySortKeys
+{
+public:
+    // колонки совпадают с DirectoryModel::Column
+    enum Column { NameColumn, SizeColumn, TypeColumn, DateColumn };
+
+    DirectorySortKeys();
+
+    int column() const { return m_column; }
+    Qt::SortOrder order() const { return m_order; }
+    int count() const { return int(m_dir.size()); }
+
+    // Ключи всех записей listing. Для размера/даты делает stat (в тех же
+    // потоках). folderSizes — посчитанные размеры каталогов (-1 — неизвестен),
+    // пустой вектор — неизвестны все. false — отменено через cancelled.
+    bool build(DirectoryListing &listing, int column, Qt::SortOrder order,
+               const std::vector<qint64> &folderSizes,
+               const std::function<bool()> &cancelled = {});
+
+    // ключ записи, дописанной в listing после build
+    void append(DirectoryListing &listing, int entry, qint64 folderSize = -1);
+    // перечитать число (размер/дату) записи, например после resetStat
+    void update(DirectoryListing &listing, int entry, qint64 folderSize = -1);
+
+    bool lessThan(int a, int b) const;
+
+    // перестановка неудалённых записей в порядке сортировки (параллельно)
+    std::vector<int> sortedOrder(const DirectoryListing &listing) const;
+
+    // неудалённая запись с таким именем (и, если задан, прошедшая match) или -1
+    int find(const DirectoryListing &listing, QByteArrayView name, bool isDir,
+             const std::function<bool(int entry)> &match = {}) const;
+
+    // «естественный» вид имени: каждая группа цифр — длина (две цифры) и
+    // число без ведущих нулей, так что file2 < file10 при обычном сравнении
+    static QString naturalText(const QString &name);
+
+private:
+    qint64 numberFor(DirectoryListing &listing, int entry, qint64 folderSize) const;
+    qint64 extRankFor(const QString &ext);
+    int compareText(const QString &a, const QString &b) const;
+
+    int           m_column = NameColumn;
+    Qt::SortOrder m_order = Qt::AscendingOrder;
+    QCollator     m_collator;
+
+    std::vector<quint8> m_dir;
+    std::vector<qint64> m_nameRank;
+    std::vector<qint64> m_number;        // размер или mtime (только для этих колонок)
+    std::vector<qint64> m_extRank;       // только для колонки типа
+    std::vector<int>    m_byName;        // записи в порядке m_nameRank — для find/append
+
+    QStringList            m_exts;       // расширения в порядке рангов
+    QHash<QString, qint64> m_extRanks;
+};
+
+// Результат фоновой сортировки: ключи, перестановка и листинг с теми stat,
+// что понадобились для ключей
+struct DirectorySortResult {
+    DirectoryListing  listing;
+    DirectorySortKeys keys;
+    std::vector<int>  order;
+};
+
+using DirectorySortResultPtr = std::shared_ptr<DirectorySortResult>;
+Q_DECLARE_METATYPE(DirectorySortResultPtr)
+
+// Сортирует копию листинга в фоновом потоке. Как и DirectoryLoader,
+// отменяется сменой счётчика у модели (новая сортировка или навигация).
+class DirectorySorter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DirectorySorter(const std::atomic<quint64> *ticket, QObject *parent = nullptr);
+
+    void sort(quint64 ticket, DirectoryListing listing, int column, Qt::SortOrder order,
+              std::vector<qint64> folderSizes);
+
+signals:
+    void sorted(quint64 ticket, const DirectorySortResultPtr &result);
+
+private:
+    const std::atomic<quint64> *m_ticket;
+};
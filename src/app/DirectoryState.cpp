@@ -0,0 +1,597 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QDebug>
+#include <algorithm>
+#include <optional>
+#include "DirectoryState.h"
+#include "DirectoryCache.h"
+#include "DirectoryWatcher.h"
+#include "IoPool.h"
+#include "Trace.h"
+
+namespace {
+
+// каталог, не отдавший за это время ни одной записи, считается зависшим
+constexpr int LoadStallMs = 2000;
+
+// есть ли имя в каталоге и каталог ли это (для applyChanges)
+struct NameState {
+    bool exists = false;
+    bool dir = false;
+};
+
+// порядок m_byName: байты имени, при равенстве — номер записи
+struct ByName {
+    const DirectoryListing *listing;
+
+    bool operator()(int a, int b) const
+    {
+        const int c = listing->nameUtf8(a).compare(listing->nameUtf8(b));
+        return c != 0 ? c < 0 : a < b;
+    }
+    bool operator()(int e, QByteArrayView name) const { return listing->nameUtf8(e).compare(name) < 0; }
+    bool operator()(QByteArrayView name, int e) const { return name.compare(listing->nameUtf8(e)) < 0; }
+};
+
+// открытые каталоги (и отдельно ветки); ссылки держат модели
+QHash<QString, std::weak_ptr<DirectoryState>> &registry(bool branch)
+{
+    static QHash<QString, std::weak_ptr<DirectoryState>> states;
+    static QHash<QString, std::weak_ptr<DirectoryState>> branches;
+    return branch ? branches : states;
+}
+
+} // namespace
+
+std::shared_ptr<DirectoryState> DirectoryState::acquire(const QString &path,
+                                                        const DirectoryListing *snapshot)
+{
+    return open(QDir::cleanPath(path), false, snapshot);
+}
+
+std::shared_ptr<DirectoryState> DirectoryState::acquireBranch(const QString &path)
+{
+    return open(QDir::cleanPath(path), true, nullptr);
+}
+
+std::shared_ptr<DirectoryState> DirectoryState::open(const QString &path, bool branch,
+                                                     const DirectoryListing *snapshot)
+{
+    if (std::shared_ptr<DirectoryState> existing = registry(branch).value(path).lock())
+        return existing;
+
+    BELKIN_TRACE_SCOPE("state.open");
+
+    // последняя ссылка закрывает каталог сразу (листинг — в кэш), а сам
+    // объект удаляется позже: его могут отпустить из его же сигнала
+    std::shared_ptr<DirectoryState> state(new DirectoryState(path, branch), [](DirectoryState *s) {
+        s->close();
+        s->deleteLater();
+    });
+    registry(branch).insert(path, state);
+    state->start(snapshot);
+    return state;
+}
+
+int DirectoryState::openCount()
+{
+    return int(registry(false).size() + registry(true).size());
+}
+
+DirectoryState::DirectoryState(const QString &path, bool branch)
+    : m_path(path)
+    , m_branch(branch)
+    , m_generation(std::make_shared<std::atomic<quint64>>(0))
+    // удаляется в GUI-потоке, когда его отпустит последняя задача IoPool
+    , m_loader(new DirectoryLoader(m_generation),
+               [](DirectoryLoader *loader) { loader->deleteLater(); })
+{
+    qRegisterMetaType<DirectoryListing>();
+    qRegisterMetaType<QList<EntryStat>>();
+    qRegisterMetaType<BranchBatchPtr>();
+
+    // загрузчик вызывается из потоков IoPool — сигналы приходят очередью
+    connect(m_loader.get(), &DirectoryLoader::batchReady, this, &DirectoryState::onBatchReady);
+    connect(m_loader.get(), &DirectoryLoader::branchBatchReady,
+            this, &DirectoryState::onBranchBatchReady);
+    connect(m_loader.get(), &DirectoryLoader::finished,   this, &DirectoryState::onLoadFinished);
+    connect(m_loader.get(), &DirectoryLoader::statReady,  this, &DirectoryState::onStatReady);
+    connect(IoPool::instance(), &IoPool::responsivenessChanged,
+            this, &DirectoryState::onResponsivenessChanged);
+    connect(IoPool::instance(), &IoPool::slotFreed, this, &DirectoryState::onSlotFreed);
+    if (!m_branch)
+        connect(DirectoryWatcher::instance(), &DirectoryWatcher::directoryChanged,
+                this, &DirectoryState::onDirectoryChanged);
+
+    m_stallTimer.setSingleShot(true);
+    m_stallTimer.setInterval(LoadStallMs);
+    connect(&m_stallTimer, &QTimer::timeout, this, [this]() {
+        if (!m_loading)
+            return;
+        m_waitingForMount = true;
+        IoPool::instance()->reportHang(m_path, m_loadJob);
+    });
+}
+
+void DirectoryState::start(const DirectoryListing *snapshot)
+{
+    IoPool *io = IoPool::instance();
+    m_statAsync = io->isRemote(m_path) || !io->isResponsive(m_path);
+
+    // ветка — снимок обхода: inotify на всё поддерево не ставится
+    if (m_branch) {
+        load();
+        return;
+    }
+
+    // watch ставится до чтения: всё, что изменится потом, придёт событием
+    DirectoryWatcher::instance()->watch(m_path);
+
+    DirectoryListing cached;
+    if (DirectoryCache::instance()->acquire(m_path, cached, m_cacheToken)) {
+        m_listing = std::move(cached);
+        return;
+    }
+
+    if (snapshot) {
+        // снимок прошлой сессии виден сразу, свежий листинг читается
+        // рядом и потом сверяется с ним
+        m_listing.reset(m_path);
+        m_listing.append(*snapshot);
+        m_reconciling = true;
+    }
+    load();
+}
+
+void DirectoryState::close()
+{
+    m_closed = true;
+    registry(m_branch).remove(m_path);
+
+    // текущее чтение бросится после текущей порции (или после возврата
+    // зависшего вызова) — ждать его не нужно
+    ++*m_generation;
+    m_stallTimer.stop();
+    m_statBusy = false;
+    disconnect(IoPool::instance(), nullptr, this, nullptr);
+    disconnect(DirectoryWatcher::instance(), nullptr, this, nullptr);
+    if (m_branch)
+        return;
+
+    // недочитанный листинг в кэш не кладём; дочитанный уносит с собой
+    // и уже сделанные ленивые stat
+    DirectoryCache::instance()->release(m_path, m_loading ? nullptr : &m_listing, m_cacheToken);
+    DirectoryWatcher::instance()->unwatch(m_path);
+}
+
+void DirectoryState::reload()
+{
+    if (m_closed)
+        return;
+
+    m_reconciling = false;
+    m_fresh.clear();
+    m_pendingNames.clear();
+    // листинг читается после watch заново: события до этого момента в нём уже учтены
+    if (!m_branch)
+        m_cacheToken = DirectoryCache::instance()->token(m_path);
+    load();
+    emit reset();
+}
+
+void DirectoryState::load()
+{
+    BELKIN_TRACE_SCOPE("state.load");
+
+    // новое поколение: всё, что ещё читается, отбрасывается
+    const quint64 generation = ++*m_generation;
+    m_stallTimer.stop();
+    m_waitingForMount = false;
+    m_waitingForSlot = false;
+
+    // stat прежнего листинга больше не нужны (ответы отсеет поколение)
+    IoPool *io = IoPool::instance();
+    m_statAsync = io->isRemote(m_path) || !io->isResponsive(m_path);
+    m_statBusy = false;
+    m_statPending.clear();
+    m_statQueue.clear();
+
+    m_byName.clear();
+    m_byNameReady = false;
+
+    if (m_reconciling)
+        m_fresh.reset(m_path);
+    else
+        m_listing.reset(m_path, m_branch);
+    m_loading = true;
+
+    const IoPool::StartResult started = io->start(m_path, [loader = m_loader, generation,
+                                                           path = m_path, branch = m_branch]() {
+        if (branch)
+            loader->loadBranch(generation, path);
+        else
+            loader->load(generation, path, false);
+    }, &m_loadJob);
+    if (started == IoPool::StartResult::Busy) {
+        // ресурс жив, но занят: чтение начнётся, когда освободится место
+        // (onSlotFreed); до тех пор каталог числится читающимся
+        m_waitingForSlot = true;
+        return;
+    }
+    if (started == IoPool::StartResult::NotResponding) {
+        // ресурс не отвечает: каталог пуст, пока зависшие вызовы не
+        // вернутся (onResponsivenessChanged перечитает его)
+        qDebug() << "Cannot list directory:" << m_path;
+        m_listing.reset(m_path, m_branch);
+        m_reconciling = false;
+        m_fresh.clear();
+        m_loading = false;
+        m_waitingForMount = true;
+        return;
+    }
+    m_stallTimer.start();
+}
+
+void DirectoryState::onBatchReady(quint64 generation, const DirectoryListing &batch)
+{
+    if (generation != *m_generation)
+        return;
+    m_stallTimer.stop();
+
+    if (m_reconciling) {
+        m_fresh.append(batch);
+        return;
+    }
+
+    const int first = m_listing.count();
+    m_listing.append(batch);
+    emit entriesAppended(first, batch.count());
+}
+
+void DirectoryState::onBranchBatchReady(quint64 generation, const BranchBatchPtr &batch)
+{
+    if (generation != *m_generation)
+        return;
+    m_stallTimer.stop();
+
+    // номера подкаталогов у обхода и у листинга совпадают: объявления
+    // приходят подряд и раньше своих файлов
+    for (const BranchWalker::Subdir &subdir : batch->subdirs) {
+        const int dir = m_listing.appendSubdir(int(subdir.parent), subdir.name);
+        Q_ASSERT(dir == int(subdir.id));
+        Q_UNUSED(dir);
+    }
+
+    const int first = m_listing.count();
+    m_listing.appendIn(batch->files, batch->dirOf);
+    if (batch->files.count() > 0)
+        emit entriesAppended(first, batch->files.count());
+}
+
+void DirectoryState::onLoadFinished(quint64 generation, bool ok)
+{
+    if (generation != *m_generation)
+        return;
+    m_stallTimer.stop();
+    if (ok)
+        m_waitingForMount = false;
+
+    if (m_reconciling) {
+        reconcile(ok);
+        return;
+    }
+
+    m_loading = false;
+    if (!ok)
+        qDebug() << "Cannot list directory:" << m_path;
+
+    // события, пришедшие во время чтения: записи могли попасть в листинг
+    // как до, так и после изменения — перепроверяем их
+    if (!m_pendingNames.isEmpty()) {
+        const QStringList names(m_pendingNames.cbegin(), m_pendingNames.cend());
+        m_pendingNames.clear();
+        applyChanges(names);
+    }
+    emit loadFinished(ok);
+}
+
+void DirectoryState::reconcile(bool ok)
+{
+    BELKIN_TRACE_SCOPE("state.reconcile");
+
+    m_reconciling = false;
+    m_loading = false;
+    DirectoryListing fresh = std::move(m_fresh);
+    m_fresh.clear();
+
+    if (!ok) {
+        // каталога больше нет (или он недоступен) — снимок показывать нельзя
+        qDebug() << "Cannot list directory:" << m_path;
+        m_listing.reset(m_path);
+        m_pendingNames.clear();
+        emit reset();
+        emit loadFinished(false);
+        return;
+    }
+
+    // разница по именам и типам; она применяется как обычные изменения
+    // каталога — строками, с сохранением выделения и прокрутки
+    QHash<QByteArrayView, bool> freshNames;
+    freshNames.reserve(fresh.count());
+    for (int i = 0; i < fresh.count(); ++i)
+        freshNames.insert(fresh.nameUtf8(i), fresh.isDir(i));
+
+    QSet<QByteArrayView> known;
+    for (int i = 0; i < m_listing.count(); ++i) {
+        if (m_listing.isRemoved(i))
+            continue;
+        const QByteArrayView name = m_listing.nameUtf8(i);
+        known.insert(name);
+        auto it = freshNames.constFind(name);
+        if (it == freshNames.cend() || *it != m_listing.isDir(i))
+            m_pendingNames.insert(QString::fromUtf8(name));
+    }
+    for (auto it = freshNames.cbegin(); it != freshNames.cend(); ++it) {
+        if (!known.contains(it.key()))
+            m_pendingNames.insert(QString::fromUtf8(it.key()));
+    }
+    if (!m_pendingNames.isEmpty()) {
+        const QStringList names(m_pendingNames.cbegin(), m_pendingNames.cend());
+        m_pendingNames.clear();
+        applyChanges(names);
+    }
+
+    // размеры и даты в снимке могли устареть — перечитаются лениво, а
+    // пересортировка по loadFinished заодно обновит ключи по размеру/дате
+    for (int i = 0; i < m_listing.count(); ++i) {
+        if (!m_listing.isRemoved(i))
+            m_listing.resetStat(i);
+    }
+    emit loadFinished(true);
+}
+
+void DirectoryState::onDirectoryChanged(const QString &path, const QStringList &names, bool rescan)
+{
+    if (path != m_path)
+        return;
+
+    if (rescan) {
+        // событий слишком много или они потеряны — перечитываем целиком
+        reload();
+        return;
+    }
+
+    if (m_loading) {
+        for (const QString &name : names)
+            m_pendingNames.insert(name);
+        return;
+    }
+
+    applyChanges(names);
+
+    // листинг совпадает с диском на момент последнего события — его снова
+    // можно отдать в кэш при уходе из каталога
+    m_cacheToken = DirectoryCache::instance()->token(m_path);
+}
+
+void DirectoryState::updateNames(const QStringList &names)
+{
+    if (m_loading) {
+        for (const QString &name : names)
+            m_pendingNames.insert(name);
+        return;
+    }
+    applyChanges(names);
+}
+
+int DirectoryState::find(QByteArrayView name)
+{
+    if (!m_byNameReady) {
+        BELKIN_TRACE_SCOPE("state.indexNames");
+        m_byName.resize(m_listing.count());
+        for (int i = 0; i < m_listing.count(); ++i)
+            m_byName[i] = i;
+        std::sort(m_byName.begin(), m_byName.end(), ByName{&m_listing});
+        m_byNameReady = true;
+    }
+
+    const auto range = std::equal_range(m_byName.begin(), m_byName.end(), name,
+                                        ByName{&m_listing});
+    int found = -1;
+    for (auto it = range.first; it != range.second; ++it) {
+        if (m_listing.isRemoved(*it))
+            continue;
+        if (m_listing.isDir(*it))
+            return *it;
+        found = *it;
+    }
+    return found;
+}
+
+void DirectoryState::indexName(int entry)
+{
+    if (!m_byNameReady)
+        return;
+    m_byName.insert(std::upper_bound(m_byName.begin(), m_byName.end(), entry,
+                                     ByName{&m_listing}), entry);
+}
+
+void DirectoryState::applyChanges(const QStringList &names)
+{
+    BELKIN_TRACE_SCOPE("state.applyChanges");
+
+    // скрытые файлы панель не показывает
+    QStringList visible;
+    for (const QString &name : names) {
+        if (!name.isEmpty() && !name.startsWith('.'))
+            visible << name;
+    }
+    if (visible.isEmpty())
+        return;
+
+    // проверка имён — одним вызовом в IoPool: ресурс может не ответить
+    const QString root = m_path;
+    const std::optional<QList<NameState>> states = IoPool::instance()->call<QList<NameState>>(
+        root, [root, visible]() {
+            QList<NameState> result;
+            result.reserve(visible.size());
+            for (const QString &name : visible) {
+                const QFileInfo fi(root + '/' + name);
+                NameState state;
+                state.exists = fi.exists() || fi.isSymLink();
+                state.dir = state.exists && fi.isDir();
+                result << state;
+            }
+            return result;
+        });
+    if (!states) {
+        // каталог перечитается целиком, когда ресурс снова ответит
+        m_waitingForMount = true;
+        return;
+    }
+
+    DirectoryChanges changes;
+    for (qsizetype i = 0; i < visible.size(); ++i) {
+        const QByteArray utf8 = visible[i].toUtf8();
+        const bool exists = states->at(i).exists;
+        const bool dir = states->at(i).dir;
+
+        int e = find(utf8);
+        if (e >= 0) {
+            if (exists && m_listing.isDir(e) == dir) {
+                // изменился сам файл: метаданные перечитаются лениво
+                m_listing.resetStat(e);
+                changes.modified << e;
+                continue;
+            }
+            m_listing.markRemoved(e);
+            changes.removed << e;
+        }
+
+        if (!exists)
+            continue;
+
+        e = m_listing.appendName(utf8, dir);
+        indexName(e);
+        changes.added << e;
+    }
+
+    if (!changes.isEmpty())
+        emit entriesChanged(changes);
+}
+
+// stat записи для data(): на локальной ФС сразу, на сетевой и FUSE (или
+// не отвечающей) — в очередь на пачку в IoPool; строка дорисуется по ответу
+bool DirectoryState::statEntry(int entry)
+{
+    if (m_listing.isStated(entry))
+        return true;
+    if (m_listing.statFailed(entry))
+        return false;
+    if (!m_statAsync)
+        return m_listing.ensureStat(entry);
+
+    if (!m_statPending.contains(entry)) {
+        m_statPending.insert(entry);
+        m_statQueue.push_back(entry);
+        if (!m_statFlushQueued) {
+            m_statFlushQueued = true;
+            QMetaObject::invokeMethod(this, &DirectoryState::flushStats, Qt::QueuedConnection);
+        }
+    }
+    return false;
+}
+
+void DirectoryState::flushStats()
+{
+    m_statFlushQueued = false;
+    // одна пачка за раз: следующая соберётся из того, что накопится
+    if (m_closed || m_statBusy || m_statQueue.empty())
+        return;
+
+    QList<EntryStat> entries;
+    entries.reserve(qsizetype(m_statQueue.size()));
+    for (int e : m_statQueue) {
+        EntryStat stat;
+        stat.entry = e;
+        stat.path = m_listing.encodedFilePath(e);
+        entries << stat;
+    }
+    m_statQueue.clear();
+
+    IoPool::JobId job = 0;
+    const IoPool::StartResult started = IoPool::instance()->start(m_path,
+        [loader = m_loader, generation = m_generation->load(), entries]() {
+            loader->stat(generation, entries);
+        }, &job);
+    if (started == IoPool::StartResult::Busy) {
+        // ресурс занят — пачка уйдёт, когда освободится место (onSlotFreed)
+        for (const EntryStat &stat : entries)
+            m_statQueue.push_back(stat.entry);
+        return;
+    }
+    // не отвечает — записи остаются в m_statPending и перезапрашиваются,
+    // когда он вернётся
+    if (started != IoPool::StartResult::Started)
+        return;
+    m_statBusy = true;
+
+    // пачка stat, не вернувшаяся за LoadStallMs, — признак зависшего ресурса
+    const quint64 batch = ++m_statBatch;
+    QTimer::singleShot(LoadStallMs, this, [this, batch, job]() {
+        if (m_statBusy && batch == m_statBatch)
+            IoPool::instance()->reportHang(m_path, job);
+    });
+}
+
+void DirectoryState::onStatReady(quint64 generation, const QList<EntryStat> &entries)
+{
+    if (generation != *m_generation)
+        return;
+
+    m_statBusy = false;
+    for (const EntryStat &stat : entries) {
+        m_statPending.remove(stat.entry);
+        if (stat.entry < m_listing.count() && !m_listing.isStated(stat.entry))
+            m_listing.setStat(stat.entry, stat.ok, stat.size, stat.mtime, stat.mode);
+    }
+    emit statsUpdated();
+    if (!m_statQueue.empty())
+        flushStats();
+}
+
+void DirectoryState::onSlotFreed(const QString &mountPoint)
+{
+    if (IoPool::instance()->mountPointOf(m_path) != mountPoint)
+        return;
+    if (m_waitingForSlot)
+        load();
+    else if (!m_statQueue.empty())
+        flushStats();
+}
+
+void DirectoryState::onResponsivenessChanged(const QString &mountPoint, bool responsive)
+{
+    IoPool *io = IoPool::instance();
+    if (io->mountPointOf(m_path) != mountPoint)
+        return;
+
+    if (!responsive) {
+        // дальше — ни одного stat в GUI-потоке
+        m_statAsync = true;
+        return;
+    }
+
+    if (m_waitingForMount) {
+        reload();
+        return;
+    }
+
+    // отклонённые пулом stat запрашиваются заново при перерисовке
+    m_statAsync = io->isRemote(m_path);
+    m_statBusy = false;
+    m_statPending.clear();
+    m_statQueue.clear();
+    emit statsUpdated();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "DirectoryListing.h"
+#include "DirectoryLoader.h"
+#include "IoPool.h"
+
+// Записи листинга, затронутые одним применением изменений каталога
+struct DirectoryChanges {
+    QList<int> removed;     // помечены удалёнными (данные записи ещё читаются)
+    QList<int> added;       // дописаны в конец листинга
+    QList<int> modified;    // stat сброшен, запись перечитается лениво
+
+    bool isEmpty() const { return removed.isEmpty() && added.isEmpty() && modified.isEmpty(); }
+};
+
+// Общее для всех панелей (и будущих вкладок) состояние одного каталога:
+// листинг, его чтение в IoPool, watch, изменения из DirectoryWatcher и
+// пачки stat для сетевых ресурсов. Две панели на одном каталоге делят
+// один листинг, одно чтение и один watch — память и дескрипторы inotify
+// растут с числом разных каталогов, а не представлений.
+// Модели подписываются на сигналы и держат только своё: порядок
+// сортировки, фильтр и строки.
+// Используется только из GUI-потока.
+class DirectoryState : public QObject
+{
+    Q_OBJECT
+
+public:
+    // состояние каталога path (cleanPath); пока его держит хоть одна
+    // модель, повторный acquire возвращает тот же объект. Новое состояние
+    // берётся из DirectoryCache, иначе из snapshot (показывается сразу,
+    // каталог сверяется с диском в фоне), иначе читается с диска.
+    // С последней ссылкой листинг уходит в DirectoryCache.
+    static std::shared_ptr<DirectoryState> acquire(const QString &path,
+                                                   const DirectoryListing *snapshot = nullptr);
+    // ветка path: все файлы поддерева (BranchWalker), тоже общая для панелей.
+    // Без watch и кэша — снимок на момент обхода, reload обходит заново
+    static std::shared_ptr<DirectoryState> acquireBranch(const QString &path);
+    // сколько каталогов открыто сейчас (для отладки)
+    static int openCount();
+
+    QString path() const { return m_path; }
+    bool isBranch() const { return m_branch; }
+    DirectoryListing &listing() { return m_listing; }
+
+    // каталог ещё читается (или сверяется со снимком)
+    bool isLoading() const { return m_loading; }
+    // показан снимок: записи уже упорядочимы, но диск ещё не прочитан
+    bool isReconciling() const { return m_reconciling; }
+    // stat только пачками в IoPool: сетевой ресурс или не отвечающий
+    bool statAsync() const { return m_statAsync; }
+
+    // перечитать каталог мимо кэша (явное обновление, потеря событий)
+    void reload();
+    // записи names изменились (операция над файлами): проверить и применить
+    void updateNames(const QStringList &names);
+
+    // stat записи: на локальной ФС сразу, иначе — в очередь на пачку;
+    // по ответу придёт statsUpdated
+    bool statEntry(int entry);
+
+signals:
+    // листинг заменён целиком (начато чтение, сверка не удалась)
+    void reset();
+    // при чтении дописаны записи [first, first + count)
+    void entriesAppended(int first, int count);
+    void loadFinished(bool ok);
+    void entriesChanged(const DirectoryChanges &changes);
+    // пришли stat из IoPool
+    void statsUpdated();
+
+private slots:
+    void onBatchReady(quint64 generation, const DirectoryListing &batch);
+    void onBranchBatchReady(quint64 generation, const BranchBatchPtr &batch);
+    void onLoadFinished(quint64 generation, bool ok);
+    void onStatReady(quint64 generation, const QList<EntryStat> &entries);
+    void onResponsivenessChanged(const QString &mountPoint, bool responsive);
+    void onSlotFreed(const QString &mountPoint);
+    void onDirectoryChanged(const QString &path, const QStringList &names, bool rescan);
+
+private:
+    DirectoryState(const QString &path, bool branch);
+
+    static std::shared_ptr<DirectoryState> open(const QString &path, bool branch,
+                                                const DirectoryListing *snapshot);
+    void start(const DirectoryListing *snapshot);
+    void close();
+    void load();
+    void reconcile(bool ok);
+    void applyChanges(const QStringList &names);
+    void flushStats();
+    // неудалённая запись с таким именем (каталог — первым) или -1
+    int find(QByteArrayView name);
+    void indexName(int entry);
+
+    QString m_path;
+    bool m_branch = false;
+    DirectoryListing m_listing;
+    bool m_loading = false;
+    bool m_closed = false;
+
+    // фоновое чтение: поколение меняется на каждое перечитывание
+    std::shared_ptr<std::atomic<quint64>> m_generation;
+    std::shared_ptr<DirectoryLoader> m_loader;
+    QTimer m_stallTimer;             // каталог долго не отдаёт ни одной записи
+    IoPool::JobId m_loadJob = 0;     // задача чтения, о зависании которой сообщает m_stallTimer
+    bool m_waitingForMount = false;  // ресурс не ответил — перечитать, когда оживёт
+    bool m_waitingForSlot = false;   // ресурс занят — начать чтение, когда освободится место
+
+    // показан снимок: свежий листинг читается в m_fresh и сверяется с ним
+    bool m_reconciling = false;
+    DirectoryListing m_fresh;
+
+    // каталог взят в DirectoryCache; token — актуальность листинга для release
+    quint64 m_cacheToken = 0;
+
+    // изменения, пришедшие во время чтения, применяются после него
+    QSet<QString> m_pendingNames;
+
+    // записи, упорядоченные по байтам имени, — поиск для applyChanges;
+    // строится при первом изменении и дальше только дополняется
+    std::vector<int> m_byName;
+    bool m_byNameReady = false;
+
+    bool m_statAsync = false;
+    bool m_statBusy = false;
+    bool m_statFlushQueued = false;
+    quint64 m_statBatch = 0;
+    QSet<int> m_statPending;
+    std::vector<int> m_statQueue;
+};
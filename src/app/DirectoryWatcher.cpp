@@ -0,0 +1,198 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QDebug>
+#include "DirectoryWatcher.h"
+#include "Trace.h"
+
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// окно склейки событий: сборка, пишущая тысячи файлов в секунду,
+// даёт не больше 10 обновлений модели в секунду
+constexpr int CoalesceMs = 100;
+// больше имён за окно — дешевле перечитать каталог целиком
+constexpr int MaxNamesPerFlush = 4096;
+
+#ifdef Q_OS_LINUX
+// всё, что меняет содержимое каталога или метаданные его файлов
+constexpr quint32 WatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                            | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE
+                            | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+} // namespace
+
+DirectoryWatcher *DirectoryWatcher::instance()
+{
+    static DirectoryWatcher *watcher = new DirectoryWatcher(QCoreApplication::instance());
+    return watcher;
+}
+
+DirectoryWatcher::DirectoryWatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(CoalesceMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &DirectoryWatcher::flush);
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qDebug() << "inotify unavailable, live directory updates disabled";
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DirectoryWatcher::readEvents);
+#endif
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0)
+        ::close(m_fd);   // все watch снимаются вместе с fd
+#endif
+}
+
+bool DirectoryWatcher::watch(const QString &path)
+{
+    if (!isEnabled())
+        return false;
+
+    Watch &w = m_watches[path];
+    ++w.refs;
+
+#ifdef Q_OS_LINUX
+    if (w.wd < 0) {
+        w.wd = inotify_add_watch(m_fd, QFile::encodeName(path).constData(), WatchMask);
+        if (w.wd >= 0) {
+            QStringList &paths = m_pathsByWd[w.wd];
+            if (!paths.contains(path))
+                paths.append(path);
+        }
+    }
+#endif
+    return w.wd >= 0;
+}
+
+void DirectoryWatcher::unwatch(const QString &path)
+{
+    auto it = m_watches.find(path);
+    if (it == m_watches.end())
+        return;
+
+    if (--it->refs > 0)
+        return;
+
+#ifdef Q_OS_LINUX
+    if (it->wd >= 0) {
+        // тот же inode может смотреть и другой путь — тогда watch остаётся
+        auto paths = m_pathsByWd.find(it->wd);
+        if (paths != m_pathsByWd.end()) {
+            paths->removeAll(path);
+            if (paths->isEmpty()) {
+                m_pathsByWd.erase(paths);
+                inotify_rm_watch(m_fd, it->wd);
+            }
+        }
+    }
+#endif
+    m_watches.erase(it);
+    m_pending.remove(path);
+}
+
+bool DirectoryWatcher::isWatched(const QString &path) const
+{
+    auto it = m_watches.constFind(path);
+    return it != m_watches.cend() && it->wd >= 0;
+}
+
+void DirectoryWatcher::touch(const QString &path, const QString &name, bool rescan)
+{
+    Pending &p = m_pending[path];
+    if (rescan || p.names.size() >= MaxNamesPerFlush) {
+        p.rescan = true;
+        p.names.clear();
+    } else if (!p.rescan && !name.isEmpty()) {
+        p.names.insert(name);
+    }
+
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void DirectoryWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    BELKIN_TRACE_SCOPE("watcher.read");
+
+    alignas(inotify_event) char buf[16 * 1024];
+    QSet<QString> touched;
+
+    for (;;) {
+        const ssize_t n = ::read(m_fd, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+
+        for (ssize_t pos = 0; pos < n;) {
+            const auto *ev = reinterpret_cast<const inotify_event *>(buf + pos);
+            pos += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // события потеряны — перечитываем всё, что смотрим
+                for (auto it = m_watches.cbegin(); it != m_watches.cend(); ++it) {
+                    touch(it.key(), QString(), true);
+                    touched.insert(it.key());
+                }
+                continue;
+            }
+
+            const QStringList paths = m_pathsByWd.value(ev->wd);
+            if (paths.isEmpty())
+                continue;
+
+            if (ev->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // каталог удалён/перемещён — watch больше не действителен
+                // ни для одного из путей, ссылки остаются до unwatch
+                if (!(ev->mask & IN_IGNORED))
+                    inotify_rm_watch(m_fd, ev->wd);
+                m_pathsByWd.remove(ev->wd);
+                for (const QString &path : paths) {
+                    auto it = m_watches.find(path);
+                    if (it != m_watches.end())
+                        it->wd = -1;
+                    touched.insert(path);
+                    touch(path, QString(), true);
+                }
+                continue;
+            }
+
+            const QString name = ev->len ? QFile::decodeName(ev->name) : QString();
+            for (const QString &path : paths) {
+                touched.insert(path);
+                touch(path, name, false);
+            }
+        }
+    }
+
+    for (const QString &path : std::as_const(touched))
+        emit directoryTouched(path);
+#endif
+}
+
+void DirectoryWatcher::flush()
+{
+    BELKIN_TRACE_SCOPE("watcher.flush");
+
+    const QHash<QString, Pending> pending = std::exchange(m_pending, {});
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it)
+        emit directoryChanged(it.key(), QStringList(it->names.cbegin(), it->names.cend()),
+                              it->rescan);
+}
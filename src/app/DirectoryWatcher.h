@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QSocketNotifier;
+
+// Общий inotify для панелей и кэша листингов.
+// watch/unwatch считают ссылки, поэтому один каталог может смотреть
+// и панель, и кэш. События читаются сразу (directoryTouched — для
+// инвалидации кэша), а имена изменённых файлов копятся и отдаются
+// пачкой не чаще раза в CoalesceMs (directoryChanged — для модели).
+class DirectoryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DirectoryWatcher *instance();
+
+    bool isEnabled() const { return m_fd >= 0; }
+
+    bool watch(const QString &path);
+    void unwatch(const QString &path);
+    bool isWatched(const QString &path) const;
+
+signals:
+    void directoryTouched(const QString &path);
+    // names — изменившиеся записи каталога; rescan — событий слишком много
+    // или они потеряны, каталог надо перечитать целиком
+    void directoryChanged(const QString &path, const QStringList &names, bool rescan);
+
+private slots:
+    void readEvents();
+    void flush();
+
+private:
+    explicit DirectoryWatcher(QObject *parent = nullptr);
+    ~DirectoryWatcher() override;
+
+    struct Watch {
+        int wd = -1;
+        int refs = 0;
+    };
+
+    struct Pending {
+        QSet<QString> names;
+        bool rescan = false;
+    };
+
+    void touch(const QString &path, const QString &name, bool rescan);
+
+    QHash<QString, Watch>   m_watches;
+    // один wd на несколько путей: ссылка и её цель, bind-монтирование —
+    // inotify отдаёт тот же wd на тот же inode; снимается с последним путём
+    QHash<int, QStringList> m_pathsByWd;
+    QHash<QString, Pending> m_pending;
+    QTimer                  m_flushTimer;
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+};
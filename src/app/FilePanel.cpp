@@ -4,22 +4,33 @@
 #include <QFileInfo>
 #include <QMenu>
 #include <QKeyEvent>
+#include <QLocale>
 #include <QDropEvent>
 #include <QMimeData>
+#include <QScrollBar>
+#include <QSettings>
 #include <QSignalBlocker>
+#include <algorithm>
 #include "FilePanel.h"
 #include "FileView.hpp"
+#include "DirectoryModel.h"
+#include "FolderSizeService.h"
+#include "ThumbnailService.h"
+#include "MountRegistry.h"
+#include "IoPool.h"
+#include "Trace.h"
 
 FilePanel::FilePanel(QWidget *parent)
     : QWidget(parent)
-    , m_model(new QFileSystemModel(this))
+    , m_model(new DirectoryModel(this))
     , m_view(new FileView(this))
     , m_pathLabel(new QLabel(this))
     , m_upButton(new QPushButton("⬆ Up", this))
     , m_driveBox(new QComboBox(this))
+    , m_freeLabel(new QLabel(this))
+    , m_filterEdit(new QLineEdit(this))
 {
-    // Настройка модели и представления
-    m_model->setRootPath(QDir::rootPath());
+    // Настройка модели и представления (каталог задаёт setPath)
     m_view->setModel(m_model);
     m_view->setRootIsDecorated(false);
     m_view->setSelectionMode(QAbstractItemView::ExtendedSelection);
@@ -28,6 +39,9 @@ FilePanel::FilePanel(QWidget *parent)
     m_view->setContextMenuPolicy(Qt::CustomContextMenu);
     m_view->setItemsExpandable(false);
     m_view->setExpandsOnDoubleClick(false);
+    // сортировку по колонкам делает сама модель (ключи один раз на листинг)
+    m_view->setSortingEnabled(true);
+    m_view->sortByColumn(DirectoryModel::NameColumn, Qt::AscendingOrder);
     
 //Drag&Drop
     m_view->setDragEnabled(true);
@@ -38,11 +52,22 @@ FilePanel::FilePanel(QWidget *parent)
     m_view->setDefaultDropAction(Qt::IgnoreAction);
     // Перехватываем события 
     m_view->viewport()->installEventFilter(this);
+    // Space QTreeView забирает себе — перехватываем до него
+    m_view->installEventFilter(this);
 
-    // если есть хотя бы одна строка – запомним её как стартовую
-    QModelIndex first = m_model->index(0, 0, m_view->rootIndex());
-    if (first.isValid())
-        m_lastIndex = first;
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    m_autoFolderSizes = settings.value("Panels/AutoFolderSizes", false).toBool();
+
+    // каталог читается пачками: первая пришедшая строка становится стартовой
+    connect(m_model, &QAbstractItemModel::rowsInserted,
+            this, [this]() {
+                if (!m_lastIndex.isValid())
+                    m_lastIndex = m_model->index(0, 0);
+            });
+    connect(m_model, &PanelModel::directoryLoaded,
+            this, &FilePanel::onDirectoryLoaded);
+    connect(m_view->verticalScrollBar(), &QScrollBar::rangeChanged,
+            this, &FilePanel::applyPendingScroll);
 
     // следим за текущей строкой
     connect(m_view->selectionModel(), &QItemSelectionModel::currentChanged,
@@ -60,17 +85,53 @@ FilePanel::FilePanel(QWidget *parent)
     auto *topLayout = new QHBoxLayout;
     topLayout->addWidget(m_upButton);
     topLayout->addWidget(m_driveBox);
-    topLayout->addWidget(m_pathLabel);
+    topLayout->addWidget(m_pathLabel, 1);
+    topLayout->addWidget(m_freeLabel);
 
     auto *mainLayout = new QVBoxLayout(this);
     mainLayout->addLayout(topLayout);
     mainLayout->addWidget(m_view);
+    mainLayout->addWidget(m_filterEdit);
     setLayout(mainLayout);
 
+    // типы файлов и миниатюры готовятся в фоне для видимых строк и запаса вокруг
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &FilePanel::prefetchVisible);
+    connect(m_model, &PanelModel::directoryLoaded,
+            this, &FilePanel::prefetchVisible);
+    connect(m_model, &QAbstractItemModel::layoutChanged,
+            this, &FilePanel::prefetchVisible);
+
+    m_listIconSize = m_view->iconSize();
+    if (settings.value("Panels/Thumbnails", false).toBool())
+        setThumbnailMode(true);
+
+    // Быстрый фильтр: набор текста в списке сразу сужает его
+    m_filterEdit->setPlaceholderText(tr("Filter (* and ? for wildcards)"));
+    m_filterEdit->setClearButtonEnabled(true);
+    m_filterEdit->hide();
+    m_filterEdit->installEventFilter(this);
+    connect(m_filterEdit, &QLineEdit::textChanged,
+            m_model, &DirectoryModel::setNameFilter);
+    // в другом каталоге прежний фильтр не нужен
+    connect(m_model, &PanelModel::rootPathChanged,
+            this, &FilePanel::closeQuickFilter);
+
     // Сигналы-слоты
     connect(m_upButton, &QPushButton::clicked,       this, &FilePanel::onUpClicked);
     connect(m_driveBox, &QComboBox::currentTextChanged,
             this, &FilePanel::onDriveChanged);
+    // носители подключают и отключают на ходу
+    connect(MountRegistry::instance(), &MountRegistry::mountsChanged,
+            this, [this]() {
+                populateDriveBox();
+                updateDriveBoxSelection();
+            });
+    connect(MountRegistry::instance(), &MountRegistry::spaceUpdated,
+            this, &FilePanel::updateFreeSpace);
+    // ресурс панели перестал отвечать или ожил — пометка в строке пути
+    connect(IoPool::instance(), &IoPool::responsivenessChanged,
+            this, &FilePanel::updatePathLabel);
     connect(m_view, &QTreeView::doubleClicked,
             this, &FilePanel::onItemActivated);
 
@@ -80,8 +141,16 @@ FilePanel::FilePanel(QWidget *parent)
         });
 }
 
+PanelModel *FilePanel::model() const
+{
+    return m_model;
+}
+
 void FilePanel::populateDriveBox()
 {
+    BELKIN_TRACE_SCOPE("panel.populateDriveBox");
+    // перезаполнение при смене таблицы монтирования не должно уводить панель
+    QSignalBlocker blocker(m_driveBox);
     m_driveBox->clear();
 #ifdef Q_OS_WIN
     const auto& drives = QDir::drives();
@@ -92,13 +161,18 @@ void FilePanel::populateDriveBox()
     m_driveBox->addItem("/");
     m_driveBox->addItem(QDir::homePath());
 
-    QDir media("/media");
-    for (const QString &entry : media.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
-        m_driveBox->addItem("/media/" + entry);
-
-    QDir mnt("/mnt");
-    for (const QString &entry : mnt.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
-        m_driveBox->addItem("/mnt/" + entry);
+    // настоящие носители из /proc/self/mountinfo (без proc, tmpfs и т.п.)
+    QList<MountInfo> mounts = MountRegistry::instance()->mounts();
+    std::sort(mounts.begin(), mounts.end(), [](const MountInfo &a, const MountInfo &b) {
+        return a.mountPoint < b.mountPoint;
+    });
+    for (const MountInfo &m : std::as_const(mounts)) {
+        if (!m.storage || m_driveBox->findText(m.mountPoint) >= 0)
+            continue;
+        m_driveBox->addItem(m.mountPoint);
+        m_driveBox->setItemData(m_driveBox->count() - 1,
+                                QString("%1 (%2)").arg(m.source, m.fsType), Qt::ToolTipRole);
+    }
 #endif
 }
 
@@ -108,15 +182,14 @@ void FilePanel::updateDriveBoxSelection()
     QString root = QFileInfo(m_currentPath).absolutePath().left(3);
 #else
     QString root = "/";
-
-    if (m_currentPath.startsWith("/media/"))
-        root = m_currentPath.section('/', 0, 2); // "/media/user"
-
-    else if (m_currentPath.startsWith("/mnt/"))
-        root = m_currentPath.section('/', 0, 2); // "/mnt/disk"
-
-    else if (m_currentPath.startsWith(QDir::homePath()))
-        root = QDir::homePath();
+    MountInfo mount;
+    if (MountRegistry::instance()->mountFor(m_currentPath, mount))
+        root = mount.mountPoint;
+
+    // домашний каталог — отдельный пункт, если он глубже точки монтирования
+    const QString home = QDir::homePath();
+    if ((m_currentPath == home || m_currentPath.startsWith(home + '/')) && home.size() > root.size())
+        root = home;
 #endif
 
     int idx = m_driveBox->findText(root);
@@ -124,16 +197,52 @@ void FilePanel::updateDriveBoxSelection()
         QSignalBlocker blocker(m_driveBox);
         m_driveBox->setCurrentIndex(idx);
     }
+    updateFreeSpace();
 }
 
+void FilePanel::updateFreeSpace()
+{
+    // statvfs делает MountRegistry в фоне; здесь только готовые цифры
+    MountInfo mount;
+    if (!MountRegistry::instance()->mountFor(m_currentPath, mount) || mount.bytesTotal < 0) {
+        m_freeLabel->clear();
+        return;
+    }
+    const QLocale locale = QLocale::system();
+    m_freeLabel->setText(tr("%1 of %2 free")
+                         .arg(locale.formattedDataSize(mount.bytesAvailable),
+                              locale.formattedDataSize(mount.bytesTotal)));
+    m_freeLabel->setToolTip(QString("%1 (%2)").arg(mount.source, mount.fsType));
+}
+
+
+void FilePanel::updatePathLabel()
+{
+    // каталог не отвечающего ресурса показывается пустым — объясняем почему
+    if (!m_currentPath.isEmpty() && !IoPool::instance()->isResponsive(m_currentPath)) {
+        m_pathLabel->setText(tr("%1 (not responding)").arg(m_currentPath));
+        m_pathLabel->setToolTip(tr("The file system does not respond; the panel "
+                                   "will reload when it comes back"));
+        return;
+    }
+    if (m_model->isBranchView()) {
+        m_pathLabel->setText(tr("%1 (branch)").arg(m_currentPath));
+        m_pathLabel->setToolTip(tr("All files under this folder; Ctrl+B to leave"));
+        return;
+    }
+    m_pathLabel->setText(m_currentPath);
+    m_pathLabel->setToolTip(QString());
+}
 
 void FilePanel::onUpClicked()
 {
-    QDir dir(m_currentPath);
-    if (dir.cdUp()) {
-        m_currentPath = dir.absolutePath();
-        m_view->setRootIndex(m_model->index(m_currentPath));
-        m_pathLabel->setText(m_currentPath);
+    // родитель вычисляется по строке: QDir::cdUp делает stat, а ресурс
+    // может не отвечать
+    const QString parent = QDir::cleanPath(m_currentPath + QLatin1String("/.."));
+    if (parent != m_currentPath) {
+        m_currentPath = parent;
+        m_model->setRootPath(m_currentPath);
+        updatePathLabel();
         updateDriveBoxSelection();
         emit pathChanged(m_currentPath);
     }
@@ -143,19 +252,20 @@ void FilePanel::onDriveChanged(const QString &drive)
 {
     m_currentPath = drive;
     qDebug()<<m_currentPath;
-    m_view->setRootIndex(m_model->index(drive));
-    m_pathLabel->setText(drive);
+    m_model->setRootPath(drive);
+    updatePathLabel();
     updateDriveBoxSelection();
     emit pathChanged(drive);
 }
 
 void FilePanel::onItemActivated(const QModelIndex &idx)
 {
-    QString path = m_model->fileInfo(idx).absoluteFilePath();
-    if (QFileInfo(path).isDir()) {
+    BELKIN_TRACE_SCOPE("panel.itemActivated");
+    if (m_model->isDir(idx)) {
+        QString path = m_model->filePath(idx);
         m_currentPath = path;
-        m_view->setRootIndex(m_model->index(path));
-        m_pathLabel->setText(path);
+        m_model->setRootPath(path);
+        updatePathLabel();
         updateDriveBoxSelection();
         emit pathChanged(path);
     }
@@ -207,6 +317,56 @@ void FilePanel::keyPressEvent(QKeyEvent *event)
 
 bool FilePanel::eventFilter(QObject *obj, QEvent *event)
 {
+    if (obj == m_view && event->type() == QEvent::KeyPress) {
+        auto *ke = static_cast<QKeyEvent *>(event);
+        if (ke->key() == Qt::Key_Space && ke->modifiers() == Qt::NoModifier) {
+            calculateFolderSizes();
+            return true;
+        }
+        if (ke->key() == Qt::Key_F && ke->modifiers() == Qt::ControlModifier) {
+            openQuickFilter();
+            return true;
+        }
+        if (ke->key() == Qt::Key_T && ke->modifiers() == Qt::ControlModifier) {
+            setThumbnailMode(!thumbnailMode());
+            return true;
+        }
+        if (ke->key() == Qt::Key_B && ke->modifiers() == Qt::ControlModifier) {
+            setBranchView(!branchView());
+            return true;
+        }
+        // печатный символ без Ctrl/Alt — начало быстрого фильтра
+        // (вместо keyboardSearch QTreeView)
+        const QString text = ke->text();
+        if (!text.isEmpty() && text.at(0).isPrint()
+            && !(ke->modifiers() & (Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier))) {
+            openQuickFilter(text);
+            return true;
+        }
+        return false;
+    }
+    if (obj == m_filterEdit && event->type() == QEvent::KeyPress) {
+        auto *ke = static_cast<QKeyEvent *>(event);
+        switch (ke->key()) {
+        case Qt::Key_Escape:
+            closeQuickFilter();
+            return true;
+        case Qt::Key_Down:
+        case Qt::Key_Up:
+        case Qt::Key_PageDown:
+        case Qt::Key_PageUp:
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            // к списку: фильтр остаётся, курсор — на первой подходящей строке
+            m_view->setFocus();
+            if (!m_view->currentIndex().isValid() && m_model->rowCount() > 0)
+                m_view->setCurrentIndex(m_model->index(0, 0));
+            if (ke->key() == Qt::Key_Return || ke->key() == Qt::Key_Enter)
+                onItemActivated(m_view->currentIndex());
+            return true;
+        }
+        return false;
+    }
     if (obj == m_view->viewport() && event->type() == QEvent::MouseButtonPress) {
 
         QMouseEvent *me = static_cast<QMouseEvent*>(event);
@@ -240,7 +400,7 @@ bool FilePanel::eventFilter(QObject *obj, QEvent *event)
             QStringList paths;
             for (const QUrl &url : e->mimeData()->urls())
                 paths << url.toLocalFile();
-            QString dstDir = m_model->filePath(m_view->rootIndex());
+            QString dstDir = m_model->rootPath();
             emit copyDropped(paths, dstDir);
             e->acceptProposedAction();
             return true;
@@ -252,70 +412,244 @@ bool FilePanel::eventFilter(QObject *obj, QEvent *event)
 
 void FilePanel::setPath(const QString &path)
 {
-    if (!QFileInfo(path).exists())
+    BELKIN_TRACE_SCOPE("panel.setPath");
+    // проверка — в IoPool с таймаутом; не дождались — всё равно переходим:
+    // модель покажет каталог пустым и перечитает, когда ресурс оживёт
+    const std::optional<bool> exists = IoPool::instance()->call<bool>(
+        path, [path]() { return QFileInfo::exists(path); });
+    if (exists && !*exists)
         return;
 
     m_currentPath = path;
-    m_view->setRootIndex(m_model->index(path));
-    m_pathLabel->setText(path);
+    m_pendingSelection.clear();
+    m_pendingScroll = -1;
+    m_model->setRootPath(path);
+    updatePathLabel();
     updateDriveBoxSelection();
 
-    // обновляем lastIndex — ставим первую строку
-    QModelIndex first = m_model->index(0, 0, m_view->rootIndex());
-    if (first.isValid())
-        m_lastIndex = first;
+    // lastIndex выставится по первой пришедшей пачке строк
+    m_lastIndex = m_model->index(0, 0);
 }
 
 void FilePanel::refresh()
 {
-    // Сбрасываем lastIndex — директория могла измениться
+    BELKIN_TRACE_SCOPE("panel.refresh");
+    // Запоминаем текущий файл: после перечитывания строки могли сдвинуться
+    const QString current = m_model->filePath(m_view->currentIndex());
     m_lastIndex = QPersistentModelIndex();
 
-    // Перечитываем директорию
-    QModelIndex idx = m_model->index(m_currentPath);
-    m_view->setRootIndex(idx);
+    // Перечитываем директорию; текущую строку вернём, когда каталог дочитается
+    m_model->refresh();
     updateDriveBoxSelection();
+
+    m_pendingSelection = current;
+    m_pendingSelect = false;
+}
+
+void FilePanel::calculateFolderSizes()
+{
+    BELKIN_TRACE_SCOPE("panel.folderSizes");
+
+    QModelIndexList rows = m_view->selectionModel()->selectedRows();
+    if (rows.isEmpty() && m_view->currentIndex().isValid())
+        rows << m_view->currentIndex();
+
+    // явный запрос всегда пересчитывает: изменения глубоко в поддереве
+    // не меняют ни mtime каталога, ни события на его watch
+    for (const QModelIndex &idx : std::as_const(rows)) {
+        if (m_model->isDir(idx))
+            FolderSizeService::instance()->request(m_model->filePath(idx), true);
+    }
+    m_view->viewport()->update();
+}
+
+void FilePanel::prefetchVisible()
+{
+    const QRect area = m_view->viewport()->rect();
+    const int first = std::max(0, m_view->indexAt(area.topLeft()).row());
+    const QModelIndex bottom = m_view->indexAt(QPoint(0, area.bottom()));
+    const int last = bottom.isValid() ? bottom.row() : m_model->rowCount() - 1;
+
+    // запас — по экрану вверх и два вниз: обычно листают вниз
+    const int page = std::max(1, last - first + 1);
+    m_model->prefetchTypes(first - page, last + 2 * page);
+    m_model->prefetchThumbnails(first, last, first - page, last + 2 * page);
+}
+
+bool FilePanel::branchView() const
+{
+    return m_model->isBranchView();
+}
+
+void FilePanel::setBranchView(bool enabled)
+{
+    BELKIN_TRACE_SCOPE("panel.branchView");
+    m_pendingSelection.clear();
+    m_pendingScroll = -1;
+    m_model->setBranchView(enabled);
+    updatePathLabel();
+    m_lastIndex = m_model->index(0, 0);
+}
+
+bool FilePanel::thumbnailMode() const
+{
+    return m_model->thumbnailsEnabled();
+}
+
+void FilePanel::setThumbnailMode(bool enabled)
+{
+    // остаётся тот же список с колонками, только строки под размер миниатюры
+    m_model->setThumbnailsEnabled(enabled);
+    m_view->setIconSize(enabled ? QSize(ThumbnailService::Size, ThumbnailService::Size)
+                                : m_listIconSize);
+    // строки одной высоты: прокрутка не меряет каждую строку
+    m_view->setUniformRowHeights(true);
+
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    settings.setValue("Panels/Thumbnails", enabled);
+
+    prefetchVisible();
+}
+
+void FilePanel::openQuickFilter(const QString &text)
+{
+    m_filterEdit->show();
+    m_filterEdit->setFocus();
+    if (!text.isEmpty())
+        m_filterEdit->insert(text);
+}
+
+void FilePanel::closeQuickFilter()
+{
+    const bool hadFocus = m_filterEdit->hasFocus();
+    m_filterEdit->clear();
+    m_filterEdit->hide();
+    if (hadFocus)
+        m_view->setFocus();
+}
+
+void FilePanel::onDirectoryLoaded(const QString &path)
+{
+    if (m_autoFolderSizes) {
+        // из кэша придут сразу, остальные встанут в очередь
+        for (int row = 0; row < m_model->rowCount(); ++row) {
+            const QModelIndex idx = m_model->index(row, 0);
+            if (!m_model->isDir(idx))
+                break;   // каталоги идут первыми
+            FolderSizeService::instance()->request(m_model->filePath(idx));
+        }
+    }
+
+    if (!m_pendingSelection.isEmpty()
+        && QDir::cleanPath(QFileInfo(m_pendingSelection).absolutePath()) == QDir::cleanPath(path)) {
+        const QModelIndex idx = m_model->indexOf(m_pendingSelection);
+        if (idx.isValid())
+            applySelection(idx, m_pendingSelect);
+        m_pendingSelection.clear();
+    }
+
+    // прокрутка из снимка сессии — после курсора, чтобы scrollTo её не сдвинул
+    applyPendingScroll();
+}
+
+void FilePanel::applyPendingScroll()
+{
+    // до показа окна диапазона прокрутки ещё нет — ждём rangeChanged
+    QScrollBar *bar = m_view->verticalScrollBar();
+    if (m_pendingScroll < 0 || m_model->rowCount() == 0 || bar->maximum() < m_pendingScroll)
+        return;
+    bar->setValue(m_pendingScroll);
+    m_pendingScroll = -1;
+}
+
+PanelSnapshot FilePanel::snapshot() const
+{
+    PanelSnapshot s;
+    if (!m_model->snapshot(s.listing))
+        return s;
+    s.scroll = m_view->verticalScrollBar()->value();
+    s.currentName = m_model->fileName(m_view->currentIndex());
+    return s;
+}
+
+void FilePanel::restoreSnapshot(const PanelSnapshot &snapshot)
+{
+    BELKIN_TRACE_SCOPE("panel.restoreSnapshot");
+
+    // без stat каталога: он может быть на медленном диске, а снимок
+    // нужен как раз для того, чтобы его не ждать
+    m_currentPath = QDir::cleanPath(snapshot.listing.path());
+    m_pendingSelection = snapshot.currentName.isEmpty()
+        ? QString() : QDir(m_currentPath).filePath(snapshot.currentName);
+    m_pendingSelect = false;
+    m_pendingScroll = snapshot.scroll;
+
+    m_model->showSnapshot(snapshot.listing);
+    updatePathLabel();
+    updateDriveBoxSelection();
+    if (!m_lastIndex.isValid())
+        m_lastIndex = m_model->index(0, 0);
+}
+
+void FilePanel::applySelection(const QModelIndex &idx, bool select)
+{
+    // Нормализуем к колонке 0
+    const QModelIndex index = idx.sibling(idx.row(), 0);
+
+    if (select) {
+        // Выделяем файл
+        m_view->setCurrentIndex(index);
+        if (auto *sel = m_view->selectionModel()) {
+            sel->setCurrentIndex(
+                index,
+                QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows
+            );
+        }
+        // Скроллим к файлу
+        m_view->scrollTo(index, QAbstractItemView::PositionAtCenter);
+    } else {
+        // после refresh только возвращаем курсор, не трогая выделение
+        if (auto *sel = m_view->selectionModel())
+            sel->setCurrentIndex(index, QItemSelectionModel::NoUpdate);
+        m_view->scrollTo(index);
+    }
+
+    // Обновляем lastIndex
+    m_lastIndex = index;
 }
 
 bool FilePanel::selectFile(const QString& filePath)
 {
+    BELKIN_TRACE_SCOPE("panel.selectFile");
     if (!m_model || !m_view)
         return false;
 
-    QFileInfo info(filePath);
-    if (!info.exists())
+    // не дождались ответа ресурса — считаем, что файла нет
+    const std::optional<bool> exists = IoPool::instance()->call<bool>(
+        filePath, [filePath]() { return QFileInfo::exists(filePath); });
+    if (!exists || !*exists)
         return false;
 
-    const QString dir = info.absolutePath();
+    const QString dir = QFileInfo(filePath).absolutePath();
 
     // Если мы не в нужной папке — переходим
     if (m_currentPath != dir) {
         setPath(dir);  // твой метод, который меняет rootIndex
     }
 
-    // Теперь получаем индекс файла уже в текущем rootIndex
-    QModelIndex index = m_model->index(filePath);
-    if (!index.isValid())
+    // Теперь получаем индекс файла уже в текущем каталоге
+    QModelIndex index = m_model->indexOf(filePath);
+    if (!index.isValid()) {
+        // каталог ещё читается — выделим файл, когда он дочитается
+        if (m_model->isLoading()) {
+            m_pendingSelection = filePath;
+            m_pendingSelect = true;
+            return true;
+        }
         return false;
-
-    // Нормализуем к колонке 0
-    index = index.sibling(index.row(), 0);
-
-    // Выделяем файл
-    m_view->setCurrentIndex(index);
-    if (auto *sel = m_view->selectionModel()) {
-        sel->setCurrentIndex(
-            index,
-            QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows
-        );
     }
 
-    // Скроллим к файлу
-    m_view->scrollTo(index, QAbstractItemView::PositionAtCenter);
-
-    // Обновляем lastIndex
-    m_lastIndex = index;
-
+    applySelection(index, true);
     return true;
 }
 
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <QWidget>
-#include <QFileSystemModel>
 #include <QLabel>
 #include <QPushButton>
 #include <QComboBox>
+#include <QLineEdit>
 #include <QPersistentModelIndex>
+#include "SessionSnapshot.h"
 class QTreeView;
+class PanelModel;
+class DirectoryModel;
 
 class FilePanel : public QWidget
 {
@@ -17,12 +20,27 @@ public:
 
     // Доступ к внутренним элементам
     QTreeView*             view() const { return m_view; }
-    QFileSystemModel*      model() const { return m_model; }
+    PanelModel*            model() const;
     QString                currentPath() const { return m_currentPath; }
     QModelIndex lastIndex()const {return m_lastIndex; }
     void setPath(const QString &path);
+    // снимок сессии: листинг, прокрутка и текущая строка
+    PanelSnapshot snapshot() const;
+    void restoreSnapshot(const PanelSnapshot &snapshot);
     void refresh();
     bool selectFile(const QString& filePath);
+    // размеры выделенных каталогов (или текущего, если выделения нет)
+    void calculateFolderSizes();
+    // быстрый фильтр под списком; text дописывается к текущему шаблону
+    void openQuickFilter(const QString &text = QString());
+    void closeQuickFilter();
+    // крупные строки с миниатюрами изображений вместо иконок типа
+    void setThumbnailMode(bool enabled);
+    bool thumbnailMode() const;
+    // «ветка» (Ctrl+B): все файлы под текущим каталогом одним списком;
+    // переход в другой каталог её выключает
+    void setBranchView(bool enabled);
+    bool branchView() const;
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
@@ -47,17 +65,30 @@ private slots:
     void onUpClicked();
     void onDriveChanged(const QString &drive);
     void onItemActivated(const QModelIndex &index);
+    void onDirectoryLoaded(const QString &path);
 
 private:
     void populateDriveBox();
     void updateDriveBoxSelection();
+    void updateFreeSpace();
+    void updatePathLabel();
+    void applySelection(const QModelIndex &index, bool select);
+    void prefetchVisible();
+    void applyPendingScroll();
 
-    QFileSystemModel *m_model;
+    DirectoryModel   *m_model;
     QTreeView        *m_view;
     QLabel           *m_pathLabel;
     QPushButton      *m_upButton;
     QComboBox        *m_driveBox;
+    QLabel           *m_freeLabel;
+    QLineEdit        *m_filterEdit;
     QString           m_currentPath;
     QPersistentModelIndex     m_lastIndex;
+    QString           m_pendingSelection;   // выделить после directoryLoaded
+    bool              m_pendingSelect = false;
+    int               m_pendingScroll = -1;       // из снимка сессии, после directoryLoaded
+    bool              m_autoFolderSizes = false;  // считать размеры всех каталогов
+    QSize             m_listIconSize;             // размер иконок вне режима миниатюр
 
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <QCoreApplication>
+#include <QMimeDatabase>
+#include "FileTypeResolver.h"
+#include "Trace.h"
+
+namespace {
+
+// пачка результатов: перерисовка не чаще, чем раз в столько мс
+constexpr int NotifyDelayMs = 30;
+// файлов, определённых по содержимому, больше не помним
+constexpr int MaxPathEntries = 100000;
+
+} // namespace
+
+FileTypeResolver *FileTypeResolver::instance()
+{
+    static FileTypeResolver *resolver = new FileTypeResolver(QCoreApplication::instance());
+    return resolver;
+}
+
+FileTypeResolver::FileTypeResolver(QObject *parent)
+    : QObject(parent)
+{
+    // чтение содержимого упирается в диск, а не в CPU
+    m_pool.setMaxThreadCount(2);
+    m_pool.setObjectName("file types");
+
+    m_notifyTimer.setSingleShot(true);
+    m_notifyTimer.setInterval(NotifyDelayMs);
+    connect(&m_notifyTimer, &QTimer::timeout, this, &FileTypeResolver::typesResolved);
+}
+
+FileTypeResolver::~FileTypeResolver()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString FileTypeResolver::suffixOf(const QString &fileName)
+{
+    // как QFileInfo::suffix(), но без QFileInfo на каждую строку
+    const qsizetype dot = fileName.lastIndexOf(QLatin1Char('.'));
+    return dot >= 0 ? fileName.mid(dot + 1) : QString();
+}
+
+const FileTypeResolver::Type *FileTypeResolver::typeFor(const QString &mimeName) const
+{
+    auto it = m_types.find(mimeName);
+    if (it == m_types.end()) {
+        // один раз на MIME-тип: поиск по имени в базе дешёвый, иконка грузится лениво
+        const QMimeType mime = QMimeDatabase().mimeTypeForName(mimeName);
+        Type type;
+        type.name = mimeName;
+        type.comment = mime.comment();
+        type.icon = QIcon::fromTheme(mime.iconName(), QIcon::fromTheme(mime.genericIconName()));
+        it = m_types.insert(mimeName, type);
+    }
+    return &*it;
+}
+
+bool FileTypeResolver::lookup(const QString &filePath, const QString &suffix, Type &out) const
+{
+    const QString ext = suffix.toLower();
+    if (!ext.isEmpty()) {
+        auto it = m_bySuffix.constFind(ext);
+        if (it != m_bySuffix.cend() && !it->isEmpty()) {
+            out = *typeFor(*it);
+            return true;
+        }
+    }
+
+    auto it = m_byPath.constFind(filePath);
+    if (it == m_byPath.cend())
+        return false;
+    out = *typeFor(*it);
+    return true;
+}
+
+void FileTypeResolver::request(const QString &filePath, const QString &suffix)
+{
+    const QString ext = suffix.toLower();
+
+    if (!ext.isEmpty()) {
+        auto it = m_bySuffix.constFind(ext);
+        if (it == m_bySuffix.cend()) {
+            // сначала расширение: без чтения файла и сразу для всех таких файлов
+            const QString key = QStringLiteral("s:") + ext;
+            if (m_pending.contains(key))
+                return;
+            m_pending.insert(key);
+
+            m_pool.start([this, ext]() {
+                BELKIN_TRACE_SCOPE("types.bySuffix");
+                const QMimeType mime = QMimeDatabase().mimeTypeForFile(
+                    QStringLiteral("x.") + ext, QMimeDatabase::MatchExtension);
+                const QString name = mime.isDefault() ? QString() : mime.name();
+                QMetaObject::invokeMethod(this, [this, ext, name]() {
+                    onResolved(ext, true, name);
+                }, Qt::QueuedConnection);
+            });
+            return;
+        }
+        if (!it->isEmpty())
+            return;
+    }
+
+    // расширения нет или оно неизвестно — смотрим содержимое
+    if (m_byPath.contains(filePath))
+        return;
+    const QString key = QStringLiteral("p:") + filePath;
+    if (m_pending.contains(key))
+        return;
+    m_pending.insert(key);
+
+    m_pool.start([this, filePath]() {
+        BELKIN_TRACE_SCOPE("types.byContent");
+        const QString name = QMimeDatabase().mimeTypeForFile(
+            filePath, QMimeDatabase::MatchContent).name();
+        QMetaObject::invokeMethod(this, [this, filePath, name]() {
+            onResolved(filePath, false, name);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileTypeResolver::onResolved(const QString &key, bool bySuffix, const QString &mimeName)
+{
+    if (bySuffix) {
+        m_pending.remove(QStringLiteral("s:") + key);
+        // неизвестное расширение тоже повод перерисовать: строки
+        // запросят определение по содержимому
+        m_bySuffix.insert(key, mimeName);
+    } else {
+        m_pending.remove(QStringLiteral("p:") + key);
+        if (m_byPath.size() >= MaxPathEntries)
+            m_byPath.clear();
+        m_byPath.insert(key, mimeName);
+    }
+
+    if (!m_notifyTimer.isActive())
+        m_notifyTimer.start();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QHash>
+#include <QIcon>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+
+// Тип файла (MIME) и его иконка для панелей без обращений к QMimeDatabase
+// из GUI-потока при отрисовке.
+// Определение идёт в пуле потоков: сначала по расширению (результат
+// кэшируется на расширение), для файлов без известного расширения —
+// по содержимому (кэшируется на файл). Описание и иконка берутся один раз
+// на MIME-тип. Пока тип неизвестен, панель рисует общую иконку файла;
+// готовые результаты отдаются пачкой (typesResolved), не чаще раза в ~30 мс.
+// Используется только из GUI-потока (кроме самих задач пула).
+class FileTypeResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Type {
+        QString name;       // "text/plain"
+        QString comment;    // "plain text document"
+        QIcon   icon;
+    };
+
+    static FileTypeResolver *instance();
+
+    // уже известный тип файла; false — ещё не определён (запрос не ставится)
+    bool lookup(const QString &filePath, const QString &suffix, Type &out) const;
+    // поставить определение типа в очередь, если он ещё неизвестен
+    void request(const QString &filePath, const QString &suffix);
+
+    static QString suffixOf(const QString &fileName);
+
+signals:
+    void typesResolved();
+
+private:
+    explicit FileTypeResolver(QObject *parent = nullptr);
+    ~FileTypeResolver() override;
+
+    void onResolved(const QString &key, bool bySuffix, const QString &mimeName);
+    const Type *typeFor(const QString &mimeName) const;
+
+    QThreadPool m_pool;
+    QTimer      m_notifyTimer;
+
+    QHash<QString, QString> m_bySuffix;   // расширение -> MIME; пусто — только по содержимому
+    QHash<QString, QString> m_byPath;     // файл без известного расширения -> MIME
+    QSet<QString>           m_pending;    // ключи (расширение или путь) в работе
+    mutable QHash<QString, Type> m_types; // MIME -> описание и иконка
+};
@@ -0,0 +1,176 @@
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include "FolderSizeService.h"
+#include "DirectoryWatcher.h"
+#include "Trace.h"
+
+FolderSizeService *FolderSizeService::instance()
+{
+    static FolderSizeService *service = new FolderSizeService(QCoreApplication::instance());
+    return service;
+}
+
+FolderSizeService::FolderSizeService(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<FolderSize>();
+
+    connect(DirectoryWatcher::instance(), &DirectoryWatcher::directoryTouched,
+            this, &FolderSizeService::onDirectoryTouched);
+    connect(DirectoryWatcher::instance(), &DirectoryWatcher::directoryChanged,
+            this, &FolderSizeService::onDirectoryChanged);
+}
+
+FolderSizeService::~FolderSizeService()
+{
+    m_queue.clear();
+    if (m_thread) {
+        m_cancel->store(true);
+        m_thread->wait();
+    }
+}
+
+bool FolderSizeService::lookup(const QString &path, qint64 mtime, FolderSize &out) const
+{
+    auto it = m_cache.constFind(path);
+    if (it == m_cache.cend() || it->mtime != mtime)
+        return false;
+    out = it->size;
+    return true;
+}
+
+bool FolderSizeService::isPending(const QString &path) const
+{
+    return m_active == path || m_queue.contains(path);
+}
+
+void FolderSizeService::request(const QString &path, bool force)
+{
+    const QString clean = QDir::cleanPath(path);
+
+    if (force)
+        m_cache.remove(clean);
+
+    auto it = m_cache.constFind(clean);
+    if (it != m_cache.cend()) {
+        const QFileInfo info(clean);
+        if (info.lastModified().toSecsSinceEpoch() == it->mtime) {
+            emit sizeReady(clean, it->size);
+            return;
+        }
+        m_cache.erase(it);
+    }
+
+    if (isPending(clean))
+        return;
+
+    m_queue.append(clean);
+    startNext();
+}
+
+void FolderSizeService::startNext()
+{
+    if (m_thread || m_queue.isEmpty())
+        return;
+
+    m_active = m_queue.takeFirst();
+    m_activeStale = false;
+    m_cancel = std::make_shared<std::atomic<bool>>(false);
+
+    // mtime берётся до обхода: если каталог изменится во время расчёта,
+    // результат просто не пройдёт проверку в lookup()
+    const QString path = m_active;
+    const qint64 mtime = QFileInfo(path).lastModified().toSecsSinceEpoch();
+    const std::shared_ptr<std::atomic<bool>> cancel = m_cancel;
+
+    m_thread = QThread::create([this, path, mtime, cancel]() {
+        const FolderSize size = FolderSizeCalculator::calculate(path, cancel.get());
+        QMetaObject::invokeMethod(this, [this, path, mtime, size]() {
+            onFinished(path, mtime, size);
+        }, Qt::QueuedConnection);
+    });
+    m_thread->setObjectName("folder size");
+    connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+}
+
+void FolderSizeService::onFinished(const QString &path, qint64 mtime, const FolderSize &size)
+{
+    BELKIN_TRACE_SCOPE("folderSize.finished");
+
+    m_thread = nullptr;
+    m_active.clear();
+
+    if (!size.complete) {
+        startNext();
+        return;
+    }
+
+    if (m_activeStale) {
+        // пока считали, в поддереве что-то поменялось — считаем ещё раз
+        if (!m_queue.contains(path))
+            m_queue.prepend(path);
+    } else {
+        m_cache.insert(path, { size, mtime });
+        emit sizeReady(path, size);
+    }
+
+    startNext();
+}
+
+void FolderSizeService::invalidate(const QStringList &paths)
+{
+    for (const QString &p : paths)
+        invalidatePath(QDir::cleanPath(p), true);
+}
+
+void FolderSizeService::invalidatePath(const QString &path, bool subtree)
+{
+    if (path.isEmpty())
+        return;
+
+    if (subtree) {
+        const QString prefix = path + '/';
+        for (auto it = m_cache.begin(); it != m_cache.end();) {
+            if (it.key().startsWith(prefix))
+                it = m_cache.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // размер каждого предка включает изменённый путь
+    QString p = path;
+    for (;;) {
+        m_cache.remove(p);
+        if (!m_active.isEmpty() && (m_active == p || (subtree && m_active.startsWith(p + '/'))))
+            m_activeStale = true;
+
+        const QString parent = QFileInfo(p).path();
+        if (parent == p || parent.isEmpty() || parent == QLatin1String("."))
+            break;
+        p = parent;
+    }
+}
+
+void FolderSizeService::onDirectoryTouched(const QString &path)
+{
+    // сам каталог и все его предки
+    invalidatePath(QDir::cleanPath(path), false);
+}
+
+void FolderSizeService::onDirectoryChanged(const QString &path, const QStringList &names,
+                                           bool rescan)
+{
+    const QString clean = QDir::cleanPath(path);
+    if (rescan) {
+        invalidatePath(clean, true);
+        return;
+    }
+    // изменившиеся записи могут быть каталогами со своим кэшем
+    for (const QString &name : names)
+        invalidatePath(clean + '/' + name, true);
+}
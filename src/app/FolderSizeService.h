@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include "FolderSize.h"
+
+class QThread;
+
+// Размеры каталогов для панелей: очередь расчётов (по одному каталогу за раз,
+// сам обход параллельный — FolderSizeCalculator) и кэш результатов.
+// Результат действителен, пока не изменилось mtime каталога и не пришло
+// событие от DirectoryWatcher/операций с файлами в нём или в его
+// поддереве. Изменения глубже показываемых каталогов inotify не видит,
+// поэтому явный запрос (Space) всегда считает заново.
+// Используется только из GUI-потока.
+class FolderSizeService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FolderSizeService *instance();
+
+    // закэшированный размер; mtime — время изменения каталога в секундах
+    bool lookup(const QString &path, qint64 mtime, FolderSize &out) const;
+
+    // поставить каталог в очередь; force — не смотреть в кэш
+    void request(const QString &path, bool force = false);
+    bool isPending(const QString &path) const;
+
+    // сбросить результаты для путей, их поддеревьев и всех предков
+    void invalidate(const QStringList &paths);
+
+signals:
+    void sizeReady(const QString &path, const FolderSize &size);
+
+private slots:
+    void onDirectoryTouched(const QString &path);
+    void onDirectoryChanged(const QString &path, const QStringList &names, bool rescan);
+
+private:
+    explicit FolderSizeService(QObject *parent = nullptr);
+    ~FolderSizeService() override;
+
+    struct Entry {
+        FolderSize size;
+        qint64 mtime = 0;
+    };
+
+    void startNext();
+    void onFinished(const QString &path, qint64 mtime, const FolderSize &size);
+    void invalidatePath(const QString &path, bool subtree);
+
+    QHash<QString, Entry> m_cache;
+    QStringList m_queue;
+
+    QString  m_active;
+    bool     m_activeStale = false;     // инвалидирован во время расчёта
+    QThread *m_thread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+};
@@ -13,10 +13,24 @@
 #include <QResource>
 #include <QSettings>
 #include <QTreeView>
+#include <QMenuBar>
+#include <QFileDialog>
+#include <QBuffer>
+#include <QTimer>
+#include <QSet>
 #include "MainWindow.h"
 #include "FilePanel.h"
+#include "PanelModel.h"
+#include "DirectoryCache.h"
+#include "DirectoryWatcher.h"
+#include "FileIndex.h"
+#include "FolderSizeService.h"
+#include "IoPool.h"
 #include "FilePluginInterface.h"
 #include "FileOperations.h"
+#include "SessionSnapshot.h"
+#include "StartupProfiler.h"
+#include "Trace.h"
 
 
 MainWindow::MainWindow(QWidget *parent)
@@ -25,27 +39,74 @@ MainWindow::MainWindow(QWidget *parent)
     , rightPanel(nullptr)
     , currentActiveView(nullptr)
 {
+    StartupProfiler *startup = StartupProfiler::instance();
+    startup->watchWindow(this);
 
-    createPluginToolbar();
-    setupUi();
-    loadPlugins();
-
+    {
+        StartupProfiler::Phase phase("startup.setupUi");
+        createPluginToolbar();
+        setupUi();
+        createDiagnosticsMenu();
+        createIndexMenu();
+    }
+    {
+        StartupProfiler::Phase phase("startup.loadPlugins");
+        loadPlugins();
+    }
 
+    // запуск закончен, когда обе панели показали свои каталоги
+    startup->setExpectedPanels(2);
+    for (FilePanel *panel : { leftPanel, rightPanel })
+        connect(panel->model(), &PanelModel::directoryLoaded,
+                startup, &StartupProfiler::panelPopulated, Qt::SingleShotConnection);
 
     QSettings settings("BelkinSoft", "BelkinCommander");
+    QString leftPath;
+    QString rightPath;
+    {
+        StartupProfiler::Phase phase("startup.settings");
+
+        // бюджет памяти кэша листингов, общий для обеих панелей
+        DirectoryCache::instance()->setBudget(
+            settings.value("Cache/DirectoryBudgetMB", 64).toLongLong() * 1024 * 1024);
 
-    QString leftPath  = settings.value("Panels/LeftPath",  QDir::homePath()).toString();
-    QString rightPath = settings.value("Panels/RightPath", QDir::homePath()).toString();
+        leftPath  = settings.value("Panels/LeftPath",  QDir::homePath()).toString();
+        rightPath = settings.value("Panels/RightPath", QDir::homePath()).toString();
+    }
+
+    // снимок прошлой сессии: панели показывают его сразу, каталоги
+    // перечитываются в фоне
+    QList<PanelSnapshot> snapshots;
+    if (settings.value("Session/Snapshot", true).toBool()) {
+        StartupProfiler::Phase phase("startup.loadSnapshot");
+        snapshots = SessionSnapshot::load();
+    }
+    auto restorePanel = [&snapshots](FilePanel *panel, int i, const QString &path) {
+        if (i < snapshots.size() && snapshots[i].isValid()
+            && QDir::cleanPath(snapshots[i].listing.path()) == QDir::cleanPath(path))
+            panel->restoreSnapshot(snapshots[i]);
+        else
+            panel->setPath(path);
+    };
 
     // восстановить пути
-    leftPanel->setPath(leftPath);
-    rightPanel->setPath(rightPath);
-    //Restore geometry
-    if (settings.contains("MainWindow/geometry"))
-        restoreGeometry(settings.value("MainWindow/geometry").toByteArray());
+    {
+        StartupProfiler::Phase phase("startup.leftPanel.setPath");
+        restorePanel(leftPanel, 0, leftPath);
+    }
+    {
+        StartupProfiler::Phase phase("startup.rightPanel.setPath");
+        restorePanel(rightPanel, 1, rightPath);
+    }
+    {
+        StartupProfiler::Phase phase("startup.restoreState");
+        //Restore geometry
+        if (settings.contains("MainWindow/geometry"))
+            restoreGeometry(settings.value("MainWindow/geometry").toByteArray());
 
-    if (settings.contains("MainWindow/state"))
-        restoreState(settings.value("MainWindow/state").toByteArray());
+        if (settings.contains("MainWindow/state"))
+            restoreState(settings.value("MainWindow/state").toByteArray());
+    }
 
     // По умолчанию – левая панель
     currentActiveView = leftPanel->view();
@@ -70,7 +131,7 @@ QString MainWindow::currentFilePath() const {
         return {}; // ничего не выбрано — вернём пустую строку
 
     QModelIndex idx = selection.first();
-    return static_cast<QFileSystemModel*>(view->model())->filePath(idx);
+    return qobject_cast<PanelModel*>(view->model())->filePath(idx);
 }
 
 
@@ -93,6 +154,8 @@ void MainWindow::addDockWidgetForPlugin(FilePluginInterface *plugin, QWidget *wi
     dock->setWidget(widget); // dock владеет widget'ом
 
         addDockWidget(Qt::RightDockWidgetArea, dock);
+        // док создаётся позже restoreState(): вернуть его на сохранённое место
+        restoreDockWidget(dock);
         m_pluginDocks.insert(plugin, dock);
     }
 }
@@ -149,6 +212,9 @@ void MainWindow::connectSignals()
 
     connect(copySignals(), &CopySignals::copyFinished,
          this,      &MainWindow::onCopyFinished);
+
+    connect(copySignals(), &CopySignals::pathsChanged,
+         this,      &MainWindow::onPathsChanged);
     
     connect(leftPanel,  &FilePanel::copyDropped,
             this,       &MainWindow::onCopyDropped);
@@ -183,6 +249,7 @@ void MainWindow::connectSignals()
 
 void MainWindow::loadPlugins()
 {
+    BELKIN_TRACE_SCOPE("plugins.scan");
     QDir pluginsDir(qApp->applicationDirPath() + "/plugins");
     const QStringList files = pluginsDir.entryList(QDir::Files);
     QStringList allowedExtensions = { ".dll", ".so", ".dylib" };
@@ -193,69 +260,134 @@ void MainWindow::loadPlugins()
         if (!allowedExtensions.contains(ext))
             continue;
 
-        QString path = pluginsDir.absoluteFilePath(fileName);
-        QPluginLoader *loader = new QPluginLoader(path, this);
-        QObject *obj = loader->instance();
-        if (!obj) {
-            qDebug() << "Failed to load plugin:" << fileName << loader->errorString();
-            delete loader;
+        // описание — из кэша или metaData(); сама библиотека не грузится
+        PluginSlot slot;
+        slot.meta = m_pluginCache.describe(QFileInfo(pluginsDir.absoluteFilePath(fileName)));
+        if (!slot.meta.plugin)
             continue;
-        }
+        m_pluginSlots.append(slot);
+        const int index = m_pluginSlots.size() - 1;
 
-        FilePluginInterface *iface = qobject_cast<FilePluginInterface*>(obj);
-        if (!iface) {
-            delete loader;
+        // без имени и флагов в метаданных кнопку не построить — загружаем
+        // сейчас, со следующего запуска описание будет в кэше
+        if (!slot.meta.complete && !ensurePlugin(index)) {
+            m_pluginSlots.removeLast();
             continue;
         }
 
-        // важно: сначала дать API, чтобы createWidget() мог им пользоваться
-        iface->setApplicationAPI(this);
-        iface->initialize();
+        if (!m_pluginSlots[index].meta.background)
+            addPluginAction(index);
+    }
+
+    m_pluginCache.save();
+}
 
+void MainWindow::addPluginAction(int index)
+{
+    const PluginCache::Entry &meta = m_pluginSlots[index].meta;
+    const QIcon icon = meta.icon();
 
-        // сохранить
-        plugins.append(iface);
-        pluginLoaders.append(loader);
+    // добавить кнопку на тулбар — при клике плагин грузится (один раз) и вызывается execute()
+    QAction *act = m_pluginToolBar->addAction(icon.isNull() ? QIcon(":/icons/default_plugin.png") : icon,
+                                              meta.name);
+    connect(act, &QAction::triggered, this, [this, index]() {
+        if (FilePluginInterface *iface = ensurePlugin(index))
+            iface->execute(selectedFiles());
+    });
+}
 
-        // создать док один раз при загрузке (если плагин этого требует)
-        if (iface->showWidget()) {
-            QWidget *w = iface->createWidget(); // должен вернуть widget с parent==nullptr
-            if (w) addDockWidgetForPlugin(iface, w, iface->name());
-        }
+FilePluginInterface *MainWindow::ensurePlugin(int index)
+{
+    PluginSlot &slot = m_pluginSlots[index];
+    if (slot.iface || slot.failed)
+        return slot.iface;
 
-        if(!iface->backgroundPlugin()){
-            // добавить кнопку на тулбар — при клике вызываем execute()
-            QAction *act = m_pluginToolBar->addAction(iface->icon().isNull() ? QIcon(":/icons/default_plugin.png") : iface->icon(), iface->name());
-            connect(act, &QAction::triggered, this, [this, iface]() {
-                QStringList paths = selectedFiles();
-                iface->execute(paths);
+    BELKIN_TRACE_SCOPE("plugins.load");
+    QPluginLoader *loader = new QPluginLoader(slot.meta.path, this);
+    QObject *obj = loader->instance();
+    FilePluginInterface *iface = qobject_cast<FilePluginInterface*>(obj);
+    if (!iface) {
+        qDebug() << "Failed to load plugin:" << slot.meta.path << loader->errorString();
+        delete loader;
+        slot.failed = true;
+        return nullptr;
+    }
 
-            });
-        }
-        else{
-            QStringList paths = selectedFiles();
-            iface->execute(paths);
-        }
+    // важно: сначала дать API, чтобы createWidget() мог им пользоваться
+    iface->setApplicationAPI(this);
+    iface->initialize();
+
+    slot.loader = loader;
+    slot.iface = iface;
+
+    // что плагин сообщил о себе — в кэш, следующий запуск обойдётся без загрузки
+    PluginCache::Entry meta = slot.meta;
+    meta.name = iface->name();
+    meta.background = iface->backgroundPlugin();
+    meta.showWidget = iface->showWidget();
+    meta.complete = true;
+    meta.iconPng.clear();
+    if (!iface->icon().isNull()) {
+        QBuffer buffer(&meta.iconPng);
+        buffer.open(QIODevice::WriteOnly);
+        iface->icon().pixmap(32, 32).save(&buffer, "PNG");
+    }
+    if (meta.name != slot.meta.name || meta.background != slot.meta.background
+        || meta.showWidget != slot.meta.showWidget || meta.iconPng != slot.meta.iconPng
+        || !slot.meta.complete) {
+        slot.meta = meta;
+        m_pluginCache.update(meta);
+        m_pluginCache.save();
+    }
 
-        qDebug() << "Loaded plugin:" << iface->name();
+    // док создаётся вместе с плагином (если плагин этого требует)
+    if (iface->showWidget()) {
+        QWidget *w = iface->createWidget(); // должен вернуть widget с parent==nullptr
+        if (w) addDockWidgetForPlugin(iface, w, iface->name());
+    }
+
+    qDebug() << "Loaded plugin:" << iface->name();
+    return iface;
+}
+
+void MainWindow::startBackgroundPlugins()
+{
+    // фоновые плагины — после первой отрисовки окна, а не до неё
+    BELKIN_TRACE_SCOPE("plugins.background");
+    for (int i = 0; i < m_pluginSlots.size(); ++i) {
+        if (!m_pluginSlots[i].meta.background)
+            continue;
+        if (FilePluginInterface *iface = ensurePlugin(i))
+            iface->execute(selectedFiles());
+    }
+}
+
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    if (!m_backgroundPluginsStarted) {
+        m_backgroundPluginsStarted = true;
+        // отрисовка уже в очереди событий, таймер сработает после неё
+        QTimer::singleShot(0, this, &MainWindow::startBackgroundPlugins);
     }
 }
 
 void MainWindow::unloadPlugins()
 {
-    for (int i = 0; i < plugins.size(); ++i) {
-        FilePluginInterface *p = plugins[i];
+    for (PluginSlot &slot : m_pluginSlots) {
+        if (!slot.iface)
+            continue;
+        FilePluginInterface *p = slot.iface;
         // удалить док, если есть
         removePluginDock(p);
         p->shutdown();
 
-        QPluginLoader *loader = pluginLoaders[i];
+        QPluginLoader *loader = slot.loader;
         qDebug() << "Unloading plugin:" << loader->fileName();
         loader->unload();
         delete loader;
     }
-    plugins.clear();
-    pluginLoaders.clear();
+    m_pluginSlots.clear();
     m_pluginDocks.clear();
 }
 
@@ -347,6 +479,84 @@ void MainWindow::createPluginToolbar()
     m_pluginToolBar = new QToolBar("Plugins", this);
 }
 
+void MainWindow::createDiagnosticsMenu()
+{
+    QMenu *diag = menuBar()->addMenu(tr("Diagnostics"));
+
+    // Запись трассы операций (Chrome trace-event / Perfetto)
+    QAction *record = diag->addAction(tr("Record trace"));
+    record->setCheckable(true);
+    record->setChecked(trace::enabled());
+    connect(record, &QAction::toggled, this, [](bool on) {
+        if (on)
+            trace::clear();
+        trace::setEnabled(on);
+    });
+
+    QAction *save = diag->addAction(tr("Save trace..."));
+    connect(save, &QAction::triggered, this, [this]() {
+        const QString path = QFileDialog::getSaveFileName(
+            this, tr("Save trace"), QDir::homePath() + "/belkin-trace.json",
+            tr("Chrome trace (*.json)"));
+        if (path.isEmpty())
+            return;
+
+        if (!trace::writeChromeTrace(path))
+            QMessageBox::warning(this, "Error", "Failed to write trace.");
+    });
+
+    diag->addSeparator();
+    QAction *startup = diag->addAction(tr("Startup timings..."));
+    connect(startup, &QAction::triggered, this, [this]() {
+        QMessageBox::information(this, tr("Startup timings"),
+                                 StartupProfiler::instance()->report());
+    });
+}
+
+void MainWindow::createIndexMenu()
+{
+    FileIndex *index = FileIndex::instance();
+    // открытые в панелях каталоги меняются — индекс узнаёт сразу, а не при обновлении
+    connect(DirectoryWatcher::instance(), &DirectoryWatcher::directoryChanged, index,
+            [index](const QString &path, const QStringList &, bool) { index->notifyChanged(path); });
+
+    QMenu *menu = menuBar()->addMenu(tr("Index"));
+
+    // индексировать ФС, на которой открыт каталог активной панели
+    QAction *volume = menu->addAction(tr("Index this volume"));
+    volume->setCheckable(true);
+    connect(menu, &QMenu::aboutToShow, this, [this, volume, index]() {
+        FilePanel *panel = findPanelFromView(currentActiveView);
+        const QString mountPoint = panel ? IoPool::instance()->mountPointOf(panel->currentPath()) : QString();
+        volume->setEnabled(!mountPoint.isEmpty());
+        volume->setData(mountPoint);
+        volume->setText(mountPoint.isEmpty() ? tr("Index this volume")
+                                             : tr("Index %1").arg(QDir::toNativeSeparators(mountPoint)));
+        volume->setChecked(!mountPoint.isEmpty() && index->isIndexed(mountPoint));
+    });
+    connect(volume, &QAction::triggered, this, [volume, index](bool on) {
+        const QString mountPoint = volume->data().toString();
+        if (!mountPoint.isEmpty())
+            index->setIndexed(mountPoint, on);
+    });
+
+    QAction *update = menu->addAction(tr("Update indexes now"));
+    connect(update, &QAction::triggered, index, [index]() { index->update(); });
+}
+
+FileIndex* MainWindow::fileIndex() const
+{
+    return FileIndex::instance();
+}
+
+DurabilityPolicy MainWindow::durabilityPolicy() const
+{
+    // Copy/Durability = none | perfile | batched
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    return DurabilityTracker::policyFromString(
+        settings.value("Copy/Durability", "none").toString());
+}
+
 void MainWindow::showDockForPlugin(FilePluginInterface *plugin)
 {
     if (!m_pluginDocks.contains(plugin)) return;
@@ -385,7 +595,7 @@ QStringList MainWindow::selectedFiles() const
     if (!view)
         return result;
 
-    auto *model = qobject_cast<QFileSystemModel*>(view->model());
+    auto *model = qobject_cast<PanelModel*>(view->model());
     if (!model)
         return result;
 
@@ -424,7 +634,7 @@ void MainWindow::showContextMenu(const QPoint &globalPos)
 void MainWindow::onDeleteRequested(bool permanent)
 {
     auto *view  = qobject_cast<QTreeView*>(activeView());
-    auto *model = qobject_cast<QFileSystemModel*>(view->model());
+    auto *model = qobject_cast<PanelModel*>(view->model());
 
     const auto sel = view->selectionModel()->selectedRows();
     if (sel.isEmpty()) {
@@ -447,15 +657,14 @@ void MainWindow::onDeleteRequested(bool permanent)
 
     //showMessage(QString("Deleted %1 items.").arg(count));
 
-    // Обновляем панель
-    QString root = model->filePath(view->rootIndex());
-    view->setRootIndex(model->index(root));
+    // Обновляем панели — только удалённые строки
+    onPathsChanged(paths);
 }
 
 void MainWindow::onRenameRequested()
 {
     auto *view  = qobject_cast<QTreeView*>(activeView());
-    auto *model = qobject_cast<QFileSystemModel*>(view->model());
+    auto *model = qobject_cast<PanelModel*>(view->model());
 
     QModelIndex idx = view->currentIndex();
     if (!idx.isValid())
@@ -484,18 +693,17 @@ void MainWindow::onRenameRequested()
         return;
     }
 
-    // обновляем панель
-    QString root = model->filePath(view->rootIndex());
-    view->setRootIndex(model->index(root));
+    // обновляем панели
+    onPathsChanged({ oldPath, newPath });
 }
 
 void MainWindow::onCreateFolderRequested()
 {
     auto *view  = qobject_cast<QTreeView*>(activeView());
-    auto *model = qobject_cast<QFileSystemModel*>(view->model());
+    auto *model = qobject_cast<PanelModel*>(view->model());
 
     // Текущая директория активной панели
-    QString root = model->filePath(view->rootIndex());
+    QString root = model->rootPath();
     if (root.isEmpty())
         return;
 
@@ -527,18 +735,10 @@ void MainWindow::onCreateFolderRequested()
         return;
     }
 
-    // Обновляем панель
-    view->setRootIndex(model->index(root));
-
-    // Выделяем созданную папку
-    QModelIndex idx = model->index(newPath);
-    if (idx.isValid()) {
-        view->selectionModel()->setCurrentIndex(
-            idx,
-            QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows
-        );
-        view->scrollTo(idx);
-    }
+    // Обновляем панели и выделяем созданную папку
+    onPathsChanged({ newPath });
+    if (auto *panel = findPanelFromView(view))
+        panel->selectFile(newPath);
     view->setFocus();
 }
 
@@ -547,8 +747,8 @@ void MainWindow::performCopyOperation()
     auto *srcView  = qobject_cast<QTreeView*>(activeView());
     auto *dstView  = qobject_cast<QTreeView*>(passiveView());
 
-    auto *srcModel = qobject_cast<QFileSystemModel*>(srcView->model());
-    auto *dstModel = qobject_cast<QFileSystemModel*>(dstView->model());
+    auto *srcModel = qobject_cast<PanelModel*>(srcView->model());
+    auto *dstModel = qobject_cast<PanelModel*>(dstView->model());
 
     const auto sel = srcView->selectionModel()->selectedRows();
     if (sel.isEmpty()) {
@@ -560,12 +760,10 @@ void MainWindow::performCopyOperation()
     for (auto idx : sel)
         files << srcModel->filePath(idx);
 
-    const QString dstDir = dstModel->filePath(dstView->rootIndex());
-
-    FileOperations::copyFilesAsync(files, dstDir, this);
+    const QString dstDir = dstModel->rootPath();
 
-    // обновить пассивную панель
-    dstView->setRootIndex(dstModel->index(dstDir));
+    // панели обновит CopySignals::pathsChanged по завершении
+    FileOperations::copyFilesAsync(files, dstDir, copySignals(), durabilityPolicy());
 }
 
 void MainWindow::onCopyFinished()
@@ -573,6 +771,21 @@ void MainWindow::onCopyFinished()
 
 }
 
+void MainWindow::onPathsChanged(const QStringList &paths)
+{
+    // точечное обновление строк: каждая модель берёт пути своего каталога
+    leftPanel->model()->updatePaths(paths);
+    rightPanel->model()->updatePaths(paths);
+    // посчитанные размеры каталогов с этими путями внутри устарели
+    FolderSizeService::instance()->invalidate(paths);
+    // каталоги, где что-то появилось или пропало, — в индекс имён
+    QSet<QString> dirs;
+    for (const QString &path : paths)
+        dirs.insert(QFileInfo(path).absolutePath());
+    for (const QString &dir : dirs)
+        FileIndex::instance()->notifyChanged(dir);
+}
+
 void MainWindow::performDeleteOperation(bool permanent)
 {
     onDeleteRequested(permanent);
@@ -615,6 +828,9 @@ void MainWindow::closeEvent(QCloseEvent *event)
     settings.setValue("Panels/LeftPath",  leftPanel->currentPath());
     settings.setValue("Panels/RightPath", rightPanel->currentPath());
 
+    if (settings.value("Session/Snapshot", true).toBool())
+        SessionSnapshot::save({ leftPanel->snapshot(), rightPanel->snapshot() });
+
     QMainWindow::closeEvent(event);
 }
 
@@ -636,11 +852,7 @@ void MainWindow::onCopyDropped(const QStringList &srcPaths, const QString &dstDi
     if (filtered.isEmpty())
         return; // нечего копировать
 
-    FileOperations::copyFilesAsync(filtered, dstDir, this);
-
-    auto *dstView  = qobject_cast<QTreeView*>(passiveView());
-    auto *dstModel = qobject_cast<QFileSystemModel*>(dstView->model());
-    dstView->setRootIndex(dstModel->index(dstDir));
+    FileOperations::copyFilesAsync(filtered, dstDir, copySignals(), durabilityPolicy());
 }
 
 void MainWindow::onCopyToBuffer()
@@ -662,22 +874,19 @@ void MainWindow::onPasteFromBuffer()
     }
 
     auto *dstView  = qobject_cast<QTreeView*>(activeView());
-    auto *dstModel = qobject_cast<QFileSystemModel*>(dstView->model());
-
-    QString dstDir = dstModel->filePath(dstView->rootIndex());
+    auto *dstModel = qobject_cast<PanelModel*>(dstView->model());
 
-    FileOperations::copyFilesAsync(m_copyBuffer, dstDir, this);
+    QString dstDir = dstModel->rootPath();
 
-    // обновить панель
-    dstView->setRootIndex(dstModel->index(dstDir));
+    FileOperations::copyFilesAsync(m_copyBuffer, dstDir, copySignals(), durabilityPolicy());
 }
 void MainWindow::performMoveOperation()
 {
     auto *srcView  = qobject_cast<QTreeView*>(activeView());
     auto *dstView  = qobject_cast<QTreeView*>(passiveView());
 
-    auto *srcModel = qobject_cast<QFileSystemModel*>(srcView->model());
-    auto *dstModel = qobject_cast<QFileSystemModel*>(dstView->model());
+    auto *srcModel = qobject_cast<PanelModel*>(srcView->model());
+    auto *dstModel = qobject_cast<PanelModel*>(dstView->model());
 
     const auto sel = srcView->selectionModel()->selectedRows();
     if (sel.isEmpty()) {
@@ -689,15 +898,11 @@ void MainWindow::performMoveOperation()
     for (auto idx : sel)
         files << srcModel->filePath(idx);
 
-    const QString dstDir = dstModel->filePath(dstView->rootIndex());
+    const QString dstDir = dstModel->rootPath();
 
     //FileOperations::moveFilesSync(files, dstDir, this);
-    FileOperations::moveFilesAsync(files, dstDir, this);
-
-
-    // обновить панели
-    srcView->setRootIndex(srcModel->index(srcModel->filePath(srcView->rootIndex())));
-    dstView->setRootIndex(dstModel->index(dstDir));
+    // обе панели обновит CopySignals::pathsChanged по завершении
+    FileOperations::moveFilesAsync(files, dstDir, copySignals(), durabilityPolicy());
 }
 void MainWindow::refreshPanelForPath(const QString &path)
 {
@@ -712,7 +917,7 @@ void MainWindow::refreshPanelForPath(const QString &path)
     if (!panel)
         return;
 
-    // Обновляем rootIndex (это заставляет модель перечитать директорию)
+    // Перечитываем каталог панели
     panel->refresh();
 }
 
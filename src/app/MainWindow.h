@@ -8,6 +8,8 @@
 #include <QStringList>
 #include "ApplicationAPI.h"
 #include "CopySignals.h"
+#include "Durability.h"
+#include "PluginCache.h"
 
 class QPushButton;
 class FilePanel;
@@ -42,15 +44,18 @@ public:
     void performMoveOperation() override;
     QWidget* mainWindow() const override { return const_cast<MainWindow*>(this); }
     void navigateToFile(const QString& path) override;
+    FileIndex* fileIndex() const override;
 
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
+    void showEvent(QShowEvent *event) override;
 
 private slots:
     void showContextMenu(const QPoint &globalPos);
     void onDeleteRequested(bool permanent);
     void onCopyFinished();
+    void onPathsChanged(const QStringList &paths);
     void onCopyDropped(const QStringList &srcPaths, const QString &dstDir);
     void onRenameRequested();
     void onCreateFolderRequested();
@@ -62,9 +67,15 @@ private slots:
     void connectSignals();
     void loadPlugins();
     void unloadPlugins();
+    void addPluginAction(int index);
+    FilePluginInterface *ensurePlugin(int index);
+    void startBackgroundPlugins();
     void setActivePanel(QWidget *panelView);
     void updateActiveStyles();
     void createPluginToolbar();
+    void createDiagnosticsMenu();
+    void createIndexMenu();
+    DurabilityPolicy durabilityPolicy() const;
     QList<QAction*> m_contextActions;
 
     FilePanel          *leftPanel;
@@ -73,8 +84,16 @@ private slots:
 
     QHBoxLayout        *m_btnLayout;
 
-    QVector<QPluginLoader*>       pluginLoaders;
-    QVector<FilePluginInterface*> plugins;
+    // плагин известен по описанию из кэша, библиотека грузится при первом использовании
+    struct PluginSlot {
+        PluginCache::Entry   meta;
+        QPluginLoader       *loader = nullptr;
+        FilePluginInterface *iface = nullptr;
+        bool                 failed = false;
+    };
+    QVector<PluginSlot> m_pluginSlots;
+    PluginCache         m_pluginCache;
+    bool                m_backgroundPluginsStarted = false;
     QToolBar *m_pluginToolBar;
     QMap<FilePluginInterface*, QDockWidget*> m_pluginDocks;
     CopySignals m_copySignals;
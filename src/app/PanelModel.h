@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QString>
+#include <QStringList>
+
+// То, что MainWindow и FilePanel знают о модели панели.
+// Модель плоская: строки — содержимое rootPath(), корневой индекс невалиден.
+class PanelModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    using QAbstractItemModel::QAbstractItemModel;
+
+    virtual QString rootPath() const = 0;
+    virtual void setRootPath(const QString &path) = 0;
+
+    // перечитать текущий каталог (после copy/move/rename/delete)
+    virtual void refresh() = 0;
+
+    // файлы изменились (операция ядра): строки текущего каталога
+    // обновляются точечно, без перечитывания
+    virtual void updatePaths(const QStringList &paths) = 0;
+
+    // каталог ещё дочитывается в фоне (строки продолжают добавляться)
+    virtual bool isLoading() const = 0;
+
+    virtual QString filePath(const QModelIndex &index) const = 0;
+    virtual QString fileName(const QModelIndex &index) const = 0;
+    virtual bool isDir(const QModelIndex &index) const = 0;
+
+    // индекс файла текущего каталога по полному пути (невалиден, если не найден)
+    virtual QModelIndex indexOf(const QString &path, int column = 0) const = 0;
+
+signals:
+    void rootPathChanged(const QString &newPath);
+    // каталог дочитан и отсортирован
+    void directoryLoaded(const QString &path);
+};
@@ -0,0 +1,150 @@
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPixmap>
+#include <QPluginLoader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "PluginCache.h"
+#include "FilePluginInterface.h"
+#include "Trace.h"
+
+namespace {
+
+// при смене формата записи старый кэш просто игнорируется
+constexpr int CacheVersion = 1;
+
+qint64 mtimeOf(const QFileInfo &file)
+{
+    return file.lastModified().toMSecsSinceEpoch();
+}
+
+} // namespace
+
+QIcon PluginCache::Entry::icon() const
+{
+    QPixmap pixmap;
+    if (iconPng.isEmpty() || !pixmap.loadFromData(iconPng, "PNG"))
+        return QIcon();
+    return QIcon(pixmap);
+}
+
+QString PluginCache::cacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+         + QStringLiteral("/plugins.json");
+}
+
+PluginCache::PluginCache()
+{
+    BELKIN_TRACE_SCOPE("plugins.readCache");
+
+    QFile file(cacheFile());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    // плагины собираются вместе с приложением — другая версия, другой кэш
+    if (root.value("version").toInt() != CacheVersion
+        || root.value("app").toString() != QCoreApplication::applicationVersion())
+        return;
+
+    for (const QJsonValue &value : root.value("plugins").toArray()) {
+        const QJsonObject o = value.toObject();
+        Entry e;
+        e.path = o.value("path").toString();
+        e.mtime = qint64(o.value("mtime").toDouble());
+        e.size = qint64(o.value("size").toDouble(-1));
+        e.plugin = o.value("plugin").toBool();
+        e.complete = o.value("complete").toBool();
+        e.name = o.value("name").toString();
+        e.background = o.value("background").toBool();
+        e.showWidget = o.value("showWidget").toBool();
+        e.iconPng = QByteArray::fromBase64(o.value("icon").toString().toLatin1());
+        if (!e.path.isEmpty())
+            m_entries.insert(e.path, e);
+    }
+}
+
+PluginCache::Entry PluginCache::describe(const QFileInfo &file)
+{
+    const QString path = file.absoluteFilePath();
+    m_seen.insert(path);
+
+    auto it = m_entries.constFind(path);
+    if (it != m_entries.cend() && it->mtime == mtimeOf(file) && it->size == file.size())
+        return *it;
+
+    BELKIN_TRACE_SCOPE("plugins.metaData");
+    Entry e;
+    e.path = path;
+    e.mtime = mtimeOf(file);
+    e.size = file.size();
+
+    // metaData() читает секцию метаданных из файла, библиотека не загружается
+    const QJsonObject meta = QPluginLoader(path).metaData();
+    e.plugin = meta.value("IID").toString() == QLatin1String(FilePluginInterface_iid);
+    const QJsonObject custom = meta.value("MetaData").toObject();
+    e.name = custom.value("name").toString();
+    e.background = custom.value("background").toBool();
+    e.showWidget = custom.value("showWidget").toBool();
+    e.complete = e.plugin && !e.name.isEmpty()
+              && custom.contains("background") && custom.contains("showWidget");
+
+    m_entries.insert(path, e);
+    m_dirty = true;
+    return e;
+}
+
+void PluginCache::update(const Entry &entry)
+{
+    m_entries.insert(entry.path, entry);
+    m_dirty = true;
+}
+
+void PluginCache::save()
+{
+    // удалённые плагины из кэша выпадают
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!m_seen.contains(it.key())) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+    if (!m_dirty)
+        return;
+
+    QJsonArray list;
+    for (const Entry &e : std::as_const(m_entries)) {
+        QJsonObject o;
+        o["path"] = e.path;
+        o["mtime"] = double(e.mtime);
+        o["size"] = double(e.size);
+        o["plugin"] = e.plugin;
+        o["complete"] = e.complete;
+        o["name"] = e.name;
+        o["background"] = e.background;
+        o["showWidget"] = e.showWidget;
+        if (!e.iconPng.isEmpty())
+            o["icon"] = QString::fromLatin1(e.iconPng.toBase64());
+        list.append(o);
+    }
+
+    QJsonObject root;
+    root["version"] = CacheVersion;
+    root["app"] = QCoreApplication::applicationVersion();
+    root["plugins"] = list;
+
+    QDir().mkpath(QFileInfo(cacheFile()).absolutePath());
+    QSaveFile file(cacheFile());
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (file.commit())
+        m_dirty = false;
+}
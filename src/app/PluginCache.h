@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFileInfo>
+#include <QHash>
+#include <QIcon>
+#include <QSet>
+#include <QString>
+
+// Кэш описаний плагинов между запусками: чтобы построить тулбар, не нужно
+// загружать ни одну библиотеку.
+// Ключ — путь, проверка актуальности — mtime и размер файла. Описание
+// берётся из QPluginLoader::metaData() (без dlopen) — из ключей MetaData
+// "name", "background", "showWidget"; чего там нет, дополняется у самого
+// плагина при первой загрузке (вместе с иконкой) и тоже кэшируется.
+class PluginCache
+{
+public:
+    struct Entry {
+        QString    path;
+        qint64     mtime = 0;
+        qint64     size = -1;
+        bool       plugin = false;      // IID совпал с FilePluginInterface
+        bool       complete = false;    // имя и флаги известны без загрузки
+        QString    name;
+        bool       background = false;
+        bool       showWidget = false;
+        QByteArray iconPng;             // иконка тулбара, снятая при загрузке
+
+        QIcon icon() const;
+    };
+
+    PluginCache();
+
+    // описание плагина: из кэша, если файл не менялся, иначе из metaData()
+    Entry describe(const QFileInfo &file);
+    // дополнить описание тем, что сообщил загруженный плагин
+    void update(const Entry &entry);
+
+    // запись на диск, только если что-то менялось
+    void save();
+
+    static QString cacheFile();
+
+private:
+    QHash<QString, Entry> m_entries;
+    QSet<QString>         m_seen;      // пути, найденные в этом запуске
+    bool m_dirty = false;
+};
@@ -0,0 +1,76 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "SessionSnapshot.h"
+#include "Trace.h"
+
+namespace {
+
+constexpr quint32 Magic = 0x42435353;   // "BCSS"
+constexpr quint32 Version = 1;
+
+} // namespace
+
+namespace SessionSnapshot {
+
+QString file()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+         + QStringLiteral("/session.bin");
+}
+
+bool save(const QList<PanelSnapshot> &panels)
+{
+    BELKIN_TRACE_SCOPE("session.save");
+
+    QDir().mkpath(QFileInfo(file()).absolutePath());
+    QSaveFile out(file());
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << Magic << Version << quint32(panels.size());
+    for (const PanelSnapshot &panel : panels) {
+        const bool withListing = panel.isValid() && panel.listing.count() <= MaxEntries;
+        stream << withListing << qint32(panel.scroll) << panel.currentName;
+        if (withListing)
+            panel.listing.save(stream);
+    }
+    return stream.status() == QDataStream::Ok && out.commit();
+}
+
+QList<PanelSnapshot> load()
+{
+    BELKIN_TRACE_SCOPE("session.load");
+
+    QFile in(file());
+    if (!in.open(QIODevice::ReadOnly))
+        return {};
+
+    QDataStream stream(&in);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, count = 0;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != Magic || version != Version)
+        return {};
+
+    QList<PanelSnapshot> panels;
+    for (quint32 i = 0; i < count && i < 16; ++i) {
+        PanelSnapshot panel;
+        bool withListing = false;
+        qint32 scroll = 0;
+        stream >> withListing >> scroll >> panel.currentName;
+        if (stream.status() != QDataStream::Ok)
+            return {};
+        if (withListing && !panel.listing.restore(stream))
+            return {};
+        panel.scroll = scroll;
+        panels << panel;
+    }
+    return panels;
+}
+
+} // namespace SessionSnapshot
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include "DirectoryListing.h"
+
+// Снимок панелей на момент закрытия окна: листинг каталога (имена, размеры,
+// mtime — то, что уже было прочитано), прокрутка и текущая строка.
+// При запуске панель показывает снимок сразу, не дожидаясь диска,
+// а настоящий каталог сверяется с ним в фоне (DirectoryModel::showSnapshot).
+// Файл — $XDG_CACHE_HOME/<приложение>/session.bin; повреждённый или другой
+// версии просто игнорируется.
+struct PanelSnapshot {
+    DirectoryListing listing;     // пустой путь — снимка нет
+    int     scroll = 0;           // значение вертикальной прокрутки
+    QString currentName;          // имя текущей строки
+
+    bool isValid() const { return !listing.path().isEmpty(); }
+};
+
+namespace SessionSnapshot {
+
+// каталоги больше этого в снимок не пишутся: их чтение из снимка само
+// стоит заметно, а панель всё равно будет читать каталог
+constexpr int MaxEntries = 200000;
+
+QString file();
+bool save(const QList<PanelSnapshot> &panels);
+QList<PanelSnapshot> load();
+
+} // namespace SessionSnapshot
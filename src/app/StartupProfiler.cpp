@@ -0,0 +1,158 @@
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFile>
+#include <QJsonArray>
+#include <QWidget>
+#include <QDebug>
+#include "StartupProfiler.h"
+#include "Trace.h"
+
+#ifdef Q_OS_LINUX
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+qint64 g_beginNs = 0;      // trace::nowNs() в begin()
+qint64 g_beforeMainNs = -1; // exec, загрузка библиотек и статические конструкторы
+
+// сколько процесс жил до main(): starttime из /proc/self/stat (в тиках от загрузки)
+qint64 processAgeNs()
+{
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/stat");
+    if (!f.open(QIODevice::ReadOnly))
+        return -1;
+    const QByteArray stat = f.readAll();
+    // имя процесса в скобках может содержать пробелы — поля считаем после ')'
+    const qsizetype paren = stat.lastIndexOf(')');
+    if (paren < 0)
+        return -1;
+    const QList<QByteArray> fields = stat.mid(paren + 2).split(' ');
+    // starttime — 22-е поле, т.е. 20-е после ')'
+    if (fields.size() < 20)
+        return -1;
+    const qint64 startTicks = fields[19].toLongLong();
+    const long hz = ::sysconf(_SC_CLK_TCK);
+
+    struct timespec now{};
+    if (hz <= 0 || ::clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+        return -1;
+    const qint64 nowNs = qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+    const qint64 age = nowNs - startTicks * (1000000000 / hz);
+    return age >= 0 ? age : -1;
+#else
+    return -1;
+#endif
+}
+
+} // namespace
+
+void StartupProfiler::begin()
+{
+    g_beginNs = trace::nowNs();
+    g_beforeMainNs = processAgeNs();
+}
+
+StartupProfiler *StartupProfiler::instance()
+{
+    static StartupProfiler *profiler = new StartupProfiler(QCoreApplication::instance());
+    return profiler;
+}
+
+StartupProfiler::StartupProfiler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StartupProfiler::Phase::Phase(const char *name)
+    : m_name(name)
+    , m_start(trace::nowNs())
+{
+}
+
+StartupProfiler::Phase::~Phase()
+{
+    const qint64 end = trace::nowNs();
+    if (trace::enabled())
+        trace::record(m_name, m_start, end - m_start);
+    StartupProfiler::instance()->addPhase(m_name, m_start - g_beginNs, end - m_start);
+}
+
+void StartupProfiler::addPhase(const char *name, qint64 startNs, qint64 durationNs)
+{
+    if (!m_reported)
+        m_phases.append({ name, startNs, durationNs });
+}
+
+void StartupProfiler::watchWindow(QWidget *window)
+{
+    window->installEventFilter(this);
+}
+
+bool StartupProfiler::eventFilter(QObject *obj, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && m_firstPaintNs < 0) {
+        m_firstPaintNs = trace::nowNs() - g_beginNs;
+        obj->removeEventFilter(this);
+        finishIfReady();
+    }
+    return QObject::eventFilter(obj, event);
+}
+
+void StartupProfiler::panelPopulated()
+{
+    if (m_populatedNs >= 0 || ++m_populatedPanels < m_expectedPanels)
+        return;
+    m_populatedNs = trace::nowNs() - g_beginNs;
+    finishIfReady();
+}
+
+void StartupProfiler::finishIfReady()
+{
+    // панели из кэша могут заполниться раньше первой отрисовки — ждём обе вехи
+    if (!isComplete() || m_reported)
+        return;
+    m_reported = true;
+    qInfo().noquote() << "startup:" << report().replace('\n', QLatin1String("; "));
+    emit completed();
+}
+
+QString StartupProfiler::report() const
+{
+    QStringList lines;
+    if (g_beforeMainNs >= 0)
+        lines << QStringLiteral("before main: %1 ms").arg(ms(g_beforeMainNs), 0, 'f', 1);
+    for (const Record &r : m_phases)
+        lines << QStringLiteral("%1: %2 ms (at %3 ms)")
+                     .arg(QLatin1String(r.name))
+                     .arg(ms(r.durationNs), 0, 'f', 1)
+                     .arg(ms(r.startNs), 0, 'f', 1);
+    if (m_firstPaintNs >= 0)
+        lines << QStringLiteral("first paint: %1 ms").arg(ms(m_firstPaintNs), 0, 'f', 1);
+    if (m_populatedNs >= 0)
+        lines << QStringLiteral("panels populated: %1 ms").arg(ms(m_populatedNs), 0, 'f', 1);
+    else
+        lines << QStringLiteral("panels populated: not yet");
+    return lines.join('\n');
+}
+
+QJsonObject StartupProfiler::toJson() const
+{
+    QJsonArray phases;
+    for (const Record &r : m_phases) {
+        QJsonObject o;
+        o["name"] = QLatin1String(r.name);
+        o["startMs"] = ms(r.startNs);
+        o["durationMs"] = ms(r.durationNs);
+        phases.append(o);
+    }
+
+    QJsonObject root;
+    root["beforeMainMs"] = g_beforeMainNs >= 0 ? ms(g_beforeMainNs) : -1.0;
+    root["firstPaintMs"] = m_firstPaintNs >= 0 ? ms(m_firstPaintNs) : -1.0;
+    root["panelsPopulatedMs"] = m_populatedNs >= 0 ? ms(m_populatedNs) : -1.0;
+    root["phases"] = phases;
+    return root;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QWidget;
+
+// Время запуска: от старта процесса до окна, которым можно пользоваться.
+// Фазы (конструирование QApplication, setupUi, загрузка плагинов, чтение
+// настроек, setPath панелей...) отмечаются StartupProfiler::Phase и заодно
+// попадают в трассу; вехи — первая отрисовка окна и заполненные панели.
+// Когда окно отрисовано и все панели заполнены, сводка пишется в лог (qInfo) и доступна
+// в меню Diagnostics; --startup-bench выводит её в JSON и завершает программу.
+class StartupProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static StartupProfiler *instance();
+
+    // начало отсчёта — первой строкой main(), до QApplication
+    static void begin();
+
+    // фаза запуска на время жизни объекта
+    class Phase
+    {
+    public:
+        explicit Phase(const char *name);
+        ~Phase();
+        Phase(const Phase &) = delete;
+        Phase &operator=(const Phase &) = delete;
+
+    private:
+        const char *m_name;
+        qint64 m_start;
+    };
+
+    // первая отрисовка window — веха firstPaint
+    void watchWindow(QWidget *window);
+    // сколько панелей должно сообщить directoryLoaded до вехи panelsPopulated
+    void setExpectedPanels(int count) { m_expectedPanels = count; }
+    void panelPopulated();
+
+    bool isComplete() const { return m_firstPaintNs >= 0 && m_populatedNs >= 0; }
+    QString report() const;
+    QJsonObject toJson() const;
+
+signals:
+    void completed();
+
+protected:
+    bool eventFilter(QObject *obj, QEvent *event) override;
+
+private:
+    explicit StartupProfiler(QObject *parent = nullptr);
+
+    struct Record {
+        const char *name;
+        qint64 startNs;      // от begin()
+        qint64 durationNs;
+    };
+
+    void addPhase(const char *name, qint64 startNs, qint64 durationNs);
+    void finishIfReady();
+    static double ms(qint64 ns) { return ns / 1e6; }
+
+    QList<Record> m_phases;
+    qint64 m_firstPaintNs = -1;    // от begin()
+    qint64 m_populatedNs = -1;
+    int m_expectedPanels = 0;
+    int m_populatedPanels = 0;
+    bool m_reported = false;
+};
@@ -0,0 +1,265 @@
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QPixmap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
+#include "ThumbnailService.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace {
+
+// готовых иконок в памяти не больше ~64 МБ пикселей
+constexpr int MemoryBudgetKb = 64 * 1024;
+
+const char *const KeyUri   = "Thumb::URI";
+const char *const KeyMTime = "Thumb::MTime";
+
+QByteArray uriOf(const QString &path)
+{
+    return QUrl::fromLocalFile(path).toEncoded();
+}
+
+QString thumbName(const QByteArray &uri)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(uri, QCryptographicHash::Md5).toHex())
+         + QStringLiteral(".png");
+}
+
+// миниатюра из кэша, если она сделана с этого же файла этой же версии
+bool readCached(const QString &file, const QByteArray &uri, qint64 mtime, QImage &out)
+{
+    if (!QFile::exists(file))
+        return false;
+    QImageReader reader(file, "png");
+    if (reader.text(QLatin1String(KeyUri)).toUtf8() != uri
+        || reader.text(QLatin1String(KeyMTime)) != QString::number(mtime))
+        return false;
+    out = reader.read();
+    return !out.isNull();
+}
+
+bool writeCached(const QString &dir, const QString &file, QImage image,
+                 const QByteArray &uri, qint64 mtime)
+{
+    // каталоги кэша и файлы в нём — только для владельца (требование спецификации)
+    if (!QDir().mkpath(dir))
+        return false;
+    QFile::setPermissions(dir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    image.setText(QLatin1String(KeyUri), QString::fromUtf8(uri));
+    image.setText(QLatin1String(KeyMTime), QString::number(mtime));
+    image.setText(QStringLiteral("Software"), QCoreApplication::applicationName());
+
+    // QSaveFile: другой процесс не увидит недописанный файл
+    QSaveFile out(file);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+    out.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+    if (!image.save(&out, "png"))
+        return false;
+    return out.commit();
+}
+
+QImage decode(const QString &path)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    // декодер сразу уменьшает (JPEG — в разы быстрее полного декодирования)
+    const QSize full = reader.size();
+    const int size = ThumbnailService::Size;
+    if (full.isValid() && (full.width() > size || full.height() > size))
+        reader.setScaledSize(full.scaled(size, size, Qt::KeepAspectRatio));
+
+    QImage image = reader.read();
+    if (!image.isNull() && (image.width() > size || image.height() > size))
+        image = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return image;
+}
+
+} // namespace
+
+ThumbnailService *ThumbnailService::instance()
+{
+    static ThumbnailService *service = new ThumbnailService(QCoreApplication::instance());
+    return service;
+}
+
+ThumbnailService::ThumbnailService(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount() - 1));
+    m_pool.setObjectName("thumbnails");
+    m_memory.setMaxCost(MemoryBudgetKb);
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    for (Job &job : m_running)
+        job.cancelled->store(true);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString ThumbnailService::cacheDir()
+{
+    // GenericCacheLocation учитывает XDG_CACHE_HOME
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+         + QStringLiteral("/thumbnails");
+}
+
+bool ThumbnailService::canThumbnail(const QString &suffix)
+{
+    static const QSet<QString> formats = []() {
+        QSet<QString> result;
+        for (const QByteArray &format : QImageReader::supportedImageFormats())
+            result.insert(QString::fromLatin1(format).toLower());
+        // у JPEG расширений несколько, а формат один
+        if (result.contains(QStringLiteral("jpeg")))
+            result.insert(QStringLiteral("jpe"));
+        return result;
+    }();
+    return !suffix.isEmpty() && formats.contains(suffix.toLower());
+}
+
+bool ThumbnailService::lookup(const QString &path, qint64 mtime, QIcon &out)
+{
+    const Entry *entry = m_memory.object(path);
+    if (!entry || entry->mtime != mtime || entry->icon.isNull())
+        return false;
+    out = entry->icon;
+    return true;
+}
+
+void ThumbnailService::request(const Request &req)
+{
+    // готово (или не получилось) для этой версии файла — не повторяем
+    if (const Entry *entry = m_memory.object(req.path); entry && entry->mtime == req.mtime)
+        return;
+    if (m_running.contains(req.path))
+        return;
+
+    if (m_queued.contains(req.path)) {
+        for (qsizetype i = 0; i < m_queue.size(); ++i) {
+            if (m_queue[i].path == req.path) {
+                m_queue.removeAt(i);
+                break;
+            }
+        }
+    }
+    m_queue.prepend(req);
+    m_queued.insert(req.path);
+    schedule();
+}
+
+void ThumbnailService::setWanted(const QList<Request> &visible, const QList<Request> &prefetch)
+{
+    m_queue.clear();
+    m_queued.clear();
+
+    QSet<QString> wanted;
+    for (const QList<Request> *list : { &visible, &prefetch }) {
+        for (const Request &req : *list) {
+            if (wanted.contains(req.path))
+                continue;
+            wanted.insert(req.path);
+            if (const Entry *entry = m_memory.object(req.path); entry && entry->mtime == req.mtime)
+                continue;
+            if (m_running.contains(req.path))
+                continue;
+            m_queue.append(req);
+            m_queued.insert(req.path);
+        }
+    }
+
+    // ушедшие с экрана: дальше кэша на диске не идут
+    for (auto it = m_running.begin(); it != m_running.end(); ++it) {
+        if (!wanted.contains(it.key()))
+            it->cancelled->store(true);
+    }
+
+    schedule();
+}
+
+void ThumbnailService::schedule()
+{
+    const QString cache = cacheDir();
+
+    while (!m_queue.isEmpty() && m_running.size() < m_pool.maxThreadCount()) {
+        const Request req = m_queue.takeFirst();
+        m_queued.remove(req.path);
+
+        Job job;
+        job.req = req;
+        job.cancelled = std::make_shared<std::atomic<bool>>(false);
+        m_running.insert(req.path, job);
+
+        m_pool.start([this, req, cache, cancelled = job.cancelled]() {
+            BELKIN_TRACE_SCOPE("thumbnails.job");
+            const QByteArray uri = uriOf(req.path);
+            const QString name = thumbName(uri);
+            const QString normalFile = cache + QStringLiteral("/normal/") + name;
+            const QString failDir = cache + QStringLiteral("/fail/belkin-commander");
+
+            QImage image;
+            bool failed = false;
+            if (!readCached(normalFile, uri, req.mtime, image)) {
+                QImage marker;
+                if (readCached(failDir + QLatin1Char('/') + name, uri, req.mtime, marker)) {
+                    failed = true;
+                } else if (req.path.startsWith(cache + QLatin1Char('/'))) {
+                    // миниатюры миниатюр не делаем
+                    failed = true;
+                } else if (!cancelled->load()) {
+                    BELKIN_TRACE_SCOPE("thumbnails.decode");
+                    image = decode(req.path);
+                    if (!image.isNull()) {
+                        writeCached(cache + QStringLiteral("/normal"), normalFile,
+                                    image, uri, req.mtime);
+                    } else if (!cancelled->load()) {
+                        // битый файл не декодируем при каждом показе каталога
+                        QImage stub(1, 1, QImage::Format_ARGB32);
+                        stub.fill(Qt::transparent);
+                        writeCached(failDir, failDir + QLatin1Char('/') + name,
+                                    stub, uri, req.mtime);
+                        failed = true;
+                    }
+                }
+            }
+
+            if (failed)
+                image = QImage();
+            QMetaObject::invokeMethod(this, [this, req, image, failed]() {
+                onFinished(req.path, req.mtime, image, failed);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void ThumbnailService::onFinished(const QString &path, qint64 mtime, const QImage &image, bool failed)
+{
+    m_running.remove(path);
+
+    if (!image.isNull()) {
+        auto *entry = new Entry;
+        entry->icon = QIcon(QPixmap::fromImage(image));
+        entry->mtime = mtime;
+        m_memory.insert(path, entry, std::max(1, int(image.sizeInBytes() / 1024)));
+        emit thumbnailReady(path);
+    } else if (failed) {
+        // запомнить неудачу, чтобы строка не запрашивала миниатюру снова
+        auto *entry = new Entry;
+        entry->mtime = mtime;
+        m_memory.insert(path, entry, 1);
+    }
+    // отменённые просто забываются: понадобятся — будут запрошены снова
+
+    schedule();
+}
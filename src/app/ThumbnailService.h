@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QCache>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+// Миниатюры изображений для режима миниатюр панели.
+// Декодирование — в пуле потоков сразу в уменьшенном размере
+// (QImageReader::setScaledSize), очередь с приоритетами: видимые строки
+// вперёд, запас вокруг — следом, всё, что ушло с экрана, снимается.
+// Готовые миниатюры пишутся в кэш по спецификации freedesktop
+// ($XDG_CACHE_HOME/thumbnails/normal/<md5(URI)>.png с Thumb::URI и
+// Thumb::MTime), его же читают файловые менеджеры окружения, и обратно.
+// Поверх — кэш готовых иконок в памяти. Используется только из GUI-потока.
+class ThumbnailService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int Size = 128;   // «normal» по спецификации
+
+    struct Request {
+        QString path;
+        qint64  mtime = 0;
+    };
+
+    static ThumbnailService *instance();
+
+    // есть ли смысл пытаться (расширение из QImageReader::supportedImageFormats)
+    static bool canThumbnail(const QString &suffix);
+
+    bool lookup(const QString &path, qint64 mtime, QIcon &out);
+
+    // строка нарисована без миниатюры — поставить в начало очереди
+    void request(const Request &req);
+
+    // что сейчас нужно панели: видимые строки и запас вокруг них.
+    // Остальное из очереди выкидывается, работающие задачи по ним отменяются.
+    void setWanted(const QList<Request> &visible, const QList<Request> &prefetch);
+
+    static QString cacheDir();
+
+signals:
+    void thumbnailReady(const QString &path);
+
+private:
+    explicit ThumbnailService(QObject *parent = nullptr);
+    ~ThumbnailService() override;
+
+    struct Job {
+        Request req;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    void schedule();
+    void onFinished(const QString &path, qint64 mtime, const QImage &image, bool failed);
+
+    QThreadPool m_pool;
+
+    QList<Request>        m_queue;     // по приоритету, голова — первой
+    QSet<QString>         m_queued;
+    QHash<QString, Job>   m_running;
+
+    struct Entry {
+        QIcon  icon;
+        qint64 mtime = 0;
+    };
+    // путь -> иконка; запись без иконки — миниатюру сделать не удалось
+    QCache<QString, Entry> m_memory;   // стоимость — КБ пикселей
+};
@@ -1,12 +1,86 @@
 #include <QApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QTimer>
+#include <cstring>
+#include <optional>
 #include "MainWindow.h"
+#include "StartupProfiler.h"
+#include "Trace.h"
+
+namespace {
+
+// --startup-bench ждёт заполненных панелей не дольше этого
+constexpr int StartupBenchTimeoutMs = 60000;
+
+bool hasArg(int argc, char *argv[], const char *name)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// JSON сводки запуска в файл (--output) или в stdout
+bool writeStartupBench(const QString &output)
+{
+    QJsonObject root = StartupProfiler::instance()->toJson();
+    root["platform"] = QGuiApplication::platformName();
+    root["os"] = QSysInfo::prettyProductName();
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    QFile file;
+    const bool ok = output.isEmpty() ? file.open(stdout, QIODevice::WriteOnly)
+                                     : (file.setFileName(output), file.open(QIODevice::WriteOnly));
+    return ok && file.write(json) == json.size();
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    StartupProfiler::begin();
+
+    // замер холодного старта: без дисплея, вывод — JSON
+    const bool startupBench = hasArg(argc, argv, "--startup-bench");
+    if (startupBench && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    std::optional<QApplication> app;
+    {
+        StartupProfiler::Phase phase("startup.QApplication");
+        app.emplace(argc, argv);
+    }
+    trace::initFromEnvironment();
+
+    QString benchOutput;
+    const QStringList args = app->arguments();
+    const qsizetype outputArg = args.indexOf(QStringLiteral("--output"));
+    if (outputArg >= 0 && outputArg + 1 < args.size())
+        benchOutput = args[outputArg + 1];
+
+    std::optional<MainWindow> w;
+    {
+        StartupProfiler::Phase phase("startup.MainWindow");
+        w.emplace();
+    }
+    {
+        StartupProfiler::Phase phase("startup.show");
+        w->show();
+    }
 
-    MainWindow w;
-    w.show();
+    if (startupBench) {
+        StartupProfiler *startup = StartupProfiler::instance();
+        // по таймауту тоже пишем, что успели замерить, но с кодом ошибки
+        auto finish = [&benchOutput, startup]() {
+            const bool written = writeStartupBench(benchOutput);
+            QCoreApplication::exit(startup->isComplete() && written ? 0 : 1);
+        };
+        QObject::connect(startup, &StartupProfiler::completed, &*app, finish, Qt::QueuedConnection);
+        QTimer::singleShot(StartupBenchTimeoutMs, &*app, finish);
+    }
 
-    return app.exec();
+    return app->exec();
 }
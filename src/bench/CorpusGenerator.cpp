@@ -0,0 +1,207 @@
+#include <QDir>
+#include <QFile>
+#include <QByteArray>
+#include <algorithm>
+#include <random>
+#include "CorpusGenerator.h"
+
+namespace {
+
+// splitmix64 — быстрый и воспроизводимый источник содержимого файлов
+inline std::uint64_t splitmix64(std::uint64_t &state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void fillBuffer(QByteArray &buf, std::uint64_t &state)
+{
+    auto *p = reinterpret_cast<unsigned char *>(buf.data());
+    qsizetype i = 0;
+    for (; i + 8 <= buf.size(); i += 8) {
+        const std::uint64_t v = splitmix64(state);
+        std::copy_n(reinterpret_cast<const unsigned char *>(&v), 8, p + i);
+    }
+    for (; i < buf.size(); ++i)
+        p[i] = static_cast<unsigned char>(splitmix64(state));
+}
+
+constexpr qint64 KB = 1024;
+constexpr qint64 MB = 1024 * KB;
+constexpr qint64 GB = 1024 * MB;
+
+} // namespace
+
+CorpusGenerator::CorpusGenerator(std::uint64_t seed, double scale)
+    : m_seed(seed)
+    , m_scale(scale)
+{
+}
+
+QString CorpusGenerator::kindName(CorpusKind kind)
+{
+    switch (kind) {
+    case CorpusKind::Tiny:       return "tiny";
+    case CorpusKind::Medium:     return "medium";
+    case CorpusKind::HugeSparse: return "huge-sparse";
+    case CorpusKind::HugeDense:  return "huge-dense";
+    case CorpusKind::DeepTree:   return "deep";
+    }
+    return {};
+}
+
+bool CorpusGenerator::kindFromName(const QString &name, CorpusKind &kind)
+{
+    for (CorpusKind k : allKinds()) {
+        if (kindName(k) == name) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<CorpusKind> CorpusGenerator::allKinds()
+{
+    return { CorpusKind::Tiny, CorpusKind::Medium, CorpusKind::HugeSparse,
+             CorpusKind::HugeDense, CorpusKind::DeepTree };
+}
+
+qint64 CorpusGenerator::scaled(qint64 full, qint64 minimum) const
+{
+    return std::max<qint64>(minimum, qint64(double(full) * m_scale));
+}
+
+bool CorpusGenerator::makeDir(const QString &path, CorpusStats &stats)
+{
+    if (!QDir().mkpath(path))
+        return false;
+    ++stats.dirs;
+    return true;
+}
+
+bool CorpusGenerator::writeFile(const QString &path, qint64 size,
+                                std::uint64_t salt, CorpusStats &stats)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    std::uint64_t state = m_seed ^ (salt * 0x2545f4914f6cdd1dULL);
+    QByteArray buf(int(std::min<qint64>(size, MB)), Qt::Uninitialized);
+
+    qint64 left = size;
+    while (left > 0) {
+        const qint64 chunk = std::min<qint64>(left, buf.size());
+        fillBuffer(buf, state);
+        if (f.write(buf.constData(), chunk) != chunk)
+            return false;
+        left -= chunk;
+    }
+
+    ++stats.files;
+    stats.bytes += size;
+    return true;
+}
+
+bool CorpusGenerator::writeSparseFile(const QString &path, qint64 size,
+                                      std::uint64_t salt, CorpusStats &stats)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    // ftruncate даёт дыру на весь файл; пишем по 4 КБ каждые 64 МБ
+    if (!f.resize(size))
+        return false;
+
+    // salt — номер файла: одинаковые по размеру файлы не должны совпадать
+    // содержимым, иначе дедупликация и сжатие ФС исказят замеры
+    std::uint64_t state = m_seed ^ std::uint64_t(size) ^ (salt * 0x2545f4914f6cdd1dULL);
+    QByteArray block(int(4 * KB), Qt::Uninitialized);
+    for (qint64 off = 0; off + block.size() <= size; off += 64 * MB) {
+        fillBuffer(block, state);
+        if (!f.seek(off) || f.write(block) != block.size())
+            return false;
+    }
+
+    ++stats.files;
+    stats.bytes += size;
+    return true;
+}
+
+bool CorpusGenerator::generate(CorpusKind kind, const QString &root, CorpusStats &stats)
+{
+    stats = {};
+    if (!makeDir(root, stats))
+        return false;
+
+    std::mt19937_64 rng(m_seed ^ std::uint64_t(kind));
+
+    switch (kind) {
+    case CorpusKind::Tiny: {
+        // по 1000 файлов на каталог — как в реальных деревьях исходников/кешей
+        const qint64 count = scaled(1000000, 100);
+        std::uniform_int_distribution<qint64> sizeDist(0, 4 * KB);
+        for (qint64 i = 0; i < count; ++i) {
+            const QString dir = root + QStringLiteral("/d%1").arg(i / 1000, 4, 10, QChar('0'));
+            if (i % 1000 == 0 && !makeDir(dir, stats))
+                return false;
+            if (!writeFile(dir + QStringLiteral("/f%1.dat").arg(i), sizeDist(rng), i, stats))
+                return false;
+        }
+        break;
+    }
+    case CorpusKind::Medium: {
+        const qint64 count = scaled(10000, 10);
+        std::uniform_int_distribution<qint64> sizeDist(64 * KB, 4 * MB);
+        for (qint64 i = 0; i < count; ++i) {
+            const QString dir = root + QStringLiteral("/d%1").arg(i / 100, 3, 10, QChar('0'));
+            if (i % 100 == 0 && !makeDir(dir, stats))
+                return false;
+            if (!writeFile(dir + QStringLiteral("/m%1.bin").arg(i), sizeDist(rng), i, stats))
+                return false;
+        }
+        break;
+    }
+    case CorpusKind::HugeSparse: {
+        const qint64 size = scaled(16 * GB, 64 * MB);
+        for (int i = 0; i < 3; ++i) {
+            if (!writeSparseFile(root + QStringLiteral("/sparse%1.img").arg(i), size, i, stats))
+                return false;
+        }
+        break;
+    }
+    case CorpusKind::HugeDense: {
+        const qint64 size = scaled(4 * GB, 16 * MB);
+        for (int i = 0; i < 3; ++i) {
+            if (!writeFile(root + QStringLiteral("/dense%1.bin").arg(i), size, i, stats))
+                return false;
+        }
+        break;
+    }
+    case CorpusKind::DeepTree: {
+        // несколько цепочек глубиной 64, на каждом уровне по паре мелких файлов
+        const qint64 chains = scaled(200, 2);
+        std::uniform_int_distribution<qint64> sizeDist(0, 16 * KB);
+        qint64 salt = 0;
+        for (qint64 c = 0; c < chains; ++c) {
+            QString dir = root + QStringLiteral("/chain%1").arg(c);
+            for (int depth = 0; depth < 64; ++depth) {
+                dir += QStringLiteral("/level%1").arg(depth);
+                if (!makeDir(dir, stats))
+                    return false;
+                for (int f = 0; f < 2; ++f) {
+                    if (!writeFile(dir + QStringLiteral("/f%1.txt").arg(f), sizeDist(rng), ++salt, stats))
+                        return false;
+                }
+            }
+        }
+        break;
+    }
+    }
+
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+
+// Тип синтетического корпуса для бенчмарка
+enum class CorpusKind {
+    Tiny,           // 1M файлов по 0..4 КБ
+    Medium,         // 10k файлов по 64 КБ..4 МБ
+    HugeSparse,     // несколько больших разреженных файлов
+    HugeDense,      // несколько больших плотных файлов
+    DeepTree        // глубокое дерево каталогов с мелкими файлами
+};
+
+struct CorpusStats {
+    qint64 files = 0;
+    qint64 dirs  = 0;
+    qint64 bytes = 0;   // логический размер (для sparse — с дырами)
+};
+
+// Детерминированный генератор: одинаковые seed и scale дают
+// байт-в-байт одинаковый корпус, чтобы результаты можно было сравнивать
+// между коммитами.
+class CorpusGenerator
+{
+public:
+    CorpusGenerator(std::uint64_t seed, double scale);
+
+    static QString kindName(CorpusKind kind);
+    static bool kindFromName(const QString &name, CorpusKind &kind);
+    static QList<CorpusKind> allKinds();
+
+    // создаёт корпус в каталоге root (каталог должен быть пустым)
+    bool generate(CorpusKind kind, const QString &root, CorpusStats &stats);
+
+private:
+    bool writeFile(const QString &path, qint64 size, std::uint64_t salt, CorpusStats &stats);
+    bool writeSparseFile(const QString &path, qint64 size, std::uint64_t salt, CorpusStats &stats);
+    bool makeDir(const QString &path, CorpusStats &stats);
+    qint64 scaled(qint64 full, qint64 minimum) const;
+
+    std::uint64_t m_seed;
+    double m_scale;
+};
@@ -0,0 +1,230 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+#include <functional>
+#include "CorpusGenerator.h"
+#include "FileOperations.h"
+#include "Trace.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Счётчики процесса до/после операции. /proc/self/io считает только вызовы
+// чтения и записи (read/pread/readv/sendfile..., write/...): open, stat,
+// rename, fsync и unlink сюда не попадают, поэтому это не общее число
+// системных вызовов — для него нужен perf trace или strace -c
+struct ProcCounters {
+    qint64 readCalls  = 0;  // /proc/self/io: syscr
+    qint64 writeCalls = 0;  // /proc/self/io: syscw
+};
+
+ProcCounters readCounters()
+{
+    ProcCounters c;
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/io");
+    if (f.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : f.readAll().split('\n')) {
+            if (line.startsWith("syscr:"))
+                c.readCalls = line.mid(6).trimmed().toLongLong();
+            else if (line.startsWith("syscw:"))
+                c.writeCalls = line.mid(6).trimmed().toLongLong();
+        }
+    }
+#endif
+    return c;
+}
+
+// Сбрасывает пиковый RSS процесса, чтобы мерить пик каждой операции отдельно
+void resetPeakRss()
+{
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/clear_refs");
+    if (f.open(QIODevice::WriteOnly))
+        f.write("5");
+#endif
+}
+
+qint64 peakRssKb()
+{
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/status");
+    if (f.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : f.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss;
+#endif
+    return 0;
+}
+
+QJsonObject measure(const QString &op, const CorpusStats &stats,
+                    const std::function<bool()> &fn)
+{
+    resetPeakRss();
+    const ProcCounters before = readCounters();
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = fn();
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    const ProcCounters after = readCounters();
+
+    QJsonObject r;
+    r["op"]          = op;
+    r["ok"]          = ok;
+    r["files"]       = stats.files;
+    r["bytes"]       = stats.bytes;
+    r["seconds"]     = seconds;
+    r["files_per_s"] = seconds > 0 ? stats.files / seconds : 0.0;
+    r["mb_per_s"]    = seconds > 0 ? stats.bytes / (1024.0 * 1024.0) / seconds : 0.0;
+    r["io_calls"]    = QJsonObject{
+        { "read",  after.readCalls  - before.readCalls },
+        { "write", after.writeCalls - before.writeCalls },
+    };
+    r["peak_rss_kb"] = peakRssKb();
+    return r;
+}
+
+} // namespace
+
+// belkin-bench — пропускная способность copy/move/delete ядра на синтетических корпусах
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("belkin-bench");
+    trace::initFromEnvironment();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Copy/move/delete throughput benchmark for BelkinCore.");
+    parser.addHelpOption();
+
+    QCommandLineOption scaleOpt("scale", "Corpus scale, 1.0 = 1M tiny / 10k medium files.", "factor", "0.01");
+    QCommandLineOption seedOpt("seed", "Corpus generator seed.", "n", "42");
+    QCommandLineOption diskOpt("disk-dir", "Directory on a real disk.", "dir", QDir::tempPath());
+    QCommandLineOption tmpfsOpt("tmpfs-dir", "Directory on tmpfs (empty to skip).", "dir", "/dev/shm");
+    QCommandLineOption corpusOpt("corpus", "Comma-separated corpora: tiny,medium,huge-sparse,huge-dense,deep.",
+                                 "list", "tiny,medium,huge-sparse,huge-dense,deep");
+    QCommandLineOption durabilityOpt("durability", "Durability policy for copy/move.", "policy", "none");
+    QCommandLineOption outputOpt("output", "Write JSON to file instead of stdout.", "file");
+    parser.addOptions({ scaleOpt, seedOpt, diskOpt, tmpfsOpt, corpusOpt, durabilityOpt, outputOpt });
+    parser.process(app);
+
+    const double scale = parser.value(scaleOpt).toDouble();
+    const quint64 seed = parser.value(seedOpt).toULongLong();
+    const DurabilityPolicy durability =
+        DurabilityTracker::policyFromString(parser.value(durabilityOpt));
+
+    QList<CorpusKind> kinds;
+    for (const QString &name : parser.value(corpusOpt).split(',', Qt::SkipEmptyParts)) {
+        CorpusKind kind;
+        if (!CorpusGenerator::kindFromName(name.trimmed(), kind)) {
+            QTextStream(stderr) << "unknown corpus: " << name << '\n';
+            return 2;
+        }
+        kinds << kind;
+    }
+
+    QList<QPair<QString, QString>> locations;   // имя -> каталог
+    if (!parser.value(tmpfsOpt).isEmpty() && QFileInfo(parser.value(tmpfsOpt)).isDir())
+        locations.append({ "tmpfs", parser.value(tmpfsOpt) });
+    if (QFileInfo(parser.value(diskOpt)).isDir())
+        locations.append({ "disk", parser.value(diskOpt) });
+
+    CorpusGenerator generator(seed, scale);
+    QJsonArray results;
+    bool allOk = true;
+
+    for (const auto &loc : std::as_const(locations)) {
+        const QString base = QStringLiteral("%1/belkin-bench-%2")
+                                 .arg(loc.second).arg(QCoreApplication::applicationPid());
+
+        for (CorpusKind kind : std::as_const(kinds)) {
+            const QString name    = CorpusGenerator::kindName(kind);
+            const QString srcRoot = base + "/src/" + name;
+            const QString copyDir = base + "/copy";
+            const QString moveDir = base + "/moved";
+            QDir().mkpath(copyDir);
+            QDir().mkpath(moveDir);
+
+            CorpusStats stats;
+            QElapsedTimer genTimer;
+            genTimer.start();
+            if (!generator.generate(kind, srcRoot, stats)) {
+                QTextStream(stderr) << "failed to generate " << name << " in " << loc.second << '\n';
+                FileOperations::removePaths({ base }, true);
+                allOk = false;
+                continue;
+            }
+            const double genSeconds = genTimer.nsecsElapsed() / 1e9;
+
+            auto tag = [&](QJsonObject r) {
+                r["location"] = loc.first;
+                r["path"]     = loc.second;
+                r["corpus"]   = name;
+                r["generate_seconds"] = genSeconds;
+                allOk &= r["ok"].toBool();
+                results.append(r);
+            };
+
+            tag(measure("copy", stats, [&] {
+                return FileOperations::copyFilesSync({ srcRoot }, copyDir, nullptr, durability);
+            }));
+
+            tag(measure("move", stats, [&] {
+                return FileOperations::moveFilesSync({ copyDir + "/" + name }, moveDir, nullptr, durability);
+            }));
+
+            tag(measure("delete", stats, [&] {
+                return FileOperations::removePaths({ moveDir + "/" + name }, true);
+            }));
+
+            FileOperations::removePaths({ srcRoot }, true);
+        }
+
+        FileOperations::removePaths({ base }, true);
+    }
+
+    QJsonObject meta;
+    meta["timestamp"]  = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    meta["host"]       = QSysInfo::machineHostName();
+    meta["kernel"]     = QSysInfo::kernelVersion();
+    meta["scale"]      = scale;
+    meta["seed"]       = QString::number(seed);
+    meta["durability"] = DurabilityTracker::policyToString(durability);
+
+    const QByteArray json = QJsonDocument(QJsonObject{
+        { "meta", meta },
+        { "results", results },
+    }).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOpt)) {
+        QFile f(parser.value(outputOpt));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "cannot write " << f.fileName() << '\n';
+            return 1;
+        }
+        f.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <cstdio>
+#include "CliCommands.h"
+#include "CopySignals.h"
+#include "DuplicateFinder.h"
+#include "FileOperations.h"
+#include "HashAlgorithm.h"
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream s(stdout);
+    return s;
+}
+
+QTextStream &err()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+// Одна JSON-строка на событие (NDJSON) — удобно читать построчно из скриптов
+void emitJson(const QJsonObject &obj)
+{
+    out() << QJsonDocument(obj).toJson(QJsonDocument::Compact) << '\n';
+    out().flush();
+}
+
+QByteArray hashFile(const QString &path, QCryptographicHash::Algorithm algo)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return {};
+
+    QCryptographicHash hash(algo);
+    if (!hash.addData(&f))
+        return {};
+
+    return hash.result().toHex();
+}
+
+} // namespace
+
+namespace cli {
+
+int runCopy(const CliOptions &opt, bool move)
+{
+    if (opt.args.size() < 2) {
+        err() << "usage: belkin-cli " << (move ? "move" : "copy")
+              << " <src>... <dstDir>\n";
+        return CliUsage;
+    }
+
+    QStringList srcFiles = opt.args;
+    const QString dstDir = QFileInfo(srcFiles.takeLast()).absoluteFilePath();
+
+    if (!QFileInfo(dstDir).isDir()) {
+        err() << "not a directory: " << dstDir << '\n';
+        return CliUsage;
+    }
+
+    for (QString &src : srcFiles)
+        src = QFileInfo(src).absoluteFilePath();
+
+    CopySignals sig;
+    bool hadError = false;
+
+    QObject::connect(&sig, &CopySignals::copyError, [&](const QString &path) {
+        hadError = true;
+        if (opt.json)
+            emitJson({ { "event", "error" }, { "path", path } });
+        else
+            err() << "failed: " << path << '\n';
+    });
+
+    QObject::connect(&sig, &CopySignals::syncFinished, [&](qint64 syncMs) {
+        if (opt.json)
+            emitJson({ { "event", "sync" }, { "ms", syncMs } });
+        else
+            out() << "sync: " << syncMs << " ms\n";
+    });
+
+    if (opt.json) {
+        QObject::connect(&sig, &CopySignals::progressChanged,
+                         [&](const CopyProgress &p) {
+            emitJson({ { "event", "progress" },
+                       { "file", p.currentFile },
+                       { "filesDone", p.filesDone },
+                       { "filesTotal", p.filesTotal },
+                       { "bytesDone", p.bytesDone },
+                       { "bytesTotal", p.bytesTotal },
+                       { "bytesPerSec", p.rateBytesPerSec },
+                       { "etaSeconds", p.etaSeconds },
+                       { "elapsedMs", p.elapsedMs },
+                       { "metadataMs", p.metadataMs },
+                       { "dataMs", p.dataMs },
+                       { "syncMs", p.syncMs },
+                       { "finished", p.finished } });
+        });
+    }
+
+    // в CLI работаем синхронно: сигналы доставляются напрямую в этот поток
+    const bool ok = move
+        ? FileOperations::moveFilesSync(srcFiles, dstDir, &sig, opt.durability)
+        : FileOperations::copyFilesSync(srcFiles, dstDir, &sig, opt.durability);
+
+    if (opt.json)
+        emitJson({ { "event", "finished" }, { "ok", ok && !hadError } });
+
+    return ok && !hadError ? CliOk : CliFailed;
+}
+
+int runRemove(const CliOptions &opt, bool permanent)
+{
+    if (opt.args.isEmpty()) {
+        err() << "usage: belkin-cli " << (permanent ? "delete" : "trash")
+              << " <path>...\n";
+        return CliUsage;
+    }
+
+    QStringList paths;
+    for (const QString &p : opt.args)
+        paths << QFileInfo(p).absoluteFilePath();
+
+    const bool ok = FileOperations::removePaths(paths, permanent);
+
+    if (opt.json)
+        emitJson({ { "event", "finished" }, { "ok", ok }, { "count", paths.size() } });
+    else if (!ok)
+        err() << "failed to remove some of the paths\n";
+
+    return ok ? CliOk : CliFailed;
+}
+
+int runHash(const CliOptions &opt)
+{
+    QCryptographicHash::Algorithm algo;
+    if (!hashing::algorithmByName(opt.algo, algo)) {
+        err() << "unknown hash algorithm: " << opt.algo << '\n';
+        return CliUsage;
+    }
+
+    if (opt.args.isEmpty()) {
+        err() << "usage: belkin-cli hash [--algo name] <file>...\n";
+        return CliUsage;
+    }
+
+    int rc = CliOk;
+    for (const QString &path : opt.args) {
+        const QByteArray digest = hashFile(path, algo);
+        if (digest.isEmpty()) {
+            rc = CliFailed;
+            if (opt.json)
+                emitJson({ { "event", "error" }, { "path", path } });
+            else
+                err() << "cannot read: " << path << '\n';
+            continue;
+        }
+
+        if (opt.json)
+            emitJson({ { "event", "hash" }, { "path", path },
+                       { "algo", opt.algo }, { "digest", QString::fromLatin1(digest) } });
+        else
+            out() << digest << "  " << path << '\n';
+    }
+
+    return rc;
+}
+
+int runDupes(const CliOptions &opt)
+{
+    if (!DuplicateFinder::isKnownAlgorithm(opt.algo)) {
+        err() << "unknown hash algorithm: " << opt.algo << '\n';
+        return CliUsage;
+    }
+
+    if (opt.args.isEmpty()) {
+        err() << "usage: belkin-cli dupes [--min-size bytes] <dir>...\n";
+        return CliUsage;
+    }
+
+    DuplicateScanParams params;
+    params.scanDirs = opt.args;
+    params.level = -1;
+    params.minSize = opt.minSize;
+    params.algo = opt.algo;
+
+    const std::vector<DuplicateGroup> groups = DuplicateFinder::find(params);
+    for (const DuplicateGroup &g : groups) {
+        if (opt.json) {
+            emitJson({ { "event", "group" },
+                       { "size", g.size },
+                       { "files", QJsonArray::fromStringList(g.files) } });
+        } else {
+            out() << g.size << " bytes\n";
+            for (const QString &path : g.files)
+                out() << "  " << path << '\n';
+        }
+    }
+
+    if (opt.json)
+        emitJson({ { "event", "finished" }, { "groups", int(groups.size()) } });
+
+    return CliOk;
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QStringList>
+#include "Durability.h"
+
+// Коды возврата belkin-cli (для скриптов и CI)
+enum CliExitCode {
+    CliOk       = 0,    // операция выполнена
+    CliFailed   = 1,    // операция завершилась ошибкой
+    CliUsage    = 2     // неверные аргументы
+};
+
+struct CliOptions {
+    QStringList      args;          // позиционные аргументы после подкоманды
+    bool             json = false;  // построчный JSON вместо текста
+    DurabilityPolicy durability = DurabilityPolicy::None;
+    QString          algo = "sha1";
+    qint64           minSize = 1;
+};
+
+namespace cli {
+
+int runCopy(const CliOptions &opt, bool move);
+int runRemove(const CliOptions &opt, bool permanent);
+int runHash(const CliOptions &opt);
+int runDupes(const CliOptions &opt);
+
+}
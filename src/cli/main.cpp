@@ -0,0 +1,76 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "CliCommands.h"
+#include "HashAlgorithm.h"
+#include "Trace.h"
+
+// belkin-cli — headless-фронтенд над BelkinCore (без QWidget/QApplication)
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("belkin-cli");
+    trace::initFromEnvironment();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Belkin Commander file operations from the command line.\n\n"
+        "Commands:\n"
+        "  copy  <src>... <dstDir>   copy files and directories\n"
+        "  move  <src>... <dstDir>   move files and directories\n"
+        "  delete <path>...          delete permanently\n"
+        "  trash  <path>...          move to trash\n"
+        "  dupes  <dir>...           find duplicate files\n"
+        "  hash   <file>...          print file digests\n\n"
+        "Exit codes: 0 - ok, 1 - operation failed, 2 - usage error.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "copy | move | delete | trash | dupes | hash");
+    parser.addPositionalArgument("args", "Command arguments.", "[args...]");
+
+    QCommandLineOption jsonOpt("json", "Print progress and results as JSON lines.");
+    QCommandLineOption durabilityOpt("durability",
+                                     "Durability policy for copy/move: none, perfile, batched.",
+                                     "policy", "none");
+    QCommandLineOption algoOpt("algo",
+                               "Hash algorithm for hash/dupes: " + hashing::algorithmNames().join(", ")
+                               + " (dupes: also crc32).",
+                               "name", "sha1");
+    QCommandLineOption minSizeOpt("min-size", "Minimal file size for dupes.", "bytes", "1");
+
+    parser.addOptions({ jsonOpt, durabilityOpt, algoOpt, minSizeOpt });
+
+    if (!parser.parse(app.arguments())) {
+        QTextStream(stderr) << parser.errorText() << '\n';
+        return CliUsage;
+    }
+
+    if (parser.isSet("help")) {
+        QTextStream(stdout) << parser.helpText();
+        return CliOk;
+    }
+
+    QStringList positional = parser.positionalArguments();
+    if (positional.isEmpty()) {
+        QTextStream(stderr) << parser.helpText();
+        return CliUsage;
+    }
+
+    const QString command = positional.takeFirst();
+
+    CliOptions opt;
+    opt.args       = positional;
+    opt.json       = parser.isSet(jsonOpt);
+    opt.durability = DurabilityTracker::policyFromString(parser.value(durabilityOpt));
+    opt.algo       = parser.value(algoOpt);
+    opt.minSize    = parser.value(minSizeOpt).toLongLong();
+
+    if (command == "copy")   return cli::runCopy(opt, false);
+    if (command == "move")   return cli::runCopy(opt, true);
+    if (command == "delete") return cli::runRemove(opt, true);
+    if (command == "trash")  return cli::runRemove(opt, false);
+    if (command == "hash")   return cli::runHash(opt);
+    if (command == "dupes")  return cli::runDupes(opt);
+
+    QTextStream(stderr) << "unknown command: " << command << '\n';
+    return CliUsage;
+}
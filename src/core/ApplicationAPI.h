@@ -10,8 +10,9 @@ class FilePluginInterface;
 class QHBoxLayout;
 class QAction;
 class CopySignals;
+class FileIndex;
 
-class BELKINCORE_EXPORT ApplicationAPI {
+class BELKINPLUGINAPI_EXPORT ApplicationAPI {
 public:
     virtual ~ApplicationAPI() = default;
     virtual CopySignals* copySignals() = 0;
@@ -31,5 +32,7 @@ public:
     virtual void performMoveOperation() = 0;
     virtual QWidget* mainWindow() const = 0;
     virtual void navigateToFile(const QString& path) = 0;
+    // индекс имён файлов (поиск по имени без обхода диска)
+    virtual FileIndex* fileIndex() const = 0;
 };
 #endif // APPLICATIONAPI_H
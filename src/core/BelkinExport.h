@@ -14,3 +14,18 @@
     #endif
 #endif
 
+
+// интерфейс плагинов (BelkinPluginApi) — отдельная библиотека с QtWidgets
+#if defined(_WIN32) || defined(__CYGWIN__)
+    #ifdef BelkinPluginApi_EXPORTS
+        #define BELKINPLUGINAPI_EXPORT __declspec(dllexport)
+    #else
+        #define BELKINPLUGINAPI_EXPORT __declspec(dllimport)
+    #endif
+#else
+    #if __GNUC__ >= 4
+        #define BELKINPLUGINAPI_EXPORT __attribute__ ((visibility ("default")))
+    #else
+        #define BELKINPLUGINAPI_EXPORT
+    #endif
+#endif
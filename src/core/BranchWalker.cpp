@@ -0,0 +1,326 @@
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QThread>
+#include "BranchWalker.h"
+#include "Trace.h"
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#endif
+
+namespace {
+
+bool isCancelled(const std::atomic<bool> *cancel)
+{
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+#ifdef Q_OS_LINUX
+
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+// пачку, которую поток копил дольше, отдаём сразу — строки идут потоком
+constexpr auto MaxBatchDelay = std::chrono::milliseconds(50);
+
+struct Item {
+    std::string path;
+    quint32     id = 0;
+};
+
+// Очередь каталогов одного потока
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Item> dirs;
+};
+
+struct Walk {
+    dev_t rootDev = 0;
+    const std::atomic<bool> *cancel = nullptr;
+    const BranchWalker::Callback *onBatch = nullptr;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<qint64> pending{0};     // каталоги в очередях + в обработке
+
+    // Номера подкаталогов и их объявления — под одним мьютексом с отдачей
+    // пачек: подкаталог попадает в очередь только после объявления, а любая
+    // пачка сначала забирает все объявления, так что его файлы не могут
+    // прийти раньше него
+    std::mutex emitMutex;
+    quint32 nextId = 1;
+    std::vector<BranchWalker::Subdir> undeclared;
+
+    void push(size_t worker, Item item)
+    {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        WorkQueue &q = *queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.dirs.push_back(std::move(item));
+    }
+
+    // свой каталог — с конца (обход в глубину, горячий кэш dentry)
+    bool popOwn(size_t worker, Item &item)
+    {
+        WorkQueue &q = *queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.dirs.empty())
+            return false;
+        item = std::move(q.dirs.back());
+        q.dirs.pop_back();
+        return true;
+    }
+
+    // чужой — с начала: там каталоги ближе к корню, т.е. крупнее
+    bool steal(size_t worker, Item &item)
+    {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            WorkQueue &q = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.dirs.empty())
+                continue;
+            item = std::move(q.dirs.front());
+            q.dirs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void flush(BranchWalker::Batch &batch)
+    {
+        std::lock_guard<std::mutex> lock(emitMutex);
+        batch.subdirs = std::move(undeclared);
+        undeclared.clear();
+        if (batch.subdirs.empty() && batch.files.count() == 0)
+            return;
+        (*onBatch)(batch);
+        batch = BranchWalker::Batch();
+    }
+
+    void processDir(size_t worker, const Item &item, std::vector<char> &buffer,
+                    BranchWalker::Batch &batch)
+    {
+        const int fd = ::open(item.path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0)
+            return;   // нет прав — показываем то, что доступно
+
+        std::vector<std::string> children;
+
+        for (;;) {
+            const long n = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if (n <= 0)
+                break;
+
+            for (long pos = 0; pos < n;) {
+                auto *e = reinterpret_cast<LinuxDirent64 *>(buffer.data() + pos);
+                pos += e->d_reclen;
+
+                // скрытые (и «.», «..») панель не показывает
+                const char *name = e->d_name;
+                if (name[0] == '.')
+                    continue;
+
+                struct stat st;
+                if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                    continue;
+
+                if (S_ISDIR(st.st_mode)) {
+                    // другая ФС (точка монтирования) — не заходим
+                    if (st.st_dev == rootDev)
+                        children.emplace_back(name);
+                    continue;
+                }
+
+                // для ссылок — цель, как в панели; ссылки на каталоги не раскрываем
+                if (S_ISLNK(st.st_mode)) {
+                    struct stat target;
+                    if (::fstatat(fd, name, &target, 0) == 0) {
+                        if (S_ISDIR(target.st_mode))
+                            continue;
+                        st = target;
+                    }
+                }
+
+                const int entry = batch.files.appendName(QByteArrayView(name, qsizetype(std::strlen(name))),
+                                                         false);
+                batch.files.setStat(entry, true, qint64(st.st_size), qint64(st.st_mtim.tv_sec),
+                                    quint32(st.st_mode));
+                batch.dirOf.push_back(item.id);
+            }
+
+            // большой каталог отдаётся по частям, не дожидаясь конца
+            if (batch.files.count() >= BranchWalker::BatchEntries)
+                flush(batch);
+            if (isCancelled(cancel))
+                break;
+        }
+
+        ::close(fd);
+
+        if (children.empty() || isCancelled(cancel))
+            return;
+
+        std::vector<Item> items;
+        items.reserve(children.size());
+        {
+            std::lock_guard<std::mutex> lock(emitMutex);
+            for (const std::string &child : children) {
+                BranchWalker::Subdir subdir;
+                subdir.id = nextId++;
+                subdir.parent = item.id;
+                subdir.name = QByteArray(child.data(), qsizetype(child.size()));
+                // у корня «/» свой разделитель уже есть
+                items.push_back({ item.path.back() == '/' ? item.path + child
+                                                          : item.path + '/' + child,
+                                  subdir.id });
+                undeclared.push_back(std::move(subdir));
+            }
+        }
+        for (Item &child : items)
+            push(worker, std::move(child));
+    }
+
+    void run(size_t worker)
+    {
+        std::vector<char> buffer(64 * 1024);
+        BranchWalker::Batch batch;
+        auto lastFlush = std::chrono::steady_clock::now();
+        Item item;
+
+        while (!isCancelled(cancel)) {
+            if (!popOwn(worker, item) && !steal(worker, item)) {
+                // работы нет ни у кого и никто ничего не обрабатывает — конец
+                if (pending.load(std::memory_order_acquire) == 0)
+                    break;
+                // своя пачка не ждёт, пока другие потоки доделают свои каталоги
+                if (batch.files.count() > 0) {
+                    flush(batch);
+                    lastFlush = std::chrono::steady_clock::now();
+                }
+                std::this_thread::yield();
+                continue;
+            }
+
+            processDir(worker, item, buffer, batch);
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+
+            const auto now = std::chrono::steady_clock::now();
+            if (batch.files.count() >= BranchWalker::BatchEntries || now - lastFlush >= MaxBatchDelay) {
+                flush(batch);
+                lastFlush = now;
+            }
+        }
+
+        if (!isCancelled(cancel))
+            flush(batch);
+    }
+};
+
+#endif
+
+} // namespace
+
+bool BranchWalker::walk(const QString &root, const Callback &onBatch,
+                        const std::atomic<bool> *cancel, int threads)
+{
+    BELKIN_TRACE_SCOPE("branch.walk");
+
+#ifdef Q_OS_LINUX
+    QByteArray encoded = QFile::encodeName(root);
+    while (encoded.size() > 1 && encoded.endsWith('/'))
+        encoded.chop(1);
+    struct stat rootSt;
+    if (::stat(encoded.constData(), &rootSt) != 0 || !S_ISDIR(rootSt.st_mode))
+        return false;
+
+    if (threads <= 0)
+        threads = qBound(1, QThread::idealThreadCount(), 8);
+
+    Walk walk;
+    walk.rootDev = rootSt.st_dev;
+    walk.cancel = cancel;
+    walk.onBatch = &onBatch;
+    for (int i = 0; i < threads; ++i)
+        walk.queues.push_back(std::make_unique<WorkQueue>());
+
+    // корень — подкаталог 0
+    walk.push(0, { std::string(encoded.constData(), size_t(encoded.size())), 0 });
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back([&walk, i]() { walk.run(size_t(i)); });
+    walk.run(0);
+    for (std::thread &t : pool)
+        t.join();
+#else
+    const QDir rootDir(root);
+    if (!QFileInfo(root).isDir())
+        return false;
+
+    // без Hidden QDirIterator не отдаёт и не обходит скрытые записи
+    QHash<QString, quint32> ids;
+    ids.insert(QString(), 0);
+    quint32 nextId = 1;
+    Batch batch;
+
+    QDirIterator it(root, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (isCancelled(cancel))
+            return true;
+
+        const QFileInfo fi = it.nextFileInfo();
+        QString parent = QFileInfo(rootDir.relativeFilePath(fi.filePath())).path();
+        if (parent == QLatin1String("."))
+            parent.clear();
+        const auto parentIt = ids.constFind(parent);
+        if (parentIt == ids.cend())
+            continue;
+
+        if (fi.isDir()) {
+            if (fi.isSymLink())
+                continue;
+            Subdir subdir;
+            subdir.id = nextId++;
+            subdir.parent = *parentIt;
+            subdir.name = fi.fileName().toUtf8();
+            ids.insert(rootDir.relativeFilePath(fi.filePath()), subdir.id);
+            batch.subdirs.push_back(std::move(subdir));
+            continue;
+        }
+
+        const int entry = batch.files.appendName(fi.fileName().toUtf8(), false);
+        batch.files.setStat(entry, true, fi.size(), fi.lastModified().toSecsSinceEpoch(),
+                            quint32(fi.permissions()));
+        batch.dirOf.push_back(*parentIt);
+
+        if (batch.files.count() >= BatchEntries) {
+            onBatch(batch);
+            batch = Batch();
+        }
+    }
+    if (batch.files.count() > 0 || !batch.subdirs.empty())
+        onBatch(batch);
+#endif
+
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "BelkinExport.h"
+#include "DirectoryListing.h"
+
+// Обход поддерева для режима «ветка» панели (Ctrl+B): все файлы под
+// каталогом одним плоским списком.
+// На Linux — параллельно, как FolderSizeCalculator: у каждого потока своя
+// очередь каталогов с work stealing, fstatat относительно дескриптора.
+// Файлы приходят пачками по мере обхода, сразу с размером и датой; скрытые
+// записи и другие ФС (точки монтирования) пропускаются, ссылки на каталоги
+// не раскрываются.
+class BELKINCORE_EXPORT BranchWalker
+{
+public:
+    // подкаталог ветки: номер, номер родителя (0 — корень обхода) и имя
+    struct Subdir {
+        quint32    id = 0;
+        quint32    parent = 0;
+        QByteArray name;
+    };
+
+    // Пачка: сначала новые подкаталоги (номера подряд), затем файлы.
+    // Подкаталог объявляется в той же или более ранней пачке, чем его файлы
+    // и его собственные подкаталоги, — пачки можно дописывать в листинг
+    // (DirectoryListing::appendSubdir/appendIn) в порядке прихода.
+    struct Batch {
+        std::vector<Subdir>  subdirs;
+        DirectoryListing     files;
+        std::vector<quint32> dirOf;     // подкаталог каждого файла
+    };
+
+    // onBatch вызывается из потоков обхода, но никогда одновременно
+    using Callback = std::function<void(Batch &batch)>;
+
+    static constexpr int BatchEntries = 4096;
+
+    // false — корень не открылся; отмена — не ошибка (cancel сам скажет)
+    static bool walk(const QString &root, const Callback &onBatch,
+                     const std::atomic<bool> *cancel = nullptr, int threads = 0);
+};
+
+using BranchBatchPtr = std::shared_ptr<BranchWalker::Batch>;
+Q_DECLARE_METATYPE(BranchBatchPtr)
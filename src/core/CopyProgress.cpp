@@ -0,0 +1,201 @@
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "CopyProgress.h"
+#include "CopySignals.h"
+#include "DirectoryListing.h"
+#include "MetadataFetcher.h"
+
+namespace {
+
+// постоянная времени сглаживания скорости: ~3 с "памяти"
+constexpr double RateTauSeconds = 3.0;
+// не пересчитываем скорость по слишком коротким интервалам
+constexpr qint64 MinRateSampleNs = 50 * 1000 * 1000;
+
+// план копирования: записи каталога читаются порциями, stat копится до пачки
+constexpr int PlanReadBatch = 4096;
+constexpr size_t PlanStatBatch = 1024;
+
+} // namespace
+
+ProgressTracker::ProgressTracker(CopySignals *sig, FileOpType opType, int publishIntervalMs)
+    : m_sig(sig)
+    , m_intervalNs(qint64(publishIntervalMs) * 1000 * 1000)
+{
+    m_progress.opType = opType;
+    m_clock.start();
+}
+
+void ProgressTracker::planPath(const QString &path)
+{
+    PhaseTimer t(this, CopyPhase::Metadata);
+
+    // размеры файлов — пачками через MetadataFetcher (io_uring): на холодном
+    // кэше stat по одному выстраивал поиски по диску в очередь
+    MetadataFetcher fetcher(MetadataFetcher::Type | MetadataFetcher::Size);
+    int files = 0;
+    qint64 bytes = 0;
+
+    MetadataFetcher::Result root;
+    fetcher.fetch({ QFile::encodeName(path) },
+                  [&root](const MetadataFetcher::Result &r) { root = r; });
+    if (!root.ok() || !root.isDir()) {
+        adjustPlan(1, root.ok() ? root.size : 0);
+        return;
+    }
+
+    std::vector<QByteArray> batch;
+    const auto flush = [&]() {
+        fetcher.fetch(batch, [&](const MetadataFetcher::Result &r) {
+            if (r.ok() && r.isFile()) {
+                ++files;
+                bytes += r.size;
+            }
+        });
+        batch.clear();
+    };
+
+    // те же правила, что у copyDirectoryRecursively: без скрытых, ссылки на
+    // каталоги раскрываются (копируется их содержимое), только обычные файлы.
+    // Каталог считается столько раз, сколько ссылок на него ведёт, — как его
+    // и скопируют. Не раскрывается только ссылка на собственного предка:
+    // копирование ходило бы по такому кольцу, пока путь не станет слишком
+    // длинным, план на нём зациклился бы
+    struct PlanDir {
+        QString path;
+        QString real;                           // путь без ссылок
+        std::shared_ptr<const PlanDir> parent;
+    };
+    const auto isAncestor = [](const PlanDir *dir, const QString &real) {
+        for (; dir; dir = dir->parent.get()) {
+            if (dir->real == real)
+                return true;
+        }
+        return false;
+    };
+
+    std::vector<std::shared_ptr<const PlanDir>> dirs{
+        std::make_shared<const PlanDir>(PlanDir{ path, QFileInfo(path).canonicalFilePath(), nullptr })
+    };
+    while (!dirs.empty()) {
+        const std::shared_ptr<const PlanDir> dir = std::move(dirs.back());
+        dirs.pop_back();
+
+        DirectoryReader reader(dir->path);
+        DirectoryListing listing;
+        while (reader.readBatch(listing, PlanReadBatch)) {}
+
+        for (int i = 0; i < listing.count(); ++i) {
+            if (listing.isDir(i)) {
+                QString real;
+                if (!listing.isLink(i)) {
+                    real = dir->real.endsWith(u'/') ? dir->real + listing.name(i)
+                                                    : dir->real + u'/' + listing.name(i);
+                } else {
+                    real = QFileInfo(listing.filePath(i)).canonicalFilePath();
+                    if (real.isEmpty() || isAncestor(dir.get(), real))
+                        continue;
+                }
+                dirs.push_back(std::make_shared<const PlanDir>(PlanDir{ listing.filePath(i), real, dir }));
+                continue;
+            }
+            batch.push_back(listing.encodedFilePath(i));
+        }
+        if (batch.size() >= PlanStatBatch)
+            flush();
+    }
+    flush();
+    adjustPlan(files, bytes);
+}
+
+void ProgressTracker::adjustPlan(int files, qint64 bytes)
+{
+    m_progress.filesTotal += files;
+    m_progress.bytesTotal += bytes;
+}
+
+void ProgressTracker::fileStarted(const QString &path, qint64 size)
+{
+    m_progress.currentFile = path;
+    m_progress.currentFileDone = 0;
+    m_progress.currentFileTotal = size;
+    publish(false);
+}
+
+void ProgressTracker::bytesCopied(qint64 bytes)
+{
+    m_progress.bytesDone += bytes;
+    m_progress.currentFileDone += bytes;
+    publish(false);
+}
+
+void ProgressTracker::fileFinished()
+{
+    ++m_progress.filesDone;
+    publish(false);
+}
+
+void ProgressTracker::addPhaseTime(CopyPhase phase, qint64 ns)
+{
+    switch (phase) {
+    case CopyPhase::Metadata: m_metadataNs += ns; break;
+    case CopyPhase::Data:     m_dataNs     += ns; break;
+    case CopyPhase::Sync:     m_syncNs     += ns; break;
+    }
+}
+
+void ProgressTracker::finish()
+{
+    m_progress.finished = true;
+    m_progress.etaSeconds = 0;
+    publish(true);
+}
+
+void ProgressTracker::updateRate(qint64 nowNs)
+{
+    const qint64 dt = nowNs - m_lastRateNs;
+    if (dt < MinRateSampleNs)
+        return;
+
+    const double seconds = dt / 1e9;
+    const double instant = (m_progress.bytesDone - m_lastRateBytes) / seconds;
+
+    if (m_lastRateNs == 0) {
+        m_progress.rateBytesPerSec = instant;
+    } else {
+        // EWMA с весом по реальному интервалу — не зависит от частоты публикации
+        const double alpha = 1.0 - std::exp(-seconds / RateTauSeconds);
+        m_progress.rateBytesPerSec += alpha * (instant - m_progress.rateBytesPerSec);
+    }
+
+    m_lastRateNs = nowNs;
+    m_lastRateBytes = m_progress.bytesDone;
+}
+
+void ProgressTracker::publish(bool force)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    if (!force && m_lastPublishNs >= 0 && now - m_lastPublishNs < m_intervalNs)
+        return;
+
+    m_lastPublishNs = now;
+    updateRate(now);
+
+    const qint64 left = m_progress.bytesTotal - m_progress.bytesDone;
+    if (!m_progress.finished)
+        m_progress.etaSeconds = m_progress.rateBytesPerSec > 0
+            ? std::max<qint64>(left, 0) / m_progress.rateBytesPerSec
+            : -1;
+
+    m_progress.elapsedMs  = now / 1000000;
+    m_progress.metadataMs = m_metadataNs / 1000000;
+    m_progress.dataMs     = m_dataNs / 1000000;
+    m_progress.syncMs     = m_syncNs / 1000000;
+
+    if (m_sig)
+        emit m_sig->progressChanged(m_progress);
+}
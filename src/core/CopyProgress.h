@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "BelkinExport.h"
+#include "FileOpType.h"
+
+class CopySignals;
+
+// Снимок прогресса всей задачи копирования/перемещения.
+// Публикуется через CopySignals::progressChanged не чаще publishIntervalMs.
+struct CopyProgress {
+    FileOpType opType = FileOpType::Copy;
+
+    qint64 bytesDone  = 0;
+    qint64 bytesTotal = 0;
+    int    filesDone  = 0;
+    int    filesTotal = 0;
+
+    QString currentFile;
+    qint64  currentFileDone  = 0;
+    qint64  currentFileTotal = 0;
+
+    double rateBytesPerSec = 0;   // сглаженная (EWMA) скорость по всей задаче
+    double etaSeconds      = -1;  // -1 — пока неизвестно
+
+    qint64 elapsedMs  = 0;
+    qint64 metadataMs = 0;        // stat/open/mkdir/listDir/rename/uniqueNameInDir
+    qint64 dataMs     = 0;        // read/write
+    qint64 syncMs     = 0;        // fdatasync/syncfs (см. DurabilityPolicy)
+
+    bool finished = false;
+};
+
+Q_DECLARE_METATYPE(CopyProgress)
+
+enum class CopyPhase {
+    Metadata,
+    Data,
+    Sync
+};
+
+// Считает прогресс задачи и публикует снимки с ограниченной частотой.
+// Живёт в потоке копирования; CopySignals может быть nullptr (CLI/бенчмарк).
+class BELKINCORE_EXPORT ProgressTracker
+{
+public:
+    ProgressTracker(CopySignals *sig, FileOpType opType, int publishIntervalMs = 100);
+
+    // предварительный обход источников: файлы и байты задачи
+    void planPath(const QString &path);
+    void adjustPlan(int files, qint64 bytes);
+
+    void fileStarted(const QString &path, qint64 size);
+    void bytesCopied(qint64 bytes);
+    void fileFinished();
+
+    void addPhaseTime(CopyPhase phase, qint64 ns);
+
+    // финальный снимок (finished = true)
+    void finish();
+
+    const CopyProgress &snapshot() const { return m_progress; }
+
+private:
+    void publish(bool force);
+    void updateRate(qint64 nowNs);
+
+    CopySignals *m_sig;
+    CopyProgress m_progress;
+    QElapsedTimer m_clock;
+
+    qint64 m_intervalNs;
+    qint64 m_lastPublishNs = -1;
+    qint64 m_lastRateNs    = 0;
+    qint64 m_lastRateBytes = 0;
+    qint64 m_metadataNs = 0;
+    qint64 m_dataNs     = 0;
+    qint64 m_syncNs     = 0;
+};
+
+// RAII-замер времени фазы (metadata / data / sync)
+class PhaseTimer
+{
+public:
+    PhaseTimer(ProgressTracker *tracker, CopyPhase phase)
+        : m_tracker(tracker), m_phase(phase)
+    {
+        if (m_tracker)
+            m_timer.start();
+    }
+
+    ~PhaseTimer()
+    {
+        if (m_tracker)
+            m_tracker->addPhaseTime(m_phase, m_timer.nsecsElapsed());
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    ProgressTracker *m_tracker;
+    CopyPhase m_phase;
+    QElapsedTimer m_timer;
+};
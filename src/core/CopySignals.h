@@ -3,16 +3,27 @@
 #include <QStringList>
 #include "BelkinExport.h"
 #include "FileOpType.h"
+#include "CopyProgress.h"
 
 class BELKINCORE_EXPORT CopySignals : public QObject
 {
     Q_OBJECT
 public:
-    explicit CopySignals(QObject *parent = nullptr) : QObject(parent) {}
+    explicit CopySignals(QObject *parent = nullptr) : QObject(parent)
+    {
+        // снимок уходит из потока копирования через очередь событий
+        qRegisterMetaType<CopyProgress>();
+    }
 
 signals:
     void copyStarted(const QStringList &files, const QString &targetDir, FileOpType opType);
-    void copyProgress(int fileIndex, qint64 copied, qint64 totalBytes, double speedMB);
+    // общий прогресс задачи, не чаще раза в 100 мс (см. ProgressTracker)
+    void progressChanged(const CopyProgress &progress);
     void copyFinished();
+    // время, потраченное на fdatasync/syncfs (только если политика != None)
+    void syncFinished(qint64 syncMs);
     void copyError(const QString &path);
+    // пути, созданные/удалённые задачей (верхний уровень), — для точечного
+    // обновления панелей; приходит перед copyFinished
+    void pathsChanged(const QStringList &paths);
 };
@@ -1,27 +1,31 @@
-#include "ApplicationAPI.h"
 #include "CopyWorkerCore.h"
 #include "FileOperations.h"
 #include "CopySignals.h"
+#include "Trace.h"
 
 CopyWorkerCore::CopyWorkerCore(const QStringList &files,
                                const QString &targetDir,
-                               ApplicationAPI *api,
+                               CopySignals *sig,
                                FileOpType opType,
+                               DurabilityPolicy durability,
                                QObject *parent)
     : QObject(parent)
     , m_files(files)
     , m_targetDir(targetDir)
     , m_opType(opType)
-    , m_api(api)
+    , m_durability(durability)
+    , m_sig(sig)
 {
 }
 
 void CopyWorkerCore::start()
 {
+    BELKIN_TRACE_SCOPE("copyJob");
+
     if (m_opType == FileOpType::Copy) {
-        FileOperations::copyFilesSync(m_files, m_targetDir, m_api);
+        FileOperations::copyFilesSync(m_files, m_targetDir, m_sig, m_durability);
     } else {
-        FileOperations::moveFilesSync(m_files, m_targetDir, m_api);
+        FileOperations::moveFilesSync(m_files, m_targetDir, m_sig, m_durability);
     }
 
     emit finished();
@@ -2,8 +2,9 @@
 #include <QObject>
 #include <QStringList>
 #include "FileOpType.h"
+#include "Durability.h"
 
-class ApplicationAPI;
+class CopySignals;
 
 class CopyWorkerCore : public QObject
 {
@@ -11,8 +12,9 @@ class CopyWorkerCore : public QObject
 public:
     CopyWorkerCore(const QStringList &files,
                    const QString &targetDir,
-                   ApplicationAPI *api,
+                   CopySignals *sig,
                    FileOpType opType,
+                   DurabilityPolicy durability = DurabilityPolicy::None,
                    QObject *parent = nullptr);
 
 public slots:
@@ -25,5 +27,6 @@ private:
     QStringList    m_files;
     QString        m_targetDir;
     FileOpType     m_opType;
-    ApplicationAPI *m_api;
+    DurabilityPolicy m_durability;
+    CopySignals    *m_sig;
 };
@@ -0,0 +1,474 @@
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include "DirectoryListing.h"
+#include "MetadataFetcher.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// запись getdents64 (в glibc нет публичного объявления для старых версий)
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+// 256 КБ — несколько тысяч записей за один системный вызов
+constexpr int DirentBufferSize = 256 * 1024;
+#endif
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// DirectoryListing
+// ---------------------------------------------------------------------------
+
+void DirectoryListing::setPath(const QString &path)
+{
+    m_path = path;
+    m_encodedPath = QFile::encodeName(path);
+}
+
+bool DirectoryListing::load(const QString &dirPath, bool includeHidden)
+{
+    BELKIN_TRACE_SCOPE("listing.load");
+    reset(dirPath);
+
+    DirectoryReader reader(dirPath, includeHidden);
+    if (!reader.isOpen())
+        return false;
+
+    while (reader.readBatch(*this, 1 << 16)) {}
+    return true;
+}
+
+void DirectoryListing::reset(const QString &dirPath, bool branch)
+{
+    clear();
+    setPath(dirPath);
+    if (branch)
+        appendSubdir(-1, {});
+}
+
+void DirectoryListing::clear()
+{
+    m_names.clear();
+    m_nameOffset.assign(1, 0);
+    m_flags.clear();
+    m_size.clear();
+    m_mtime.clear();
+    m_mode.clear();
+    m_subdirNames.clear();
+    m_subdirNameOffset.clear();
+    m_subdirParent.clear();
+    m_entryDir.clear();
+}
+
+void DirectoryListing::append(const DirectoryListing &other)
+{
+    const quint32 base = quint32(m_names.size());
+    m_names.append(other.m_names);
+    m_nameOffset.reserve(m_nameOffset.size() + other.m_flags.size());
+    for (size_t i = 1; i < other.m_nameOffset.size(); ++i)
+        m_nameOffset.push_back(base + other.m_nameOffset[i]);
+
+    m_flags.insert(m_flags.end(), other.m_flags.begin(), other.m_flags.end());
+    m_size.insert(m_size.end(), other.m_size.begin(), other.m_size.end());
+    m_mtime.insert(m_mtime.end(), other.m_mtime.begin(), other.m_mtime.end());
+    m_mode.insert(m_mode.end(), other.m_mode.begin(), other.m_mode.end());
+    if (isBranch())
+        m_entryDir.resize(m_flags.size(), 0);
+}
+
+int DirectoryListing::appendSubdir(int parent, QByteArrayView name)
+{
+    if (m_subdirNameOffset.empty())
+        m_subdirNameOffset.push_back(0);
+    m_subdirNames.append(name.data(), name.size());
+    m_subdirNameOffset.push_back(quint32(m_subdirNames.size()));
+    m_subdirParent.push_back(qint32(parent));
+    // записи, дописанные до того, как листинг стал веткой, лежат в корне
+    m_entryDir.resize(m_flags.size(), 0);
+    return subdirCount() - 1;
+}
+
+void DirectoryListing::appendIn(const DirectoryListing &files, const std::vector<quint32> &dirOf)
+{
+    Q_ASSERT(isBranch() && dirOf.size() == size_t(files.count()));
+
+    append(files);
+    std::copy(dirOf.begin(), dirOf.end(), m_entryDir.end() - qsizetype(dirOf.size()));
+}
+
+QByteArray DirectoryListing::subdirPath(int dir) const
+{
+    // имена от подкаталога к корню, потом склеиваются в обратном порядке
+    std::vector<int> chain;
+    for (int d = dir; d > 0; d = m_subdirParent[d])
+        chain.push_back(d);
+
+    QByteArray path;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!path.isEmpty())
+            path += '/';
+        path.append(m_subdirNames.constData() + m_subdirNameOffset[*it],
+                    m_subdirNameOffset[*it + 1] - m_subdirNameOffset[*it]);
+    }
+    return path;
+}
+
+QString DirectoryListing::relativePath(int i) const
+{
+    const int dir = subdir(i);
+    if (dir == 0)
+        return name(i);
+    QByteArray path = subdirPath(dir);
+    path += '/';
+    path += nameUtf8(i);
+    return QString::fromUtf8(path);
+}
+
+int DirectoryListing::appendName(QByteArrayView name, bool isDir)
+{
+    appendEntry(name.data(), name.size(), isDir ? quint8(IsDir) : quint8(0));
+    return count() - 1;
+}
+
+void DirectoryListing::appendEntry(const char *name, qsizetype len, quint8 flags,
+                                   qint64 size, qint64 mtime, quint32 mode)
+{
+    m_names.append(name, len);
+    m_nameOffset.push_back(quint32(m_names.size()));
+    m_flags.push_back(flags);
+    m_size.push_back(size);
+    m_mtime.push_back(mtime);
+    m_mode.push_back(mode);
+}
+
+QString DirectoryListing::filePath(int i) const
+{
+    if (m_path.endsWith('/'))
+        return m_path + relativePath(i);
+    return m_path + '/' + relativePath(i);
+}
+
+bool DirectoryListing::ensureStat(int i)
+{
+    if (m_flags[i] & Stated)
+        return true;
+    if (m_flags[i] & StatFailed)
+        return false;
+
+    BELKIN_TRACE_SCOPE("listing.stat");
+
+    qint64 size = -1, mtime = 0;
+    quint32 mode = 0;
+    const bool ok = statFile(encodedFilePath(i), size, mtime, mode);
+    setStat(i, ok, size, mtime, mode);
+    return ok;
+}
+
+QByteArray DirectoryListing::encodedFilePath(int i) const
+{
+    QByteArray full = m_encodedPath;
+    if (!full.endsWith('/'))
+        full += '/';
+    if (subdir(i) != 0) {
+        full += subdirPath(subdir(i));
+        full += '/';
+    }
+    full += nameUtf8(i);
+    return full;
+}
+
+bool DirectoryListing::statFile(const QByteArray &encodedPath, qint64 &size, qint64 &mtime, quint32 &mode)
+{
+#ifdef Q_OS_LINUX
+    // для ссылок показываем цель, как QFileSystemModel; битая ссылка — сама ссылка
+    struct stat st;
+    if (::stat(encodedPath.constData(), &st) != 0 && ::lstat(encodedPath.constData(), &st) != 0)
+        return false;
+
+    size  = S_ISDIR(st.st_mode) ? 0 : qint64(st.st_size);
+    mtime = qint64(st.st_mtim.tv_sec);
+    mode  = quint32(st.st_mode);
+#else
+    QFileInfo fi(QFile::decodeName(encodedPath));
+    if (!fi.exists())
+        return false;
+    size  = fi.isDir() ? 0 : fi.size();
+    mtime = fi.lastModified().toSecsSinceEpoch();
+    mode  = quint32(fi.permissions());
+#endif
+    return true;
+}
+
+void DirectoryListing::setStat(int i, bool ok, qint64 size, qint64 mtime, quint32 mode)
+{
+    if (!ok) {
+        m_flags[i] |= StatFailed;
+        return;
+    }
+    m_size[i]  = size;
+    m_mtime[i] = mtime;
+    m_mode[i]  = mode;
+    m_flags[i] |= Stated;
+}
+
+void DirectoryListing::mergeStats(const DirectoryListing &copy)
+{
+    const int n = std::min(count(), copy.count());
+    for (int i = 0; i < n; ++i) {
+        if ((m_flags[i] & (Stated | StatFailed | Removed)) || !(copy.m_flags[i] & (Stated | StatFailed)))
+            continue;
+        setStat(i, copy.m_flags[i] & Stated, copy.m_size[i], copy.m_mtime[i], copy.m_mode[i]);
+    }
+}
+
+void DirectoryListing::ensureStats(int first, int last)
+{
+    std::vector<int> entries;
+    std::vector<QByteArray> paths;
+    for (int i = first; i < last; ++i) {
+        if (!(m_flags[i] & (Stated | StatFailed | Removed))) {
+            entries.push_back(i);
+            paths.push_back(encodedFilePath(i));
+        }
+    }
+    if (entries.empty())
+        return;
+
+    BELKIN_TRACE_SCOPE("listing.statBatch");
+
+    MetadataFetcher fetcher(MetadataFetcher::Mode | MetadataFetcher::Size | MetadataFetcher::MTime,
+                            MetadataFetcher::Links::FollowOrSelf);
+    fetcher.fetch(paths, [this, &entries](const MetadataFetcher::Result &r) {
+        setStat(entries[size_t(r.index)], r.ok(), r.isDir() ? 0 : r.size, r.mtime, r.mode);
+    });
+}
+
+qint64 DirectoryListing::memoryUsage() const
+{
+    return m_names.capacity()
+         + qint64(m_nameOffset.capacity() * sizeof(quint32))
+         + qint64(m_flags.capacity() * sizeof(quint8))
+         + qint64(m_size.capacity() * sizeof(qint64))
+         + qint64(m_mtime.capacity() * sizeof(qint64))
+         + qint64(m_mode.capacity() * sizeof(quint32))
+         + m_subdirNames.capacity()
+         + qint64(m_subdirNameOffset.capacity() * sizeof(quint32))
+         + qint64(m_subdirParent.capacity() * sizeof(qint32))
+         + qint64(m_entryDir.capacity() * sizeof(quint32));
+}
+
+void DirectoryListing::save(QDataStream &out) const
+{
+    quint32 live = 0;
+    for (quint8 f : m_flags) {
+        if (!(f & Removed))
+            ++live;
+    }
+
+    out << m_path << live;
+    for (int i = 0; i < count(); ++i) {
+        if (m_flags[i] & Removed)
+            continue;
+        const QByteArrayView name = nameUtf8(i);
+        out << QByteArray::fromRawData(name.data(), name.size()) << m_flags[i] << m_size[i] << m_mtime[i] << m_mode[i];
+    }
+}
+
+bool DirectoryListing::restore(QDataStream &in)
+{
+    QString path;
+    quint32 n = 0;
+    in >> path >> n;
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    reset(path);
+    // n из файла: резервируем с оглядкой, дальше вектора растут сами
+    const size_t reserve = std::min<size_t>(n, 1 << 20);
+    m_flags.reserve(reserve);
+    m_size.reserve(reserve);
+    m_mtime.reserve(reserve);
+    m_mode.reserve(reserve);
+    m_nameOffset.reserve(reserve + 1);
+
+    QByteArray name;
+    for (quint32 i = 0; i < n; ++i) {
+        quint8 flags = 0;
+        qint64 size = -1;
+        qint64 mtime = 0;
+        quint32 mode = 0;
+        in >> name >> flags >> size >> mtime >> mode;
+        if (in.status() != QDataStream::Ok) {
+            clear();
+            return false;
+        }
+        appendEntry(name.constData(), name.size(), quint8(flags & ~Removed), size, mtime, mode);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// DirectoryReader
+// ---------------------------------------------------------------------------
+
+struct DirectoryReader::Private
+{
+    QString path;
+    bool includeHidden = false;
+
+#ifdef Q_OS_LINUX
+    int fd = -1;
+    QByteArray buffer;
+    long bufferLen = 0;
+    long bufferPos = 0;
+#else
+    std::unique_ptr<QDirIterator> it;
+#endif
+};
+
+DirectoryReader::DirectoryReader(const QString &dirPath, bool includeHidden)
+    : d(std::make_unique<Private>())
+{
+    d->path = dirPath;
+    d->includeHidden = includeHidden;
+
+#ifdef Q_OS_LINUX
+    d->fd = ::open(QFile::encodeName(dirPath).constData(),
+                   O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (d->fd >= 0)
+        d->buffer.resize(DirentBufferSize);
+#else
+    if (QFileInfo(dirPath).isDir()) {
+        QDir::Filters filters = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System;
+        if (includeHidden)
+            filters |= QDir::Hidden;
+        d->it = std::make_unique<QDirIterator>(dirPath, filters);
+    }
+#endif
+}
+
+DirectoryReader::~DirectoryReader()
+{
+#ifdef Q_OS_LINUX
+    if (d->fd >= 0)
+        ::close(d->fd);
+#endif
+}
+
+bool DirectoryReader::isOpen() const
+{
+#ifdef Q_OS_LINUX
+    return d->fd >= 0;
+#else
+    return d->it != nullptr;
+#endif
+}
+
+bool DirectoryReader::readBatch(DirectoryListing &out, int maxEntries)
+{
+    if (!isOpen())
+        return false;
+
+    BELKIN_TRACE_SCOPE("listing.readBatch");
+
+    if (out.m_path.isEmpty())
+        out.setPath(d->path);
+
+    int added = 0;
+
+#ifdef Q_OS_LINUX
+    while (added < maxEntries) {
+
+        if (d->bufferPos >= d->bufferLen) {
+            const long n = ::syscall(SYS_getdents64, d->fd, d->buffer.data(), d->buffer.size());
+            if (n <= 0)
+                return false;   // 0 — конец каталога, <0 — ошибка
+            d->bufferLen = n;
+            d->bufferPos = 0;
+        }
+
+        while (d->bufferPos < d->bufferLen && added < maxEntries) {
+            auto *e = reinterpret_cast<LinuxDirent64 *>(d->buffer.data() + d->bufferPos);
+            d->bufferPos += e->d_reclen;
+
+            const char *name = e->d_name;
+            const qsizetype len = qsizetype(::strlen(name));
+
+            if (name[0] == '.') {
+                if (len == 1 || (len == 2 && name[1] == '.'))
+                    continue;
+                if (!d->includeHidden)
+                    continue;
+            }
+
+            quint8 flags = 0;
+            if (e->d_type == DT_DIR) {
+                flags = DirectoryListing::IsDir;
+                out.appendEntry(name, len, flags);
+            } else if (e->d_type == DT_LNK || e->d_type == DT_UNKNOWN) {
+                // тип неизвестен без stat (ссылка или ФС без d_type) —
+                // раз уж stat всё равно нужен, сохраняем и метаданные
+                struct stat st;
+                const bool link = e->d_type == DT_LNK;
+                const int rc = ::fstatat(d->fd, name, &st, 0) == 0
+                               ? 0 : ::fstatat(d->fd, name, &st, AT_SYMLINK_NOFOLLOW);
+                if (link)
+                    flags |= DirectoryListing::IsLink;
+                if (rc != 0) {
+                    out.appendEntry(name, len, flags | DirectoryListing::StatFailed);
+                } else {
+                    if (S_ISDIR(st.st_mode))
+                        flags |= DirectoryListing::IsDir;
+                    out.appendEntry(name, len, flags | DirectoryListing::Stated,
+                                    S_ISDIR(st.st_mode) ? 0 : qint64(st.st_size),
+                                    qint64(st.st_mtim.tv_sec), quint32(st.st_mode));
+                }
+            } else {
+                out.appendEntry(name, len, flags);
+            }
+            ++added;
+        }
+    }
+    return true;
+#else
+    while (added < maxEntries) {
+        if (!d->it->hasNext())
+            return false;
+
+        const QFileInfo fi = d->it->nextFileInfo();
+        const QByteArray name = fi.fileName().toUtf8();
+
+        quint8 flags = DirectoryListing::Stated;
+        if (fi.isDir())
+            flags |= DirectoryListing::IsDir;
+        if (fi.isSymLink())
+            flags |= DirectoryListing::IsLink;
+
+        out.appendEntry(name.constData(), name.size(), flags,
+                        fi.isDir() ? 0 : fi.size(),
+                        fi.lastModified().toSecsSinceEpoch(),
+                        quint32(fi.permissions()));
+        ++added;
+    }
+    return true;
+#endif
+}
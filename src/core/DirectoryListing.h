@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QDataStream>
+#include <QMetaType>
+#include <QString>
+#include <memory>
+#include <vector>
+#include "BelkinExport.h"
+
+// Содержимое одного каталога в компактном виде (struct-of-arrays).
+// Имена лежат подряд в одном UTF-8 буфере, метаданные — в плотных массивах.
+// stat() делается лениво: при листинге известны только имя и тип (d_type),
+// размер/время/права читаются при первом обращении к строке.
+class BELKINCORE_EXPORT DirectoryListing
+{
+public:
+    enum Flag : quint8 {
+        IsDir      = 0x01,
+        IsLink     = 0x02,
+        Stated     = 0x04,   // size/mtime/mode уже прочитаны
+        StatFailed = 0x08,
+        Removed    = 0x10    // удалена после листинга (индексы остальных не сдвигаются)
+    };
+
+    // Синхронно читает каталог целиком; false — каталог не открылся
+    bool load(const QString &dirPath, bool includeHidden = false);
+    void clear();
+    // пустой листинг каталога dirPath (записи придут пачками через append);
+    // branch — плоский листинг всего поддерева (appendSubdir/appendIn)
+    void reset(const QString &dirPath, bool branch = false);
+
+    // дописывает записи другого листинга того же каталога (пачки из DirectoryReader)
+    void append(const DirectoryListing &other);
+
+    // Ветка: записи всех подкаталогов в одном листинге. Подкаталог хранится
+    // один раз — номер родителя и своё имя, у записи — только номер
+    // подкаталога, так что общие начала путей не повторяются от строки к строке.
+    // Подкаталог 0 — сам каталог листинга.
+    bool isBranch() const { return !m_subdirParent.empty(); }
+    int subdirCount() const { return int(m_subdirParent.size()); }
+    // новый подкаталог parent/name; возвращает его номер
+    int appendSubdir(int parent, QByteArrayView name);
+    // дописывает записи плоского листинга files в подкаталоги dirOf[i]
+    void appendIn(const DirectoryListing &files, const std::vector<quint32> &dirOf);
+    int subdir(int i) const { return m_entryDir.empty() ? 0 : int(m_entryDir[i]); }
+    // путь подкаталога от каталога листинга (пустой для самого каталога)
+    QByteArray subdirPath(int dir) const;
+    // путь записи от каталога листинга: «подкаталог/имя», вне ветки — имя
+    QString relativePath(int i) const;
+
+    // точечные изменения после листинга (события inotify, операции над файлами)
+    int  appendName(QByteArrayView name, bool isDir);
+    void markRemoved(int i) { m_flags[i] |= Removed; }
+    void resetStat(int i)   { m_flags[i] &= quint8(~(Stated | StatFailed)); }
+
+    QString path() const { return m_path; }
+    int count() const { return int(m_flags.size()); }
+
+    QByteArrayView nameUtf8(int i) const
+    {
+        return QByteArrayView(m_names.constData() + m_nameOffset[i],
+                              m_nameOffset[i + 1] - m_nameOffset[i]);
+    }
+    QString name(int i) const { return QString::fromUtf8(nameUtf8(i)); }
+    QString filePath(int i) const;
+
+    bool isDir(int i) const  { return m_flags[i] & IsDir; }
+    bool isLink(int i) const { return m_flags[i] & IsLink; }
+    bool isStated(int i) const { return m_flags[i] & Stated; }
+    bool isRemoved(int i) const { return m_flags[i] & Removed; }
+    bool statFailed(int i) const { return m_flags[i] & StatFailed; }
+
+    // ленивые метаданные: при первом вызове делают stat()
+    qint64  size(int i)  { ensureStat(i); return m_size[i]; }
+    qint64  mtime(int i) { ensureStat(i); return m_mtime[i]; }   // секунды от эпохи
+    quint32 mode(int i)  { ensureStat(i); return m_mode[i]; }    // st_mode (Windows: QFile::Permissions)
+    bool ensureStat(int i);
+
+    // stat вне листинга (в IoPool, чтобы медленный ресурс не держал GUI):
+    // путь записи в кодировке ФС, сам stat и запись результата обратно
+    QByteArray encodedFilePath(int i) const;
+    static bool statFile(const QByteArray &encodedPath, qint64 &size, qint64 &mtime, quint32 &mode);
+    void setStat(int i, bool ok, qint64 size, qint64 mtime, quint32 mode);
+    // stat ещё не прочитанных записей [first, last) одной пачкой (MetadataFetcher):
+    // для обходов всего каталога, например ключей сортировки по размеру
+    void ensureStats(int first, int last);
+    // перенести stat из копии того же листинга (сортировка в своём потоке):
+    // только для записей, у которых здесь stat ещё не сделан
+    void mergeStats(const DirectoryListing &copy);
+
+    // примерный объём памяти под листинг (для отладки и кэша)
+    qint64 memoryUsage() const;
+
+    // компактная запись между запусками (снимок сессии): удалённые записи
+    // пропускаются, уже сделанные stat сохраняются; false — данные повреждены
+    void save(QDataStream &out) const;
+    bool restore(QDataStream &in);
+
+private:
+    friend class DirectoryReader;
+
+    void setPath(const QString &path);
+    void appendEntry(const char *name, qsizetype len, quint8 flags,
+                     qint64 size = -1, qint64 mtime = 0, quint32 mode = 0);
+
+    QString    m_path;
+    QByteArray m_encodedPath;
+
+    QByteArray            m_names;                 // арена имён
+    std::vector<quint32>  m_nameOffset{0};         // count() + 1 смещений
+    std::vector<quint8>   m_flags;
+    std::vector<qint64>   m_size;
+    std::vector<qint64>   m_mtime;
+    std::vector<quint32>  m_mode;
+
+    // только у ветки: подкаталоги и подкаталог каждой записи
+    QByteArray            m_subdirNames;
+    std::vector<quint32>  m_subdirNameOffset;
+    std::vector<qint32>   m_subdirParent;
+    std::vector<quint32>  m_entryDir;
+};
+
+Q_DECLARE_METATYPE(DirectoryListing)
+
+// Пачечное чтение каталога: getdents64 большим буфером на Linux,
+// QDirIterator на остальных платформах.
+class BELKINCORE_EXPORT DirectoryReader
+{
+public:
+    explicit DirectoryReader(const QString &dirPath, bool includeHidden = false);
+    ~DirectoryReader();
+
+    DirectoryReader(const DirectoryReader &) = delete;
+    DirectoryReader &operator=(const DirectoryReader &) = delete;
+
+    bool isOpen() const;
+
+    // дописывает в out не больше maxEntries записей;
+    // false — каталог дочитан (или ошибка чтения)
+    bool readBatch(DirectoryListing &out, int maxEntries);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
@@ -0,0 +1,227 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+#include <array>
+#include "DuplicateFinder.h"
+#include "HashAlgorithm.h"
+#include "Trace.h"
+
+namespace {
+
+// дальше блоки не растут: крупнее — только лишняя память на группу
+constexpr qint64 MaxBlockSize = 1024 * 1024;
+
+bool isCancelled(const std::atomic<bool> *cancel)
+{
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+// CRC-32 (IEEE 802.3), как boost::crc_32_type
+quint32 crc32(const QByteArray &data)
+{
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 c = 0xFFFFFFFFu;
+    for (char ch : data)
+        c = table[(c ^ uchar(ch)) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+QByteArray hashBlock(const QByteArray &block, const QString &algo)
+{
+    if (algo == QLatin1String("crc32")) {
+        const quint32 c = crc32(block);
+        return QByteArray(reinterpret_cast<const char *>(&c), sizeof c);
+    }
+    QCryptographicHash::Algorithm hash = QCryptographicHash::Sha1;
+    hashing::algorithmByName(algo, hash);
+    return QCryptographicHash::hash(block, hash);
+}
+
+// false — файл не открылся или стал короче
+bool readBlock(const QString &path, qint64 offset, qint64 length, QByteArray &block)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly) || !f.seek(offset))
+        return false;
+    block = f.read(length);
+    return block.size() == length;
+}
+
+bool matchMask(const QString &name, const QStringList &masks)
+{
+    if (masks.isEmpty())
+        return true;
+    for (const QString &m : masks) {
+        if (m.size() > 2 && m.startsWith(QLatin1String("*."))) {
+            if (name.endsWith(QStringView(m).mid(1), Qt::CaseInsensitive))
+                return true;
+        } else if (name.contains(m, Qt::CaseInsensitive)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString canonicalPath(const QString &path)
+{
+    const QFileInfo fi(path);
+    const QString canonical = fi.canonicalFilePath();
+    return canonical.isEmpty() ? QDir::cleanPath(fi.absoluteFilePath()) : canonical;
+}
+
+bool isExcluded(const QString &dir, const QStringList &excluded)
+{
+    for (const QString &ex : excluded) {
+        if (dir == ex || dir.startsWith(ex.endsWith(u'/') ? ex : ex + u'/'))
+            return true;
+    }
+    return false;
+}
+
+// Файлы одного размера: группа дробится по хешам очередного блока, пока в
+// ней больше одного файла; дочитанные до конца группы — дубликаты
+bool splitGroup(qint64 size, const QStringList &files, const DuplicateScanParams &p,
+                const std::atomic<bool> *cancel, std::vector<DuplicateGroup> &out)
+{
+    struct Pending {
+        QStringList files;
+        qint64 offset;
+        qint64 block;
+    };
+    std::vector<Pending> work{ { files, 0, qMax<qint64>(1, p.blockSize) } };
+    QByteArray block;
+
+    while (!work.empty()) {
+        if (isCancelled(cancel))
+            return false;
+
+        Pending cur = std::move(work.back());
+        work.pop_back();
+
+        if (cur.offset >= size) {
+            cur.files.sort();
+            out.push_back({ size, cur.files });
+            continue;
+        }
+
+        const qint64 length = qMin(cur.block, size - cur.offset);
+        QHash<QByteArray, QStringList> byHash;
+        for (const QString &path : cur.files) {
+            if (readBlock(path, cur.offset, length, block))
+                byHash[hashBlock(block, p.algo)] << path;
+        }
+
+        const qint64 next = qMax(cur.block, qMin(cur.block * 2, MaxBlockSize));
+        for (auto it = byHash.begin(); it != byHash.end(); ++it) {
+            if (it.value().size() > 1)
+                work.push_back({ std::move(it.value()), cur.offset + length, next });
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool DuplicateFinder::isKnownAlgorithm(const QString &algo)
+{
+    QCryptographicHash::Algorithm hash;
+    return algo.compare(QLatin1String("crc32"), Qt::CaseInsensitive) == 0
+        || hashing::algorithmByName(algo, hash);
+}
+
+std::vector<DuplicateGroup> DuplicateFinder::find(const DuplicateScanParams &params,
+                                                  const std::atomic<bool> *cancel)
+{
+    BELKIN_TRACE_SCOPE("dupes.findDuplicates");
+
+    DuplicateScanParams p = params;
+    p.algo = p.algo.toLower();
+    if (!isKnownAlgorithm(p.algo))
+        return {};
+
+    QStringList excluded;
+    for (const QString &dir : p.excludeDirs)
+        excluded << canonicalPath(dir);
+
+    // 1. Группируем по размеру — дешёвый первый фильтр
+    QHash<qint64, QStringList> bySize;
+    {
+        BELKIN_TRACE_SCOPE("dupes.scan");
+
+        struct Dir {
+            QString path;
+            int depth;
+        };
+        // каталоги поиска могут пересекаться — файл считается один раз
+        const bool overlap = p.scanDirs.size() > 1;
+        QSet<QString> seen;
+
+        for (const QString &root : p.scanDirs) {
+            if (!QFileInfo(root).isDir())
+                continue;
+
+            std::vector<Dir> dirs{ { canonicalPath(root), 0 } };
+            while (!dirs.empty()) {
+                if (isCancelled(cancel))
+                    return {};
+
+                const Dir dir = std::move(dirs.back());
+                dirs.pop_back();
+                if (isExcluded(dir.path, excluded))
+                    continue;
+
+                QDirIterator it(dir.path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot
+                                        | QDir::Hidden | QDir::NoSymLinks);
+                while (it.hasNext()) {
+                    const QFileInfo fi = it.nextFileInfo();
+                    if (fi.isDir()) {
+                        if (p.level < 0 || dir.depth < p.level)
+                            dirs.push_back({ fi.filePath(), dir.depth + 1 });
+                        continue;
+                    }
+                    if (fi.size() < p.minSize || !matchMask(fi.fileName(), p.masks))
+                        continue;
+                    if (overlap) {
+                        if (seen.contains(fi.filePath()))
+                            continue;
+                        seen.insert(fi.filePath());
+                    }
+                    bySize[fi.size()] << fi.filePath();
+                }
+            }
+        }
+    }
+
+    // 2. Внутри групп одного размера — по хешам блоков
+    BELKIN_TRACE_SCOPE("dupes.compare");
+
+    std::vector<DuplicateGroup> groups;
+    for (auto it = bySize.cbegin(); it != bySize.cend(); ++it) {
+        if (it.value().size() < 2)
+            continue;
+        if (!splitGroup(it.key(), it.value(), p, cancel, groups))
+            return {};
+    }
+
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup &a, const DuplicateGroup &b) {
+        if (a.size != b.size)
+            return a.size > b.size;
+        return a.files.first() < b.files.first();
+    });
+    return groups;
+}
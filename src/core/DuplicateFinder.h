@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+#include "BelkinExport.h"
+
+struct DuplicateScanParams {
+    QStringList scanDirs;
+    QStringList excludeDirs;
+    int level = 0;              // 0 — только сами каталоги, -1 — без ограничения, >0 — глубина
+    qint64 minSize = 1;
+    QStringList masks;          // "*.ext" — по окончанию, иначе подстрока; без учёта регистра
+    qint64 blockSize = 1024;    // первый сравниваемый блок
+    QString algo = "crc32";     // crc32, md5, sha1, sha256, sha512, blake2b
+};
+
+struct DuplicateGroup {
+    qint64 size = 0;
+    QStringList files;          // абсолютные пути, по алфавиту
+};
+
+// Поиск одинаковых файлов — общий для belkin-cli и плагина DuplicateFinder.
+// Файлы группируются по размеру, затем группы одного размера дробятся по
+// хешам блоков: сначала blockSize, дальше блоки растут вдвое до 1 МиБ, так
+// что разные файлы обычно отсеиваются после первого блока, а одинаковые
+// дочитываются крупными кусками. Ссылки не учитываются и не обходятся.
+class BELKINCORE_EXPORT DuplicateFinder
+{
+public:
+    static bool isKnownAlgorithm(const QString &algo);
+
+    // группы от больших файлов к меньшим; пусто и при отмене
+    static std::vector<DuplicateGroup> find(const DuplicateScanParams &params,
+                                            const std::atomic<bool> *cancel = nullptr);
+};
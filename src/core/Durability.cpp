@@ -0,0 +1,219 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include "Durability.h"
+#include "FileOperations.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// fsync/syncfs для каталога по пути
+#ifndef Q_OS_WIN
+bool syncPathFd(const QString &path, bool wholeFs)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    int rc;
+#ifdef Q_OS_LINUX
+    rc = wholeFs ? ::syncfs(fd) : ::fsync(fd);
+#else
+    if (wholeFs)
+        ::sync();
+    rc = ::fsync(fd);
+#endif
+    ::close(fd);
+    return rc == 0;
+}
+#endif
+
+} // namespace
+
+DurabilityTracker::DurabilityTracker(DurabilityPolicy policy)
+    : m_policy(policy)
+{
+}
+
+DurabilityPolicy DurabilityTracker::policyFromString(const QString &name)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "perfile" || n == "per-file" || n == "fdatasync")
+        return DurabilityPolicy::PerFile;
+    if (n == "batched" || n == "syncfs")
+        return DurabilityPolicy::Batched;
+    return DurabilityPolicy::None;
+}
+
+QString DurabilityTracker::policyToString(DurabilityPolicy policy)
+{
+    switch (policy) {
+    case DurabilityPolicy::PerFile: return "perfile";
+    case DurabilityPolicy::Batched: return "batched";
+    case DurabilityPolicy::None:    break;
+    }
+    return "none";
+}
+
+void DurabilityTracker::blockWritten(int fd, qint64 offset, qint64 length)
+{
+    if (m_policy != DurabilityPolicy::Batched || fd < 0 || length <= 0)
+        return;
+
+#ifdef Q_OS_LINUX
+    // только запускаем writeback — не ждём, чтобы не тормозить цикл копирования
+    QElapsedTimer t;
+    t.start();
+    ::sync_file_range(fd, offset, length, SYNC_FILE_RANGE_WRITE);
+    m_syncNs += t.nsecsElapsed();
+#else
+    Q_UNUSED(offset)
+#endif
+}
+
+bool DurabilityTracker::fileWritten(int fd)
+{
+    if (fd < 0)
+        return true;    // нативный хэндл без fd (Windows) — синхронизировать нечем
+
+    bool needSync = m_policy == DurabilityPolicy::PerFile;
+#ifndef Q_OS_LINUX
+    // без syncfs пакетный режим сводится к синхронизации каждого файла
+    needSync = needSync || m_policy == DurabilityPolicy::Batched;
+#endif
+    if (!needSync)
+        return true;
+
+    QElapsedTimer t;
+    t.start();
+#ifdef Q_OS_WIN
+    bool ok = ::_commit(fd) == 0;
+#elif defined(Q_OS_LINUX)
+    bool ok = ::fdatasync(fd) == 0;
+#else
+    bool ok = ::fsync(fd) == 0;
+#endif
+    m_syncNs += t.nsecsElapsed();
+    return ok;
+}
+
+void DurabilityTracker::rememberDir(const QString &dstFile)
+{
+    const QString dir = QFileInfo(dstFile).absolutePath();
+    if (m_dirs.contains(dir))
+        return;
+    m_dirs.insert(dir);
+
+#ifndef Q_OS_WIN
+    struct stat st{};
+    if (::stat(QFile::encodeName(dir).constData(), &st) == 0 && !m_devices.contains(st.st_dev))
+        m_devices.insert(st.st_dev, dir);
+#endif
+}
+
+bool DurabilityTracker::commitFile(const QString &tmpFile, const QString &dstFile)
+{
+    if (m_policy != DurabilityPolicy::None)
+        rememberDir(dstFile);
+
+    if (m_policy == DurabilityPolicy::Batched) {
+        m_pendingRenames.append({tmpFile, dstFile});
+        m_reserved.insert(QDir::cleanPath(QFileInfo(dstFile).absoluteFilePath()));
+        return true;
+    }
+
+    QFile::remove(dstFile);               // если перезапись
+    return QFile::rename(tmpFile, dstFile);
+}
+
+void DurabilityTracker::removeAfterCommit(const QString &path)
+{
+    if (m_policy == DurabilityPolicy::Batched)
+        m_pendingRemovals << path;
+    else
+        FileOperations::removePaths({path}, false);
+}
+
+void DurabilityTracker::directoryCreated(const QString &path)
+{
+    if (m_policy != DurabilityPolicy::None)
+        rememberDir(path);
+}
+
+bool DurabilityTracker::isReserved(const QString &path) const
+{
+    return !m_reserved.isEmpty()
+        && m_reserved.contains(QDir::cleanPath(QFileInfo(path).absoluteFilePath()));
+}
+
+void DurabilityTracker::rollback()
+{
+    for (const auto &r : std::as_const(m_pendingRenames))
+        QFile::remove(r.first);
+    m_pendingRenames.clear();
+    m_pendingRemovals.clear();
+    m_reserved.clear();
+}
+
+bool DurabilityTracker::syncDirectories()
+{
+#ifdef Q_OS_WIN
+    return true;
+#else
+    QElapsedTimer t;
+    t.start();
+    bool ok = true;
+    for (const QString &dir : std::as_const(m_dirs))
+        ok &= syncPathFd(dir, false);
+    m_syncNs += t.nsecsElapsed();
+    return ok;
+#endif
+}
+
+bool DurabilityTracker::commit()
+{
+    if (m_policy == DurabilityPolicy::None)
+        return true;
+
+    bool ok = true;
+
+    if (m_policy == DurabilityPolicy::Batched) {
+#ifndef Q_OS_WIN
+        // 1. Данные всех tmp-файлов — на диск, один syncfs на каждую ФС
+        QElapsedTimer t;
+        t.start();
+        for (const QString &dir : std::as_const(m_devices))
+            ok &= syncPathFd(dir, true);
+        m_syncNs += t.nsecsElapsed();
+#endif
+        if (!ok) {
+            // данные не на диске — публиковать нечего, tmp-файлы не оставляем
+            rollback();
+            return false;
+        }
+
+        // 2. Только теперь rename считается зафиксированным
+        for (const auto &r : std::as_const(m_pendingRenames)) {
+            QFile::remove(r.second);
+            ok &= QFile::rename(r.first, r.second);
+        }
+        m_pendingRenames.clear();
+        m_reserved.clear();
+    }
+
+    // 3. Сами rename — в журнал каталогов
+    ok &= syncDirectories();
+
+    if (ok && !m_pendingRemovals.isEmpty())
+        FileOperations::removePaths(m_pendingRemovals, false);
+    m_pendingRemovals.clear();
+    return ok;
+}
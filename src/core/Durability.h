@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+#include <QMap>
+#include <QSet>
+#include "BelkinExport.h"
+
+// Насколько строго копирование гарантирует сохранность данных на диске
+enum class DurabilityPolicy {
+    None,       // только flush() — данные могут остаться в page cache
+    PerFile,    // fdatasync каждого файла перед rename
+    Batched     // sync_file_range во время копирования + один syncfs на ФС в конце
+};
+
+// Состояние "долговечности" одной задачи копирования/перемещения.
+// Создаётся на задачу, проходит через все copyFileWithProgress,
+// а commit() вызывается один раз в конце.
+class BELKINCORE_EXPORT DurabilityTracker
+{
+public:
+    explicit DurabilityTracker(DurabilityPolicy policy);
+
+    DurabilityPolicy policy() const { return m_policy; }
+
+    // "none" / "perfile" / "batched" (значение из QSettings "Copy/Durability")
+    static DurabilityPolicy policyFromString(const QString &name);
+    static QString policyToString(DurabilityPolicy policy);
+
+    // блок записан в fd (после flush) — в Batched запускаем writeback
+    void blockWritten(int fd, qint64 offset, qint64 length);
+
+    // файл дописан целиком (после flush, до close) — в PerFile делаем fdatasync
+    bool fileWritten(int fd);
+
+    // tmp-файл готов: в None/PerFile сразу переименовываем,
+    // в Batched откладываем rename до commit()
+    bool commitFile(const QString &tmpFile, const QString &dstFile);
+
+    // для move: исходник удаляется только после commit()
+    void removeAfterCommit(const QString &path);
+
+    // задача создала каталог: его запись в родителе тоже надо fsync
+    void directoryCreated(const QString &path);
+
+    // имя уже обещано отложенному rename (Batched): на диске его ещё нет,
+    // но занимать его второй копией нельзя
+    bool isReserved(const QString &path) const;
+
+    // отказ от отложенного: tmp-файлы удаляются, исходники остаются
+    void rollback();
+
+    // syncfs по каждой ФС назначения, отложенные rename, fsync каталогов,
+    // удаление исходников
+    bool commit();
+
+    // сколько времени ушло на fdatasync/sync_file_range/syncfs/fsync
+    qint64 syncTimeMs() const { return m_syncNs / 1000000; }
+
+private:
+    void rememberDir(const QString &dstFile);
+    bool syncDirectories();
+
+    DurabilityPolicy m_policy;
+    qint64 m_syncNs = 0;
+
+    QList<QPair<QString, QString>> m_pendingRenames; // tmp -> dst
+    QStringList m_pendingRemovals;
+    QSet<QString> m_reserved;           // dst отложенных rename
+    QSet<QString> m_dirs;               // каталоги назначения (для fsync после rename)
+    QMap<quint64, QString> m_devices;   // st_dev -> любой каталог на этой ФС
+};
@@ -0,0 +1,666 @@
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "FileIndex.h"
+#include "FileNameIndex.h"
+#include "IoPool.h"
+#include "MetadataFetcher.h"
+#include "NameFilter.h"
+#include "Trace.h"
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// первое обновление — не во время запуска
+constexpr int FirstUpdateDelayMs = 60 * 1000;
+// столько перекрытых каталогов — пора переписать индекс
+constexpr int MaxOverrides = 10000;
+// mtime у ФС в секундах: каталог, изменённый за эти секунды до обхода, мог
+// измениться ещё раз в ту же секунду после чтения — такому mtime не верим
+constexpr qint64 RacySeconds = 2;
+
+using Entries = std::vector<FileNameIndex::Entry>;
+
+bool isCancelled(const std::atomic<bool> *cancel)
+{
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+// записи каталога, перечитанные после события; до следующего обновления
+// индекса заменяют записанные в нём
+struct Override {
+    Entries entries;
+    QSet<QByteArray> subdirs;
+    quint64 seq = 0;            // поколение события: перекрытие старше обхода уходит с ним
+};
+
+struct Volume {
+    QByteArray root;                            // точка монтирования в кодировке ФС
+    std::shared_ptr<FileNameIndex> index;
+    QHash<QByteArray, Override> overrides;      // по пути каталога от корня
+    // каталоги с событиями, ещё не перечитанные: их по очереди перечитывает
+    // одно задание IoPool на ФС (refreshing), сколько бы событий ни пришло
+    QSet<QByteArray> pending;
+    bool refreshing = false;
+};
+
+struct Subdir {
+    QByteArray name;
+    qint64 mtime = 0;
+};
+
+struct BuildItem {
+    QByteArray rel;
+    qint64 mtime = 0;
+};
+
+// путь от точки монтирования; false — path не на ней
+bool relativeTo(const QString &mountPoint, const QString &path, QByteArray &rel)
+{
+    if (path == mountPoint) {
+        rel.clear();
+        return true;
+    }
+    const QString prefix = mountPoint.endsWith(QLatin1Char('/')) ? mountPoint
+                                                                 : mountPoint + QLatin1Char('/');
+    if (!path.startsWith(prefix))
+        return false;
+    rel = QFile::encodeName(path.mid(prefix.size()));
+    return true;
+}
+
+QByteArray joinPath(QByteArrayView dir, QByteArrayView name)
+{
+    QByteArray path = dir.toByteArray();
+    if (!path.isEmpty() && !path.endsWith('/'))
+        path += '/';
+    path += name;
+    return path;
+}
+
+bool isHiddenPath(QByteArrayView rel)
+{
+    for (qsizetype i = 0; i < rel.size(); ++i) {
+        if (rel[i] == '.' && (i == 0 || rel[i - 1] == '/'))
+            return true;
+    }
+    return false;
+}
+
+// каталог dir пропал: у одного из предков перечитанные записи без него
+bool removedByOverrides(const Volume &v, QByteArrayView dir)
+{
+    if (v.overrides.isEmpty() || dir.isEmpty())
+        return false;
+
+    const std::string_view d(dir.data(), size_t(dir.size()));
+    size_t start = 0;
+    for (;;) {
+        const size_t slash = d.find('/', start);
+        const size_t end = slash == std::string_view::npos ? d.size() : slash;
+        const QByteArray parent(d.data(), qsizetype(start == 0 ? 0 : start - 1));
+        const auto it = v.overrides.constFind(parent);
+        if (it != v.overrides.cend()
+            && !it->subdirs.contains(QByteArray(d.data() + start, qsizetype(end - start))))
+            return true;
+        if (slash == std::string_view::npos)
+            return false;
+        start = slash + 1;
+    }
+}
+
+// Записи каталога path (в кодировке ФС) без скрытых; подкаталоги той же ФС
+// (dev) с их mtime — в subdirs, если он задан
+bool readDirectory(const QByteArray &path, quint64 dev, Entries &entries, std::vector<Subdir> *subdirs)
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::open(path.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    DIR *d = ::fdopendir(fd);
+    if (!d) {
+        ::close(fd);
+        return false;
+    }
+
+    while (const dirent *e = ::readdir(d)) {
+        const char *name = e->d_name;
+        if (name[0] == '.')
+            continue;
+
+        bool isDir = e->d_type == DT_DIR;
+        if (e->d_type == DT_UNKNOWN || (isDir && subdirs)) {
+            struct stat st;
+            if (::fstatat(::dirfd(d), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                continue;
+            isDir = S_ISDIR(st.st_mode);
+            // другая ФС (точка монтирования) — сама запись есть, внутрь не идём
+            if (isDir && subdirs && quint64(st.st_dev) == dev)
+                subdirs->push_back({ QByteArray(name), qint64(st.st_mtim.tv_sec) });
+        }
+        entries.push_back({ QByteArray(name), isDir });
+    }
+    ::closedir(d);
+    return true;
+#else
+    Q_UNUSED(dev);
+    const QDir dir(QFile::decodeName(path));
+    if (!dir.exists())
+        return false;
+    const QFileInfoList list = dir.entryInfoList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot);
+    for (const QFileInfo &fi : list) {
+        const bool isDir = fi.isDir() && !fi.isSymLink();
+        entries.push_back({ QFile::encodeName(fi.fileName()), isDir });
+        if (isDir && subdirs)
+            subdirs->push_back({ QFile::encodeName(fi.fileName()), fi.lastModified().toSecsSinceEpoch() });
+    }
+    return true;
+#endif
+}
+
+// Обход ФС mountPoint в новый индекс file. Каталог, чей mtime совпал
+// с записанным в old, не читается: записи берутся из old, а stat нужен
+// только его подкаталогам (пачкой через MetadataFetcher).
+// Каталоги раздаются потокам из общей очереди: работа каждого — системные
+// вызовы, а не вычисления, так что общий мьютекс не мешает.
+std::shared_ptr<FileNameIndex> buildIndex(const QString &mountPoint,
+                                          const std::shared_ptr<FileNameIndex> &old,
+                                          const QString &file, const std::atomic<bool> *cancel)
+{
+    BELKIN_TRACE_SCOPE("index.build");
+
+    const quint32 statFields = MetadataFetcher::Type | MetadataFetcher::MTime | MetadataFetcher::Identity;
+    const QByteArray root = QFile::encodeName(mountPoint);
+
+    MetadataFetcher::Result rootStat;
+    MetadataFetcher(statFields, MetadataFetcher::Links::NoFollow)
+        .fetch({ root }, [&rootStat](const MetadataFetcher::Result &r) { rootStat = r; });
+    if (!rootStat.ok() || !rootStat.isDir())
+        return nullptr;
+
+    const quint64 dev = rootStat.dev;
+    const qint64 racyAfter = QDateTime::currentSecsSinceEpoch() - RacySeconds;
+
+    FileNameIndex::Builder builder;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<BuildItem> queue;
+    int busy = 0;
+    queue.push_back({ QByteArray(), rootStat.mtime });
+
+    const auto worker = [&]() {
+        MetadataFetcher fetcher(statFields, MetadataFetcher::Links::NoFollow);
+        Entries entries;
+        std::vector<Subdir> subdirs;
+        std::vector<QByteArray> paths;
+        std::vector<size_t> pathEntry;
+
+        for (;;) {
+            BuildItem item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                // очередь пуста и никто не работает — обход кончился
+                wake.wait(lock, [&]() { return !queue.empty() || busy == 0 || isCancelled(cancel); });
+                if (queue.empty() || isCancelled(cancel)) {
+                    wake.notify_all();
+                    return;
+                }
+                item = std::move(queue.front());
+                queue.pop_front();
+                ++busy;
+            }
+
+            entries.clear();
+            subdirs.clear();
+            const QByteArray path = joinPath(root, item.rel);
+
+            int known = old ? old->findDirectory(item.rel) : -1;
+            if (known >= 0 && old->directoryMtime(quint32(known)) != item.mtime)
+                known = -1;
+
+            bool listed = true;
+            if (known >= 0) {
+                old->children(quint32(known), entries);
+                paths.clear();
+                pathEntry.clear();
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    if (entries[i].dir) {
+                        paths.push_back(joinPath(path, entries[i].name));
+                        pathEntry.push_back(i);
+                    }
+                }
+                fetcher.fetch(paths, [&](const MetadataFetcher::Result &r) {
+                    if (r.ok() && r.isDir() && r.dev == dev)
+                        subdirs.push_back({ entries[pathEntry[size_t(r.index)]].name, r.mtime });
+                }, cancel);
+            } else {
+                listed = readDirectory(path, dev, entries, &subdirs);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (listed)
+                    builder.addDirectory(item.rel, item.mtime < racyAfter ? item.mtime : -1, entries);
+                for (const Subdir &sub : subdirs)
+                    queue.push_back({ joinPath(item.rel, sub.name), sub.mtime });
+                --busy;
+            }
+            wake.notify_all();
+        }
+    };
+
+    const int threads = qBound(2, QThread::idealThreadCount(), 8);
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool)
+        t.join();
+
+    if (isCancelled(cancel))
+        return nullptr;
+
+    QDir().mkpath(QFileInfo(file).absolutePath());
+    if (!builder.write(file, root))
+        return nullptr;
+
+    auto index = std::make_shared<FileNameIndex>();
+    if (!index->open(file))
+        return nullptr;
+    return index;
+}
+
+} // namespace
+
+struct FileIndex::Data {
+    mutable QReadWriteLock lock;
+    QHash<QString, Volume> volumes;     // по точке монтирования
+    std::atomic<quint64> seq{0};        // номер последнего события
+};
+
+FileIndex *FileIndex::instance()
+{
+    static FileIndex *index = new FileIndex(QCoreApplication::instance());
+    return index;
+}
+
+FileIndex::FileIndex(QObject *parent)
+    : QObject(parent)
+    , m_data(std::make_shared<Data>())
+{
+    // готовый индекс только отображается в память — поиск доступен сразу
+    for (const QString &mountPoint : mounts())
+        load(mountPoint);
+
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    const int minutes = qMax(1, settings.value("Index/RescanMinutes", 60).toInt());
+    m_rescanTimer.setInterval(minutes * 60 * 1000);
+    connect(&m_rescanTimer, &QTimer::timeout, this, [this]() { update(); });
+    m_rescanTimer.start();
+    QTimer::singleShot(FirstUpdateDelayMs, this, [this]() { update(); });
+
+    connect(IoPool::instance(), &IoPool::slotFreed, this, &FileIndex::retryRefresh);
+    connect(IoPool::instance(), &IoPool::responsivenessChanged, this,
+            [this](const QString &, bool responsive) {
+        if (responsive)
+            retryRefresh();
+    });
+}
+
+FileIndex::~FileIndex()
+{
+    m_queue.clear();
+    if (m_thread) {
+        m_cancel->store(true);
+        m_thread->wait();
+    }
+}
+
+QString FileIndex::indexFile(const QString &mountPoint)
+{
+    const QByteArray key = QCryptographicHash::hash(mountPoint.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+         + QStringLiteral("/index/") + QString::fromLatin1(key.left(16)) + QStringLiteral(".idx");
+}
+
+QStringList FileIndex::mounts() const
+{
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    return settings.value("Index/Mounts").toStringList();
+}
+
+bool FileIndex::isIndexed(const QString &mountPoint) const
+{
+    return mounts().contains(QDir::cleanPath(mountPoint));
+}
+
+void FileIndex::setIndexed(const QString &mountPoint, bool on)
+{
+    const QString clean = QDir::cleanPath(mountPoint);
+    QStringList list = mounts();
+    if (on == list.contains(clean))
+        return;
+
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    if (on) {
+        list.append(clean);
+        settings.setValue("Index/Mounts", list);
+        load(clean);
+        update(clean);
+        return;
+    }
+
+    list.removeAll(clean);
+    settings.setValue("Index/Mounts", list);
+    m_queue.removeAll(clean);
+    {
+        QWriteLocker lock(&m_data->lock);
+        m_data->volumes.remove(clean);
+    }
+    // отображённый файл остаётся у тех, кто его ещё держит
+    QFile::remove(indexFile(clean));
+    emit indexUpdated(clean);
+}
+
+void FileIndex::load(const QString &mountPoint)
+{
+    QWriteLocker lock(&m_data->lock);
+    Volume &volume = m_data->volumes[mountPoint];
+    volume.root = QFile::encodeName(mountPoint);
+
+    auto index = std::make_shared<FileNameIndex>();
+    if (index->open(indexFile(mountPoint)) && index->root() == volume.root)
+        volume.index = index;
+}
+
+bool FileIndex::covers(const QString &path) const
+{
+    const QString clean = QDir::cleanPath(path);
+    QByteArray rel;
+    QReadLocker lock(&m_data->lock);
+    for (auto it = m_data->volumes.cbegin(); it != m_data->volumes.cend(); ++it) {
+        if (it->index && relativeTo(it.key(), clean, rel))
+            return true;
+    }
+    return false;
+}
+
+void FileIndex::search(const QString &pattern, const QString &under, const HitVisitor &visit) const
+{
+    BELKIN_TRACE_SCOPE("index.query");
+
+    const NameFilter filter(pattern);
+    if (filter.isEmpty())
+        return;
+    const QString cleanUnder = under.isEmpty() ? QString() : QDir::cleanPath(under);
+
+    bool more = true;
+    QReadLocker lock(&m_data->lock);
+    for (auto it = m_data->volumes.cbegin(); it != m_data->volumes.cend() && more; ++it) {
+        const Volume &v = it.value();
+
+        QByteArray rel, unused;
+        if (!cleanUnder.isEmpty() && !relativeTo(it.key(), cleanUnder, rel)) {
+            // вся ФС лежит под under — ищем во всём индексе
+            if (!relativeTo(cleanUnder, it.key(), unused))
+                continue;
+            rel.clear();
+        }
+
+        if (v.index) {
+            qint64 lastDir = -1;
+            QByteArray dirPath;
+            bool skip = false;
+            v.index->search(filter, rel, [&](quint32 dir, QByteArrayView name, bool isDir) {
+                if (qint64(dir) != lastDir) {
+                    lastDir = dir;
+                    dirPath = v.index->directoryPath(dir);
+                    // записи каталога перечитаны — берутся из перекрытия ниже
+                    skip = v.overrides.contains(dirPath) || removedByOverrides(v, dirPath);
+                }
+                if (skip)
+                    return true;
+                more = visit({ QFile::decodeName(joinPath(v.root, joinPath(dirPath, name))), isDir });
+                return more;
+            });
+        }
+
+        for (auto o = v.overrides.cbegin(); o != v.overrides.cend() && more; ++o) {
+            const QByteArray &dir = o.key();
+            if (!rel.isEmpty() && dir != rel && !dir.startsWith(rel + '/'))
+                continue;
+            if (removedByOverrides(v, dir))
+                continue;
+            for (const FileNameIndex::Entry &e : o->entries) {
+                if (!filter.matches(e.name))
+                    continue;
+                more = visit({ QFile::decodeName(joinPath(v.root, joinPath(dir, e.name))), e.dir });
+                if (!more)
+                    break;
+            }
+        }
+    }
+}
+
+QList<FileIndex::Hit> FileIndex::search(const QString &pattern, const QString &under, int limit) const
+{
+    QList<Hit> hits;
+    if (limit <= 0)
+        return hits;
+    search(pattern, under, [&](const Hit &hit) {
+        hits.append(hit);
+        return hits.size() < limit;
+    });
+    return hits;
+}
+
+void FileIndex::notifyChanged(const QString &dir)
+{
+    const QString clean = QDir::cleanPath(dir);
+
+    // самая глубокая индексируемая ФС, на которой лежит каталог
+    QString mountPoint;
+    bool tooMany = false;
+    bool submit = false;
+    {
+        QWriteLocker lock(&m_data->lock);
+        QByteArray rel;
+        for (auto it = m_data->volumes.cbegin(); it != m_data->volumes.cend(); ++it) {
+            QByteArray r;
+            if (it->index && it.key().size() > mountPoint.size() && relativeTo(it.key(), clean, r)) {
+                mountPoint = it.key();
+                rel = r;
+            }
+        }
+        if (mountPoint.isEmpty() || isHiddenPath(rel))
+            return;
+        Volume &v = m_data->volumes[mountPoint];
+        tooMany = v.overrides.size() >= MaxOverrides;
+        v.pending.insert(rel);
+        submit = !v.refreshing;
+    }
+    if (tooMany)
+        update(mountPoint);
+    if (submit)
+        startRefresh(mountPoint);
+}
+
+void FileIndex::startRefresh(const QString &mountPoint)
+{
+    const std::shared_ptr<Data> data = m_data;
+    {
+        QWriteLocker lock(&data->lock);
+        const auto it = data->volumes.find(mountPoint);
+        if (it == data->volumes.end() || it->refreshing || it->pending.isEmpty())
+            return;
+        it->refreshing = true;
+    }
+
+    // чтение каталогов — в IoPool: сетевой ресурс не держит GUI. Задание
+    // перечитывает и то, что накопится, пока оно идёт
+    const IoPool::StartResult started = IoPool::instance()->start(mountPoint, [data, mountPoint]() {
+        for (;;) {
+            QSet<QByteArray> dirs;
+            QByteArray root;
+            {
+                QWriteLocker lock(&data->lock);
+                const auto it = data->volumes.find(mountPoint);
+                if (it == data->volumes.end())
+                    return;     // ФС больше не индексируется
+                if (it->pending.isEmpty()) {
+                    it->refreshing = false;
+                    return;
+                }
+                dirs.swap(it->pending);
+                root = it->root;
+            }
+
+            // события до этого момента чтение уже увидит
+            const quint64 seq = ++data->seq;
+            std::vector<std::pair<QByteArray, Override>> read;
+            read.reserve(size_t(dirs.size()));
+            for (const QByteArray &rel : std::as_const(dirs)) {
+                Override o;
+                o.seq = seq;
+                // каталог удалён — пустое перекрытие прячет его записи
+                if (!readDirectory(joinPath(root, rel), 0, o.entries, nullptr))
+                    o.entries.clear();
+                for (const FileNameIndex::Entry &e : o.entries) {
+                    if (e.dir)
+                        o.subdirs.insert(e.name);
+                }
+                read.emplace_back(rel, std::move(o));
+            }
+
+            QWriteLocker lock(&data->lock);
+            const auto it = data->volumes.find(mountPoint);
+            if (it == data->volumes.end())
+                return;
+            for (auto &[rel, o] : read) {
+                const auto prev = it->overrides.constFind(rel);
+                if (prev != it->overrides.cend() && prev->seq > seq)
+                    continue;   // уже есть более свежее
+                it->overrides.insert(rel, std::move(o));
+            }
+        }
+    });
+    if (started == IoPool::StartResult::Started)
+        return;
+
+    // ресурс занят или не отвечает: каталоги остаются в pending, их
+    // перечитает retryRefresh, когда место освободится или ресурс оживёт
+    QWriteLocker lock(&data->lock);
+    const auto it = data->volumes.find(mountPoint);
+    if (it != data->volumes.end())
+        it->refreshing = false;
+}
+
+void FileIndex::retryRefresh()
+{
+    QStringList waiting;
+    {
+        QReadLocker lock(&m_data->lock);
+        for (auto it = m_data->volumes.cbegin(); it != m_data->volumes.cend(); ++it) {
+            if (!it->refreshing && !it->pending.isEmpty())
+                waiting << it.key();
+        }
+    }
+    for (const QString &mountPoint : std::as_const(waiting))
+        startRefresh(mountPoint);
+}
+
+void FileIndex::update(const QString &mountPoint)
+{
+    const QStringList targets = mountPoint.isEmpty() ? mounts() : QStringList{ QDir::cleanPath(mountPoint) };
+    for (const QString &target : targets) {
+        if (!m_queue.contains(target))
+            m_queue.append(target);
+    }
+    startNext();
+}
+
+void FileIndex::startNext()
+{
+    if (m_thread)
+        return;
+
+    while (!m_queue.isEmpty()) {
+        const QString mountPoint = m_queue.takeFirst();
+        // не отвечающий ресурс — до следующего раза
+        if (!isIndexed(mountPoint) || !IoPool::instance()->isResponsive(mountPoint))
+            continue;
+
+        std::shared_ptr<FileNameIndex> old;
+        {
+            QReadLocker lock(&m_data->lock);
+            const auto it = m_data->volumes.constFind(mountPoint);
+            if (it == m_data->volumes.cend())
+                continue;
+            old = it->index;
+        }
+        // события до этого момента обход увидит сам
+        const quint64 seq = m_data->seq.load();
+
+        m_cancel = std::make_shared<std::atomic<bool>>(false);
+        const std::shared_ptr<std::atomic<bool>> cancel = m_cancel;
+        const QString file = indexFile(mountPoint);
+
+        m_thread = QThread::create([this, mountPoint, old, file, cancel, seq]() {
+            const std::shared_ptr<FileNameIndex> index = buildIndex(mountPoint, old, file, cancel.get());
+            QMetaObject::invokeMethod(this, [this, mountPoint, index, seq]() {
+                onBuilt(mountPoint, index, seq);
+            }, Qt::QueuedConnection);
+        });
+        m_thread->setObjectName("file index");
+        connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+        m_thread->start(QThread::IdlePriority);
+        return;
+    }
+}
+
+void FileIndex::onBuilt(const QString &mountPoint, const std::shared_ptr<FileNameIndex> &index,
+                        quint64 seq)
+{
+    BELKIN_TRACE_SCOPE("index.built");
+
+    m_thread = nullptr;
+    if (index) {
+        {
+            QWriteLocker lock(&m_data->lock);
+            const auto it = m_data->volumes.find(mountPoint);
+            if (it != m_data->volumes.end()) {
+                it->index = index;
+                for (auto o = it->overrides.begin(); o != it->overrides.end();) {
+                    if (o->seq <= seq)
+                        o = it->overrides.erase(o);
+                    else
+                        ++o;
+                }
+            }
+        }
+        emit indexUpdated(mountPoint);
+    }
+    startNext();
+}
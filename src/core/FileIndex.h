@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "BelkinExport.h"
+
+class FileNameIndex;
+class QThread;
+
+// Необязательный индекс имён файлов по точкам монтирования, как у locate:
+// поиск по имени на томе в десятки миллионов файлов — за миллисекунды,
+// без обхода. Какие ФС индексировать, задаётся в настройках (Index/Mounts).
+// Индекс каждой ФС — файл FileNameIndex в каталоге кэша. Обновляется:
+// - сравнением mtime каталогов (фоном, по таймеру и по update()): каталог
+//   с прежним mtime не читается, записи берутся из старого индекса, так что
+//   обновление стоит stat каталогов, а не чтения всего дерева;
+// - событиями об изменении каталога (notifyChanged — DirectoryWatcher,
+//   операции над файлами): каталог перечитывается сразу и до следующего
+//   обновления его записи перекрывают записанные в индексе. События
+//   копятся по ФС, и их перечитывает одно задание IoPool за раз: поток
+//   событий не занимает места, нужные панелям, а отказ пула не теряет
+//   событие — каталог перечитается, когда место освободится.
+// Скрытые записи и другие ФС внутри точки монтирования не индексируются.
+// search() — из любого потока, в том числе из плагинов (ApplicationAPI::fileIndex).
+class BELKINCORE_EXPORT FileIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Hit {
+        QString path;
+        bool    dir = false;
+    };
+
+    static FileIndex *instance();
+
+    // индексируемые точки монтирования
+    QStringList mounts() const;
+    void setIndexed(const QString &mountPoint, bool on);
+    bool isIndexed(const QString &mountPoint) const;
+
+    // индекс, в котором есть path, уже построен
+    bool covers(const QString &path) const;
+    // какая-то ФС сейчас индексируется
+    bool isUpdating() const { return m_thread != nullptr; }
+
+    // Записи, чьё имя проходит шаблон (как быстрый фильтр панели: без * и ?
+    // — подстрока, с ними — glob; регистр не учитывается), под каталогом
+    // under (пусто — во всех индексах), по одной в visit, без ограничения
+    // числа; visit вернул false — поиск прекращается. Индекс всё это время
+    // заблокирован на чтение — visit не должен долго ждать.
+    // Диск не трогает — только отображённые файлы индекса
+    using HitVisitor = std::function<bool(const Hit &hit)>;
+    void search(const QString &pattern, const QString &under, const HitVisitor &visit) const;
+    // то же списком, не больше limit записей
+    QList<Hit> search(const QString &pattern, const QString &under = QString(),
+                      int limit = 10000) const;
+
+    // содержимое каталога dir изменилось
+    void notifyChanged(const QString &dir);
+
+    // обновить индекс mountPoint (пусто — все) сейчас
+    void update(const QString &mountPoint = QString());
+
+signals:
+    void indexUpdated(const QString &mountPoint);
+
+private:
+    explicit FileIndex(QObject *parent = nullptr);
+    ~FileIndex() override;
+
+    struct Data;
+
+    static QString indexFile(const QString &mountPoint);
+    void load(const QString &mountPoint);
+    void startNext();
+    // перечитать каталоги из событий mountPoint (одно задание IoPool на ФС)
+    void startRefresh(const QString &mountPoint);
+    void retryRefresh();
+    void onBuilt(const QString &mountPoint, const std::shared_ptr<FileNameIndex> &index,
+                 quint64 seq);
+
+    // индексы и перекрытия — в общем с заданиями IoPool объекте
+    std::shared_ptr<Data> m_data;
+
+    QStringList m_queue;
+    QThread *m_thread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+    QTimer m_rescanTimer;
+};
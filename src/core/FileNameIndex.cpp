@@ -0,0 +1,723 @@
+#include <QDateTime>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include "FileNameIndex.h"
+#include "NameFilter.h"
+#include "Trace.h"
+
+namespace {
+
+constexpr quint32 Magic = 0x49464342;   // "BCFI"
+constexpr quint32 Version = 1;
+constexpr quint32 BlockSize = 16;       // записей в блоке front coding
+
+// пересекать длинный список дороже, чем проверить оставшихся кандидатов по имени
+constexpr size_t MaxIntersectRatio = 64;
+
+void putVarint(std::string &out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.push_back(char(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+bool getVarint(const uchar *&p, const uchar *end, quint64 &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uchar b = *p++;
+        v |= quint64(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+inline uchar foldByte(uchar c)
+{
+    return (c >= 'A' && c <= 'Z') ? uchar(c + ('a' - 'A')) : c;
+}
+
+// Триграммы ASCII-части s без учёта регистра; байты >= 0x80 в триграммы не
+// входят — регистр не-ASCII символов NameFilter сворачивает через QString
+void appendGrams(QByteArrayView s, std::vector<quint32> &out)
+{
+    for (qsizetype i = 0; i + 3 <= s.size(); ++i) {
+        const uchar a = uchar(s[i]), b = uchar(s[i + 1]), c = uchar(s[i + 2]);
+        if ((a | b | c) & 0x80)
+            continue;
+        out.push_back(quint32(foldByte(a)) << 16 | quint32(foldByte(b)) << 8 | foldByte(c));
+    }
+}
+
+void uniqueSorted(std::vector<quint32> &v)
+{
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+size_t commonPrefix(std::string_view a, std::string_view b)
+{
+    const size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i])
+        ++i;
+    return i;
+}
+
+// Чтение последовательности, закодированной front coding блоками по
+// BlockSize: в начале блока префикс пустой, так что с любого блока можно
+// начать, а дальше читать подряд через границы блоков
+class FrontCodedReader
+{
+public:
+    FrontCodedReader(const uchar *data, quint64 size, const quint64 *index, quint32 count, bool flags)
+        : m_data(data), m_end(data + size), m_index(index), m_count(count), m_flags(flags)
+    {
+    }
+
+    // следующий read() вернёт элемент item
+    bool seek(quint32 item)
+    {
+        if (item >= m_count)
+            return false;
+        // внутри того же блока и впереди — дочитываем, не возвращаясь
+        if (!(m_next > 0 && item >= m_next && item / BlockSize == (m_next - 1) / BlockSize)) {
+            const quint64 offset = m_index[item / BlockSize];
+            if (offset > quint64(m_end - m_data))
+                return false;
+            m_p = m_data + offset;
+            m_next = item - item % BlockSize;
+            m_value.clear();
+        }
+        while (m_next < item) {
+            if (!read())
+                return false;
+        }
+        return true;
+    }
+
+    bool read()
+    {
+        if (m_next >= m_count || !m_p)
+            return false;
+        quint64 prefix = 0, suffix = 0;
+        if (!getVarint(m_p, m_end, prefix) || !getVarint(m_p, m_end, suffix))
+            return false;
+        m_flag = false;
+        if (m_flags) {
+            m_flag = suffix & 1;
+            suffix >>= 1;
+        }
+        if (prefix > m_value.size() || suffix > quint64(m_end - m_p))
+            return false;
+        m_value.resize(size_t(prefix));
+        m_value.append(reinterpret_cast<const char *>(m_p), size_t(suffix));
+        m_p += suffix;
+        ++m_next;
+        return true;
+    }
+
+    QByteArrayView value() const { return QByteArrayView(m_value.data(), qsizetype(m_value.size())); }
+    bool flag() const { return m_flag; }
+
+private:
+    const uchar   *m_data;
+    const uchar   *m_end;
+    const quint64 *m_index;
+    quint32        m_count;
+    bool           m_flags;
+
+    const uchar *m_p = nullptr;
+    quint32      m_next = 0;
+    std::string  m_value;
+    bool         m_flag = false;
+};
+
+// Запись front-coded последовательности: блоки — в out, смещения блоков — в index
+class FrontCodedWriter
+{
+public:
+    FrontCodedWriter(std::string &out, std::vector<quint64> &index, quint64 base = 0)
+        : m_out(out), m_index(index), m_base(base)
+    {
+    }
+
+    void add(std::string_view value, int flag = -1)
+    {
+        if (m_count % BlockSize == 0) {
+            m_index.push_back(m_base + m_out.size());
+            m_prev.clear();
+        }
+        const size_t prefix = commonPrefix(m_prev, value);
+        const quint64 suffix = value.size() - prefix;
+        putVarint(m_out, prefix);
+        putVarint(m_out, flag < 0 ? suffix : (suffix << 1 | quint64(flag)));
+        m_out.append(value.data() + prefix, size_t(suffix));
+        m_prev.assign(value);
+        ++m_count;
+    }
+
+    // out сброшен в файл: смещения дальше считаются от нового начала
+    void flushed(quint64 bytes) { m_base += bytes; }
+
+private:
+    std::string          &m_out;
+    std::vector<quint64> &m_index;
+    quint64               m_base;
+    std::string           m_prev;
+    quint64               m_count = 0;
+};
+
+} // namespace
+
+struct FileNameIndex::Header {
+    quint32 magic;
+    quint32 version;
+    qint64  builtAt;
+    quint32 dirCount;
+    quint32 entryCount;
+    quint32 gramCount;
+    quint32 rootSize;
+    quint64 rootOffset;
+    quint64 dirInfoOffset;
+    quint64 dirBlocksOffset;
+    quint64 dirBlocksSize;
+    quint64 dirIndexOffset;         // quint64 на блок
+    quint64 entryBlocksOffset;
+    quint64 entryBlocksSize;
+    quint64 entryIndexOffset;
+    quint64 gramOffset;
+    quint64 postingsOffset;
+    quint64 postingsSize;
+    quint64 fileSize;
+};
+
+struct FileNameIndex::DirInfo {
+    quint32 firstEntry;
+    quint32 entryCount;
+    qint64  mtime;
+};
+
+struct FileNameIndex::Gram {
+    quint32 key;
+    quint32 count;
+    quint64 offset;                 // от начала posting lists
+    quint64 size;
+};
+
+// ---- Builder ----
+
+void FileNameIndex::Builder::addDirectory(QByteArrayView path, qint64 mtime,
+                                          const std::vector<Entry> &entries)
+{
+    Dir dir;
+    dir.path = path.toByteArray();
+    dir.mtime = mtime;
+    dir.dirs.reserve(entries.size());
+    for (const Entry &e : entries) {
+        dir.names.append(e.name.constData(), size_t(e.name.size()));
+        dir.names.push_back('\0');
+        dir.dirs.push_back(e.dir ? 1 : 0);
+    }
+    m_dirs.push_back(std::move(dir));
+}
+
+bool FileNameIndex::Builder::write(const QString &file, const QByteArray &root) const
+{
+    BELKIN_TRACE_SCOPE("index.write");
+
+    std::vector<quint32> order(m_dirs.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](quint32 a, quint32 b) {
+        return pathLess(m_dirs[a].path, m_dirs[b].path);
+    });
+
+    QSaveFile out(file);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+
+    quint64 pos = 0;
+    bool ok = true;
+    const auto writeBytes = [&](const void *data, quint64 size) {
+        if (ok && out.write(static_cast<const char *>(data), qint64(size)) != qint64(size))
+            ok = false;
+        pos += size;
+    };
+    // разделы выровнены по 8: в отображённом файле их читают как массивы
+    const auto pad = [&]() {
+        static const char zeros[8] = {};
+        if (pos % 8)
+            writeBytes(zeros, 8 - pos % 8);
+    };
+
+    Header h = {};
+    h.magic = Magic;
+    h.version = Version;
+    h.builtAt = QDateTime::currentSecsSinceEpoch();
+    h.dirCount = quint32(order.size());
+    h.rootSize = quint32(root.size());
+    writeBytes(&h, sizeof(h));
+
+    h.rootOffset = pos;
+    writeBytes(root.constData(), quint64(root.size()));
+    pad();
+
+    // записи каталогов подряд, в порядке каталогов; блоки пишутся в файл
+    // по мере кодирования, триграммы копятся в памяти
+    struct Postings {
+        std::string bytes;
+        quint32 last = 0;
+        quint32 count = 0;
+    };
+    std::unordered_map<quint32, Postings> postings;
+    std::vector<DirInfo> infos(order.size());
+    std::vector<quint64> entryIndex;
+    std::string buffer;
+    FrontCodedWriter entries(buffer, entryIndex);
+
+    h.entryBlocksOffset = pos;
+    quint64 id = 0;
+    std::vector<std::string_view> names;
+    std::vector<quint32> byName;
+    std::vector<quint32> keys;
+    for (size_t k = 0; k < order.size(); ++k) {
+        const Dir &dir = m_dirs[order[k]];
+
+        names.clear();
+        for (size_t start = 0; start < dir.names.size();) {
+            const size_t stop = dir.names.find('\0', start);
+            names.emplace_back(dir.names.data() + start, stop - start);
+            start = stop + 1;
+        }
+        byName.resize(names.size());
+        std::iota(byName.begin(), byName.end(), 0u);
+        std::sort(byName.begin(), byName.end(),
+                  [&names](quint32 a, quint32 b) { return names[a] < names[b]; });
+
+        infos[k] = { quint32(id), quint32(names.size()), dir.mtime };
+        for (quint32 j : byName) {
+            if (id >= 0xffffffffu)
+                return false;
+            entries.add(names[j], dir.dirs[j]);
+
+            keys.clear();
+            appendGrams(QByteArrayView(names[j].data(), qsizetype(names[j].size())), keys);
+            uniqueSorted(keys);
+            for (quint32 key : keys) {
+                Postings &p = postings[key];
+                putVarint(p.bytes, id - p.last);
+                p.last = quint32(id);
+                ++p.count;
+            }
+            ++id;
+        }
+
+        if (buffer.size() >= (1u << 20)) {
+            writeBytes(buffer.data(), buffer.size());
+            entries.flushed(buffer.size());
+            buffer.clear();
+        }
+    }
+    writeBytes(buffer.data(), buffer.size());
+    buffer.clear();
+    h.entryCount = quint32(id);
+    h.entryBlocksSize = pos - h.entryBlocksOffset;
+    pad();
+
+    // смещения блоков писались от начала раздела записей
+    h.entryIndexOffset = pos;
+    writeBytes(entryIndex.data(), entryIndex.size() * sizeof(quint64));
+    pad();
+
+    h.dirInfoOffset = pos;
+    writeBytes(infos.data(), infos.size() * sizeof(DirInfo));
+    pad();
+
+    std::vector<quint64> dirIndex;
+    FrontCodedWriter dirs(buffer, dirIndex);
+    for (quint32 k : order)
+        dirs.add(std::string_view(m_dirs[k].path.constData(), size_t(m_dirs[k].path.size())));
+    h.dirBlocksOffset = pos;
+    h.dirBlocksSize = buffer.size();
+    writeBytes(buffer.data(), buffer.size());
+    pad();
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    h.dirIndexOffset = pos;
+    writeBytes(dirIndex.data(), dirIndex.size() * sizeof(quint64));
+    pad();
+
+    std::vector<quint32> gramKeys;
+    gramKeys.reserve(postings.size());
+    for (const auto &p : postings)
+        gramKeys.push_back(p.first);
+    std::sort(gramKeys.begin(), gramKeys.end());
+
+    std::vector<Gram> table;
+    table.reserve(gramKeys.size());
+    quint64 offset = 0;
+    for (quint32 key : gramKeys) {
+        const Postings &p = postings[key];
+        table.push_back({ key, p.count, offset, p.bytes.size() });
+        offset += p.bytes.size();
+    }
+    h.gramCount = quint32(table.size());
+    h.gramOffset = pos;
+    writeBytes(table.data(), table.size() * sizeof(Gram));
+    pad();
+
+    h.postingsOffset = pos;
+    h.postingsSize = offset;
+    for (quint32 key : gramKeys) {
+        const Postings &p = postings[key];
+        writeBytes(p.bytes.data(), p.bytes.size());
+    }
+    pad();
+
+    h.fileSize = pos;
+    if (!ok || !out.seek(0) || out.write(reinterpret_cast<const char *>(&h), sizeof(h)) != qint64(sizeof(h)))
+        return false;
+    return out.commit();
+}
+
+// ---- Чтение ----
+
+bool FileNameIndex::open(const QString &file)
+{
+    BELKIN_TRACE_SCOPE("index.open");
+
+    m_file.setFileName(file);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const quint64 size = quint64(m_file.size());
+    if (size >= sizeof(Header))
+        m_data = m_file.map(0, qint64(size));
+    if (!m_data) {
+        m_file.close();
+        return false;
+    }
+
+    const Header *h = reinterpret_cast<const Header *>(m_data);
+    const auto within = [size](quint64 offset, quint64 bytes) {
+        return offset <= size && bytes <= size - offset && offset % 8 == 0;
+    };
+    const auto blocks = [](quint32 count) { return quint64(count + BlockSize - 1) / BlockSize; };
+
+    const bool valid = h->magic == Magic && h->version == Version && h->fileSize == size
+        && within(h->rootOffset, h->rootSize)
+        && within(h->dirInfoOffset, quint64(h->dirCount) * sizeof(DirInfo))
+        && within(h->dirBlocksOffset, h->dirBlocksSize)
+        && within(h->dirIndexOffset, blocks(h->dirCount) * sizeof(quint64))
+        && within(h->entryBlocksOffset, h->entryBlocksSize)
+        && within(h->entryIndexOffset, blocks(h->entryCount) * sizeof(quint64))
+        && within(h->gramOffset, quint64(h->gramCount) * sizeof(Gram))
+        && within(h->postingsOffset, h->postingsSize);
+    if (!valid) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_file.close();
+        m_data = nullptr;
+        return false;
+    }
+
+    m_header = h;
+    return true;
+}
+
+QByteArray FileNameIndex::root() const
+{
+    if (!m_header)
+        return {};
+    return QByteArray(reinterpret_cast<const char *>(m_data + m_header->rootOffset),
+                      qsizetype(m_header->rootSize));
+}
+
+qint64 FileNameIndex::builtAt() const
+{
+    return m_header ? m_header->builtAt : 0;
+}
+
+quint32 FileNameIndex::directoryCount() const
+{
+    return m_header ? m_header->dirCount : 0;
+}
+
+quint32 FileNameIndex::entryCount() const
+{
+    return m_header ? m_header->entryCount : 0;
+}
+
+const FileNameIndex::DirInfo *FileNameIndex::dirInfos() const
+{
+    return reinterpret_cast<const DirInfo *>(m_data + m_header->dirInfoOffset);
+}
+
+const quint64 *FileNameIndex::dirIndex() const
+{
+    return reinterpret_cast<const quint64 *>(m_data + m_header->dirIndexOffset);
+}
+
+const quint64 *FileNameIndex::entryIndex() const
+{
+    return reinterpret_cast<const quint64 *>(m_data + m_header->entryIndexOffset);
+}
+
+const FileNameIndex::Gram *FileNameIndex::grams() const
+{
+    return reinterpret_cast<const Gram *>(m_data + m_header->gramOffset);
+}
+
+bool FileNameIndex::pathLess(QByteArrayView a, QByteArrayView b)
+{
+    const qsizetype n = std::min(a.size(), b.size());
+    for (qsizetype i = 0; i < n; ++i) {
+        // '/' меньше любого байта имени: поддерево идёт сразу за каталогом
+        const uint ka = a[i] == '/' ? 0u : uint(uchar(a[i]));
+        const uint kb = b[i] == '/' ? 0u : uint(uchar(b[i]));
+        if (ka != kb)
+            return ka < kb;
+    }
+    return a.size() < b.size();
+}
+
+int FileNameIndex::findDirectory(QByteArrayView path) const
+{
+    if (!m_header || m_header->dirCount == 0)
+        return -1;
+
+    FrontCodedReader dirs(m_data + m_header->dirBlocksOffset, m_header->dirBlocksSize,
+                          dirIndex(), m_header->dirCount, false);
+
+    // последний блок, чей первый путь не больше path
+    quint32 lo = 0;
+    quint32 hi = quint32((quint64(m_header->dirCount) + BlockSize - 1) / BlockSize);
+    while (hi - lo > 1) {
+        const quint32 mid = lo + (hi - lo) / 2;
+        if (!dirs.seek(mid * BlockSize) || !dirs.read())
+            return -1;
+        if (pathLess(path, dirs.value()))
+            hi = mid;
+        else
+            lo = mid;
+    }
+
+    if (!dirs.seek(lo * BlockSize))
+        return -1;
+    for (quint32 i = lo * BlockSize; i < m_header->dirCount && i < (lo + 1) * BlockSize; ++i) {
+        if (!dirs.read())
+            return -1;
+        if (dirs.value() == path)
+            return int(i);
+    }
+    return -1;
+}
+
+QByteArray FileNameIndex::directoryPath(quint32 dir) const
+{
+    if (!m_header)
+        return {};
+    FrontCodedReader dirs(m_data + m_header->dirBlocksOffset, m_header->dirBlocksSize,
+                          dirIndex(), m_header->dirCount, false);
+    if (!dirs.seek(dir) || !dirs.read())
+        return {};
+    return dirs.value().toByteArray();
+}
+
+qint64 FileNameIndex::directoryMtime(quint32 dir) const
+{
+    if (!m_header || dir >= m_header->dirCount)
+        return 0;
+    return dirInfos()[dir].mtime;
+}
+
+void FileNameIndex::children(quint32 dir, std::vector<Entry> &out) const
+{
+    out.clear();
+    if (!m_header || dir >= m_header->dirCount)
+        return;
+
+    const DirInfo &info = dirInfos()[dir];
+    if (info.entryCount == 0)
+        return;
+
+    FrontCodedReader entries(m_data + m_header->entryBlocksOffset, m_header->entryBlocksSize,
+                             entryIndex(), m_header->entryCount, true);
+    if (!entries.seek(info.firstEntry))
+        return;
+    out.reserve(info.entryCount);
+    for (quint32 i = 0; i < info.entryCount && entries.read(); ++i)
+        out.push_back({ entries.value().toByteArray(), entries.flag() });
+}
+
+bool FileNameIndex::subtree(QByteArrayView under, quint32 &first, quint32 &last) const
+{
+    if (under.isEmpty()) {
+        first = 0;
+        last = m_header->dirCount;
+        return true;
+    }
+
+    const int dir = findDirectory(under);
+    if (dir < 0)
+        return false;
+
+    FrontCodedReader dirs(m_data + m_header->dirBlocksOffset, m_header->dirBlocksSize,
+                          dirIndex(), m_header->dirCount, false);
+    const auto inside = [&under](QByteArrayView path) {
+        return path.size() > under.size() && path.startsWith(under) && path[under.size()] == '/';
+    };
+
+    // поддерево — отрезок сразу за каталогом: ищем его конец
+    quint32 lo = quint32(dir) + 1;
+    quint32 hi = m_header->dirCount;
+    while (lo < hi) {
+        const quint32 mid = lo + (hi - lo) / 2;
+        if (!dirs.seek(mid) || !dirs.read())
+            return false;
+        if (inside(dirs.value()))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    first = quint32(dir);
+    last = lo;
+    return true;
+}
+
+quint32 FileNameIndex::directoryOf(quint32 entry) const
+{
+    const DirInfo *infos = dirInfos();
+    const DirInfo *end = infos + m_header->dirCount;
+    // последний каталог, чьи записи начинаются не позже entry (пустые
+    // каталоги с тем же началом стоят раньше)
+    const DirInfo *it = std::upper_bound(infos, end, entry, [](quint32 e, const DirInfo &d) {
+        return e < d.firstEntry;
+    });
+    return it == infos ? 0 : quint32(it - infos - 1);
+}
+
+const FileNameIndex::Gram *FileNameIndex::findGram(quint32 key) const
+{
+    const Gram *begin = grams();
+    const Gram *end = begin + m_header->gramCount;
+    const Gram *it = std::lower_bound(begin, end, key,
+                                      [](const Gram &g, quint32 k) { return g.key < k; });
+    return (it != end && it->key == key) ? it : nullptr;
+}
+
+void FileNameIndex::decodePostings(const Gram &gram, std::vector<quint32> &out) const
+{
+    out.clear();
+    if (gram.offset > m_header->postingsSize || gram.size > m_header->postingsSize - gram.offset)
+        return;
+
+    const uchar *p = m_data + m_header->postingsOffset + gram.offset;
+    const uchar *end = p + gram.size;
+    out.reserve(gram.count);
+    quint64 value = 0;
+    for (quint32 i = 0; i < gram.count; ++i) {
+        quint64 delta = 0;
+        if (!getVarint(p, end, delta))
+            break;
+        value += delta;
+        out.push_back(quint32(value));
+    }
+}
+
+void FileNameIndex::search(const NameFilter &filter, QByteArrayView under, const Visitor &visit) const
+{
+    BELKIN_TRACE_SCOPE("index.search");
+
+    if (!m_header || filter.isEmpty())
+        return;
+
+    quint32 firstDir = 0, lastDir = 0;
+    if (!subtree(under, firstDir, lastDir) || firstDir >= lastDir)
+        return;
+
+    const DirInfo *infos = dirInfos();
+    const quint32 firstEntry = infos[firstDir].firstEntry;
+    const quint32 endEntry = infos[lastDir - 1].firstEntry + infos[lastDir - 1].entryCount;
+    if (firstEntry >= endEntry)
+        return;
+
+    FrontCodedReader entries(m_data + m_header->entryBlocksOffset, m_header->entryBlocksSize,
+                             entryIndex(), m_header->entryCount, true);
+
+    // литеральные части шаблона: у glob — куски между * и ?
+    std::vector<quint32> keys;
+    const QByteArray pattern = filter.pattern().toUtf8();
+    if (filter.isGlob()) {
+        qsizetype start = 0;
+        for (qsizetype i = 0; i <= pattern.size(); ++i) {
+            if (i == pattern.size() || pattern[i] == '*' || pattern[i] == '?') {
+                appendGrams(QByteArrayView(pattern).sliced(start, i - start), keys);
+                start = i + 1;
+            }
+        }
+    } else {
+        appendGrams(pattern, keys);
+    }
+    uniqueSorted(keys);
+
+    if (keys.empty()) {
+        // короткий шаблон — перебираем имена поддерева подряд
+        if (!entries.seek(firstEntry))
+            return;
+        for (quint32 dir = firstDir; dir < lastDir; ++dir) {
+            for (quint32 i = 0; i < infos[dir].entryCount; ++i) {
+                if (!entries.read())
+                    return;
+                if (filter.matches(entries.value()) && !visit(dir, entries.value(), entries.flag()))
+                    return;
+            }
+        }
+        return;
+    }
+
+    std::vector<const Gram *> lists;
+    for (quint32 key : keys) {
+        const Gram *gram = findGram(key);
+        if (!gram)
+            return;     // ни в одном имени нет этой триграммы
+        lists.push_back(gram);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const Gram *a, const Gram *b) { return a->count < b->count; });
+
+    std::vector<quint32> candidates;
+    decodePostings(*lists.front(), candidates);
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [=](quint32 e) { return e < firstEntry || e >= endEntry; }),
+                     candidates.end());
+
+    std::vector<quint32> list, both;
+    for (size_t k = 1; k < lists.size() && !candidates.empty(); ++k) {
+        if (lists[k]->count > candidates.size() * MaxIntersectRatio)
+            break;
+        decodePostings(*lists[k], list);
+        both.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), list.begin(), list.end(),
+                              std::back_inserter(both));
+        candidates.swap(both);
+    }
+
+    // кандидаты по возрастанию — каталог двигается только вперёд
+    quint32 dir = candidates.empty() ? 0 : directoryOf(candidates.front());
+    for (quint32 entry : candidates) {
+        while (dir + 1 < m_header->dirCount && infos[dir].firstEntry + infos[dir].entryCount <= entry)
+            ++dir;
+        if (!entries.seek(entry) || !entries.read())
+            return;
+        if (filter.matches(entries.value()) && !visit(dir, entries.value(), entries.flag()))
+            return;
+    }
+}
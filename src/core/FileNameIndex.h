@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QString>
+#include <functional>
+#include <string>
+#include <vector>
+#include "BelkinExport.h"
+
+class NameFilter;
+
+// Индекс имён файлов одной ФС на диске (для FileIndex).
+// Каталоги отсортированы по пути ('/' меньше любого символа — поддерево
+// каталога идёт сразу за ним одним отрезком), записи каждого каталога лежат
+// подряд и отсортированы по имени. И пути каталогов, и имена записей
+// хранятся с front coding блоками по 16: у соседей общие начала, так что
+// 20 млн путей занимают немногим больше суммарной длины имён.
+// Для поиска подстрок — posting lists триграмм имени (ASCII без учёта
+// регистра): номера записей, дельты в varint.
+// Файл отображается в память (QFile::map) и не меняется; обновление —
+// это запись нового файла (Builder). Порядок байт — хоста: индекс
+// локальный кэш, а не формат обмена.
+// Чтение потокобезопасно.
+class BELKINCORE_EXPORT FileNameIndex
+{
+public:
+    struct Entry {
+        QByteArray name;
+        bool       dir = false;
+    };
+
+    // Сборка индекса: каталоги добавляются в любом порядке (из потоков обхода —
+    // под своим мьютексом), сортировка и кодирование — в write()
+    class BELKINCORE_EXPORT Builder
+    {
+    public:
+        // path — от корня индекса без ведущего '/', корень — пустой путь
+        void addDirectory(QByteArrayView path, qint64 mtime, const std::vector<Entry> &entries);
+        int directoryCount() const { return int(m_dirs.size()); }
+        bool write(const QString &file, const QByteArray &root) const;
+
+    private:
+        struct Dir {
+            QByteArray path;
+            qint64 mtime = 0;
+            std::string names;          // имена через '\0'
+            std::vector<quint8> dirs;   // 1 — подкаталог
+        };
+        std::vector<Dir> m_dirs;
+    };
+
+    // return false — хватит
+    using Visitor = std::function<bool(quint32 dir, QByteArrayView name, bool isDir)>;
+
+    FileNameIndex() = default;
+    FileNameIndex(const FileNameIndex &) = delete;
+    FileNameIndex &operator=(const FileNameIndex &) = delete;
+
+    bool open(const QString &file);
+    bool isOpen() const { return m_header != nullptr; }
+
+    QByteArray root() const;            // в кодировке ФС
+    qint64 builtAt() const;             // секунды от эпохи
+    quint32 directoryCount() const;
+    quint32 entryCount() const;
+    qint64 fileSize() const { return m_file.size(); }
+
+    // номер каталога path (от корня индекса) или -1
+    int findDirectory(QByteArrayView path) const;
+    QByteArray directoryPath(quint32 dir) const;
+    qint64 directoryMtime(quint32 dir) const;
+    void children(quint32 dir, std::vector<Entry> &out) const;
+
+    // записи под каталогом under (пусто — весь индекс), чьё имя проходит
+    // filter; кандидаты — пересечение списков триграмм шаблона, без триграмм
+    // (короткий или не-ASCII шаблон) — перебор имён
+    void search(const NameFilter &filter, QByteArrayView under, const Visitor &visit) const;
+
+    // «a/b» < «a/b/c» < «a/b-c»: порядок каталогов в индексе
+    static bool pathLess(QByteArrayView a, QByteArrayView b);
+
+private:
+    struct Header;
+    struct DirInfo;
+    struct Gram;
+
+    const DirInfo *dirInfos() const;
+    const quint64 *dirIndex() const;
+    const quint64 *entryIndex() const;
+    const Gram *grams() const;
+
+    // отрезок каталогов [first, last) — under и всё его поддерево
+    bool subtree(QByteArrayView under, quint32 &first, quint32 &last) const;
+    quint32 directoryOf(quint32 entry) const;
+    const Gram *findGram(quint32 key) const;
+    void decodePostings(const Gram &gram, std::vector<quint32> &out) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    const Header *m_header = nullptr;
+};
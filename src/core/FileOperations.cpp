@@ -5,40 +5,58 @@
 #include <QThread>
 #include "CopySignals.h"
 #include "FileOperations.h"
-#include "ApplicationAPI.h"
 #include "CopyWorkerCore.h"
+#include "Trace.h"
+#include "CopyProgress.h"
+#include "MountRegistry.h"
 
 
 bool FileOperations::copyDirectoryRecursively(const QString &srcPath,
                                               const QString &dstPath,
-                                              ApplicationAPI *api,
-                                              int &fileIndex)
+                                              ProgressTracker *progress,
+                                              DurabilityTracker *durability)
 {
+    BELKIN_TRACE_SCOPE("copyDirectory");
+
     QDir sourceDir(srcPath);
-    if (!sourceDir.exists())
-        return false;
+    QFileInfoList entries;
+    {
+        PhaseTimer phase(progress, CopyPhase::Metadata);
 
-    QDir targetDir(dstPath);
-    if (!targetDir.exists()) {
-        if (!QDir().mkdir(dstPath))
+        if (!sourceDir.exists())
             return false;
-    }
 
-    const QFileInfoList entries =
-        sourceDir.entryInfoList(QDir::NoDotAndDotDot | QDir::AllEntries);
+        {
+            BELKIN_TRACE_SCOPE("mkdir");
+            QDir targetDir(dstPath);
+            if (!targetDir.exists()) {
+                if (!QDir().mkdir(dstPath))
+                    return false;
+                if (durability)
+                    durability->directoryCreated(dstPath);
+            }
+        }
+
+        BELKIN_TRACE_SCOPE("listDir");
+        entries = sourceDir.entryInfoList(QDir::NoDotAndDotDot | QDir::AllEntries);
+    }
 
     for (const QFileInfo &entry : entries) {
 
         QString srcFile = entry.absoluteFilePath();
         //QString dstFile = dstPath + "/" + entry.fileName();
         QString baseName = entry.fileName();
-        QString finalName = FileOperations::uniqueNameInDir(dstPath, baseName);
+        QString finalName;
+        {
+            PhaseTimer phase(progress, CopyPhase::Metadata);
+            finalName = FileOperations::uniqueNameInDir(dstPath, baseName, durability);
+        }
         QString dstFile = dstPath + "/" + finalName;
 
 
         if (entry.isDir()) {
 
-            if (!copyDirectoryRecursively(srcFile, dstFile, api, fileIndex))
+            if (!copyDirectoryRecursively(srcFile, dstFile, progress, durability))
                 return false;
 
         } else {
@@ -46,10 +64,8 @@ bool FileOperations::copyDirectoryRecursively(const QString &srcPath,
             if (QFile::exists(dstFile))
                 QFile::remove(dstFile);
 
-            if (!copyFileWithProgress(srcFile, dstFile, fileIndex, api))
+            if (!copyFileWithProgress(srcFile, dstFile, progress, durability))
                 return false;
-
-            fileIndex++;
         }
     }
 
@@ -58,18 +74,32 @@ bool FileOperations::copyDirectoryRecursively(const QString &srcPath,
 
 bool FileOperations::copyFileWithProgress(const QString &srcFile,
                                           const QString &dstFile,
-                                          int fileIndex,
-                                          ApplicationAPI *api)
+                                          ProgressTracker *progress,
+                                          DurabilityTracker *durability)
 {
-    QFile in(srcFile);
-    if (!in.open(QIODevice::ReadOnly))
-        return false;
+    BELKIN_TRACE_SCOPE("copyFile");
 
     QString tmpFile = dstFile + ".tmp";
+    QFile in(srcFile);
     QFile out(tmpFile);
 
-    if (!out.open(QIODevice::WriteOnly))
-        return false;
+    // недописанный tmp не оставляем (свой — с момента, как он открыт)
+    struct TmpGuard {
+        QFile &file;
+        bool keep = true;
+        ~TmpGuard() { if (!keep) file.remove(); }
+    } guard{out};
+
+    {
+        BELKIN_TRACE_SCOPE("open");
+        PhaseTimer phase(progress, CopyPhase::Metadata);
+        if (!in.open(QIODevice::ReadOnly))
+            return false;
+
+        if (!out.open(QIODevice::WriteOnly))
+            return false;
+        guard.keep = false;
+    }
 
     qint64 total = in.size();
     qint64 copied = 0;
@@ -77,49 +107,123 @@ bool FileOperations::copyFileWithProgress(const QString &srcFile,
     const qint64 block = 1024 * 1024;
     QByteArray buffer(block, Qt::Uninitialized);
 
-    QElapsedTimer timer;
-    timer.start();
+    if (progress)
+        progress->fileStarted(srcFile, total);
 
     while (true) {
 
-        qint64 read = in.read(buffer.data(), block);
+        qint64 read;
+        {
+            BELKIN_TRACE_SCOPE("read");
+            PhaseTimer phase(progress, CopyPhase::Data);
+            read = in.read(buffer.data(), block);
+        }
         if (read < 0)
             return false;
 
         if (read == 0)
             break;
 
-        if (out.write(buffer.constData(), read) != read)
-            return false;
+        {
+            BELKIN_TRACE_SCOPE("write");
+            PhaseTimer phase(progress, CopyPhase::Data);
+            if (out.write(buffer.constData(), read) != read)
+                return false;
+        }
+
+        if (durability && durability->policy() == DurabilityPolicy::Batched) {
+            out.flush();
+            durability->blockWritten(out.handle(), copied, read);
+        }
 
         copied += read;
 
-        double seconds = timer.elapsed() / 1000.0;
-        double speedMB = seconds > 0
-            ? (copied / (1024.0 * 1024.0)) / seconds
-            : 0;
+        if (progress)
+            progress->bytesCopied(read);
+    }
 
-        if (auto *sig = api->copySignals())
-            emit sig->copyProgress(fileIndex, copied, total, speedMB);
+    {
+        BELKIN_TRACE_SCOPE("close");
+        out.flush();
+        if (durability && !durability->fileWritten(out.handle()))
+            return false;
+        out.close();
+        in.close();
     }
 
-    out.flush();
-    out.close();
-    in.close();
+    BELKIN_TRACE_SCOPE("rename");
+    PhaseTimer phase(progress, CopyPhase::Metadata);
 
-    QFile::remove(dstFile);               // если перезапись
-    if (!QFile::rename(tmpFile, dstFile)) // ключевой момент
-        return false;
+    // дальше tmp принадлежит rename (или DurabilityTracker)
+    guard.keep = true;
 
-    return true;
+    // в Batched rename откладывается до syncfs в конце задачи
+    bool ok;
+    if (durability) {
+        ok = durability->commitFile(tmpFile, dstFile);
+    } else {
+        QFile::remove(dstFile);             // если перезапись
+        ok = QFile::rename(tmpFile, dstFile); // ключевой момент
+    }
+
+    if (ok && progress)
+        progress->fileFinished();
+
+    return ok;
+}
+
+
+// Общий хвост copy/move: фиксируем долговечность, публикуем финальный прогресс
+static bool finishJob(DurabilityTracker &durability, ProgressTracker &progress,
+                      const QString &dstDir, const QStringList &changed, CopySignals *sig)
+{
+    bool ok;
+    {
+        BELKIN_TRACE_SCOPE("durabilityCommit");
+        ok = durability.commit();
+    }
+
+    progress.addPhaseTime(CopyPhase::Sync, durability.syncTimeMs() * 1000000);
+    progress.finish();
+
+    if (sig) {
+        sig->pathsChanged(changed);
+        if (!ok)
+            sig->copyError(dstDir);
+        if (durability.policy() != DurabilityPolicy::None)
+            sig->syncFinished(durability.syncTimeMs());
+        sig->copyFinished();
+    }
+    return ok;
 }
 
+// Хвост задачи с ошибкой: уже скопированное фиксируется так же, как без
+// отложенных rename (в None/PerFile оно уже на месте), иначе в Batched
+// готовые файлы остались бы .tmp навсегда
+static bool failJob(DurabilityTracker &durability, ProgressTracker &progress,
+                    const QString &failedPath, const QStringList &changed, CopySignals *sig)
+{
+    {
+        BELKIN_TRACE_SCOPE("durabilityCommit");
+        durability.commit();
+    }
+    progress.addPhaseTime(CopyPhase::Sync, durability.syncTimeMs() * 1000000);
+
+    if (sig) {
+        sig->pathsChanged(changed);
+        sig->copyError(failedPath);
+        sig->copyFinished();
+    }
+    return false;
+}
 
 bool FileOperations::copyFilesSync(const QStringList &srcFiles,
                                    const QString &dstDir,
-                                   ApplicationAPI *api)
+                                   CopySignals *sig,
+                                   DurabilityPolicy durabilityPolicy)
 {
-    auto *sig = api->copySignals();
+    BELKIN_TRACE_SCOPE("copyFilesSync");
+
     if (sig)
         sig->copyStarted(srcFiles, dstDir, FileOpType::Copy);
 
@@ -128,14 +232,24 @@ bool FileOperations::copyFilesSync(const QStringList &srcFiles,
         return true;
     }
 
-    int fileIndex = 0;
+    DurabilityTracker durability(durabilityPolicy);
+    ProgressTracker progress(sig, FileOpType::Copy);
+    QStringList changed;
+
+    // план задачи: сколько файлов и байт всего (для общего прогресса и ETA)
+    for (const QString &srcPath : srcFiles)
+        progress.planPath(srcPath);
 
     for (const QString &srcPath : srcFiles) {
 
         QFileInfo info(srcPath);
 
         QString baseName = info.fileName();
-        QString finalName = FileOperations::uniqueNameInDir(dstDir, baseName);
+        QString finalName;
+        {
+            PhaseTimer phase(&progress, CopyPhase::Metadata);
+            finalName = FileOperations::uniqueNameInDir(dstDir, baseName, &durability);
+        }
 
         QString dstPath = dstDir + "/" + finalName;
 
@@ -143,43 +257,38 @@ bool FileOperations::copyFilesSync(const QStringList &srcFiles,
         bool ok = false;
 
         if (info.isDir()) {
-            ok = copyDirectoryRecursively(srcPath, dstPath, api, fileIndex);
+            ok = copyDirectoryRecursively(srcPath, dstPath, &progress, &durability);
         } else {
-            ok = copyFileWithProgress(srcPath, dstPath, fileIndex, api);
+            ok = copyFileWithProgress(srcPath, dstPath, &progress, &durability);
         }
 
-        if (!ok) {
-            if (sig) {
-                sig->copyError(srcPath);
-                sig->copyFinished();
-            }
-            return false;
-        }
+        // каталог мог быть создан и при частичной ошибке
+        changed << dstPath;
 
-        ++fileIndex;
+        if (!ok)
+            return failJob(durability, progress, srcPath, changed, sig);
     }
 
-    if (sig)
-        sig->copyFinished();
-
-    return true;
+    return finishJob(durability, progress, dstDir, changed, sig);
 }
 
 void FileOperations::copyFilesAsync(const QStringList &srcFiles,
                                     const QString &dstDir,
-                                    ApplicationAPI *api)
+                                    CopySignals *sig,
+                                    DurabilityPolicy durability)
 {
     // если файлов нет — даже поток не создаём
     if (srcFiles.isEmpty()) {
-        if (auto *sig = api->copySignals()) {
+        if (sig) {
             sig->copyStarted(srcFiles, dstDir,FileOpType::Copy);
             sig->copyFinished();
         }
         return;
     }
 
-    auto *worker = new CopyWorkerCore(srcFiles, dstDir, api,FileOpType::Copy);
+    auto *worker = new CopyWorkerCore(srcFiles, dstDir, sig, FileOpType::Copy, durability);
     auto *thread = new QThread;
+    thread->setObjectName("copy worker");
 
     worker->moveToThread(thread);
 
@@ -198,18 +307,20 @@ void FileOperations::copyFilesAsync(const QStringList &srcFiles,
 
 void FileOperations::moveFilesAsync(const QStringList &srcFiles,
                                     const QString &dstDir,
-                                    ApplicationAPI *api)
+                                    CopySignals *sig,
+                                    DurabilityPolicy durability)
 {
     if (srcFiles.isEmpty()) {
-        if (auto *sig = api->copySignals()) {
+        if (sig) {
             sig->copyStarted(srcFiles, dstDir,FileOpType::Move);
             sig->copyFinished();
         }
         return;
     }
 
-    auto *worker = new CopyWorkerCore(srcFiles, dstDir, api, FileOpType::Move);
+    auto *worker = new CopyWorkerCore(srcFiles, dstDir, sig, FileOpType::Move, durability);
     auto *thread = new QThread;
+    thread->setObjectName("move worker");
 
     worker->moveToThread(thread);
 
@@ -360,6 +471,8 @@ static bool sendToTrash(const QStringList &paths)
 
 bool FileOperations::removePaths(const QStringList &paths, bool permanent)
 {
+    BELKIN_TRACE_SCOPE("removePaths");
+
     if (paths.isEmpty())
         return false;
 
@@ -407,11 +520,15 @@ bool FileOperations::removeDirectoryRecursively(const QString &path)
 
 bool FileOperations::renamePath(const QString &oldPath, const QString &newPath)
 {
+    BELKIN_TRACE_SCOPE("rename");
     return QFile::rename(oldPath, newPath);
 }
 
-QString FileOperations::uniqueNameInDir(const QString &dir, const QString &fileName)
+QString FileOperations::uniqueNameInDir(const QString &dir, const QString &fileName,
+                                        const DurabilityTracker *durability)
 {
+    BELKIN_TRACE_SCOPE("uniqueNameInDir");
+
     QDir d(dir);
 
     // Разбираем имя вручную, чтобы корректно обрабатывать много точек
@@ -434,14 +551,19 @@ QString FileOperations::uniqueNameInDir(const QString &dir, const QString &fileN
 
     QString copyWord = QObject::tr("Copy");
 
+    // занято на диске или отложенным rename этой же задачи
+    auto taken = [&](const QString &name) {
+        return d.exists(name) || (durability && durability->isReserved(d.filePath(name)));
+    };
+
     // 1. Базовое имя
     QString candidate = makeName(base);
-    if (!d.exists(candidate))
+    if (!taken(candidate))
         return candidate;
 
     // 2. "base - Copy"
     candidate = makeName(base + " - " + copyWord);
-    if (!d.exists(candidate))
+    if (!taken(candidate))
         return candidate;
 
     // 3. "base - Copy (2)", "base - Copy (3)", ...
@@ -451,7 +573,7 @@ QString FileOperations::uniqueNameInDir(const QString &dir, const QString &fileN
                              .arg(base)
                              .arg(copyWord)
                              .arg(counter));
-        if (!d.exists(candidate))
+        if (!taken(candidate))
             return candidate;
         counter++;
     }
@@ -484,6 +606,13 @@ bool sameDevice(const QString &a, const QString &b)
 
 bool sameDevice(const QString &pathA, const QString &pathB)
 {
+    // точка монтирования, а не st_dev: между bind-монтированиями одной ФС
+    // rename всё равно даёт EXDEV
+    MountRegistry *mounts = MountRegistry::instance();
+    if (mounts->isAvailable())
+        return mounts->sameMount(pathA, pathB);
+
+    BELKIN_TRACE_SCOPE("stat");
     struct stat stA{}, stB{};
 
     if (stat(pathA.toUtf8().constData(), &stA) != 0)
@@ -497,19 +626,34 @@ bool sameDevice(const QString &pathA, const QString &pathB)
 #endif
 bool FileOperations::moveFilesSync(const QStringList &srcFiles,
                                    const QString &dstDir,
-                                   ApplicationAPI *api)
+                                   CopySignals *sig,
+                                   DurabilityPolicy durabilityPolicy)
 {
+    BELKIN_TRACE_SCOPE("moveFilesSync");
+
     if (srcFiles.isEmpty())
         return true;
 
-    auto *sig = api->copySignals();
     if (sig)
         sig->copyStarted(srcFiles, dstDir, FileOpType::Move);
 
-    int fileIndex = 0;
+    DurabilityTracker durability(durabilityPolicy);
+    ProgressTracker progress(sig, FileOpType::Move);
+    QStringList changed;
 
-    for (const QString &srcPath : srcFiles)
+    // rename на той же ФС — один "файл" без байтов, иначе полный обход
+    QList<bool> sameFs;
+    for (const QString &srcPath : srcFiles) {
+        sameFs << sameDevice(QFileInfo(srcPath).absolutePath(), dstDir);
+        if (sameFs.last())
+            progress.adjustPlan(1, 0);
+        else
+            progress.planPath(srcPath);
+    }
+
+    for (qsizetype i = 0; i < srcFiles.size(); ++i)
     {
+        const QString &srcPath = srcFiles[i];
         QFileInfo info(srcPath);
         const QString srcDir = info.absolutePath();
         const QString baseName = info.fileName();
@@ -517,7 +661,7 @@ bool FileOperations::moveFilesSync(const QStringList &srcFiles,
         // 0. Перемещение в ту же директорию — бессмысленно, просто пропускаем
         if (QDir::cleanPath(srcDir) == QDir::cleanPath(dstDir)) {
             qDebug() << "Move in same dir, skip:" << srcPath;
-            ++fileIndex;
+            progress.fileFinished();
             continue;
         }
 
@@ -525,50 +669,59 @@ bool FileOperations::moveFilesSync(const QStringList &srcFiles,
         QString dstPathRaw = dstDir + "/" + baseName;
 
         // 1. Попытка быстрого перемещения (rename) на одном устройстве
-        if (sameDevice(srcDir, dstDir)) {
+        if (sameFs[i]) {
+
+            bool renamed;
+            {
+                BELKIN_TRACE_SCOPE("rename");
+                PhaseTimer phase(&progress, CopyPhase::Metadata);
+                renamed = QFile::rename(srcPath, dstPathRaw);
+            }
 
             // src и dst разные директории, но имя то же — это нормальный move
-            if (QFile::rename(srcPath, dstPathRaw)) {
+            if (renamed) {
                 qDebug() << "Fast rename:" << srcPath << "->" << dstPathRaw;
-                if (sig)
-                    emit sig->copyProgress(fileIndex, 1, 1, 0);
-                ++fileIndex;
+                changed << srcPath << dstPathRaw;
+                progress.fileStarted(srcPath, 0);
+                progress.fileFinished();
                 continue;
             }
 
             qDebug() << "Rename failed, fallback to copy:" << srcPath;
+            // вместо одного rename будет полное копирование
+            progress.adjustPlan(-1, 0);
+            progress.planPath(srcPath);
         } else {
             qDebug() << "Different FS, copy+delete:" << srcPath;
         }
 
         // 2. COPY + DELETE с уникальным именем (как при копировании)
-        QString finalName = FileOperations::uniqueNameInDir(dstDir, baseName);
+        QString finalName;
+        {
+            PhaseTimer phase(&progress, CopyPhase::Metadata);
+            finalName = FileOperations::uniqueNameInDir(dstDir, baseName, &durability);
+        }
         QString dstPath   = dstDir + "/" + finalName;
 
         bool ok = false;
 
         if (info.isDir()) {
-            ok = copyDirectoryRecursively(srcPath, dstPath, api, fileIndex);
+            ok = copyDirectoryRecursively(srcPath, dstPath, &progress, &durability);
         } else {
-            ok = copyFileWithProgress(srcPath, dstPath, fileIndex, api);
+            ok = copyFileWithProgress(srcPath, dstPath, &progress, &durability);
         }
 
-        if (!ok) {
-            if (sig) {
-                sig->copyError(srcPath);
-                sig->copyFinished();
-            }
-            return false;
-        }
+        changed << dstPath;
 
-        FileOperations::removePaths({srcPath}, false);
-        ++fileIndex;
-    }
+        if (!ok)
+            return failJob(durability, progress, srcPath, changed, sig);
 
-    if (sig)
-        sig->copyFinished();
+        // исходник удаляем только после того, как копия зафиксирована
+        durability.removeAfterCommit(srcPath);
+        changed << srcPath;
+    }
 
-    return true;
+    return finishJob(durability, progress, dstDir, changed, sig);
 }
 
 
@@ -3,21 +3,23 @@
 
 #include <QStringList>
 #include "BelkinExport.h"
+#include "Durability.h"
 
-class ApplicationAPI;
+class CopySignals;
+class ProgressTracker;
 
 class BELKINCORE_EXPORT FileOperations
 {
 public:
     static bool copyDirectoryRecursively(const QString &srcPath,
                                          const QString &dstPath,
-                                         ApplicationAPI *api,
-                                         int &fileIndex);
+                                         ProgressTracker *progress,
+                                         DurabilityTracker *durability = nullptr);
 
     static bool copyFileWithProgress(const QString &srcFile,
                                      const QString &dstFile,
-                                     int fileIndex,
-                                     ApplicationAPI *api);
+                                     ProgressTracker *progress,
+                                     DurabilityTracker *durability = nullptr);
 
     static bool removePaths(const QStringList &paths, bool permanent);
     static bool removePath(const QString &path);
@@ -26,22 +28,28 @@ public:
     // новый фасад: асинхронное копирование через поток
     static void copyFilesAsync(const QStringList &srcFiles,
                                const QString &dstDir,
-                               ApplicationAPI *api);
+                               CopySignals *sig,
+                               DurabilityPolicy durability = DurabilityPolicy::None);
     static void moveFilesAsync(const QStringList &srcFiles,
                                const QString &dstDir,
-                               ApplicationAPI *api);
+                               CopySignals *sig,
+                               DurabilityPolicy durability = DurabilityPolicy::None);
 
     // синхронный вариант (используется только внутри потока)
     static bool copyFilesSync(const QStringList &srcFiles,
                               const QString &dstDir,
-                              ApplicationAPI *api);
+                              CopySignals *sig,
+                              DurabilityPolicy durability = DurabilityPolicy::None);
     static bool renamePath(const QString &oldPath, const QString &newPath);
 
-    static QString uniqueNameInDir(const QString &dir, const QString &baseName);
+    // durability — имена, обещанные отложенным rename этой задачи, тоже заняты
+    static QString uniqueNameInDir(const QString &dir, const QString &baseName,
+                                   const DurabilityTracker *durability = nullptr);
 
     static bool moveFilesSync(const QStringList &srcFiles,
                           const QString &dstDir,
-                          ApplicationAPI *api);
+                          CopySignals *sig,
+                          DurabilityPolicy durability = DurabilityPolicy::None);
 
 
 
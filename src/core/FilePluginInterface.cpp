@@ -1,6 +1,6 @@
 #include "FilePluginInterface.h"
 
 // Пустой деструктор и конструктор в .cpp файле гарантируют 
-// наличие символов в BelkinCore.lib
+// наличие символов в BelkinPluginApi.lib
 FilePluginInterface::FilePluginInterface() = default;
 FilePluginInterface::~FilePluginInterface() = default;
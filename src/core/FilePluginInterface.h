@@ -7,7 +7,7 @@
 #include <QWidget>
 #include "ApplicationAPI.h"
 
-class BELKINCORE_EXPORT FilePluginInterface {
+class BELKINPLUGINAPI_EXPORT FilePluginInterface {
 public:
     FilePluginInterface();
     virtual ~FilePluginInterface();
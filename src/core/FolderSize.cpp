@@ -0,0 +1,259 @@
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include "FolderSize.h"
+#include "Trace.h"
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#endif
+
+namespace {
+
+bool isCancelled(const std::atomic<bool> *cancel)
+{
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+#ifdef Q_OS_LINUX
+
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+// Множество (dev, ino) файлов с st_nlink > 1, разбитое на шарды,
+// чтобы потоки не толкались на одном мьютексе
+class InodeSet
+{
+public:
+    bool insert(dev_t dev, ino_t ino)
+    {
+        const quint64 key = quint64(ino) * 0x9E3779B97F4A7C15ull ^ quint64(dev);
+        Shard &s = m_shards[key % ShardCount];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.keys.insert({ quint64(dev), quint64(ino) }).second;
+    }
+
+private:
+    struct PairHash {
+        size_t operator()(const std::pair<quint64, quint64> &p) const
+        {
+            return size_t(p.second * 0x9E3779B97F4A7C15ull ^ p.first);
+        }
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<std::pair<quint64, quint64>, PairHash> keys;
+    };
+    static constexpr int ShardCount = 64;
+    Shard m_shards[ShardCount];
+};
+
+// Очередь каталогов одного потока
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::string> dirs;
+};
+
+struct Walk {
+    dev_t rootDev = 0;
+    const std::atomic<bool> *cancel = nullptr;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<qint64> pending{0};     // каталоги в очередях + в обработке
+
+    std::atomic<qint64> bytes{0};
+    std::atomic<qint64> files{0};
+    std::atomic<qint64> dirs{0};
+
+    InodeSet hardLinks;
+
+    void push(size_t worker, std::string dir)
+    {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        WorkQueue &q = *queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.dirs.push_back(std::move(dir));
+    }
+
+    // свой каталог — с конца (обход в глубину, горячий кэш dentry)
+    bool popOwn(size_t worker, std::string &dir)
+    {
+        WorkQueue &q = *queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.dirs.empty())
+            return false;
+        dir = std::move(q.dirs.back());
+        q.dirs.pop_back();
+        return true;
+    }
+
+    // чужой — с начала: там каталоги ближе к корню, т.е. крупнее
+    bool steal(size_t worker, std::string &dir)
+    {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            WorkQueue &q = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.dirs.empty())
+                continue;
+            dir = std::move(q.dirs.front());
+            q.dirs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void processDir(size_t worker, const std::string &dir, std::vector<char> &buffer)
+    {
+        const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0)
+            return;   // нет прав — считаем то, что доступно
+
+        qint64 localBytes = 0, localFiles = 0, localDirs = 0;
+
+        for (;;) {
+            const long n = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if (n <= 0)
+                break;
+
+            for (long pos = 0; pos < n;) {
+                auto *e = reinterpret_cast<LinuxDirent64 *>(buffer.data() + pos);
+                pos += e->d_reclen;
+
+                const char *name = e->d_name;
+                if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+                    continue;
+
+                struct stat st;
+                if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                    continue;
+
+                // другая ФС (точка монтирования) — не считаем
+                if (st.st_dev != rootDev)
+                    continue;
+
+                if (S_ISDIR(st.st_mode)) {
+                    ++localDirs;
+                    push(worker, dir + '/' + name);
+                    continue;
+                }
+
+                // жёсткая ссылка на уже посчитанный inode
+                if (st.st_nlink > 1 && !hardLinks.insert(st.st_dev, st.st_ino))
+                    continue;
+
+                localBytes += st.st_size;
+                ++localFiles;
+            }
+
+            if (isCancelled(cancel))
+                break;
+        }
+
+        ::close(fd);
+
+        bytes.fetch_add(localBytes, std::memory_order_relaxed);
+        files.fetch_add(localFiles, std::memory_order_relaxed);
+        dirs.fetch_add(localDirs, std::memory_order_relaxed);
+    }
+
+    void run(size_t worker)
+    {
+        std::vector<char> buffer(64 * 1024);
+        std::string dir;
+
+        while (!isCancelled(cancel)) {
+            if (!popOwn(worker, dir) && !steal(worker, dir)) {
+                // работы нет ни у кого и никто ничего не обрабатывает — конец
+                if (pending.load(std::memory_order_acquire) == 0)
+                    break;
+                std::this_thread::yield();
+                continue;
+            }
+
+            processDir(worker, dir, buffer);
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+};
+
+#endif
+
+} // namespace
+
+FolderSize FolderSizeCalculator::calculate(const QString &path,
+                                           const std::atomic<bool> *cancel,
+                                           int threads)
+{
+    BELKIN_TRACE_SCOPE("folderSize.calculate");
+
+    FolderSize result;
+
+#ifdef Q_OS_LINUX
+    const QByteArray encoded = QFile::encodeName(path);
+    struct stat rootSt;
+    if (::stat(encoded.constData(), &rootSt) != 0 || !S_ISDIR(rootSt.st_mode))
+        return result;
+
+    if (threads <= 0)
+        threads = qBound(1, QThread::idealThreadCount(), 8);
+
+    Walk walk;
+    walk.rootDev = rootSt.st_dev;
+    walk.cancel = cancel;
+    for (int i = 0; i < threads; ++i)
+        walk.queues.push_back(std::make_unique<WorkQueue>());
+
+    walk.push(0, std::string(encoded.constData(), encoded.size()));
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back([&walk, i]() { walk.run(size_t(i)); });
+    walk.run(0);
+    for (std::thread &t : pool)
+        t.join();
+
+    result.bytes = walk.bytes.load();
+    result.files = walk.files.load();
+    result.dirs  = walk.dirs.load();
+    result.complete = !isCancelled(cancel);
+#else
+    if (!QFileInfo(path).isDir())
+        return result;
+
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden
+                          | QDir::System | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (isCancelled(cancel))
+            return result;
+        const QFileInfo fi = it.nextFileInfo();
+        if (fi.isDir()) {
+            ++result.dirs;
+        } else {
+            result.bytes += fi.size();
+            ++result.files;
+        }
+    }
+    result.complete = true;
+#endif
+
+    return result;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QMetaType>
+#include <QString>
+#include <atomic>
+#include "BelkinExport.h"
+
+struct FolderSize {
+    qint64 bytes = 0;       // логический размер файлов (st_size)
+    qint64 files = 0;
+    qint64 dirs  = 0;
+    bool complete = false;  // false — обход отменён или корень не открылся
+};
+
+Q_DECLARE_METATYPE(FolderSize)
+
+// Рекурсивный размер каталога.
+// На Linux — параллельный обход с work stealing: у каждого потока своя
+// очередь каталогов (свои берёт с конца, чужие крадёт с начала — крупные
+// поддеревья), fstatat относительно дескриптора каталога. Жёсткие ссылки
+// считаются один раз, точки монтирования не пересекаются.
+class BELKINCORE_EXPORT FolderSizeCalculator
+{
+public:
+    // threads <= 0 — по числу ядер (не больше 8: упираемся в диск, а не в CPU)
+    static FolderSize calculate(const QString &path,
+                                const std::atomic<bool> *cancel = nullptr,
+                                int threads = 0);
+};
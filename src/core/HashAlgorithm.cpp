@@ -0,0 +1,38 @@
+#include <QHash>
+#include "HashAlgorithm.h"
+
+namespace hashing {
+
+namespace {
+
+const QHash<QString, QCryptographicHash::Algorithm> &algorithms()
+{
+    static const QHash<QString, QCryptographicHash::Algorithm> algos = {
+        { "md5",     QCryptographicHash::Md5 },
+        { "sha1",    QCryptographicHash::Sha1 },
+        { "sha256",  QCryptographicHash::Sha256 },
+        { "sha512",  QCryptographicHash::Sha512 },
+        { "blake2b", QCryptographicHash::Blake2b_256 },
+    };
+    return algos;
+}
+
+} // namespace
+
+QStringList algorithmNames()
+{
+    QStringList names = algorithms().keys();
+    names.sort();
+    return names;
+}
+
+bool algorithmByName(const QString &name, QCryptographicHash::Algorithm &algo)
+{
+    const auto it = algorithms().constFind(name.toLower());
+    if (it == algorithms().constEnd())
+        return false;
+    algo = it.value();
+    return true;
+}
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QCryptographicHash>
+#include <QString>
+#include <QStringList>
+#include "BelkinExport.h"
+
+// Алгоритмы хеширования по имени (без учёта регистра) — одни и те же для
+// belkin-cli hash/dupes и DuplicateFinder
+namespace hashing {
+
+// md5, sha1, sha256, sha512, blake2b
+BELKINCORE_EXPORT QStringList algorithmNames();
+// false — такого имени нет
+BELKINCORE_EXPORT bool algorithmByName(const QString &name, QCryptographicHash::Algorithm &algo);
+
+}
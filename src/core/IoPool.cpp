@@ -0,0 +1,137 @@
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThreadPool>
+#include <QDebug>
+#include "IoPool.h"
+#include "MountRegistry.h"
+#include "Trace.h"
+
+namespace {
+
+// потоки на все ресурсы сразу: зависшие держат свой поток, пока ядро
+// не вернёт вызов, остальным ресурсам должно хватить
+constexpr int MaxThreads = 16;
+
+bool isRemoteFs(const QString &fsType)
+{
+    static const QSet<QString> remote = {
+        "nfs", "nfs4", "cifs", "smb3", "smbfs", "ncpfs", "9p", "afs", "ceph",
+        "glusterfs", "davfs", "lustre", "gpfs", "beegfs",
+    };
+    return remote.contains(fsType) || fsType.startsWith(QLatin1String("fuse"));
+}
+
+} // namespace
+
+IoPool *IoPool::instance()
+{
+    static IoPool *pool = new IoPool(QCoreApplication::instance());
+    return pool;
+}
+
+IoPool::IoPool(QObject *parent)
+    : QObject(parent)
+    // без родителя и не удаляется: деструктор QThreadPool ждёт потоки,
+    // а зависший на мёртвом ресурсе не вернётся — выход не должен его ждать
+    , m_pool(new QThreadPool)
+{
+    m_pool->setMaxThreadCount(MaxThreads);
+}
+
+QString IoPool::mountPointOf(const QString &path, bool *remote) const
+{
+    // mountFor не трогает диск — только таблицу монтирования в памяти
+    MountInfo mount;
+    if (!MountRegistry::instance()->mountFor(path, mount)) {
+        if (remote)
+            *remote = false;
+        return QStringLiteral("/");
+    }
+    if (remote)
+        *remote = isRemoteFs(mount.fsType);
+    return mount.mountPoint;
+}
+
+bool IoPool::isResponsive(const QString &path) const
+{
+    const QString key = mountPointOf(path);
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_mounts.constFind(key);
+    return it == m_mounts.constEnd() || it->hung.isEmpty();
+}
+
+bool IoPool::isRemote(const QString &path) const
+{
+    bool remote = false;
+    mountPointOf(path, &remote);
+    return remote;
+}
+
+IoPool::StartResult IoPool::start(const QString &path, std::function<void()> job, JobId *id)
+{
+    const QString key = mountPointOf(path);
+    JobId jobId;
+    {
+        QMutexLocker locker(&m_mutex);
+        MountState &state = m_mounts[key];
+        if (!state.hung.isEmpty())
+            return StartResult::NotResponding;
+        if (state.running.size() >= MaxInFlightPerMount) {
+            state.refused = true;
+            return StartResult::Busy;
+        }
+        jobId = ++m_nextJob;
+        state.running.insert(jobId);
+    }
+    if (id)
+        *id = jobId;
+
+    m_pool->start([this, key, jobId, job = std::move(job)]() {
+        BELKIN_TRACE_SCOPE("io.job");
+        job();
+        finished(key, jobId);
+    });
+    return StartResult::Started;
+}
+
+void IoPool::finished(const QString &key, JobId job)
+{
+    bool recovered = false;
+    bool freed = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        MountState &state = m_mounts[key];
+        state.running.remove(job);
+        // вернулась последняя из зависших — ресурс снова живой
+        if (state.hung.remove(job) && state.hung.isEmpty())
+            recovered = true;
+        // пока ресурс не отвечает, новых задач на нём всё равно не запустить
+        if (state.refused && state.hung.isEmpty()) {
+            state.refused = false;
+            freed = true;
+        }
+    }
+    if (recovered)
+        emit responsivenessChanged(key, true);
+    if (freed)
+        emit slotFreed(key);
+}
+
+void IoPool::reportHang(const QString &path, JobId job)
+{
+    const QString key = mountPointOf(path);
+    {
+        QMutexLocker locker(&m_mutex);
+        MountState &state = m_mounts[key];
+        // задача уже вернулась, пока о ней сообщали, — ресурс жив
+        if (!state.running.contains(job))
+            return;
+        const bool wasResponsive = state.hung.isEmpty();
+        state.hung.insert(job);
+        if (!wasResponsive)
+            return;
+    }
+    qWarning() << "Mount is not responding:" << key;
+    emit responsivenessChanged(key, false);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include "BelkinExport.h"
+
+class QThreadPool;
+
+// Пул потоков для обращений к файловой системе от имени панелей.
+// Зависший CIFS/NFS/FUSE-ресурс блокирует stat()/opendir() без таймаута,
+// поэтому GUI не трогает такие пути сам: короткие проверки идут через
+// call() с ожиданием не дольше таймаута, чтение каталогов и пачки stat —
+// через start().
+// Здоровье отслеживается по точкам монтирования (MountRegistry): ресурс,
+// на котором операция не уложилась в срок, считается неотвечающим, новые
+// операции на нём сразу отклоняются, пока не вернутся именно зависшие —
+// долгие, но живые задачи на том же ресурсе (обход ветки, индекс) его
+// выздоровление не задерживают.
+// Так один мёртвый ресурс занимает не больше MaxInFlightPerMount потоков.
+// Живой, но занятый ресурс (MaxInFlightPerMount задач уже идут) — не то же
+// самое: start() отвечает Busy, и когда место освободится, придёт slotFreed.
+class BELKINCORE_EXPORT IoPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static IoPool *instance();
+
+    // сколько GUI готов ждать короткую операцию (exists, isDir...)
+    static constexpr int DefaultTimeoutMs = 300;
+    static constexpr int MaxInFlightPerMount = 8;
+
+    // номер задачи start() — чтобы сообщить о зависании именно её
+    using JobId = quint64;
+
+    enum class StartResult {
+        Started,
+        Busy,           // на ресурсе уже MaxInFlightPerMount задач — ждать slotFreed
+        NotResponding,  // на ресурсе есть зависшие задачи — ждать responsivenessChanged
+    };
+
+    // false — на ресурсе есть операция, не вернувшаяся в срок
+    bool isResponsive(const QString &path) const;
+    // сетевая или FUSE-ФС: даже stat может идти по сети
+    bool isRemote(const QString &path) const;
+    // ключ здоровья для path — точка монтирования, как в responsivenessChanged
+    QString mountPointOf(const QString &path, bool *remote = nullptr) const;
+
+    // выполнить job в пуле; кроме Started job не запущен.
+    // id — номер запущенной задачи
+    StartResult start(const QString &path, std::function<void()> job, JobId *id = nullptr);
+
+    // выполнить fn в пуле и дождаться результата не дольше timeoutMs;
+    // nullopt — не дождались (ресурс помечается неотвечающим) или ресурс
+    // уже не отвечает. fn может пережить вызывающего: всё нужное —
+    // захватом по значению
+    template <typename T>
+    std::optional<T> call(const QString &path, std::function<T()> fn,
+                          int timeoutMs = DefaultTimeoutMs);
+
+    // задача job на path идёт дольше разумного (например, каталог не отдал
+    // ни одной записи): пометить ресурс неотвечающим до её возврата.
+    // Уже вернувшаяся задача ничего не помечает
+    void reportHang(const QString &path, JobId job);
+
+signals:
+    // mountPoint перестал отвечать или снова отвечает
+    void responsivenessChanged(const QString &mountPoint, bool responsive);
+    // на mountPoint, где start() ответил Busy, освободилось место
+    void slotFreed(const QString &mountPoint);
+
+private:
+    explicit IoPool(QObject *parent = nullptr);
+
+    struct MountState {
+        QSet<JobId> running;
+        QSet<JobId> hung;       // непусто — ресурс не отвечает
+        bool refused = false;   // был отказ Busy — сообщить о свободном месте
+    };
+
+    void finished(const QString &key, JobId job);
+
+    mutable QMutex m_mutex;
+    QHash<QString, MountState> m_mounts;   // по точке монтирования
+    JobId m_nextJob = 0;
+    QThreadPool *m_pool;
+};
+
+template <typename T>
+std::optional<T> IoPool::call(const QString &path, std::function<T()> fn, int timeoutMs)
+{
+    struct State {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::optional<T> value;
+    };
+    auto state = std::make_shared<State>();
+
+    JobId job = 0;
+    const StartResult started = start(path, [state, fn = std::move(fn)]() {
+        T value = fn();
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->value = std::move(value);
+        state->done.notify_all();
+    }, &job);
+    if (started != StartResult::Started)
+        return std::nullopt;
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (!state->done.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                              [&state]() { return state->value.has_value(); })) {
+        lock.unlock();
+        reportHang(path, job);
+        return std::nullopt;
+    }
+    return std::move(state->value);
+}
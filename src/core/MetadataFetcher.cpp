@@ -0,0 +1,469 @@
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QtGlobal>
+#include <QDebug>
+#include "MetadataFetcher.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#endif
+#endif
+
+// IORING_OP_STATX и IORING_REGISTER_PROBE появились в 5.6 — вместе с этим флагом
+#if defined(Q_OS_LINUX) && defined(STATX_BASIC_STATS) && defined(IORING_FEAT_CUR_PERSONALITY) \
+    && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define BELKIN_HAVE_IO_URING 1
+#endif
+
+namespace {
+
+// меньше — обычный stat подряд: кольцо и потоки дороже самих вызовов
+constexpr size_t SyncBatch = 8;
+// потоки запасного пути: ждут диск, а не процессор
+constexpr size_t MaxThreads = 8;
+constexpr size_t PathsPerThread = 32;
+
+bool ioUringDisabled()
+{
+    return qEnvironmentVariableIsSet("BELKIN_NO_IO_URING");
+}
+
+#if defined(Q_OS_LINUX) && defined(STATX_BASIC_STATS)
+unsigned statxMask(quint32 fields)
+{
+    unsigned mask = STATX_TYPE;
+    if (fields & MetadataFetcher::Mode)
+        mask |= STATX_MODE;
+    if (fields & MetadataFetcher::Size)
+        mask |= STATX_SIZE;
+    if (fields & MetadataFetcher::MTime)
+        mask |= STATX_MTIME;
+    if (fields & MetadataFetcher::Identity)
+        mask |= STATX_INO | STATX_NLINK;
+    return mask;
+}
+
+void fromStatx(const struct statx &stx, MetadataFetcher::Result &r)
+{
+    r.error = 0;
+    r.mode  = stx.stx_mode;
+    r.size  = qint64(stx.stx_size);
+    r.mtime = qint64(stx.stx_mtime.tv_sec);
+    r.dev   = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    r.ino   = stx.stx_ino;
+    r.nlink = stx.stx_nlink;
+}
+#endif
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Кольцо io_uring без liburing: три mmap и два системных вызова
+// ---------------------------------------------------------------------------
+
+#ifdef BELKIN_HAVE_IO_URING
+
+struct MetadataFetcher::Ring
+{
+    int fd = -1;
+    unsigned entries = 0;
+
+    void  *sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void  *cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    void  *sqesMap = MAP_FAILED;
+    size_t sqesSize = 0;
+
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqMask = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned *cqMask = nullptr;
+    io_uring_sqe *sqes = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    // буферы результатов живут вместе с кольцом: ядро пишет в них,
+    // пока запрос не завершён
+    std::vector<struct statx> buffers;
+
+    ~Ring()
+    {
+        if (sqesMap != MAP_FAILED)
+            ::munmap(sqesMap, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing)
+            ::munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED)
+            ::munmap(sqRing, sqRingSize);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    bool init(unsigned depth)
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        fd = int(::syscall(__NR_io_uring_setup, depth, &p));
+        if (fd < 0)
+            return false;
+
+        entries = p.sq_entries;
+        sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED)
+            return false;
+        cqRing = single ? sqRing
+                        : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+            return false;
+        sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+        sqesMap = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQES);
+        if (sqesMap == MAP_FAILED)
+            return false;
+
+        const auto at = [](void *base, unsigned offset) {
+            return reinterpret_cast<unsigned *>(static_cast<char *>(base) + offset);
+        };
+        sqHead  = at(sqRing, p.sq_off.head);
+        sqTail  = at(sqRing, p.sq_off.tail);
+        sqMask  = at(sqRing, p.sq_off.ring_mask);
+        sqArray = at(sqRing, p.sq_off.array);
+        cqHead  = at(cqRing, p.cq_off.head);
+        cqTail  = at(cqRing, p.cq_off.tail);
+        cqMask  = at(cqRing, p.cq_off.ring_mask);
+        sqes = static_cast<io_uring_sqe *>(sqesMap);
+        cqes = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(cqRing) + p.cq_off.cqes);
+        buffers.resize(entries);
+
+        return supportsStatx();
+    }
+
+    // кольцо есть, но STATX ядро может не уметь (5.1–5.5) — спрашиваем
+    bool supportsStatx() const
+    {
+        constexpr unsigned ProbeOps = 256;
+        std::vector<char> buffer(sizeof(io_uring_probe) + ProbeOps * sizeof(io_uring_probe_op), 0);
+        auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+        if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ProbeOps) < 0)
+            return false;
+        return probe->last_op >= IORING_OP_STATX
+            && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    }
+};
+
+#else
+
+struct MetadataFetcher::Ring {};
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+MetadataFetcher::MetadataFetcher(quint32 fields, Links links)
+    : m_fields(fields)
+    , m_links(links)
+{
+}
+
+MetadataFetcher::~MetadataFetcher() = default;
+
+bool MetadataFetcher::ioUringSupported()
+{
+#ifdef BELKIN_HAVE_IO_URING
+    static const bool supported = []() {
+        Ring ring;
+        return !ioUringDisabled() && ring.init(2);
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+MetadataFetcher::Result MetadataFetcher::statOne(const QByteArray &path, int index) const
+{
+    Result r;
+    r.index = index;
+
+#if defined(Q_OS_LINUX) && defined(STATX_BASIC_STATS)
+    const unsigned mask = statxMask(m_fields);
+    struct statx stx;
+    int flags = m_links == Links::NoFollow ? AT_SYMLINK_NOFOLLOW : 0;
+    int rc = ::statx(AT_FDCWD, path.constData(), flags, mask, &stx);
+    if (rc != 0 && m_links == Links::FollowOrSelf)
+        rc = ::statx(AT_FDCWD, path.constData(), AT_SYMLINK_NOFOLLOW, mask, &stx);
+    if (rc != 0) {
+        r.error = errno;
+        return r;
+    }
+    fromStatx(stx, r);
+#elif defined(Q_OS_LINUX)
+    struct stat st;
+    int rc = m_links == Links::NoFollow ? ::lstat(path.constData(), &st)
+                                        : ::stat(path.constData(), &st);
+    if (rc != 0 && m_links == Links::FollowOrSelf)
+        rc = ::lstat(path.constData(), &st);
+    if (rc != 0) {
+        r.error = errno;
+        return r;
+    }
+    r.mode  = quint32(st.st_mode);
+    r.size  = qint64(st.st_size);
+    r.mtime = qint64(st.st_mtim.tv_sec);
+    r.dev   = quint64(st.st_dev);
+    r.ino   = quint64(st.st_ino);
+    r.nlink = quint32(st.st_nlink);
+#else
+    // QFileInfo смотрит на цель ссылки; саму ссылку отдаём только битую
+    const QFileInfo fi(QFile::decodeName(path));
+    if (!fi.exists() && !(m_links != Links::Follow && fi.isSymLink())) {
+        r.error = ENOENT;
+        return r;
+    }
+    r.mode  = quint32(fi.permissions()) | (fi.isDir() ? 0x4000u : 0x8000u);
+    r.size  = fi.size();
+    r.mtime = fi.lastModified().toSecsSinceEpoch();
+#endif
+    return r;
+}
+
+void MetadataFetcher::fetch(const std::vector<QByteArray> &paths, const Callback &onResult,
+                            const std::atomic<bool> *cancel)
+{
+    if (paths.empty())
+        return;
+
+    BELKIN_TRACE_SCOPE("metadata.fetch");
+
+    if (paths.size() <= SyncBatch) {
+        m_lastBackend = Backend::Sync;
+        fetchSync(paths, 0, paths.size(), onResult, cancel);
+        return;
+    }
+
+    if (fetchRing(paths, onResult, cancel)) {
+        m_lastBackend = Backend::IoUring;
+        return;
+    }
+    m_lastBackend = Backend::Threads;
+    fetchThreaded(paths, onResult, cancel);
+}
+
+void MetadataFetcher::fetchSync(const std::vector<QByteArray> &paths, size_t begin, size_t end,
+                                const Callback &onResult, const std::atomic<bool> *cancel)
+{
+    for (size_t i = begin; i < end; ++i) {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return;
+        onResult(statOne(paths[i], int(i)));
+    }
+}
+
+void MetadataFetcher::fetchThreaded(const std::vector<QByteArray> &paths, const Callback &onResult,
+                                    const std::atomic<bool> *cancel)
+{
+    BELKIN_TRACE_SCOPE("metadata.threads");
+
+    const size_t threads = std::clamp<size_t>(paths.size() / PathsPerThread, 1, MaxThreads);
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<Result> done;
+    size_t running = threads;
+    std::atomic<size_t> next{0};
+
+    // потоки только делают stat; onResult вызывается здесь, в потоке вызывающего
+    const auto worker = [&]() {
+        std::vector<Result> local;
+        for (;;) {
+            if (cancel && cancel->load(std::memory_order_relaxed))
+                break;
+            const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= paths.size())
+                break;
+            local.push_back(statOne(paths[i], int(i)));
+            if (local.size() >= 16) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.insert(done.end(), local.begin(), local.end());
+                local.clear();
+                ready.notify_one();
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        done.insert(done.end(), local.begin(), local.end());
+        --running;
+        ready.notify_one();
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (size_t t = 0; t < threads; ++t)
+        pool.emplace_back(worker);
+
+    std::vector<Result> batch;
+    for (bool last = false; !last;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]() { return !done.empty() || running == 0; });
+            batch.swap(done);
+            last = running == 0;
+        }
+        for (const Result &r : batch) {
+            if (!cancel || !cancel->load(std::memory_order_relaxed))
+                onResult(r);
+        }
+        batch.clear();
+    }
+
+    for (std::thread &t : pool)
+        t.join();
+}
+
+bool MetadataFetcher::fetchRing(const std::vector<QByteArray> &paths, const Callback &onResult,
+                                const std::atomic<bool> *cancel)
+{
+#ifdef BELKIN_HAVE_IO_URING
+    if (!m_ring && !m_ringFailed) {
+        auto ring = std::make_unique<Ring>();
+        if (!ioUringDisabled() && ring->init(QueueDepth))
+            m_ring = std::move(ring);
+        else
+            m_ringFailed = true;
+    }
+    if (!m_ring || m_ringFailed)
+        return false;
+
+    BELKIN_TRACE_SCOPE("metadata.ioUring");
+
+    Ring &r = *m_ring;
+    const unsigned mask = statxMask(m_fields);
+    const int flags = m_links == Links::NoFollow ? AT_SYMLINK_NOFOLLOW : 0;
+
+    std::vector<int> slotIndex(r.entries, -1);
+    std::vector<unsigned> freeSlots;
+    freeSlots.reserve(r.entries);
+    for (unsigned s = r.entries; s > 0; --s)
+        freeSlots.push_back(s - 1);
+
+    size_t next = 0;
+    unsigned inFlight = 0;
+    unsigned unsubmitted = 0;
+
+    for (;;) {
+        const bool stop = cancel && cancel->load(std::memory_order_relaxed);
+
+        // окно дополняется новыми запросами по мере освобождения слотов
+        if (!stop) {
+            unsigned tail = *r.sqTail;
+            while (next < paths.size() && !freeSlots.empty()) {
+                const unsigned slot = freeSlots.back();
+                freeSlots.pop_back();
+
+                const unsigned idx = tail & *r.sqMask;
+                io_uring_sqe *sqe = &r.sqes[idx];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_STATX;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = reinterpret_cast<quint64>(paths[next].constData());
+                sqe->len = mask;
+                sqe->off = reinterpret_cast<quint64>(&r.buffers[slot]);
+                sqe->statx_flags = quint32(flags);
+                sqe->user_data = slot;
+                r.sqArray[idx] = idx;
+
+                slotIndex[slot] = int(next);
+                ++tail;
+                ++next;
+                ++unsubmitted;
+                ++inFlight;
+            }
+            __atomic_store_n(r.sqTail, tail, __ATOMIC_RELEASE);
+        }
+
+        if (inFlight == 0)
+            break;
+
+        // отдать ядру новое и дождаться хотя бы одного ответа
+        const long ret = ::syscall(__NR_io_uring_enter, r.fd, unsubmitted, 1u,
+                                   IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret >= 0) {
+            unsubmitted -= std::min<unsigned>(unsubmitted, unsigned(ret));
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            // кольцо сломалось: неотправленное и недождавшееся делаем обычным
+            // stat, а кольцо больше не используем (буферы остаются при нём)
+            qWarning() << "io_uring_enter failed, falling back to threads:" << strerror(errno);
+            m_ringFailed = true;
+            for (unsigned s = 0; s < r.entries; ++s) {
+                if (slotIndex[s] >= 0 && !stop)
+                    onResult(statOne(paths[size_t(slotIndex[s])], slotIndex[s]));
+            }
+            if (!stop)
+                fetchSync(paths, next, paths.size(), onResult, cancel);
+            return true;
+        }
+
+        unsigned head = *r.cqHead;
+        const unsigned cqTail = __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != cqTail; ++head) {
+            const io_uring_cqe &cqe = r.cqes[head & *r.cqMask];
+            const unsigned slot = unsigned(cqe.user_data);
+            const int index = slotIndex[slot];
+            slotIndex[slot] = -1;
+            freeSlots.push_back(slot);
+            --inFlight;
+            if (stop)
+                continue;
+
+            if (cqe.res < 0) {
+                // битая ссылка при FollowOrSelf — второй, обычный stat самой ссылки
+                Result result;
+                if (m_links == Links::FollowOrSelf) {
+                    result = statOne(paths[size_t(index)], index);
+                } else {
+                    result.index = index;
+                    result.error = -cqe.res;
+                }
+                onResult(result);
+                continue;
+            }
+            Result result;
+            result.index = index;
+            fromStatx(r.buffers[slot], result);
+            onResult(result);
+        }
+        __atomic_store_n(r.cqHead, head, __ATOMIC_RELEASE);
+    }
+    return true;
+#else
+    Q_UNUSED(paths);
+    Q_UNUSED(onResult);
+    Q_UNUSED(cancel);
+    return false;
+#endif
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QByteArray>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "BelkinExport.h"
+
+// Пачечный stat для обходов, которым нужны метаданные тысяч записей
+// (ключи сортировки панели, план копирования).
+// На Linux запросы уходят в io_uring (IORING_OP_STATX) окном до QueueDepth:
+// ядро выполняет их параллельно, и на холодном кэше поиски по диску не
+// выстраиваются в очередь за одним потоком. Если io_uring нет (старое ядро,
+// seccomp, BELKIN_NO_IO_URING=1), та же пачка делится между потоками.
+// Запрашиваются только нужные вызывающему поля (маска statx).
+// Объект не потокобезопасен: один на поток обхода.
+class BELKINCORE_EXPORT MetadataFetcher
+{
+public:
+    enum Field : quint32 {
+        Type     = 0x01,    // каталог/файл/ссылка (mode & S_IFMT)
+        Mode     = 0x02,    // права
+        Size     = 0x04,
+        MTime    = 0x08,
+        Identity = 0x10     // dev, ino, nlink (жёсткие ссылки)
+    };
+
+    enum class Links {
+        NoFollow,           // lstat
+        Follow,             // stat
+        FollowOrSelf        // stat, для битой ссылки — сама ссылка
+    };
+
+    enum class Backend {
+        Sync,               // пачка слишком мала или не Linux
+        IoUring,
+        Threads
+    };
+
+    struct Result {
+        int     index = -1;     // номер пути в запросе
+        int     error = 0;      // errno; 0 — успех
+        quint32 mode = 0;
+        qint64  size = -1;
+        qint64  mtime = 0;      // секунды от эпохи
+        quint64 dev = 0;
+        quint64 ino = 0;
+        quint32 nlink = 0;
+
+        bool ok() const { return error == 0; }
+        bool isDir() const  { return (mode & 0170000) == 0040000; }
+        bool isFile() const { return (mode & 0170000) == 0100000; }
+    };
+
+    using Callback = std::function<void(const Result &)>;
+
+    static constexpr int QueueDepth = 128;
+
+    explicit MetadataFetcher(quint32 fields, Links links = Links::Follow);
+    ~MetadataFetcher();
+
+    // stat всех paths (в кодировке ФС); onResult вызывается в этом же потоке
+    // по мере готовности, порядок не гарантирован. cancel прерывает пачку
+    // между окнами — для уже отправленных запросов onResult не вызывается
+    void fetch(const std::vector<QByteArray> &paths, const Callback &onResult,
+               const std::atomic<bool> *cancel = nullptr);
+
+    // чем выполнена последняя пачка (для трассы и бенчмарка)
+    Backend lastBackend() const { return m_lastBackend; }
+
+    static bool ioUringSupported();
+
+private:
+    struct Ring;
+
+    void fetchSync(const std::vector<QByteArray> &paths, size_t begin, size_t end,
+                   const Callback &onResult, const std::atomic<bool> *cancel);
+    void fetchThreaded(const std::vector<QByteArray> &paths, const Callback &onResult,
+                       const std::atomic<bool> *cancel);
+    bool fetchRing(const std::vector<QByteArray> &paths, const Callback &onResult,
+                   const std::atomic<bool> *cancel);
+    Result statOne(const QByteArray &path, int index) const;
+
+    quint32 m_fields;
+    Links   m_links;
+    Backend m_lastBackend = Backend::Sync;
+    std::unique_ptr<Ring> m_ring;
+    bool    m_ringFailed = false;
+};
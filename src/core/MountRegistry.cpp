@@ -0,0 +1,353 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStorageInfo>
+#include <QThreadPool>
+#include "MountRegistry.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// свободное место меняется постоянно, но панели хватает раза в несколько секунд
+constexpr int SpaceIntervalMs = 5000;
+
+// "\040" -> ' ' и т.п.: так mountinfo экранирует пробелы, табы, \n и '\'
+QString unescape(const QByteArray &field)
+{
+    QByteArray out;
+    out.reserve(field.size());
+    for (qsizetype i = 0; i < field.size(); ++i) {
+        if (field[i] == '\\' && i + 3 < field.size()
+            && field[i + 1] >= '0' && field[i + 1] <= '3'
+            && field[i + 2] >= '0' && field[i + 2] <= '7'
+            && field[i + 3] >= '0' && field[i + 3] <= '7') {
+            out += char(((field[i + 1] - '0') << 6) | ((field[i + 2] - '0') << 3) | (field[i + 3] - '0'));
+            i += 3;
+        } else {
+            out += field[i];
+        }
+    }
+    return QFile::decodeName(out);
+}
+
+bool isUnder(const QString &path, const QString &dir)
+{
+    return path == dir || path.startsWith(dir + QLatin1Char('/'));
+}
+
+bool isStorage(const MountInfo &m)
+{
+    static const QSet<QString> pseudo = {
+        "proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "ramfs", "cgroup", "cgroup2",
+        "securityfs", "pstore", "bpf", "debugfs", "tracefs", "mqueue", "hugetlbfs",
+        "configfs", "fusectl", "autofs", "binfmt_misc", "efivarfs", "rpc_pipefs",
+        "nsfs", "squashfs", "overlay", "selinuxfs", "fuse.gvfsd-fuse", "fuse.portal",
+    };
+    if (pseudo.contains(m.fsType))
+        return false;
+
+    // служебные каталоги; съёмные носители udisks монтирует в /run/media
+    const QString &mp = m.mountPoint;
+    if (isUnder(mp, "/run/media"))
+        return true;
+    for (const char *dir : { "/proc", "/sys", "/dev", "/run", "/boot", "/snap", "/var/lib/docker" }) {
+        if (isUnder(mp, QLatin1String(dir)))
+            return false;
+    }
+    return true;
+}
+
+#ifdef Q_OS_LINUX
+QByteArray readAllFd(int fd)
+{
+    QByteArray data;
+    if (::lseek(fd, 0, SEEK_SET) < 0)
+        return data;
+    char buf[16 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        data.append(buf, n);
+    }
+    return data;
+}
+#endif
+
+void statSpace(MountInfo &m)
+{
+#ifdef Q_OS_LINUX
+    struct statvfs st{};
+    if (::statvfs(QFile::encodeName(m.mountPoint).constData(), &st) != 0)
+        return;
+    m.bytesTotal     = qint64(st.f_blocks) * qint64(st.f_frsize);
+    m.bytesFree      = qint64(st.f_bfree)  * qint64(st.f_frsize);
+    m.bytesAvailable = qint64(st.f_bavail) * qint64(st.f_frsize);
+#else
+    const QStorageInfo info(m.mountPoint);
+    if (!info.isValid() || !info.isReady())
+        return;
+    m.bytesTotal     = info.bytesTotal();
+    m.bytesFree      = info.bytesFree();
+    m.bytesAvailable = info.bytesAvailable();
+#endif
+}
+
+} // namespace
+
+MountRegistry *MountRegistry::instance()
+{
+    // спрашивают и из потоков копирования, а слежение должно жить
+    // в потоке приложения
+    static MountRegistry *registry = []() {
+        auto *r = new MountRegistry;
+        if (QCoreApplication *app = QCoreApplication::instance()) {
+            r->moveToThread(app->thread());
+            QMetaObject::invokeMethod(r, &MountRegistry::startMonitoring, Qt::AutoConnection);
+        }
+        return r;
+    }();
+    return registry;
+}
+
+MountRegistry::MountRegistry(QObject *parent)
+    : QObject(parent)
+    , m_spacePool(new QThreadPool(this))
+{
+    // statvfs на зависшем NFS может висеть долго — пусть висит один поток
+    m_spacePool->setMaxThreadCount(1);
+    m_spacePool->setObjectName("mount space");
+
+    m_spaceTimer.setInterval(SpaceIntervalMs);
+    connect(&m_spaceTimer, &QTimer::timeout, this, &MountRegistry::refreshSpace);
+
+    reload();
+}
+
+MountRegistry::~MountRegistry()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+}
+
+void MountRegistry::startMonitoring()
+{
+#ifdef Q_OS_LINUX
+    m_fd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (m_fd >= 0) {
+        // изменение таблицы ядро сообщает как POLLPRI
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &MountRegistry::reload);
+        // событие снимается чтением файла с начала
+        reload();
+    }
+#endif
+    m_spaceTimer.start();
+    refreshSpace();
+}
+
+QList<MountInfo> MountRegistry::parseMountInfo(const QByteArray &data)
+{
+    QList<MountInfo> result;
+    for (const QByteArray &line : data.split('\n')) {
+        // 36 35 98:0 /mnt1 /mnt2 rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+        const QList<QByteArray> f = line.split(' ');
+        const qsizetype sep = f.indexOf(QByteArray("-"), 6);
+        if (f.size() < 6 || sep < 0 || sep + 2 >= f.size())
+            continue;
+
+        MountInfo m;
+        m.id = f[0].toInt();
+        const QList<QByteArray> dev = f[2].split(':');
+        if (dev.size() == 2) {
+            m.major = dev[0].toUInt();
+            m.minor = dev[1].toUInt();
+        }
+        m.root = unescape(f[3]);
+        m.mountPoint = unescape(f[4]);
+        m.readOnly = f[5].split(',').contains("ro");
+        m.fsType = unescape(f[sep + 1]);
+        m.source = unescape(f[sep + 2]);
+        m.storage = isStorage(m);
+        result << m;
+    }
+    return result;
+}
+
+void MountRegistry::reload()
+{
+    BELKIN_TRACE_SCOPE("mounts.reload");
+
+    QList<MountInfo> mounts;
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        mounts = parseMountInfo(readAllFd(m_fd));
+    } else {
+        const int fd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            mounts = parseMountInfo(readAllFd(fd));
+            ::close(fd);
+        }
+    }
+#else
+    int id = 0;
+    for (const QStorageInfo &info : QStorageInfo::mountedVolumes()) {
+        MountInfo m;
+        m.id = id++;
+        m.root = QStringLiteral("/");
+        m.mountPoint = info.rootPath();
+        m.fsType = QString::fromUtf8(info.fileSystemType());
+        m.source = QString::fromUtf8(info.device());
+        m.readOnly = info.isReadOnly();
+        m.storage = info.isValid() && info.isReady();
+        mounts << m;
+    }
+#endif
+
+    bool changed;
+    {
+        QWriteLocker locker(&m_lock);
+        changed = mounts.size() != m_mounts.size();
+        for (MountInfo &m : mounts) {
+            // место на уже известных точках не сбрасываем до следующего опроса
+            auto old = std::find_if(m_mounts.cbegin(), m_mounts.cend(), [&](const MountInfo &o) {
+                return o.id == m.id && o.mountPoint == m.mountPoint;
+            });
+            if (old == m_mounts.cend()) {
+                changed = true;
+                continue;
+            }
+            m.bytesTotal = old->bytesTotal;
+            m.bytesFree = old->bytesFree;
+            m.bytesAvailable = old->bytesAvailable;
+        }
+        m_mounts = mounts;
+    }
+
+    if (changed) {
+        emit mountsChanged();
+        if (m_spaceTimer.isActive())
+            refreshSpace();
+    }
+}
+
+void MountRegistry::refreshSpace()
+{
+    if (m_spaceBusy)
+        return;
+
+    QList<MountInfo> targets;
+    {
+        QReadLocker locker(&m_lock);
+        for (const MountInfo &m : m_mounts) {
+            if (m.storage)
+                targets << m;
+        }
+    }
+    if (targets.isEmpty())
+        return;
+
+    m_spaceBusy = true;
+    m_spacePool->start([this, targets]() mutable {
+        BELKIN_TRACE_SCOPE("mounts.statvfs");
+        for (MountInfo &m : targets)
+            statSpace(m);
+        QMetaObject::invokeMethod(this, [this, targets]() {
+            applySpace(targets);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MountRegistry::applySpace(const QList<MountInfo> &space)
+{
+    m_spaceBusy = false;
+    bool changed = false;
+    {
+        QWriteLocker locker(&m_lock);
+        for (const MountInfo &s : space) {
+            for (MountInfo &m : m_mounts) {
+                if (m.id != s.id || m.mountPoint != s.mountPoint)
+                    continue;
+                if (m.bytesAvailable != s.bytesAvailable || m.bytesTotal != s.bytesTotal) {
+                    m.bytesTotal = s.bytesTotal;
+                    m.bytesFree = s.bytesFree;
+                    m.bytesAvailable = s.bytesAvailable;
+                    changed = true;
+                }
+            }
+        }
+    }
+    if (changed)
+        emit spaceUpdated();
+}
+
+QList<MountInfo> MountRegistry::mounts() const
+{
+    QReadLocker locker(&m_lock);
+    return m_mounts;
+}
+
+bool MountRegistry::isAvailable() const
+{
+    QReadLocker locker(&m_lock);
+    return !m_mounts.isEmpty();
+}
+
+int MountRegistry::indexFor(const QString &path) const
+{
+    // при одинаковой точке монтирования видна последняя (смонтирована поверх)
+    int best = -1;
+    qsizetype bestLen = -1;
+    for (int i = 0; i < m_mounts.size(); ++i) {
+        const QString &mp = m_mounts[i].mountPoint;
+        const bool contains = mp == QLatin1String("/") || isUnder(path, mp);
+        if (contains && mp.size() >= bestLen) {
+            best = i;
+            bestLen = mp.size();
+        }
+    }
+    return best;
+}
+
+bool MountRegistry::mountFor(const QString &path, MountInfo &out) const
+{
+    const QString clean = QDir::cleanPath(QDir(path).absolutePath());
+    QReadLocker locker(&m_lock);
+    const int i = indexFor(clean);
+    if (i < 0)
+        return false;
+    out = m_mounts[i];
+    return true;
+}
+
+bool MountRegistry::sameMount(const QString &pathA, const QString &pathB) const
+{
+    // ссылки разыменовываем: важно, где файлы лежат на самом деле
+    auto resolve = [](const QString &path) {
+        const QString canonical = QFileInfo(path).canonicalFilePath();
+        return canonical.isEmpty() ? QDir::cleanPath(QDir(path).absolutePath()) : canonical;
+    };
+    const QString a = resolve(pathA);
+    const QString b = resolve(pathB);
+
+    QReadLocker locker(&m_lock);
+    const int ia = indexFor(a);
+    const int ib = indexFor(b);
+    return ia >= 0 && ib >= 0 && m_mounts[ia].id == m_mounts[ib].id;
+}
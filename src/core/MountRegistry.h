@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QTimer>
+#include "BelkinExport.h"
+
+class QSocketNotifier;
+class QThreadPool;
+
+// Одна точка монтирования (строка /proc/self/mountinfo)
+struct MountInfo {
+    int     id = -1;            // mount ID: у bind-монтирований одной ФС он разный
+    quint32 major = 0;
+    quint32 minor = 0;
+    QString root;               // какой каталог ФС смонтирован (для bind — не "/")
+    QString mountPoint;
+    QString fsType;
+    QString source;             // "/dev/sda1", "server:/export", "tmpfs"...
+    bool    readOnly = false;
+    bool    storage = false;    // настоящий носитель, а не proc/sysfs/cgroup...
+
+    // из statvfs, обновляются в фоне; -1 — ещё не известно
+    qint64  bytesTotal = -1;
+    qint64  bytesFree = -1;
+    qint64  bytesAvailable = -1;
+};
+
+// Таблица монтирования для панелей и копирования.
+// На Linux читается /proc/self/mountinfo; ядро помечает файл POLLPRI при
+// каждом mount/umount, так что таблица перечитывается только по событию.
+// Свободное место (statvfs) собирается по таймеру в отдельном потоке —
+// зависший сетевой ресурс не блокирует ни GUI, ни копирование.
+// Чтение (mounts/mountFor/sameMount) потокобезопасно; слежение живёт
+// в потоке приложения.
+class BELKINCORE_EXPORT MountRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MountRegistry *instance();
+
+    QList<MountInfo> mounts() const;
+
+    // самая глубокая точка монтирования, содержащая path (путь не
+    // разыменовывается — для этого sameMount)
+    bool mountFor(const QString &path, MountInfo &out) const;
+
+    // rename между путями возможен: одна и та же точка монтирования
+    // (у bind-монтирований одной ФС st_dev совпадает, но rename даёт EXDEV)
+    bool sameMount(const QString &pathA, const QString &pathB) const;
+
+    bool isAvailable() const;
+
+    // разбор содержимого mountinfo (экранирование \040 и т.п. снимается)
+    static QList<MountInfo> parseMountInfo(const QByteArray &data);
+
+public slots:
+    void reload();
+    void refreshSpace();
+
+signals:
+    void mountsChanged();
+    void spaceUpdated();
+
+private:
+    explicit MountRegistry(QObject *parent = nullptr);
+    ~MountRegistry() override;
+
+    void startMonitoring();
+    void applySpace(const QList<MountInfo> &space);
+    int indexFor(const QString &path) const;   // под m_lock
+
+    mutable QReadWriteLock m_lock;
+    QList<MountInfo> m_mounts;
+
+    int              m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer           m_spaceTimer;
+    QThreadPool     *m_spacePool = nullptr;
+    bool             m_spaceBusy = false;
+};
@@ -0,0 +1,211 @@
+#include "NameFilter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BELKIN_NAMEFILTER_SSE2 1
+#endif
+
+namespace {
+
+inline char foldAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c + ('a' - 'A')) : c;
+}
+
+bool hasNonAscii(const char *s, qsizetype n)
+{
+    qsizetype i = 0;
+#ifdef BELKIN_NAMEFILTER_SSE2
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        if (_mm_movemask_epi8(v))
+            return true;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (uchar(s[i]) >= 0x80)
+            return true;
+    }
+    return false;
+}
+
+// needle уже в нижнем регистре; '?' в needle — любой символ (только для glob)
+inline bool equalsFolded(const char *s, const char *needle, qsizetype m, bool anyChar)
+{
+    for (qsizetype k = 0; k < m; ++k) {
+        if (anyChar && needle[k] == '?')
+            continue;
+        if (foldAscii(s[k]) != needle[k])
+            return false;
+    }
+    return true;
+}
+
+// Позиция первого вхождения needle в hay[from, n) без учёта регистра ASCII
+// или -1. Кандидаты ищутся по первому символу шаблона по 16 байт за раз.
+qsizetype findFolded(const char *hay, qsizetype n, qsizetype from,
+                     const char *needle, qsizetype m, bool anyChar)
+{
+    if (m == 0)
+        return from <= n ? from : -1;
+    const qsizetype last = n - m;   // последняя возможная позиция начала
+    if (from > last)
+        return -1;
+
+    const char first = needle[0];
+    qsizetype i = from;
+
+#ifdef BELKIN_NAMEFILTER_SSE2
+    if (!(anyChar && first == '?')) {
+        const __m128i vFirst = _mm_set1_epi8(first);
+        const __m128i lo     = _mm_set1_epi8('A' - 1);
+        const __m128i hi     = _mm_set1_epi8('Z' + 1);
+        const __m128i bit    = _mm_set1_epi8(0x20);
+
+        for (; i <= last && i + 16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay + i));
+            // 'A'..'Z' -> 'a'..'z'; байты >= 0x80 знаковые и под сравнение не попадают
+            const __m128i upper  = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+            const __m128i folded = _mm_or_si128(v, _mm_and_si128(upper, bit));
+
+            unsigned mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, vFirst)));
+            while (mask) {
+                const qsizetype pos = i + qsizetype(__builtin_ctz(mask));
+                if (pos > last)
+                    return -1;
+                if (equalsFolded(hay + pos + 1, needle + 1, m - 1, anyChar))
+                    return pos;
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    for (; i <= last; ++i) {
+        if (equalsFolded(hay + i, needle, m, anyChar))
+            return i;
+    }
+    return -1;
+}
+
+QString globToRegex(const QString &pattern)
+{
+    // только * и ?, остальное буквально (как и в ASCII-пути)
+    QString rx = QStringLiteral("^");
+    for (const QChar c : pattern) {
+        if (c == QLatin1Char('*'))
+            rx += QStringLiteral(".*");
+        else if (c == QLatin1Char('?'))
+            rx += QLatin1Char('.');
+        else
+            rx += QRegularExpression::escape(QString(c));
+    }
+    rx += QLatin1Char('$');
+    return rx;
+}
+
+} // namespace
+
+NameFilter::NameFilter(const QString &pattern)
+    : m_pattern(pattern)
+{
+    m_glob = pattern.contains(QLatin1Char('*')) || pattern.contains(QLatin1Char('?'));
+    m_anyChar = pattern.contains(QLatin1Char('?'));
+
+    for (const QChar c : pattern) {
+        if (c.unicode() >= 0x80) {
+            m_ascii = false;
+            break;
+        }
+    }
+
+    if (m_glob)
+        m_regex = QRegularExpression(globToRegex(pattern),
+                                     QRegularExpression::CaseInsensitiveOption
+                                   | QRegularExpression::DotMatchesEverythingOption);
+
+    if (!m_ascii)
+        return;
+
+    m_lower = pattern.toLatin1();
+    for (char &c : m_lower)
+        c = foldAscii(c);
+
+    if (m_glob) {
+        m_anchorStart = !m_lower.startsWith('*');
+        m_anchorEnd   = !m_lower.endsWith('*');
+        for (const QByteArray &part : m_lower.split('*')) {
+            if (!part.isEmpty())
+                m_segments << part;
+        }
+    }
+}
+
+bool NameFilter::matches(QByteArrayView name) const
+{
+    if (m_pattern.isEmpty())
+        return true;
+    if (!m_ascii)
+        return matchesUnicode(name);
+    // '?' — один символ, а в UTF-8 символ бывает многобайтным
+    if (m_anyChar && hasNonAscii(name.data(), name.size()))
+        return matchesUnicode(name);
+    return matchesAscii(name);
+}
+
+bool NameFilter::matchesAscii(QByteArrayView name) const
+{
+    const char *s = name.data();
+    const qsizetype n = name.size();
+
+    if (!m_glob)
+        return findFolded(s, n, 0, m_lower.constData(), m_lower.size(), false) >= 0;
+
+    if (!m_lower.contains('*')) {
+        // только '?': всё имя целиком
+        return n == m_lower.size() && equalsFolded(s, m_lower.constData(), n, true);
+    }
+
+    // жадный поиск частей слева направо; первая и последняя могут быть
+    // привязаны к краям имени
+    qsizetype pos = 0;
+    for (int k = 0; k < m_segments.size(); ++k) {
+        const QByteArray &seg = m_segments[k];
+        const qsizetype m = seg.size();
+
+        if (k == 0 && m_anchorStart) {
+            if (m > n || !equalsFolded(s, seg.constData(), m, m_anyChar))
+                return false;
+            pos = m;
+            continue;
+        }
+        if (k == m_segments.size() - 1 && m_anchorEnd) {
+            return n - m >= pos && equalsFolded(s + n - m, seg.constData(), m, m_anyChar);
+        }
+
+        const qsizetype found = findFolded(s, n, pos, seg.constData(), m, m_anyChar);
+        if (found < 0)
+            return false;
+        pos = found + m;
+    }
+    return true;
+}
+
+bool NameFilter::matchesUnicode(QByteArrayView name) const
+{
+    const QString s = QString::fromUtf8(name);
+    if (m_glob)
+        return m_regex.match(s).hasMatch();
+    return s.contains(m_pattern, Qt::CaseInsensitive);
+}
+
+bool NameFilter::narrows(const NameFilter &wider) const
+{
+    if (wider.isEmpty())
+        return true;
+    // дописанный к подстроке символ сужает выборку; у шаблона на всё имя
+    // (*.c -> *.cp) — нет
+    if (m_glob || wider.m_glob)
+        return m_pattern.compare(wider.m_pattern, Qt::CaseInsensitive) == 0;
+    return m_pattern.contains(wider.m_pattern, Qt::CaseInsensitive);
+}
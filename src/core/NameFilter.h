@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include "BelkinExport.h"
+
+// Фильтр имён для быстрого поиска в панели.
+// Без * и ? — подстрока в любом месте имени, с ними — шаблон на всё имя.
+// Регистр не учитывается. Имена проверяются прямо в UTF-8 (арена
+// DirectoryListing): ASCII-шаблон ищется SSE2-сканированием со сворачиванием
+// регистра на лету, шаблон с не-ASCII символами идёт через QString.
+class BELKINCORE_EXPORT NameFilter
+{
+public:
+    NameFilter() = default;
+    explicit NameFilter(const QString &pattern);
+
+    QString pattern() const { return m_pattern; }
+    bool isEmpty() const { return m_pattern.isEmpty(); }
+    bool isGlob() const { return m_glob; }
+
+    bool matches(QByteArrayView name) const;
+
+    // всё, что проходит этот фильтр, проходит и wider — значит, при уточнении
+    // шаблона достаточно перепроверить прежние совпадения
+    bool narrows(const NameFilter &wider) const;
+
+private:
+    bool matchesAscii(QByteArrayView name) const;
+    bool matchesUnicode(QByteArrayView name) const;
+
+    QString m_pattern;
+    bool m_glob  = false;
+    bool m_ascii = true;
+    bool m_anyChar = false;       // в шаблоне есть '?'
+
+    QByteArray        m_lower;     // ASCII-шаблон в нижнем регистре
+    QList<QByteArray> m_segments;  // части glob между '*'
+    bool m_anchorStart = false;
+    bool m_anchorEnd   = false;
+
+    QRegularExpression m_regex;   // glob для не-ASCII
+};
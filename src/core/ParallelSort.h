@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QThread>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// Параллельная сортировка без TBB и execution policies:
+// куски сортируются std::sort в своих потоках, затем сливаются попарно
+// (каждый раунд слияний тоже параллельный). Маленькие массивы — обычный std::sort.
+template <typename RandomIt, typename Less>
+void parallelSort(RandomIt first, RandomIt last, Less less, int threads = 0)
+{
+    constexpr std::ptrdiff_t MinParallel = 32 * 1024;
+
+    const std::ptrdiff_t n = std::distance(first, last);
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    if (n < MinParallel || threads <= 1) {
+        std::sort(first, last, less);
+        return;
+    }
+
+    const int chunks = int(std::min<std::ptrdiff_t>(threads, n / (MinParallel / 2)));
+    std::vector<RandomIt> bounds;
+    bounds.reserve(chunks + 1);
+    for (int i = 0; i <= chunks; ++i)
+        bounds.push_back(first + n * i / chunks);
+
+    {
+        std::vector<std::thread> pool;
+        for (int i = 1; i < chunks; ++i)
+            pool.emplace_back([&, i]() { std::sort(bounds[i], bounds[i + 1], less); });
+        std::sort(bounds[0], bounds[1], less);
+        for (std::thread &t : pool)
+            t.join();
+    }
+
+    // слияние соседних кусков, пока не останется один
+    while (bounds.size() > 2) {
+        std::vector<RandomIt> merged;
+        std::vector<std::thread> pool;
+        size_t i = 0;
+        for (; i + 2 < bounds.size(); i += 2) {
+            pool.emplace_back([&bounds, &less, i]() {
+                std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], less);
+            });
+            merged.push_back(bounds[i]);
+        }
+        for (; i < bounds.size(); ++i)
+            merged.push_back(bounds[i]);
+        for (std::thread &t : pool)
+            t.join();
+        bounds = std::move(merged);
+    }
+}
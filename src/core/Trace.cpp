@@ -0,0 +1,243 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Trace.h"
+
+namespace trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+struct Event {
+    const char *name;
+    qint64 start;
+    qint64 duration;
+};
+
+// Кольцевой буфер одного потока: пишет только владелец, читает дамп.
+// Память выделяется кусками по мере записи: поток с парой событий
+// занимает 24 КБ, а не все 1,5 МБ полного кольца
+struct ThreadBuffer {
+    static constexpr quint64 Capacity = 1 << 16;   // 65536 событий на поток
+    static constexpr quint64 ChunkSize = 1 << 10;  // 1024 события, 24 КБ
+
+    // кусок публикуется владельцем до head.store(release), поэтому читатель,
+    // берущий только индексы ниже прочитанного head, видит его выделенным
+    std::unique_ptr<Event[]> chunks[Capacity / ChunkSize];
+    std::atomic<quint64> head{0};
+    std::atomic<quint64> cleared{0};    // события до этого индекса уже сброшены clear()
+    std::atomic<bool> finished{false};  // поток завершился
+    int tid = 0;
+    QString threadName;
+
+    Event &at(quint64 i)
+    {
+        i &= Capacity - 1;
+        return chunks[i / ChunkSize][i % ChunkSize];
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // живут дольше потоков
+    int nextTid = 1;
+    QString envPath;
+};
+
+Registry &registry()
+{
+    static Registry r;
+    return r;
+}
+
+// Помечает буфер завершённым при выходе потока, чтобы clear() мог его освободить
+struct ThreadBufferHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~ThreadBufferHolder()
+    {
+        if (buffer)
+            buffer->finished.store(true, std::memory_order_release);
+    }
+};
+
+ThreadBuffer *threadBuffer()
+{
+    thread_local ThreadBufferHolder holder;
+    if (holder.buffer)
+        return holder.buffer.get();
+
+    auto b = std::make_shared<ThreadBuffer>();
+    QThread *t = QThread::currentThread();
+    const bool isMain = QCoreApplication::instance()
+                        && QCoreApplication::instance()->thread() == t;
+
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    b->tid = r.nextTid++;
+    b->threadName = isMain ? QStringLiteral("main")
+                  : (t && !t->objectName().isEmpty() ? t->objectName()
+                                                      : QStringLiteral("worker %1").arg(b->tid));
+    r.buffers.push_back(b);
+    holder.buffer = b;
+    return b.get();
+}
+
+// Строка JSON: кавычки, обратная косая и управляющие символы
+void appendEscaped(QByteArray &out, const char *s)
+{
+    for (; *s; ++s) {
+        const uchar c = uchar(*s);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += char(c);
+        } else if (c < 0x20) {
+            out += "\\u00";
+            out += "0123456789abcdef"[c >> 4];
+            out += "0123456789abcdef"[c & 0xF];
+        } else {
+            out += char(c);
+        }
+    }
+}
+
+} // namespace
+
+void setEnabled(bool on)
+{
+    g_enabled.store(on, std::memory_order_relaxed);
+}
+
+qint64 nowNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void record(const char *name, qint64 startNs, qint64 durationNs)
+{
+    ThreadBuffer *b = threadBuffer();
+    const quint64 h = b->head.load(std::memory_order_relaxed);
+    std::unique_ptr<Event[]> &chunk = b->chunks[(h & (ThreadBuffer::Capacity - 1)) / ThreadBuffer::ChunkSize];
+    if (!chunk)
+        chunk = std::make_unique<Event[]>(ThreadBuffer::ChunkSize);
+    b->at(h) = { name, startNs, durationNs };
+    b->head.store(h + 1, std::memory_order_release);
+}
+
+void clear()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    // буферы завершившихся потоков освобождаем; у живых head двигает только
+    // владелец, поэтому просто запоминаем, с какого события читать дальше
+    r.buffers.erase(std::remove_if(r.buffers.begin(), r.buffers.end(),
+                                   [](const auto &b) { return b->finished.load(std::memory_order_acquire); }),
+                    r.buffers.end());
+    for (const auto &b : r.buffers)
+        b->cleared.store(b->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+bool writeChromeTrace(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffers = r.buffers;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out;
+    out.reserve(1 << 20);
+    out += "{\"traceEvents\":[\n";
+    bool first = true;
+
+    auto sep = [&]() {
+        if (!first)
+            out += ",\n";
+        first = false;
+    };
+
+    for (const auto &b : buffers) {
+        sep();
+        out += QStringLiteral("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%1,\"tid\":%2,"
+                              "\"args\":{\"name\":\"").arg(pid).arg(b->tid).toUtf8();
+        appendEscaped(out, b->threadName.toUtf8().constData());
+        out += "\"}}";
+
+        // Копируем хвост кольца; записи, которые поток мог перезаписать
+        // во время копирования, отбрасываем по повторно прочитанному head
+        const quint64 head = b->head.load(std::memory_order_acquire);
+        const quint64 begin = std::max<quint64>(head > ThreadBuffer::Capacity ? head - ThreadBuffer::Capacity : 0,
+                                                b->cleared.load(std::memory_order_relaxed));
+        std::vector<Event> copy;
+        copy.reserve(head - begin);
+        for (quint64 i = begin; i < head; ++i)
+            copy.push_back(b->at(i));
+
+        const quint64 headAfter = b->head.load(std::memory_order_acquire);
+        // +1: запись с индексом headAfter может идти прямо сейчас
+        const quint64 safeBegin = headAfter + 1 > ThreadBuffer::Capacity
+                                  ? headAfter + 1 - ThreadBuffer::Capacity : 0;
+
+        for (quint64 i = std::max(begin, safeBegin); i < head; ++i) {
+            const Event &e = copy[i - begin];
+            sep();
+            out += "{\"name\":\"";
+            appendEscaped(out, e.name);
+            out += "\",\"cat\":\"belkin\",\"ph\":\"X\",\"ts\":";
+            out += QByteArray::number(e.start / 1000.0, 'f', 3);
+            out += ",\"dur\":";
+            out += QByteArray::number(e.duration / 1000.0, 'f', 3);
+            out += ",\"pid\":";
+            out += QByteArray::number(pid);
+            out += ",\"tid\":";
+            out += QByteArray::number(b->tid);
+            out += '}';
+
+            if (out.size() > (1 << 20)) {
+                f.write(out);
+                out.clear();
+            }
+        }
+    }
+
+    out += "\n]}\n";
+    return f.write(out) == out.size();
+}
+
+static void dumpAtExit()
+{
+    const QString path = registry().envPath;
+    if (path.isEmpty())
+        return;
+
+    if (writeChromeTrace(path))
+        qDebug() << "Trace written to" << path;
+    else
+        qDebug() << "Failed to write trace to" << path;
+}
+
+void initFromEnvironment()
+{
+    const QString path = qEnvironmentVariable("BELKIN_TRACE");
+    if (path.isEmpty())
+        return;
+
+    registry().envPath = path;
+    setEnabled(true);
+    qAddPostRoutine(dumpAtExit);
+}
+
+} // namespace trace
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include "BelkinExport.h"
+
+// Лёгкая трассировка операций в формате Chrome trace-event (chrome://tracing, Perfetto).
+//
+// События пишутся в кольцевой буфер своего потока без блокировок
+// (мьютекс берётся один раз — при регистрации буфера потока).
+// Когда трассировка выключена, BELKIN_TRACE_SCOPE стоит одно relaxed-чтение atomic.
+//
+// Включение: переменная окружения BELKIN_TRACE=/path/trace.json
+// (дамп при завершении приложения) или меню Diagnostics в главном окне.
+namespace trace {
+
+BELKINCORE_EXPORT extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+BELKINCORE_EXPORT void setEnabled(bool on);
+BELKINCORE_EXPORT qint64 nowNs();
+
+// name должен жить всё время работы программы (строковый литерал)
+BELKINCORE_EXPORT void record(const char *name, qint64 startNs, qint64 durationNs);
+
+BELKINCORE_EXPORT void clear();
+BELKINCORE_EXPORT bool writeChromeTrace(const QString &path);
+
+// BELKIN_TRACE=path: включает запись и сохраняет трассу при выходе из приложения
+BELKINCORE_EXPORT void initFromEnvironment();
+
+class Scope
+{
+public:
+    explicit Scope(const char *name)
+        : m_name(enabled() ? name : nullptr)
+    {
+        if (m_name)
+            m_start = nowNs();
+    }
+
+    ~Scope()
+    {
+        if (m_name)
+            record(m_name, m_start, nowNs() - m_start);
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_start = 0;
+};
+
+} // namespace trace
+
+#define BELKIN_TRACE_CAT2(a, b) a##b
+#define BELKIN_TRACE_CAT(a, b) BELKIN_TRACE_CAT2(a, b)
+#define BELKIN_TRACE_SCOPE(name) ::trace::Scope BELKIN_TRACE_CAT(_traceScope_, __LINE__)(name)
@@ -1,6 +1,7 @@
 #include "CopyPlugin.h"
 #include "CopyProgressDialog.hpp"
 #include "CopySignals.h"
+#include "Trace.h"
 
 #include <QDebug>
 
@@ -11,8 +12,8 @@ void CopyPlugin::initialize()
     connect(sig, &CopySignals::copyStarted,
             this, &CopyPlugin::onCopyStarted);
 
-    connect(sig, &CopySignals::copyProgress,
-            this, &CopyPlugin::onCopyProgress);
+    connect(sig, &CopySignals::progressChanged,
+            this, &CopyPlugin::onProgressChanged);
 
     connect(sig, &CopySignals::copyFinished,
             this, &CopyPlugin::onCopyFinished);
@@ -20,6 +21,9 @@ void CopyPlugin::initialize()
     connect(sig, &CopySignals::copyError,
             this, &CopyPlugin::onCopyError);
 
+    connect(sig, &CopySignals::syncFinished,
+            this, &CopyPlugin::onSyncFinished);
+
     qDebug() << "[CopyPlugin] initialized";
 }
 
@@ -57,12 +61,13 @@ void CopyPlugin::onCopyStarted(const QStringList &files, const QString &targetDi
 }
 
 
-void CopyPlugin::onCopyProgress(int fileIndex, qint64 copied, qint64 total, double speedMB)
+void CopyPlugin::onProgressChanged(const CopyProgress &progress)
 {
+    BELKIN_TRACE_SCOPE("gui.copyProgress");
     if (!m_dialog)
         return;
 
-    m_dialog->updateProgress(fileIndex, copied, total, speedMB);
+    m_dialog->updateProgress(progress);
 }
 
 void CopyPlugin::onCopyFinished()
@@ -75,6 +80,12 @@ void CopyPlugin::onCopyFinished()
     }
 }
 
+void CopyPlugin::onSyncFinished(qint64 syncMs)
+{
+    // итоговые фазы уже пришли в последнем CopyProgress (finished = true)
+    qDebug() << "[CopyPlugin] Time spent in sync:" << syncMs << "ms";
+}
+
 void CopyPlugin::onCopyError(const QString &path)
 {
     qDebug() << "[CopyPlugin] Copy error:" << path;
@@ -4,13 +4,14 @@
 #include <QList>
 #include <QAction>
 #include "FilePluginInterface.h"
+#include "CopyProgress.h"
 
 class CopyProgressDialog;
 
 class CopyPlugin : public QObject, public FilePluginInterface
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID FilePluginInterface_iid)
+    Q_PLUGIN_METADATA(IID FilePluginInterface_iid FILE "CopyPlugin.json")
     Q_INTERFACES(FilePluginInterface)
 
 public:
@@ -31,8 +32,9 @@ public:
 
 private slots:
     void onCopyStarted(const QStringList &files, const QString &targetDir, FileOpType opType);
-    void onCopyProgress(int fileIndex, qint64 copied, qint64 total, double speedMB);
+    void onProgressChanged(const CopyProgress &progress);
     void onCopyFinished();
+    void onSyncFinished(qint64 syncMs);
     void onCopyError(const QString &path);
 
 private:
@@ -5,6 +5,9 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QVBoxLayout>
+#include <QFileInfo>
+#include <QLocale>
+#include "CopyProgress.h"
 
 class CopyProgressDialog : public QDialog
 {
@@ -21,24 +24,53 @@ public:
         setMinimumWidth(420);
 
         m_fileLabel = new QLabel("File 1 of " + QString::number(fileCount));
+        m_currentLabel = new QLabel;
+        m_currentLabel->setTextFormat(Qt::PlainText);
         m_speedLabel = new QLabel("Speed: 0 MB/s");
 
+        // общий прогресс задачи по байтам, второй — по текущему файлу
         m_progress = new QProgressBar;
-        m_progress->setRange(0, 100);
+        m_progress->setRange(0, 1000);
+        m_fileProgress = new QProgressBar;
+        m_fileProgress->setRange(0, 1000);
+        m_fileProgress->setTextVisible(false);
+        m_fileProgress->setMaximumHeight(8);
 
         QVBoxLayout *layout = new QVBoxLayout;
         layout->addWidget(m_fileLabel);
         layout->addWidget(m_progress);
+        layout->addWidget(m_currentLabel);
+        layout->addWidget(m_fileProgress);
         layout->addWidget(m_speedLabel);
 
         setLayout(layout);
     }
 
-    void updateProgress(int fileIndex, qint64 copied, qint64 total, double speedMB)
+    void updateProgress(const CopyProgress &p)
     {
-        m_fileLabel->setText(QString("File %1").arg(fileIndex + 1));
-        m_progress->setValue(int((double)copied / total * 100));
-        m_speedLabel->setText(QString("Speed: %1 MB/s").arg(speedMB, 0, 'f', 2));
+        const QLocale locale;
+
+        m_fileLabel->setText(QString("Files %1 of %2 (%3 of %4)")
+                                 .arg(p.filesDone)
+                                 .arg(p.filesTotal)
+                                 .arg(locale.formattedDataSize(p.bytesDone))
+                                 .arg(locale.formattedDataSize(p.bytesTotal)));
+        m_progress->setValue(permille(p.bytesDone, p.bytesTotal));
+
+        m_currentLabel->setText(QFileInfo(p.currentFile).fileName());
+        m_fileProgress->setValue(permille(p.currentFileDone, p.currentFileTotal));
+
+        QString eta = "--:--";
+        if (p.etaSeconds >= 0) {
+            const qint64 s = qint64(p.etaSeconds);
+            eta = s >= 3600
+                ? QString("%1:%2:%3").arg(s / 3600).arg(s / 60 % 60, 2, 10, QChar('0')).arg(s % 60, 2, 10, QChar('0'))
+                : QString("%1:%2").arg(s / 60, 2, 10, QChar('0')).arg(s % 60, 2, 10, QChar('0'));
+        }
+
+        m_speedLabel->setText(QString("Speed: %1 MB/s, left %2")
+                                  .arg(p.rateBytesPerSec / (1024.0 * 1024.0), 0, 'f', 2)
+                                  .arg(eta));
     }
 
     void showError(const QString &msg)
@@ -47,7 +79,14 @@ public:
     }
 
 private:
+    static int permille(qint64 done, qint64 total)
+    {
+        return total > 0 ? int(qBound<qint64>(0, done * 1000 / total, 1000)) : 0;
+    }
+
     QLabel *m_fileLabel;
+    QLabel *m_currentLabel;
     QLabel *m_speedLabel;
     QProgressBar *m_progress;
+    QProgressBar *m_fileProgress;
 };
@@ -9,7 +9,7 @@ class DuplicateFinderDialog;
 class DuplicateFinderPlugin : public QObject, public FilePluginInterface
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID FilePluginInterface_iid)
+    Q_PLUGIN_METADATA(IID FilePluginInterface_iid FILE "DuplicateFinderPlugin.json")
     Q_INTERFACES(FilePluginInterface)
 
 public:
@@ -176,23 +176,23 @@ void DuplicateFinderDialog::onRemoveMask()
 
 void DuplicateFinderDialog::onRunSearch()
 {
-    ScanParams p;
+    DuplicateScanParams p;
 
     for (int i = 0; i < scanDirsList_->count(); ++i)
-        p.scanDirs.push_back(scanDirsList_->item(i)->text().toStdString());
+        p.scanDirs << scanDirsList_->item(i)->text();
 
     for (int i = 0; i < excludeDirsList_->count(); ++i)
-        p.excludeDirs.push_back(excludeDirsList_->item(i)->text().toStdString());
+        p.excludeDirs << excludeDirsList_->item(i)->text();
 
     for (int i = 0; i < masksList_->count(); ++i)
-        p.masks.push_back(masksList_->item(i)->text().toStdString());
+        p.masks << masksList_->item(i)->text();
 
     p.level = levelSpin_->value();
     p.minSize = minSizeSpin_->value();
     p.blockSize = blockSizeSpin_->value();
-    p.algo = algoCombo_->currentText().toStdString();
+    p.algo = algoCombo_->currentText();
 
-    auto groups = findDuplicates(p);
+    auto groups = DuplicateFinder::find(p);
 
     auto* model = qobject_cast<DuplicateResultModel*>(resultTable_->model());
     model->setData(groups);
@@ -6,7 +6,7 @@
 #include <QComboBox>
 #include <QTableView>
 #include <QPushButton>
-#include "duplicate_finder.hpp"
+#include "DuplicateFinder.h"
 
 class DuplicateFinderDialog : public QDialog
 {
@@ -12,7 +12,7 @@ void DuplicateResultModel::setData(const std::vector<DuplicateGroup>& groups)
 
     for (const auto& g : groups) {
         for (const auto& f : g.files) {
-            rows_.push_back({ g.size, QString::fromStdString(f.string()) });
+            rows_.push_back({ g.size, f });
         }
     }
 
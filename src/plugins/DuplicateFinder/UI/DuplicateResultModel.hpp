@@ -1,6 +1,6 @@
 #pragma once
 #include <QAbstractTableModel>
-#include "duplicate_finder.hpp"
+#include "DuplicateFinder.h"
 
 class DuplicateResultModel : public QAbstractTableModel
 {
@@ -18,7 +18,7 @@ public:
 
 private:
     struct Row {
-        std::size_t size;
+        qint64 size;
         QString path;
     };
 
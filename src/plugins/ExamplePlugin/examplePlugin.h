@@ -8,7 +8,7 @@ class QLabel;
 class ExamplePlugin : public QObject, public FilePluginInterface
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID FilePluginInterface_iid)
+    Q_PLUGIN_METADATA(IID FilePluginInterface_iid FILE "examplePlugin.json")
     Q_INTERFACES(FilePluginInterface)
 
 public:
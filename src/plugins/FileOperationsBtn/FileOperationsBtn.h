@@ -9,7 +9,7 @@ class QPushButton;
 class FileOperationsBtn : public QObject, public FilePluginInterface
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID FilePluginInterface_iid)
+    Q_PLUGIN_METADATA(IID FilePluginInterface_iid FILE "FileOperationsBtn.json")
     Q_INTERFACES(FilePluginInterface)
 
 public:
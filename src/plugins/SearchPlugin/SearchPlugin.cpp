@@ -0,0 +1,76 @@
+#include "SearchPlugin.h"
+#include "ContentIndexService.h"
+#include "SearchWidget.h"
+
+#include <QAction>
+#include <QFileInfo>
+
+QWidget* SearchPlugin::createWidget()
+{
+    if (!m_widget) {
+        m_widget = new SearchWidget(nullptr);
+        if (m_api)
+            m_widget->setFileIndex(m_api->fileIndex());
+        m_widget->setContentIndex(m_contentIndex);
+        connect(m_widget, &SearchWidget::fileActivated, this, [this](const QString &path) {
+            if (m_api)
+                m_api->navigateToFile(path);
+        });
+    }
+    return m_widget;
+}
+
+void SearchPlugin::execute(const QStringList &files)
+{
+    if (!m_api)
+        return;
+
+    createWidget();
+    m_widget->setRoots(rootsFor(files));
+    m_api->showDockForPlugin(this);
+    m_widget->focusPattern();
+}
+
+QStringList SearchPlugin::rootsFor(const QStringList &files) const
+{
+    QStringList roots;
+    for (const QString &file : files) {
+        if (QFileInfo(file).isDir())
+            roots.append(file);
+    }
+    if (roots.isEmpty() && m_api) {
+        // выделены только файлы — ищем в каталоге, где они лежат
+        const QString current = m_api->currentFilePath();
+        if (!current.isEmpty())
+            roots.append(QFileInfo(current).absolutePath());
+    }
+    return roots;
+}
+
+void SearchPlugin::initialize()
+{
+    // индексы содержимого обновляются в фоне, даже пока док закрыт
+    m_contentIndex = new ContentIndexService(this);
+
+    QAction *act = new QAction("Искать здесь...");
+
+    connect(act, &QAction::triggered, this, [this]() {
+        execute(m_api->selectedFiles());
+    });
+
+    m_api->addContextMenuAction(act);
+    m_actions.append(act);
+}
+
+void SearchPlugin::shutdown()
+{
+    if (m_widget)
+        m_widget->setContentIndex(nullptr);
+    delete m_contentIndex;
+    m_contentIndex = nullptr;
+
+    for (QAction *a : m_actions)
+        delete a;
+
+    m_actions.clear();
+}
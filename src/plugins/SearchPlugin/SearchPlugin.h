@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include "FilePluginInterface.h"
+
+class ContentIndexService;
+class QAction;
+class SearchWidget;
+
+// Поиск файлов по имени и содержимому в доке главного окна
+class SearchPlugin : public QObject, public FilePluginInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID FilePluginInterface_iid FILE "SearchPlugin.json")
+    Q_INTERFACES(FilePluginInterface)
+
+public:
+    QString name() const override { return "Search"; }
+    void execute(const QStringList &files) override;
+
+    QIcon icon() const override { return QIcon(); }
+    void setApplicationAPI(ApplicationAPI *api) override { m_api = api; }
+    bool showWidget() const override { return true; }
+    bool backgroundPlugin() const override { return false; }
+
+    QWidget* createWidget() override;
+    void initialize() override;
+    void shutdown() override;
+
+private:
+    // где искать: выделенные каталоги, иначе текущий каталог панели
+    QStringList rootsFor(const QStringList &files) const;
+
+    ApplicationAPI *m_api = nullptr;
+    QPointer<SearchWidget> m_widget;
+    ContentIndexService *m_contentIndex = nullptr;
+    QList<QAction*> m_actions;
+};
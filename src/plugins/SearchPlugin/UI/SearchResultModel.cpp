@@ -0,0 +1,93 @@
+#include "SearchResultModel.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include <iterator>
+
+SearchResultModel::SearchResultModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void SearchResultModel::clear()
+{
+    beginResetModel();
+    m_hits.clear();
+    endResetModel();
+}
+
+void SearchResultModel::append(std::vector<SearchHit> &hits)
+{
+    if (hits.empty())
+        return;
+
+    const int first = int(m_hits.size());
+    beginInsertRows(QModelIndex(), first, first + int(hits.size()) - 1);
+    m_hits.insert(m_hits.end(), std::make_move_iterator(hits.begin()),
+                  std::make_move_iterator(hits.end()));
+    endInsertRows();
+    hits.clear();
+}
+
+QString SearchResultModel::filePathAt(int row) const
+{
+    if (row < 0 || row >= int(m_hits.size()))
+        return {};
+    return m_hits[size_t(row)].path;
+}
+
+int SearchResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_hits.size());
+}
+
+int SearchResultModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant SearchResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= int(m_hits.size()))
+        return {};
+
+    const SearchHit &hit = m_hits[size_t(index.row())];
+
+    if (role == Qt::ToolTipRole)
+        return QDir::toNativeSeparators(hit.path);
+
+    if (role == Qt::TextAlignmentRole && index.column() == SizeColumn)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+
+    if (role != Qt::DisplayRole)
+        return {};
+
+    switch (index.column()) {
+    case NameColumn:
+        return QFileInfo(hit.path).fileName();
+    case FolderColumn:
+        return QDir::toNativeSeparators(QFileInfo(hit.path).path());
+    case SizeColumn:
+        if (hit.dir)
+            return QStringLiteral("<DIR>");
+        return hit.size < 0 ? QString() : QLocale().formattedDataSize(hit.size);
+    case LineColumn:
+        return hit.line > 0 ? QStringLiteral("%1: %2").arg(hit.line).arg(hit.text) : QString();
+    }
+    return {};
+}
+
+QVariant SearchResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return {};
+
+    switch (section) {
+    case NameColumn:   return "Имя";
+    case FolderColumn: return "Папка";
+    case SizeColumn:   return "Размер";
+    case LineColumn:   return "Строка";
+    }
+    return {};
+}
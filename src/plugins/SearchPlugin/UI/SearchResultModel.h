@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <vector>
+#include "FileSearch.h"
+
+// Найденные файлы; строки дописываются пачками по мере поиска
+class SearchResultModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { NameColumn, FolderColumn, SizeColumn, LineColumn, ColumnCount };
+
+    explicit SearchResultModel(QObject *parent = nullptr);
+
+    void clear();
+    void append(std::vector<SearchHit> &hits);
+
+    QString filePathAt(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+private:
+    std::vector<SearchHit> m_hits;
+};
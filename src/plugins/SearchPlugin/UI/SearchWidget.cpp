@@ -0,0 +1,361 @@
+#include "SearchWidget.h"
+#include "ContentIndex.h"
+#include "ContentIndexService.h"
+#include "SearchResultModel.h"
+
+#include <QCheckBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableView>
+#include <QThread>
+#include <QVBoxLayout>
+#include "FileIndex.h"
+
+namespace {
+
+// совпадения из индекса имён приходят быстро — пачки крупнее, чем у обхода
+constexpr size_t IndexBatchHits = 4096;
+
+} // namespace
+
+SearchWidget::SearchWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    auto *mainLayout = new QVBoxLayout(this);
+    auto *form = new QFormLayout();
+
+    // --- Где искать ---
+    m_roots = new QLineEdit();
+    m_roots->setPlaceholderText("Каталоги через ;");
+    auto *browseBtn = new QPushButton("...");
+    connect(browseBtn, &QPushButton::clicked, this, &SearchWidget::onBrowse);
+    m_indexButton = new QPushButton("Индекс");
+    m_indexButton->setCheckable(true);
+    m_indexButton->setVisible(false);
+    connect(m_indexButton, &QPushButton::clicked, this, &SearchWidget::onIndexToggled);
+    connect(m_roots, &QLineEdit::textChanged, this, &SearchWidget::updateIndexButton);
+    auto *rootsLayout = new QHBoxLayout();
+    rootsLayout->addWidget(m_roots);
+    rootsLayout->addWidget(browseBtn);
+    rootsLayout->addWidget(m_indexButton);
+    form->addRow("Где:", rootsLayout);
+
+    // --- Имя ---
+    m_name = new QLineEdit();
+    m_name->setPlaceholderText("*.cpp;*.h — пусто: любое имя");
+    m_nameRegex = new QCheckBox("RegExp");
+    auto *nameLayout = new QHBoxLayout();
+    nameLayout->addWidget(m_name);
+    nameLayout->addWidget(m_nameRegex);
+    form->addRow("Имя:", nameLayout);
+
+    // --- Содержимое ---
+    m_content = new QLineEdit();
+    m_content->setPlaceholderText("Текст в файле — пусто: не читать файлы");
+    m_contentRegex = new QCheckBox("RegExp");
+    auto *contentLayout = new QHBoxLayout();
+    contentLayout->addWidget(m_content);
+    contentLayout->addWidget(m_contentRegex);
+    form->addRow("Текст:", contentLayout);
+
+    mainLayout->addLayout(form);
+
+    // --- Параметры ---
+    m_caseSensitive = new QCheckBox("Учитывать регистр");
+    m_hidden = new QCheckBox("Скрытые");
+    m_skipBinary = new QCheckBox("Пропускать двоичные");
+    m_skipBinary->setChecked(true);
+    m_startButton = new QPushButton("Найти");
+    connect(m_startButton, &QPushButton::clicked, this, &SearchWidget::onStartStop);
+
+    auto *optionsLayout = new QHBoxLayout();
+    optionsLayout->addWidget(m_caseSensitive);
+    optionsLayout->addWidget(m_hidden);
+    optionsLayout->addWidget(m_skipBinary);
+    optionsLayout->addStretch();
+    optionsLayout->addWidget(m_startButton);
+    mainLayout->addLayout(optionsLayout);
+
+    for (QLineEdit *edit : { m_roots, m_name, m_content })
+        connect(edit, &QLineEdit::returnPressed, this, &SearchWidget::start);
+
+    // --- Результаты ---
+    m_model = new SearchResultModel(this);
+    m_view = new QTableView();
+    m_view->setModel(m_model);
+    m_view->verticalHeader()->setVisible(false);
+    m_view->verticalHeader()->setDefaultSectionSize(m_view->fontMetrics().height() + 4);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_view->setWordWrap(false);
+    auto *header = m_view->horizontalHeader();
+    header->setSectionResizeMode(SearchResultModel::NameColumn, QHeaderView::Interactive);
+    header->setSectionResizeMode(SearchResultModel::SizeColumn, QHeaderView::ResizeToContents);
+    header->setStretchLastSection(true);
+    connect(m_view, &QTableView::doubleClicked, this, &SearchWidget::onActivated);
+    mainLayout->addWidget(m_view, 1);
+
+    m_status = new QLabel();
+    mainLayout->addWidget(m_status);
+}
+
+SearchWidget::~SearchWidget()
+{
+    stop();
+}
+
+void SearchWidget::setRoots(const QStringList &roots)
+{
+    if (m_thread || roots.isEmpty())
+        return;
+
+    QStringList native;
+    for (const QString &root : roots)
+        native.append(QDir::toNativeSeparators(root));
+    m_roots->setText(native.join("; "));
+}
+
+void SearchWidget::setContentIndex(ContentIndexService *index)
+{
+    // идущий поиск может держать прежний индекс
+    stop();
+    updateStatus(false);
+    if (m_contentIndex)
+        disconnect(m_contentIndex, nullptr, this, nullptr);
+    m_contentIndex = index;
+    m_indexButton->setVisible(index != nullptr);
+    if (index)
+        connect(index, &ContentIndexService::indexUpdated, this, &SearchWidget::updateIndexButton);
+    updateIndexButton();
+}
+
+void SearchWidget::focusPattern()
+{
+    m_name->setFocus();
+    m_name->selectAll();
+}
+
+void SearchWidget::onStartStop()
+{
+    if (m_thread) {
+        stop();
+        updateStatus(false);
+    } else {
+        start();
+    }
+}
+
+void SearchWidget::onBrowse()
+{
+    const QString dir = QFileDialog::getExistingDirectory(this, "Выбрать каталог");
+    if (dir.isEmpty())
+        return;
+    const QString current = m_roots->text().trimmed();
+    m_roots->setText(current.isEmpty() ? QDir::toNativeSeparators(dir)
+                                       : current + "; " + QDir::toNativeSeparators(dir));
+}
+
+void SearchWidget::onIndexToggled(bool on)
+{
+    if (!m_contentIndex)
+        return;
+    for (const QString &root : roots())
+        m_contentIndex->setIndexed(root, on);
+    updateIndexButton();
+}
+
+void SearchWidget::updateIndexButton()
+{
+    if (!m_contentIndex)
+        return;
+
+    const QStringList list = roots();
+    bool indexed = !list.isEmpty();
+    bool ready = indexed;
+    for (const QString &root : list) {
+        indexed = indexed && m_contentIndex->isIndexed(root);
+        ready = ready && m_contentIndex->covers(root);
+    }
+    m_indexButton->setEnabled(!list.isEmpty());
+    m_indexButton->setChecked(indexed);
+    if (!indexed)
+        m_indexButton->setToolTip("Индексировать содержимое этих каталогов: поиск текста "
+                                  "будет читать только подходящие файлы");
+    else if (ready)
+        m_indexButton->setToolTip("Содержимое проиндексировано — нажать, чтобы убрать индекс");
+    else
+        m_indexButton->setToolTip("Индекс строится в фоне");
+}
+
+void SearchWidget::onActivated(const QModelIndex &index)
+{
+    const QString path = m_model->filePathAt(index.row());
+    if (!path.isEmpty())
+        emit fileActivated(path);
+}
+
+void SearchWidget::start()
+{
+    stop();
+
+    SearchQuery query;
+    query.roots = roots();
+    query.namePattern = m_name->text().trimmed();
+    query.nameRegex = m_nameRegex->isChecked();
+    query.content = m_content->text();
+    query.contentRegex = m_contentRegex->isChecked();
+    query.caseSensitive = m_caseSensitive->isChecked();
+    query.hidden = m_hidden->isChecked();
+    query.skipBinary = m_skipBinary->isChecked();
+
+    if (query.roots.isEmpty()) {
+        m_status->setText("Не указано, где искать");
+        return;
+    }
+    QString error;
+    if (!FileSearch::validate(query, &error)) {
+        m_status->setText(error);
+        return;
+    }
+
+    m_model->clear();
+    m_cancel = std::make_shared<std::atomic<bool>>(false);
+    const std::shared_ptr<std::atomic<bool>> cancel = m_cancel;
+    const quint64 generation = ++m_generation;
+    FileIndex *index = canUseIndex(query) ? m_index : nullptr;
+    ContentIndexService *contentIndex = canUseContentIndex(query) ? m_contentIndex : nullptr;
+    m_source = index ? " (по индексу имён)" : contentIndex ? " (по индексу содержимого)" : "";
+
+    // пачки из потоков поиска — в очередь GUI; деструктор дожидается потока,
+    // так что this жив, пока поиск может что-то прислать
+    m_thread = QThread::create([this, query, cancel, generation, index, contentIndex]() {
+        const FileSearch::Callback deliver = [this, generation](std::vector<SearchHit> &hits) {
+            auto batch = std::make_shared<std::vector<SearchHit>>(std::move(hits));
+            hits.clear();
+            QMetaObject::invokeMethod(this, [this, generation, batch]() {
+                onHits(generation, batch);
+            }, Qt::QueuedConnection);
+        };
+        if (index) {
+            // все совпадения, пачками; размеров и дат в индексе нет —
+            // колонка размера пустая
+            std::vector<SearchHit> batch;
+            for (const QString &root : query.roots) {
+                index->search(query.namePattern, root, [&](const FileIndex::Hit &found) {
+                    if (cancel->load(std::memory_order_relaxed))
+                        return false;
+                    SearchHit hit;
+                    hit.path = found.path;
+                    hit.dir = found.dir;
+                    hit.size = -1;
+                    batch.push_back(std::move(hit));
+                    if (batch.size() >= IndexBatchHits)
+                        deliver(batch);
+                    return true;
+                });
+            }
+            if (!batch.empty())
+                deliver(batch);
+        } else {
+            // кандидаты из индекса содержимого проверяются по самим файлам
+            QStringList files;
+            if (contentIndex && contentIndex->candidates(query, files, cancel.get()))
+                FileSearch::runOnFiles(query, files, deliver, cancel.get());
+            else
+                FileSearch::run(query, deliver, cancel.get());
+        }
+        QMetaObject::invokeMethod(this, [this, generation]() {
+            onFinished(generation);
+        }, Qt::QueuedConnection);
+    });
+    m_thread->setObjectName("file search");
+    connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+    m_elapsed.start();
+    m_thread->start(QThread::LowPriority);
+    updateStatus(true);
+}
+
+QStringList SearchWidget::roots() const
+{
+    QStringList result;
+    for (const QString &part : m_roots->text().split(';', Qt::SkipEmptyParts)) {
+        const QString root = part.trimmed();
+        if (!root.isEmpty())
+            result.append(QDir::cleanPath(QDir::fromNativeSeparators(root)));
+    }
+    return result;
+}
+
+bool SearchWidget::canUseIndex(const SearchQuery &query) const
+{
+    // индекс знает только имена без скрытых записей и ищет без учёта регистра
+    // по одному шаблону в стиле быстрого фильтра
+    if (!m_index || query.namePattern.isEmpty() || query.nameRegex || !query.content.isEmpty()
+        || query.hidden || query.caseSensitive || query.namePattern.contains(QLatin1Char(';')))
+        return false;
+    for (const QString &root : query.roots) {
+        if (!m_index->covers(root))
+            return false;
+    }
+    return true;
+}
+
+bool SearchWidget::canUseContentIndex(const SearchQuery &query) const
+{
+    // скрытых файлов в индексе нет; шаблон без триграмм индекс не сужает
+    std::vector<quint32> grams;
+    if (!m_contentIndex || query.content.isEmpty() || query.hidden
+        || !ContentIndex::queryGrams(query.content, query.contentRegex, query.caseSensitive, grams))
+        return false;
+    for (const QString &root : query.roots) {
+        if (!m_contentIndex->covers(root))
+            return false;
+    }
+    return true;
+}
+
+void SearchWidget::stop()
+{
+    if (!m_thread)
+        return;
+
+    // отмена проверяется на каждой записи и каждом блоке файла — ждать недолго;
+    // пачки остановленного поиска отсечёт поколение
+    m_cancel->store(true);
+    m_thread->wait();
+    m_thread = nullptr;
+    ++m_generation;
+}
+
+void SearchWidget::onHits(quint64 generation, const std::shared_ptr<std::vector<SearchHit>> &hits)
+{
+    if (generation != m_generation)
+        return;
+    m_model->append(*hits);
+    updateStatus(true);
+}
+
+void SearchWidget::onFinished(quint64 generation)
+{
+    if (generation != m_generation)
+        return;
+    m_thread = nullptr;
+    updateStatus(false);
+}
+
+void SearchWidget::updateStatus(bool running)
+{
+    m_startButton->setText(running ? "Стоп" : "Найти");
+    const QString found = QString("Найдено: %1").arg(m_model->rowCount());
+    if (running)
+        m_status->setText(found + " — поиск...");
+    else
+        m_status->setText(found + QString(" за %1 с").arg(m_elapsed.elapsed() / 1000.0, 0, 'f', 1)
+                          + m_source);
+}
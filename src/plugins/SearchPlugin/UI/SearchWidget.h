@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QWidget>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "FileSearch.h"
+
+class ContentIndexService;
+class FileIndex;
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTableView;
+class QThread;
+class SearchResultModel;
+
+// Док поиска: где, что в имени, что в содержимом и список найденного,
+// который растёт по мере обхода
+class SearchWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SearchWidget(QWidget *parent = nullptr);
+    ~SearchWidget() override;
+
+    // каталоги, с которых начнётся следующий поиск (если он ещё не идёт)
+    void setRoots(const QStringList &roots);
+    void focusPattern();
+    // индекс имён: запрос только по имени в проиндексированных каталогах
+    // отвечается из него, без обхода
+    void setFileIndex(FileIndex *index) { m_index = index; }
+    // индекс содержимого: поиск текста в проиндексированных каталогах
+    // читает только файлы-кандидаты; кнопка «Индекс» включает его для корней
+    void setContentIndex(ContentIndexService *index);
+
+signals:
+    // двойной щелчок по найденному
+    void fileActivated(const QString &path);
+
+private slots:
+    void onStartStop();
+    void onBrowse();
+    void onActivated(const QModelIndex &index);
+    void onIndexToggled(bool on);
+    void updateIndexButton();
+
+private:
+    void start();
+    QStringList roots() const;
+    bool canUseIndex(const SearchQuery &query) const;
+    bool canUseContentIndex(const SearchQuery &query) const;
+    void stop();
+    void onHits(quint64 generation, const std::shared_ptr<std::vector<SearchHit>> &hits);
+    void onFinished(quint64 generation);
+    void updateStatus(bool running);
+
+    QLineEdit *m_roots;
+    QLineEdit *m_name;
+    QCheckBox *m_nameRegex;
+    QLineEdit *m_content;
+    QCheckBox *m_contentRegex;
+    QCheckBox *m_caseSensitive;
+    QCheckBox *m_hidden;
+    QCheckBox *m_skipBinary;
+    QPushButton *m_startButton;
+    QPushButton *m_indexButton;
+    QLabel *m_status;
+    QTableView *m_view;
+    SearchResultModel *m_model;
+    FileIndex *m_index = nullptr;
+    ContentIndexService *m_contentIndex = nullptr;
+    QString m_source;       // откуда результат, если не обход: для строки состояния
+
+    // поиск идёт в своём потоке; поколение отсекает пачки остановленного
+    QThread *m_thread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+    quint64 m_generation = 0;
+    QElapsedTimer m_elapsed;
+};
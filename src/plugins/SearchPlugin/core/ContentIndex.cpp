@@ -0,0 +1,845 @@
+#include "ContentIndex.h"
+#include "Trace.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr quint32 Magic = 0x58494342;   // "BCIX"
+constexpr quint32 Version = 1;
+
+// больше — не индексируется (кандидат всегда): дампы, логи, сгенерированное
+constexpr qint64 MaxIndexedSize = 8 * 1024 * 1024;
+// столько разных триграмм у текста почти не бывает — это сжатое или случайное
+constexpr size_t MaxFileGrams = 100000;
+// NUL в первых байтах — двоичный файл, как у ContentMatcher
+constexpr qint64 BinaryProbe = 8 * 1024;
+constexpr qint64 ReadBlock = 256 * 1024;
+// столько номеров в памяти — и уже собранное сбрасывается в промежуточный файл
+constexpr size_t MaxPendingPostings = size_t(64) << 20;
+// mtime моложе — файл ещё могут дописывать в ту же секунду
+constexpr qint64 RacyMs = 2000;
+
+enum FileFlag : quint32 {
+    Indexed = 1,
+    Binary  = 2
+};
+
+// номера файлов по триграмме: собранные в этом проходе, по возрастанию
+using Postings = std::unordered_map<quint32, std::vector<quint32>>;
+
+struct NewFile {
+    QByteArray path;            // от корня, в кодировке ФС
+    qint64     size = 0;
+    qint64     mtime = 0;       // мс; -1 — «свежий», в следующий раз перечитать
+    quint32    flags = 0;
+    bool       reused = false;
+};
+
+bool isCancelled(const std::atomic<bool> *cancel)
+{
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+void putVarint(std::string &out, quint64 v)
+{
+    while (v >= 0x80) {
+        out.push_back(char(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+bool getVarint(const uchar *&p, const uchar *end, quint64 &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uchar b = *p++;
+        v |= quint64(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+inline uchar foldByte(uchar c)
+{
+    return (c >= 'A' && c <= 'Z') ? uchar(c + ('a' - 'A')) : c;
+}
+
+inline quint32 gramKey(uchar a, uchar b, uchar c)
+{
+    return quint32(a) << 16 | quint32(b) << 8 | c;
+}
+
+// Триграммы строки шаблона. asciiOnly — без учёта регистра: регистр не-ASCII
+// символов сворачивается не по байтам, такие триграммы ничего не гарантируют
+void appendGrams(const QByteArray &s, bool asciiOnly, std::vector<quint32> &out)
+{
+    for (qsizetype i = 0; i + 3 <= s.size(); ++i) {
+        const uchar a = uchar(s[i]), b = uchar(s[i + 1]), c = uchar(s[i + 2]);
+        if (a == '\n' || b == '\n' || c == '\n')
+            continue;
+        if (asciiOnly && ((a | b | c) & 0x80))
+            continue;
+        out.push_back(gramKey(foldByte(a), foldByte(b), foldByte(c)));
+    }
+}
+
+// Литералы, которые есть в любом совпадении регулярного выражения.
+// Разбор осторожный: чередование и флаги — отказ; группы, классы и всё
+// после незнакомой escape-последовательности не используются; символ под
+// ?, * или {} выпадает из литерала
+bool requiredLiterals(const QString &p, QStringList &runs)
+{
+    QString run;
+    int depth = 0;
+    bool lastLiteral = false;
+    const auto endRun = [&]() {
+        if (!run.isEmpty())
+            runs.append(run);
+        run.clear();
+    };
+
+    for (qsizetype i = 0; i < p.size();) {
+        const QChar c = p[i];
+
+        if (c == u'*' || c == u'?' || c == u'+' || c == u'{') {
+            if (c == u'{') {
+                const qsizetype close = p.indexOf(u'}', i);
+                if (close < 0)
+                    return false;
+                i = close + 1;
+            } else {
+                ++i;
+            }
+            // ленивые и захватывающие формы
+            if (i < p.size() && (p[i] == u'?' || p[i] == u'+'))
+                ++i;
+            if (lastLiteral) {
+                if (c == u'+') {
+                    // «ab+c»: есть и «ab», и «bc», но не «abc»
+                    const QChar last = run.back();
+                    endRun();
+                    run = last;
+                } else {
+                    run.chop(1);
+                    endRun();
+                }
+            }
+            lastLiteral = false;
+            continue;
+        }
+
+        lastLiteral = false;
+        if (c == u'\\') {
+            if (i + 1 >= p.size())
+                return false;
+            const QChar d = p[i + 1];
+            // \d, \b, \x41, \1... — дальше не разбираем
+            if (d.isLetterOrNumber())
+                break;
+            if (depth == 0) {
+                run += d;
+                lastLiteral = true;
+            }
+            i += 2;
+            continue;
+        }
+        if (c == u'[') {
+            endRun();
+            qsizetype j = i + 1;
+            if (j < p.size() && p[j] == u'^')
+                ++j;
+            if (j < p.size() && p[j] == u']')
+                ++j;
+            while (j < p.size() && p[j] != u']')
+                j += p[j] == u'\\' ? 2 : 1;
+            if (j >= p.size())
+                return false;
+            i = j + 1;
+            continue;
+        }
+        if (c == u'(') {
+            if (i + 1 < p.size() && p[i + 1] == u'?')
+                return false;
+            ++depth;
+            endRun();
+            ++i;
+            continue;
+        }
+        if (c == u')') {
+            --depth;
+            endRun();
+            ++i;
+            continue;
+        }
+        if (c == u'|')
+            return false;
+        if (c == u'.' || c == u'^' || c == u'$') {
+            endRun();
+            ++i;
+            continue;
+        }
+        if (depth == 0) {
+            run += c;
+            lastLiteral = true;
+        }
+        ++i;
+    }
+    endRun();
+    return true;
+}
+
+// Триграммы одного файла без повторов: битовая карта на все 2^24 ключа
+// (2 МБ) и список поставленных бит, чтобы быстро её очистить
+class GramSet
+{
+public:
+    GramSet() : m_bits(size_t(1) << 18) {}
+
+    void add(quint32 key)
+    {
+        quint64 &word = m_bits[key >> 6];
+        const quint64 bit = quint64(1) << (key & 63);
+        if (word & bit)
+            return;
+        word |= bit;
+        m_keys.push_back(key);
+    }
+
+    const std::vector<quint32> &keys() const { return m_keys; }
+    size_t size() const { return m_keys.size(); }
+
+    void clear()
+    {
+        for (quint32 key : m_keys)
+            m_bits[key >> 6] = 0;
+        m_keys.clear();
+    }
+
+private:
+    std::vector<quint64> m_bits;
+    std::vector<quint32> m_keys;
+};
+
+// триграммы файла в grams; флаги для записи файла в индексе
+quint32 readFile(const QString &path, GramSet &grams, std::vector<char> &buffer)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() > MaxIndexedSize)
+        return 0;
+
+    uchar a = 0, b = 0;
+    int have = 0;       // байтов подряд без '\n' перед текущим, до 2
+    bool first = true;
+    for (;;) {
+        const qint64 n = file.read(buffer.data(), qint64(buffer.size()));
+        if (n < 0)
+            return 0;
+        if (n == 0)
+            break;
+        if (first && std::memchr(buffer.data(), 0, size_t(std::min(n, BinaryProbe))))
+            return Binary;
+        first = false;
+
+        for (qint64 k = 0; k < n; ++k) {
+            const uchar c = foldByte(uchar(buffer[size_t(k)]));
+            if (c == '\n') {
+                have = 0;
+                continue;
+            }
+            if (have == 2)
+                grams.add(gramKey(a, b, c));
+            else
+                ++have;
+            a = b;
+            b = c;
+        }
+        if (grams.size() > MaxFileGrams)
+            return 0;
+    }
+    return Indexed;
+}
+
+} // namespace
+
+struct ContentIndex::Header {
+    quint32 magic;
+    quint32 version;
+    quint64 fileSize;
+    qint64  builtAt;
+    quint32 fileCount;
+    quint32 gramCount;
+    quint64 rootOffset;
+    quint64 rootSize;
+    quint64 pathsOffset;
+    quint64 pathsSize;
+    quint64 filesOffset;
+    quint64 gramOffset;
+    quint64 postingsOffset;
+    quint64 postingsSize;
+};
+
+struct ContentIndex::FileRecord {
+    quint64 pathOffset;     // от начала раздела путей
+    quint32 pathSize;
+    quint32 flags;
+    qint64  size;
+    qint64  mtime;
+};
+
+struct ContentIndex::Gram {
+    quint32 key;
+    quint32 count;
+    quint64 offset;         // от начала раздела posting lists
+};
+
+// Запись файла индекса: записи файлов и posting lists слиянием прежнего
+// индекса (номера его файлов переводятся в новые через baseToNew, -1 —
+// файла больше нет или он перечитан) с собранным в этом проходе
+class ContentIndexWriter
+{
+public:
+    static bool write(QIODevice &out, const QString &root, const std::vector<NewFile> &files,
+                      const ContentIndex *base, const std::vector<qint32> &baseToNew,
+                      const Postings &fresh)
+    {
+        using Header = ContentIndex::Header;
+        using FileRecord = ContentIndex::FileRecord;
+        using Gram = ContentIndex::Gram;
+
+        quint64 pos = 0;
+        bool ok = true;
+        const auto writeBytes = [&](const void *data, quint64 size) {
+            if (ok && out.write(static_cast<const char *>(data), qint64(size)) != qint64(size))
+                ok = false;
+            pos += size;
+        };
+        // разделы выровнены по 8: в отображённом файле их читают как массивы
+        const auto pad = [&]() {
+            static const char zeros[8] = {};
+            if (pos % 8)
+                writeBytes(zeros, 8 - pos % 8);
+        };
+
+        Header h = {};
+        h.magic = Magic;
+        h.version = Version;
+        h.builtAt = QDateTime::currentSecsSinceEpoch();
+        h.fileCount = quint32(files.size());
+        writeBytes(&h, sizeof(h));
+
+        const QByteArray rootUtf8 = root.toUtf8();
+        h.rootOffset = pos;
+        h.rootSize = quint64(rootUtf8.size());
+        writeBytes(rootUtf8.constData(), h.rootSize);
+        pad();
+
+        h.pathsOffset = pos;
+        for (const NewFile &file : files)
+            writeBytes(file.path.constData(), quint64(file.path.size()));
+        h.pathsSize = pos - h.pathsOffset;
+        pad();
+
+        h.filesOffset = pos;
+        quint64 pathOffset = 0;
+        for (const NewFile &file : files) {
+            const FileRecord record = { pathOffset, quint32(file.path.size()), file.flags,
+                                        file.size, file.mtime };
+            writeBytes(&record, sizeof(record));
+            pathOffset += quint64(file.path.size());
+        }
+
+        std::vector<quint32> keys;
+        keys.reserve(fresh.size());
+        for (const auto &[key, list] : fresh)
+            keys.push_back(key);
+        std::sort(keys.begin(), keys.end());
+
+        const Gram *baseGrams = base ? base->grams() : nullptr;
+        const quint32 baseCount = base ? base->gramCount() : 0;
+
+        h.postingsOffset = pos;
+        std::vector<Gram> table;
+        std::vector<quint32> decoded, mapped, merged;
+        std::string encoded;
+        size_t bi = 0, fi = 0;
+        while (ok && (bi < baseCount || fi < keys.size())) {
+            const quint32 key = bi < baseCount && (fi >= keys.size() || baseGrams[bi].key <= keys[fi])
+                ? baseGrams[bi].key : keys[fi];
+
+            mapped.clear();
+            if (bi < baseCount && baseGrams[bi].key == key) {
+                base->decodePostings(baseGrams[bi++], decoded);
+                // перевод номеров монотонный — порядок сохраняется
+                for (quint32 id : decoded) {
+                    if (id < baseToNew.size() && baseToNew[id] >= 0)
+                        mapped.push_back(quint32(baseToNew[id]));
+                }
+            }
+            const std::vector<quint32> *added = nullptr;
+            if (fi < keys.size() && keys[fi] == key)
+                added = &fresh.at(keys[fi++]);
+
+            const std::vector<quint32> *list = &mapped;
+            if (added) {
+                merged.clear();
+                std::merge(mapped.begin(), mapped.end(), added->begin(), added->end(),
+                           std::back_inserter(merged));
+                list = &merged;
+            }
+            if (list->empty())
+                continue;
+
+            encoded.clear();
+            quint32 prev = 0;
+            for (quint32 id : *list) {
+                putVarint(encoded, id - prev);
+                prev = id;
+            }
+            table.push_back({ key, quint32(list->size()), pos - h.postingsOffset });
+            writeBytes(encoded.data(), encoded.size());
+        }
+        h.postingsSize = pos - h.postingsOffset;
+        pad();
+
+        h.gramOffset = pos;
+        h.gramCount = quint32(table.size());
+        writeBytes(table.data(), table.size() * sizeof(Gram));
+        h.fileSize = pos;
+
+        if (!ok || !out.seek(0))
+            return false;
+        return out.write(reinterpret_cast<const char *>(&h), sizeof(h)) == qint64(sizeof(h));
+    }
+};
+
+bool ContentIndex::open(const QString &file)
+{
+    BELKIN_TRACE_SCOPE("search.indexOpen");
+
+    m_file.setFileName(file);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const quint64 size = quint64(m_file.size());
+    if (size >= sizeof(Header))
+        m_data = m_file.map(0, qint64(size));
+    if (!m_data) {
+        m_file.close();
+        return false;
+    }
+
+    const Header *h = reinterpret_cast<const Header *>(m_data);
+    const auto within = [size](quint64 offset, quint64 bytes) {
+        return offset <= size && bytes <= size - offset && offset % 8 == 0;
+    };
+
+    const bool valid = h->magic == Magic && h->version == Version && h->fileSize == size
+        && within(h->rootOffset, h->rootSize)
+        && within(h->pathsOffset, h->pathsSize)
+        && within(h->filesOffset, quint64(h->fileCount) * sizeof(FileRecord))
+        && within(h->postingsOffset, h->postingsSize)
+        && within(h->gramOffset, quint64(h->gramCount) * sizeof(Gram));
+    if (!valid) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_file.close();
+        m_data = nullptr;
+        return false;
+    }
+
+    m_header = h;
+    return true;
+}
+
+QString ContentIndex::root() const
+{
+    if (!m_header)
+        return {};
+    return QString::fromUtf8(reinterpret_cast<const char *>(m_data + m_header->rootOffset),
+                             qsizetype(m_header->rootSize));
+}
+
+qint64 ContentIndex::builtAt() const
+{
+    return m_header ? m_header->builtAt : 0;
+}
+
+quint32 ContentIndex::fileCount() const
+{
+    return m_header ? m_header->fileCount : 0;
+}
+
+const ContentIndex::FileRecord *ContentIndex::files() const
+{
+    return reinterpret_cast<const FileRecord *>(m_data + m_header->filesOffset);
+}
+
+const ContentIndex::Gram *ContentIndex::grams() const
+{
+    return reinterpret_cast<const Gram *>(m_data + m_header->gramOffset);
+}
+
+quint32 ContentIndex::gramCount() const
+{
+    return m_header ? m_header->gramCount : 0;
+}
+
+QByteArrayView ContentIndex::pathView(quint32 file) const
+{
+    const FileRecord &record = files()[file];
+    if (record.pathOffset > m_header->pathsSize || record.pathSize > m_header->pathsSize - record.pathOffset)
+        return {};
+    return QByteArrayView(reinterpret_cast<const char *>(m_data + m_header->pathsOffset + record.pathOffset),
+                          qsizetype(record.pathSize));
+}
+
+QByteArray ContentIndex::path(quint32 file) const
+{
+    if (!m_header || file >= m_header->fileCount)
+        return {};
+    return pathView(file).toByteArray();
+}
+
+int ContentIndex::findFile(QByteArrayView path) const
+{
+    if (!m_header)
+        return -1;
+    // пути отсортированы как QByteArray — побайтно
+    quint32 lo = 0, hi = m_header->fileCount;
+    while (lo < hi) {
+        const quint32 mid = lo + (hi - lo) / 2;
+        const int cmp = QByteArrayView::compare(pathView(mid), path);
+        if (cmp == 0)
+            return int(mid);
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return -1;
+}
+
+qint64 ContentIndex::size(quint32 file) const
+{
+    return m_header && file < m_header->fileCount ? files()[file].size : 0;
+}
+
+qint64 ContentIndex::mtime(quint32 file) const
+{
+    return m_header && file < m_header->fileCount ? files()[file].mtime : 0;
+}
+
+const ContentIndex::Gram *ContentIndex::findGram(quint32 key) const
+{
+    const Gram *first = grams();
+    const Gram *last = first + gramCount();
+    const Gram *it = std::lower_bound(first, last, key,
+                                      [](const Gram &g, quint32 k) { return g.key < k; });
+    return it != last && it->key == key ? it : nullptr;
+}
+
+void ContentIndex::decodePostings(const Gram &gram, std::vector<quint32> &out) const
+{
+    out.clear();
+    if (gram.offset > m_header->postingsSize)
+        return;
+    const uchar *p = m_data + m_header->postingsOffset + gram.offset;
+    const uchar *end = m_data + m_header->postingsOffset + m_header->postingsSize;
+    out.reserve(gram.count);
+    quint64 id = 0;
+    for (quint32 k = 0; k < gram.count; ++k) {
+        quint64 delta = 0;
+        if (!getVarint(p, end, delta))
+            break;
+        id += delta;
+        if (id >= m_header->fileCount)
+            break;
+        out.push_back(quint32(id));
+    }
+}
+
+bool ContentIndex::queryGrams(const QString &pattern, bool regex, bool caseSensitive,
+                              std::vector<quint32> &grams)
+{
+    grams.clear();
+    QStringList runs;
+    if (!regex)
+        runs.append(pattern);
+    else if (!requiredLiterals(pattern, runs))
+        return false;
+
+    for (const QString &run : runs)
+        appendGrams(run.toUtf8(), !caseSensitive, grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return !grams.empty();
+}
+
+std::vector<quint32> ContentIndex::candidates(const std::vector<quint32> &keys, bool includeBinary) const
+{
+    std::vector<quint32> result;
+    if (!m_header)
+        return result;
+
+    if (keys.empty()) {
+        result.resize(m_header->fileCount);
+        std::iota(result.begin(), result.end(), 0u);
+        return result;
+    }
+
+    // пересечение: от самого короткого списка, результат только сужается
+    std::vector<const Gram *> lists;
+    for (quint32 key : keys) {
+        const Gram *gram = findGram(key);
+        if (!gram) {
+            lists.clear();
+            break;
+        }
+        lists.push_back(gram);
+    }
+    if (!lists.empty()) {
+        std::sort(lists.begin(), lists.end(),
+                  [](const Gram *a, const Gram *b) { return a->count < b->count; });
+        decodePostings(*lists.front(), result);
+        std::vector<quint32> list, next;
+        for (size_t k = 1; k < lists.size() && !result.empty(); ++k) {
+            decodePostings(*lists[k], list);
+            next.clear();
+            std::set_intersection(result.begin(), result.end(), list.begin(), list.end(),
+                                  std::back_inserter(next));
+            result.swap(next);
+        }
+    }
+
+    // файлы вне индекса проверяются всегда
+    std::vector<quint32> outside;
+    const FileRecord *records = files();
+    for (quint32 i = 0; i < m_header->fileCount; ++i) {
+        const quint32 flags = records[i].flags;
+        if (!(flags & Indexed) && (includeBinary || !(flags & Binary)))
+            outside.push_back(i);
+    }
+    if (!outside.empty()) {
+        std::vector<quint32> merged;
+        merged.reserve(result.size() + outside.size());
+        std::merge(result.begin(), result.end(), outside.begin(), outside.end(),
+                   std::back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
+}
+
+bool ContentIndex::listFiles(const QString &root, const std::atomic<bool> *cancel,
+                             const FileVisitor &visit)
+{
+    BELKIN_TRACE_SCOPE("search.indexList");
+
+#ifdef Q_OS_LINUX
+    struct Dir {
+        QByteArray path;        // полный, в кодировке ФС
+        QByteArray relative;    // от root, с '/' на конце (у root — пусто)
+    };
+
+    QByteArray top = QFile::encodeName(QDir::cleanPath(root));
+    struct stat rootSt;
+    if (::stat(top.constData(), &rootSt) != 0 || !S_ISDIR(rootSt.st_mode))
+        return !isCancelled(cancel);
+    if (!top.endsWith('/'))
+        top.append('/');
+
+    std::vector<Dir> stack{ { top, QByteArray() } };
+    while (!stack.empty()) {
+        if (isCancelled(cancel))
+            return false;
+        const Dir dir = std::move(stack.back());
+        stack.pop_back();
+
+        // корень может быть ссылкой на каталог — его открываем с переходом
+        const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (dir.relative.isEmpty() ? 0 : O_NOFOLLOW);
+        const int fd = ::open(dir.path.constData(), flags);
+        if (fd < 0)
+            continue;
+        DIR *d = ::fdopendir(fd);
+        if (!d) {
+            ::close(fd);
+            continue;
+        }
+        while (const dirent *e = ::readdir(d)) {
+            const char *name = e->d_name;
+            if (name[0] == '.')
+                continue;   // «.», «..» и скрытые
+
+            struct stat st;
+            if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                continue;
+            const QByteArray relative = dir.relative + name;
+            if (S_ISDIR(st.st_mode)) {
+                if (st.st_dev == rootSt.st_dev)
+                    stack.push_back({ dir.path + name + '/', relative + '/' });
+                continue;
+            }
+            // ссылка — цель; ссылки на каталоги не раскрываем
+            if (S_ISLNK(st.st_mode) && ::fstatat(fd, name, &st, 0) != 0)
+                continue;
+            if (!S_ISREG(st.st_mode))
+                continue;
+            visit(relative, qint64(st.st_size),
+                  qint64(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000);
+        }
+        ::closedir(d);
+    }
+    return true;
+#else
+    const QString prefix = QDir::cleanPath(root) + u'/';
+    QDirIterator it(QDir::cleanPath(root), QDir::Files | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (isCancelled(cancel))
+            return false;
+        const QFileInfo fi = it.nextFileInfo();
+        visit(QFile::encodeName(fi.filePath().mid(prefix.size())), fi.size(),
+              fi.lastModified().toMSecsSinceEpoch());
+    }
+    return true;
+#endif
+}
+
+bool ContentIndex::build(const QString &root, const QString &file,
+                         const std::atomic<bool> *cancel, Stats *stats)
+{
+    BELKIN_TRACE_SCOPE("search.indexBuild");
+
+    const QString cleanRoot = QDir::cleanPath(root);
+    const QString prefix = cleanRoot.endsWith(u'/') ? cleanRoot : cleanRoot + u'/';
+    const qint64 racyAfter = QDateTime::currentMSecsSinceEpoch() - RacyMs;
+
+    std::vector<NewFile> files;
+    const bool listed = listFiles(cleanRoot, cancel, [&](const QByteArray &relative, qint64 size,
+                                                         qint64 mtime) {
+        NewFile f;
+        f.path = relative;
+        f.size = size;
+        f.mtime = mtime > racyAfter ? -1 : mtime;
+        files.push_back(std::move(f));
+    });
+    if (!listed)
+        return false;
+    std::sort(files.begin(), files.end(),
+              [](const NewFile &a, const NewFile &b) { return a.path < b.path; });
+
+    // прежний индекс: файлы с теми же размером и mtime берутся из него
+    ContentIndex old;
+    const bool haveOld = old.open(file) && old.root() == cleanRoot;
+    std::vector<qint32> baseToNew(haveOld ? old.fileCount() : 0, -1);
+    Stats counts;
+    counts.files = int(files.size());
+    if (haveOld) {
+        const FileRecord *records = old.files();
+        size_t j = 0;
+        for (quint32 i = 0; i < old.fileCount() && j < files.size(); ++i) {
+            const QByteArray oldPath = old.path(i);
+            while (j < files.size() && files[j].path < oldPath)
+                ++j;
+            if (j == files.size() || files[j].path != oldPath)
+                continue;
+            NewFile &f = files[j];
+            if (f.mtime >= 0 && f.mtime == records[i].mtime && f.size == records[i].size) {
+                f.flags = records[i].flags;
+                f.reused = true;
+                baseToNew[i] = qint32(j);
+                ++counts.reused;
+            }
+        }
+    }
+
+    // изменившиеся файлы — читаем; собранное держим в памяти до предела,
+    // дальше сбрасываем в промежуточный индекс и продолжаем с ним как с базой
+    const QString parts[2] = { file + QStringLiteral(".part0"), file + QStringLiteral(".part1") };
+    const auto removeParts = [&parts]() {
+        QFile::remove(parts[0]);
+        QFile::remove(parts[1]);
+    };
+    const ContentIndex *base = haveOld ? &old : nullptr;
+    std::unique_ptr<ContentIndex> spilled;
+    int nextPart = 0;
+
+    QDir().mkpath(QFileInfo(file).absolutePath());
+
+    Postings fresh;
+    size_t pending = 0;
+    GramSet grams;
+    std::vector<char> buffer(size_t(ReadBlock));
+    for (size_t j = 0; j < files.size(); ++j) {
+        NewFile &f = files[j];
+        if (f.reused)
+            continue;
+        if (isCancelled(cancel)) {
+            spilled.reset();
+            removeParts();
+            return false;
+        }
+
+        f.flags = readFile(prefix + QFile::decodeName(f.path), grams, buffer);
+        ++counts.read;
+        if (f.flags & Indexed) {
+            for (quint32 key : grams.keys())
+                fresh[key].push_back(quint32(j));
+            pending += grams.size();
+        }
+        grams.clear();
+
+        if (pending < MaxPendingPostings)
+            continue;
+
+        const QString &part = parts[nextPart];
+        nextPart ^= 1;
+        QFile out(part);
+        auto next = std::make_unique<ContentIndex>();
+        const bool written = out.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            && ContentIndexWriter::write(out, cleanRoot, files, base, baseToNew, fresh);
+        out.close();
+        if (!written || !next->open(part)) {
+            spilled.reset();
+            removeParts();
+            return false;
+        }
+        // номера в промежуточном индексе уже новые
+        baseToNew.resize(files.size());
+        std::iota(baseToNew.begin(), baseToNew.end(), 0);
+        spilled = std::move(next);
+        base = spilled.get();
+        fresh.clear();
+        pending = 0;
+    }
+
+    QSaveFile out(file);
+    const bool ok = out.open(QIODevice::WriteOnly)
+        && ContentIndexWriter::write(out, cleanRoot, files, base, baseToNew, fresh)
+        && !isCancelled(cancel) && out.commit();
+    spilled.reset();
+    removeParts();
+
+    if (stats)
+        *stats = counts;
+    return ok;
+}
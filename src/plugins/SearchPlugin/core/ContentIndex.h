@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Индекс содержимого каталога на диске, как у codesearch/zoekt:
+// для каждой триграммы текста — список файлов, где она встречается
+// (номера файлов, дельты в varint). Поиск строки сначала пересекает списки
+// триграмм шаблона, и читаются только файлы-кандидаты; совпадение всё равно
+// проверяется по самому файлу (ContentMatcher), индекс лишь отсекает лишнее.
+// Триграммы — байты с ASCII без учёта регистра и без '\n': один индекс
+// годится для поиска и с учётом регистра, и без.
+// Файлы, которые в индекс не попали (большие, нечитаемые, с слишком
+// разнообразным содержимым), — кандидаты всегда; двоичные (NUL в начале) —
+// когда двоичные не пропускаются.
+// Файл индекса отображается в память и не меняется; обновление (build) пишет
+// новый, перечитывая только файлы с другими размером или mtime.
+class ContentIndex
+{
+public:
+    struct Stats {
+        int files = 0;
+        int reused = 0;     // взяты из прежнего индекса
+        int read = 0;       // прочитаны заново
+    };
+
+    ContentIndex() = default;
+    ContentIndex(const ContentIndex &) = delete;
+    ContentIndex &operator=(const ContentIndex &) = delete;
+
+    bool open(const QString &file);
+    bool isOpen() const { return m_header != nullptr; }
+
+    QString root() const;
+    qint64 builtAt() const;             // секунды от эпохи
+    quint32 fileCount() const;
+
+    // путь от корня в кодировке ФС; файлы отсортированы по нему
+    QByteArray path(quint32 file) const;
+    qint64 size(quint32 file) const;
+    qint64 mtime(quint32 file) const;   // мс; -1 — при сборке файл только что менялся
+    // номер файла path или -1
+    int findFile(QByteArrayView path) const;
+
+    // Триграммы, без которых шаблон не найти (отсортированы). false — индекс
+    // запрос не сужает: короткий литерал, чередование в регулярном выражении...
+    static bool queryGrams(const QString &pattern, bool regex, bool caseSensitive,
+                           std::vector<quint32> &grams);
+
+    // файлы, где есть все grams, и файлы вне индекса, по возрастанию номера
+    std::vector<quint32> candidates(const std::vector<quint32> &grams, bool includeBinary) const;
+
+    // Файлы под root по тем же правилам, что и обход FileSearch без скрытых:
+    // ссылки на файлы — как файлы (размер и mtime цели), ссылки на каталоги
+    // и другие ФС не обходятся. relative — от root, в кодировке ФС.
+    // Одни и те же правила для сборки и для проверки свежести индекса —
+    // поиск по индексу видит те же файлы, что и обход. false — отменено
+    using FileVisitor = std::function<void(const QByteArray &relative, qint64 size, qint64 mtimeMs)>;
+    static bool listFiles(const QString &root, const std::atomic<bool> *cancel,
+                          const FileVisitor &visit);
+
+    // (Пере)строить индекс root в file (файлы — listFiles). Прежний file,
+    // если есть, — база: файлы с теми же размером и mtime не читаются.
+    // false — отменено или не записалось (прежний file цел)
+    static bool build(const QString &root, const QString &file,
+                      const std::atomic<bool> *cancel, Stats *stats = nullptr);
+
+private:
+    struct Header;
+    struct FileRecord;
+    struct Gram;
+    friend class ContentIndexWriter;
+
+    const FileRecord *files() const;
+    QByteArrayView pathView(quint32 file) const;
+    const Gram *grams() const;
+    quint32 gramCount() const;
+    const Gram *findGram(quint32 key) const;
+    void decodePostings(const Gram &gram, std::vector<quint32> &out) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    const Header *m_header = nullptr;
+};
@@ -0,0 +1,253 @@
+#include "ContentIndexService.h"
+#include "ContentIndex.h"
+#include "Trace.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// первое обновление — когда окно уже открыто и панели прочитаны
+constexpr int FirstUpdateDelayMs = 90 * 1000;
+
+// Чтение индексатора — только когда диск больше никому не нужен
+void setIdleIoPriority()
+{
+#ifdef Q_OS_LINUX
+    // ioprio_set(IOPRIO_WHO_PROCESS, 0 — текущий поток, IOPRIO_CLASS_IDLE)
+    constexpr int WhoProcess = 1;
+    constexpr int ClassIdle = 3;
+    constexpr int ClassShift = 13;
+    ::syscall(SYS_ioprio_set, WhoProcess, 0, ClassIdle << ClassShift);
+#endif
+}
+
+// path внутри dir (или сам dir): путь от dir без ведущего '/'
+bool relativeTo(const QString &dir, const QString &path, QString &relative)
+{
+    if (path == dir) {
+        relative.clear();
+        return true;
+    }
+    const QString prefix = dir.endsWith(u'/') ? dir : dir + u'/';
+    if (!path.startsWith(prefix))
+        return false;
+    relative = path.mid(prefix.size());
+    return true;
+}
+
+} // namespace
+
+ContentIndexService::ContentIndexService(QObject *parent)
+    : QObject(parent)
+{
+    for (const QString &dir : directories())
+        load(dir);
+
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    const int minutes = qMax(1, settings.value("Search/ContentIndexRescanMinutes", 30).toInt());
+    m_rescanTimer.setInterval(minutes * 60 * 1000);
+    connect(&m_rescanTimer, &QTimer::timeout, this, [this]() { update(); });
+    m_rescanTimer.start();
+    QTimer::singleShot(FirstUpdateDelayMs, this, [this]() { update(); });
+}
+
+ContentIndexService::~ContentIndexService()
+{
+    m_queue.clear();
+    if (m_thread) {
+        m_cancel->store(true);
+        m_thread->wait();
+    }
+}
+
+QString ContentIndexService::indexFile(const QString &dir)
+{
+    const QByteArray key = QCryptographicHash::hash(dir.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+         + QStringLiteral("/content-index/") + QString::fromLatin1(key.left(16)) + QStringLiteral(".cix");
+}
+
+QStringList ContentIndexService::directories() const
+{
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    return settings.value("Search/ContentIndexDirs").toStringList();
+}
+
+bool ContentIndexService::isIndexed(const QString &dir) const
+{
+    return directories().contains(QDir::cleanPath(dir));
+}
+
+void ContentIndexService::setIndexed(const QString &dir, bool on)
+{
+    const QString clean = QDir::cleanPath(dir);
+    QStringList list = directories();
+    if (on == list.contains(clean))
+        return;
+
+    QSettings settings("BelkinSoft", "BelkinCommander");
+    if (on) {
+        list.append(clean);
+        settings.setValue("Search/ContentIndexDirs", list);
+        load(clean);
+        update(clean);
+        return;
+    }
+
+    list.removeAll(clean);
+    settings.setValue("Search/ContentIndexDirs", list);
+    m_queue.removeAll(clean);
+    {
+        QMutexLocker lock(&m_mutex);
+        m_indexes.remove(clean);
+    }
+    // отображённый файл остаётся у поиска, который его ещё держит
+    QFile::remove(indexFile(clean));
+    emit indexUpdated(clean);
+}
+
+void ContentIndexService::load(const QString &dir)
+{
+    auto index = std::make_shared<ContentIndex>();
+    if (!index->open(indexFile(dir)) || index->root() != dir)
+        return;
+    QMutexLocker lock(&m_mutex);
+    m_indexes.insert(dir, index);
+}
+
+std::shared_ptr<ContentIndex> ContentIndexService::indexFor(const QString &path, QString *dir,
+                                                            QByteArray *relative) const
+{
+    const QString clean = QDir::cleanPath(path);
+    QString rel;
+    QMutexLocker lock(&m_mutex);
+    for (auto it = m_indexes.cbegin(); it != m_indexes.cend(); ++it) {
+        if (!relativeTo(it.key(), clean, rel))
+            continue;
+        if (dir)
+            *dir = it.key();
+        if (relative)
+            *relative = QFile::encodeName(rel);
+        return it.value();
+    }
+    return nullptr;
+}
+
+bool ContentIndexService::covers(const QString &path) const
+{
+    return indexFor(path, nullptr, nullptr) != nullptr;
+}
+
+bool ContentIndexService::candidates(const SearchQuery &query, QStringList &files,
+                                     const std::atomic<bool> *cancel) const
+{
+    BELKIN_TRACE_SCOPE("search.indexCandidates");
+
+    std::vector<quint32> grams;
+    if (query.content.isEmpty()
+        || !ContentIndex::queryGrams(query.content, query.contentRegex, query.caseSensitive, grams))
+        return false;
+
+    struct Root {
+        std::shared_ptr<ContentIndex> index;
+        QString path;
+        QByteArray prefix;      // от корня индекса, с '/' на конце; пусто — весь индекс
+    };
+    std::vector<Root> roots;
+    for (const QString &path : query.roots) {
+        Root root;
+        root.path = QDir::cleanPath(path);
+        root.index = indexFor(root.path, nullptr, &root.prefix);
+        if (!root.index)
+            return false;
+        if (!root.prefix.isEmpty())
+            root.prefix.append('/');
+        roots.push_back(std::move(root));
+    }
+
+    files.clear();
+    for (const Root &root : roots) {
+        const ContentIndex &index = *root.index;
+        std::vector<bool> matched(index.fileCount(), false);
+        for (quint32 file : index.candidates(grams, !query.skipBinary))
+            matched[file] = true;
+
+        // индекс отвечает только за файлы, которые с тех пор не менялись
+        const QString base = root.path.endsWith(u'/') ? root.path : root.path + u'/';
+        const bool listed = ContentIndex::listFiles(root.path, cancel,
+            [&](const QByteArray &relative, qint64 size, qint64 mtime) {
+                const int file = index.findFile(root.prefix + relative);
+                const bool stale = file < 0 || index.size(quint32(file)) != size
+                                || index.mtime(quint32(file)) != mtime;
+                if (stale || matched[size_t(file)])
+                    files.append(base + QFile::decodeName(relative));
+            });
+        if (!listed)
+            return true;    // отменено — поиск всё равно остановится
+    }
+    if (roots.size() > 1)
+        files.removeDuplicates();
+    return true;
+}
+
+void ContentIndexService::update(const QString &dir)
+{
+    const QStringList targets = dir.isEmpty() ? directories() : QStringList{ QDir::cleanPath(dir) };
+    for (const QString &target : targets) {
+        if (!m_queue.contains(target))
+            m_queue.append(target);
+    }
+    startNext();
+}
+
+void ContentIndexService::startNext()
+{
+    if (m_thread)
+        return;
+
+    while (!m_queue.isEmpty()) {
+        const QString dir = m_queue.takeFirst();
+        if (!isIndexed(dir) || !QFileInfo(dir).isDir())
+            continue;
+
+        m_cancel = std::make_shared<std::atomic<bool>>(false);
+        const std::shared_ptr<std::atomic<bool>> cancel = m_cancel;
+        const QString file = indexFile(dir);
+
+        m_thread = QThread::create([this, dir, file, cancel]() {
+            setIdleIoPriority();
+            const bool ok = ContentIndex::build(dir, file, cancel.get());
+            QMetaObject::invokeMethod(this, [this, dir, ok]() {
+                onBuilt(dir, ok);
+            }, Qt::QueuedConnection);
+        });
+        m_thread->setObjectName("content index");
+        connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+        m_thread->start(QThread::IdlePriority);
+        return;
+    }
+}
+
+void ContentIndexService::onBuilt(const QString &dir, bool ok)
+{
+    m_thread = nullptr;
+    // каталог могли исключить, пока индекс строился
+    if (!isIndexed(dir)) {
+        QFile::remove(indexFile(dir));
+    } else if (ok) {
+        load(dir);
+        emit indexUpdated(dir);
+    }
+    startNext();
+}
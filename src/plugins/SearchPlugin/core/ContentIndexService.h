@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include "FileSearch.h"
+
+class ContentIndex;
+class QThread;
+
+// Индексы содержимого для выбранных каталогов (Search/ContentIndexDirs):
+// поиск текста в них читает только файлы-кандидаты из индекса.
+// Индексы строятся по одному в фоне — поток с низким приоритетом и
+// приоритетом ввода-вывода idle, чтобы не мешать панелям, — и обновляются по
+// таймеру (Search/ContentIndexRescanMinutes): перечитываются только файлы с
+// другими размером или mtime.
+// Файлы, созданные или изменённые после обновления, поиск проверяет всегда
+// (см. candidates): устаревший индекс медленнее, но не теряет совпадений.
+class ContentIndexService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContentIndexService(QObject *parent = nullptr);
+    ~ContentIndexService() override;
+
+    QStringList directories() const;
+    bool isIndexed(const QString &dir) const;
+    void setIndexed(const QString &dir, bool on);
+
+    // path лежит в каталоге с уже построенным индексом
+    bool covers(const QString &path) const;
+    bool isUpdating() const { return m_thread != nullptr; }
+
+    // Файлы под query.roots, в которых может быть query.content: кандидаты
+    // индекса плюс все файлы, которых в индексе нет или у которых размер или
+    // mtime уже не те, — для этого корни обходятся без чтения файлов
+    // (ContentIndex::listFiles), так что устаревший индекс ничего не теряет.
+    // false — индекс запрос не сужает (или корень не покрыт), нужен обход.
+    // Из любого потока
+    bool candidates(const SearchQuery &query, QStringList &files,
+                    const std::atomic<bool> *cancel = nullptr) const;
+
+    // обновить индекс dir (пусто — все) сейчас
+    void update(const QString &dir = QString());
+
+signals:
+    void indexUpdated(const QString &dir);
+
+private:
+    static QString indexFile(const QString &dir);
+    void load(const QString &dir);
+    void startNext();
+    void onBuilt(const QString &dir, bool ok);
+    // индекс каталога, в котором лежит path, и путь path от его корня
+    std::shared_ptr<ContentIndex> indexFor(const QString &path, QString *dir, QByteArray *relative) const;
+
+    mutable QMutex m_mutex;
+    QHash<QString, std::shared_ptr<ContentIndex>> m_indexes;   // под m_mutex
+
+    QStringList m_queue;
+    QThread *m_thread = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+    QTimer m_rescanTimer;
+};
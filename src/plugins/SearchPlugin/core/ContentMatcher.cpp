@@ -0,0 +1,237 @@
+#include "ContentMatcher.h"
+
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BELKIN_SEARCH_SSE2 1
+#endif
+
+namespace {
+
+constexpr qsizetype BlockSize = 256 * 1024;
+// строка длиннее (минифицированный JS, дампы) проверяется по частям
+constexpr qsizetype MaxLineBytes = 4 * 1024 * 1024;
+// NUL в первых байтах — двоичный файл, как у grep
+constexpr qsizetype BinaryProbe = 8 * 1024;
+constexpr int MaxTextLength = 200;
+
+inline char foldAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c + ('a' - 'A')) : c;
+}
+
+bool isAscii(const QByteArray &s)
+{
+    for (char c : s) {
+        if (uchar(c) >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+// needle уже в нижнем регистре
+inline bool equalsFolded(const char *s, const char *needle, qsizetype m)
+{
+    for (qsizetype k = 0; k < m; ++k) {
+        if (foldAscii(s[k]) != needle[k])
+            return false;
+    }
+    return true;
+}
+
+qsizetype findFolded(const char *hay, qsizetype n, const QByteArray &needle)
+{
+    const qsizetype m = needle.size();
+    if (m > n)
+        return -1;
+    const qsizetype last = n - m;   // последняя возможная позиция начала
+    const char lower = needle[0];
+    const char upper = (lower >= 'a' && lower <= 'z') ? char(lower - ('a' - 'A')) : lower;
+    qsizetype i = 0;
+
+#ifdef BELKIN_SEARCH_SSE2
+    // кандидаты — первый символ шаблона в обоих регистрах, по 16 байт за раз
+    const __m128i vLower = _mm_set1_epi8(lower);
+    const __m128i vUpper = _mm_set1_epi8(upper);
+    for (; i <= last && i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay + i));
+        unsigned mask = unsigned(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, vLower), _mm_cmpeq_epi8(v, vUpper))));
+        while (mask) {
+            const qsizetype pos = i + qsizetype(__builtin_ctz(mask));
+            if (pos > last)
+                return -1;
+            if (equalsFolded(hay + pos + 1, needle.constData() + 1, m - 1))
+                return pos;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i <= last; ++i) {
+        if (foldAscii(hay[i]) == lower && equalsFolded(hay + i + 1, needle.constData() + 1, m - 1))
+            return i;
+    }
+    return -1;
+}
+
+} // namespace
+
+ContentMatcher::ContentMatcher(const QString &pattern, bool regex, bool caseSensitive)
+{
+    if (pattern.isEmpty())
+        return;
+
+    const QByteArray utf8 = pattern.toUtf8();
+    if (!regex && caseSensitive) {
+        m_mode = Mode::Literal;
+        m_needle = utf8;
+        return;
+    }
+    if (!regex && isAscii(utf8)) {
+        m_mode = Mode::FoldedLiteral;
+        m_needle = utf8.toLower();
+        return;
+    }
+
+    // регистр не-ASCII символов сворачивает только QString
+    m_mode = Mode::Regex;
+    QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+    if (!caseSensitive)
+        options |= QRegularExpression::CaseInsensitiveOption;
+    m_regex = QRegularExpression(regex ? pattern : QRegularExpression::escape(pattern), options);
+    m_regex.optimize();
+}
+
+qsizetype ContentMatcher::findLiteral(const char *data, qsizetype n) const
+{
+    if (m_mode == Mode::FoldedLiteral)
+        return findFolded(data, n, m_needle);
+
+    const qsizetype m = m_needle.size();
+    const char first = m_needle[0];
+    const char *p = data;
+    const char *end = data + n;
+    // memchr в glibc векторизован: кандидатов ищем им, остаток — memcmp
+    while (end - p >= m) {
+        p = static_cast<const char *>(std::memchr(p, first, size_t(end - p - m + 1)));
+        if (!p)
+            return -1;
+        if (std::memcmp(p + 1, m_needle.constData() + 1, size_t(m - 1)) == 0)
+            return p - data;
+        ++p;
+    }
+    return -1;
+}
+
+qsizetype ContentMatcher::findRegex(const char *data, qsizetype n) const
+{
+    qsizetype start = 0;
+    while (start < n) {
+        const char *nl = static_cast<const char *>(std::memchr(data + start, '\n', size_t(n - start)));
+        const qsizetype stop = nl ? nl - data : n;
+        qsizetype length = stop - start;
+        if (length > 0 && data[start + length - 1] == '\r')
+            --length;
+        if (m_regex.match(QString::fromUtf8(data + start, length)).hasMatch())
+            return start;
+        start = stop + 1;
+    }
+    return -1;
+}
+
+bool ContentMatcher::matchFile(const QString &path, bool skipBinary, int *line, QString *text,
+                               const std::atomic<bool> *cancel)
+{
+    if (m_mode == Mode::None)
+        return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        return false;
+
+    if (m_buffer.size() < size_t(BlockSize))
+        m_buffer.resize(size_t(BlockSize));
+
+    qsizetype filled = 0;
+    int lineNo = 1;
+    bool probed = false;
+
+    for (;;) {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return false;
+
+        // в буфере одна незаконченная строка — расширяем, пока можно
+        if (filled == qsizetype(m_buffer.size()) && filled < MaxLineBytes)
+            m_buffer.resize(m_buffer.size() * 2);
+
+        char *data = m_buffer.data();
+        const qsizetype capacity = qsizetype(m_buffer.size());
+
+        bool eof = false;
+        if (filled < capacity) {
+            const qint64 got = file.read(data + filled, capacity - filled);
+            if (got < 0)
+                return false;
+            eof = got == 0;
+            if (!probed) {
+                probed = true;
+                if (skipBinary && std::memchr(data, 0, size_t(std::min<qint64>(got, BinaryProbe))))
+                    return false;
+            }
+            filled += qsizetype(got);
+        }
+
+        // проверяем до конца последней целой строки; в конце файла и для
+        // строки длиннее MaxLineBytes — всё, что есть
+        qsizetype end = filled;
+        bool split = false;
+        if (!eof) {
+            const size_t nl = std::string_view(data, size_t(filled)).rfind('\n');
+            if (nl != std::string_view::npos) {
+                end = qsizetype(nl) + 1;
+            } else if (filled < capacity || capacity < MaxLineBytes) {
+                continue;   // дочитываем строку
+            } else {
+                split = true;
+            }
+        }
+
+        if (end > 0) {
+            const qsizetype pos = m_mode == Mode::Regex ? findRegex(data, end)
+                                                        : findLiteral(data, end);
+            if (pos >= 0) {
+                const std::string_view view(data, size_t(end));
+                const size_t before = pos > 0 ? view.rfind('\n', size_t(pos - 1)) : std::string_view::npos;
+                const qsizetype lineStart = before == std::string_view::npos ? 0 : qsizetype(before) + 1;
+                const size_t after = view.find('\n', size_t(pos));
+                const qsizetype lineEnd = after == std::string_view::npos ? end : qsizetype(after);
+
+                if (line)
+                    *line = lineNo + int(std::count(data, data + pos, '\n'));
+                if (text) {
+                    // длинную строку обрезаем до декодирования
+                    const qsizetype length = std::min<qsizetype>(lineEnd - lineStart, MaxTextLength * 4);
+                    *text = QString::fromUtf8(data + lineStart, length).trimmed().left(MaxTextLength);
+                }
+                return true;
+            }
+            lineNo += int(std::count(data, data + end, '\n'));
+        }
+
+        if (eof)
+            return false;
+
+        // строку, разрезанную по MaxLineBytes, проверяем с перекрытием:
+        // вхождение литерала на границе не теряется
+        qsizetype keep = filled - end;
+        if (split && m_mode != Mode::Regex)
+            keep = std::min<qsizetype>(m_needle.size() - 1, filled);
+        std::memmove(data, data + filled - keep, size_t(keep));
+        filled = keep;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QByteArray>
+#include <QRegularExpression>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+// Поиск строки в содержимом файла.
+// Литерал ищется прямо в байтах файла: кандидаты — по первому байту шаблона
+// (memchr, без учёта регистра — SSE2 по двум регистрам сразу), дальше
+// сравнение остатка. Регулярное выражение (и литерал с не-ASCII символами
+// без учёта регистра) проверяется построчно через QString.
+// Файл читается блоками, строки не склеиваются в памяти целиком; файл с NUL
+// в первом блоке считается двоичным и пропускается.
+// Объект держит буфер чтения: один на поток поиска.
+class ContentMatcher
+{
+public:
+    ContentMatcher() = default;
+    ContentMatcher(const QString &pattern, bool regex, bool caseSensitive);
+
+    bool isEmpty() const { return m_mode == Mode::None; }
+    bool isValid() const { return m_mode != Mode::Regex || m_regex.isValid(); }
+    QString errorString() const { return m_regex.errorString(); }
+
+    // первое совпадение в файле: номер строки (с 1) и сама строка.
+    // false — совпадений нет, файл не читается или двоичный (skipBinary).
+    // cancel проверяется между блоками: большой файл не держит отмену
+    bool matchFile(const QString &path, bool skipBinary, int *line, QString *text,
+                   const std::atomic<bool> *cancel = nullptr);
+
+private:
+    enum class Mode {
+        None,
+        Literal,        // байты как есть
+        FoldedLiteral,  // ASCII без учёта регистра, m_needle в нижнем регистре
+        Regex
+    };
+
+    // позиция первого вхождения литерала в [data, data + n) или -1
+    qsizetype findLiteral(const char *data, qsizetype n) const;
+    // первая подходящая строка в [data, data + n): смещение её начала или -1
+    qsizetype findRegex(const char *data, qsizetype n) const;
+
+    Mode m_mode = Mode::None;
+    QByteArray m_needle;
+    QRegularExpression m_regex;
+    std::vector<char> m_buffer;
+};
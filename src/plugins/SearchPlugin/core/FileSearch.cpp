@@ -0,0 +1,521 @@
+#include "FileSearch.h"
+#include "ContentMatcher.h"
+#include "NameFilter.h"
+#include "Trace.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+#include <QThread>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#endif
+
+namespace {
+
+// найденное, которое поток копил дольше, отдаём сразу — список растёт потоком
+constexpr auto MaxBatchDelay = std::chrono::milliseconds(50);
+constexpr size_t MaxBatchHits = 256;
+
+bool isCancelled(const std::atomic<bool> *cancel)
+{
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+// Имя: glob-шаблоны NameFilter (как быстрый фильтр панели — без * и ?
+// подстрока, регистр не учитывается) через ';' или регулярное выражение
+class NameMatcher
+{
+public:
+    explicit NameMatcher(const SearchQuery &query)
+    {
+        if (query.nameRegex) {
+            if (query.namePattern.isEmpty())
+                return;
+            QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+            if (!query.caseSensitive)
+                options |= QRegularExpression::CaseInsensitiveOption;
+            m_regex = QRegularExpression(query.namePattern, options);
+            m_regex.optimize();
+            m_useRegex = true;
+            return;
+        }
+        for (const QString &part : query.namePattern.split(QLatin1Char(';'), Qt::SkipEmptyParts)) {
+            const QString glob = part.trimmed();
+            if (!glob.isEmpty())
+                m_globs.append(NameFilter(glob));
+        }
+    }
+
+    bool isValid() const { return !m_useRegex || m_regex.isValid(); }
+    QString errorString() const { return m_regex.errorString(); }
+
+    bool matches(QByteArrayView name) const
+    {
+        if (m_useRegex)
+            return m_regex.match(QString::fromUtf8(name)).hasMatch();
+        if (m_globs.isEmpty())
+            return true;
+        for (const NameFilter &glob : m_globs) {
+            if (glob.matches(name))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    QList<NameFilter> m_globs;
+    QRegularExpression m_regex;
+    bool m_useRegex = false;
+};
+
+// Своё у каждого потока: буфер чтения файлов и ещё не отданные совпадения
+struct Worker {
+    ContentMatcher content;
+    std::vector<SearchHit> hits;
+    std::chrono::steady_clock::time_point lastFlush = std::chrono::steady_clock::now();
+};
+
+#ifdef Q_OS_LINUX
+
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+struct Item {
+    std::string path;
+    dev_t       dev = 0;    // ФС корня: точки монтирования внутри не пересекаем
+    bool        root = false;   // корень может быть ссылкой на каталог
+};
+
+// Очередь каталогов одного потока
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Item> dirs;
+};
+
+struct Walk {
+    const SearchQuery *query = nullptr;
+    const NameMatcher *names = nullptr;
+    const std::atomic<bool> *cancel = nullptr;
+    const FileSearch::Callback *onHits = nullptr;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<qint64> pending{0};     // каталоги в очередях + в обработке
+    std::atomic<qint64> queued{0};      // только в очередях
+    std::mutex emitMutex;
+
+    // потоку без работы незачем крутиться: ждёт нового каталога или конца.
+    // queued/sleeping/pending — seq_cst: push и засыпающий поток не могут
+    // одновременно не увидеть друг друга
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    std::atomic<int> sleeping{0};
+
+    void wakeIdle(bool all)
+    {
+        if (sleeping.load() == 0)
+            return;
+        // под мьютексом — чтобы не проскочить между проверкой и wait
+        { std::lock_guard<std::mutex> lock(idleMutex); }
+        if (all)
+            idle.notify_all();
+        else
+            idle.notify_one();
+    }
+
+    void push(size_t worker, Item item)
+    {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            WorkQueue &q = *queues[worker];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.dirs.push_back(std::move(item));
+        }
+        queued.fetch_add(1);
+        wakeIdle(false);
+    }
+
+    void waitForWork()
+    {
+        std::unique_lock<std::mutex> lock(idleMutex);
+        sleeping.fetch_add(1);
+        // таймаут — чтобы заметить отмену
+        idle.wait_for(lock, MaxBatchDelay, [this]() {
+            return queued.load() > 0 || pending.load() == 0 || isCancelled(cancel);
+        });
+        sleeping.fetch_sub(1);
+    }
+
+    // свой каталог — с конца (обход в глубину, горячий кэш dentry)
+    bool popOwn(size_t worker, Item &item)
+    {
+        WorkQueue &q = *queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.dirs.empty())
+            return false;
+        item = std::move(q.dirs.back());
+        q.dirs.pop_back();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // чужой — с начала: там каталоги ближе к корню, т.е. крупнее
+    bool steal(size_t worker, Item &item)
+    {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            WorkQueue &q = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.dirs.empty())
+                continue;
+            item = std::move(q.dirs.front());
+            q.dirs.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void flush(Worker &w)
+    {
+        w.lastFlush = std::chrono::steady_clock::now();
+        if (w.hits.empty())
+            return;
+        std::lock_guard<std::mutex> lock(emitMutex);
+        (*onHits)(w.hits);
+        w.hits.clear();
+    }
+
+    void maybeFlush(Worker &w)
+    {
+        if (w.hits.size() >= MaxBatchHits
+            || std::chrono::steady_clock::now() - w.lastFlush >= MaxBatchDelay)
+            flush(w);
+    }
+
+    static std::string join(const std::string &dir, const char *name)
+    {
+        // у корня «/» свой разделитель уже есть
+        return dir.back() == '/' ? dir + name : dir + '/' + name;
+    }
+
+    void addHit(Worker &w, const std::string &path, const struct stat &st, bool dir,
+                int line = 0, const QString &text = QString())
+    {
+        SearchHit hit;
+        hit.path = QFile::decodeName(QByteArray(path.data(), qsizetype(path.size())));
+        hit.size = dir ? 0 : qint64(st.st_size);
+        hit.mtime = qint64(st.st_mtim.tv_sec);
+        hit.dir = dir;
+        hit.line = line;
+        hit.text = text;
+        w.hits.push_back(std::move(hit));
+    }
+
+    void processDir(size_t worker, const Item &item, std::vector<char> &buffer, Worker &w)
+    {
+        const int fd = ::open(item.path.c_str(),
+                              O_RDONLY | O_DIRECTORY | O_CLOEXEC | (item.root ? 0 : O_NOFOLLOW));
+        if (fd < 0)
+            return;   // нет прав — ищем в том, что доступно
+
+        const bool grep = !w.content.isEmpty();
+        std::vector<std::string> children;
+
+        for (;;) {
+            const long n = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if (n <= 0)
+                break;
+
+            for (long pos = 0; pos < n && !isCancelled(cancel);) {
+                auto *e = reinterpret_cast<LinuxDirent64 *>(buffer.data() + pos);
+                pos += e->d_reclen;
+
+                const char *name = e->d_name;
+                if (name[0] == '.'
+                    && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0') || !query->hidden))
+                    continue;
+
+                const QByteArrayView nameView(name, qsizetype(std::strlen(name)));
+                const bool nameMatches = names->matches(nameView);
+                const bool isDir = e->d_type == DT_DIR;
+
+                // stat нужен каталогам (точка монтирования?), совпавшим по
+                // имени и всем записям неизвестного типа
+                if (!isDir && !nameMatches && e->d_type != DT_UNKNOWN)
+                    continue;
+
+                struct stat st;
+                if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                    continue;
+
+                if (S_ISDIR(st.st_mode)) {
+                    if (st.st_dev == item.dev)
+                        children.emplace_back(name);
+                    if (nameMatches && !grep)
+                        addHit(w, join(item.path, name), st, true);
+                    continue;
+                }
+                if (!nameMatches)
+                    continue;
+
+                // для ссылок — цель; ссылки на каталоги не раскрываем
+                if (S_ISLNK(st.st_mode)) {
+                    struct stat target;
+                    if (::fstatat(fd, name, &target, 0) == 0) {
+                        if (S_ISDIR(target.st_mode))
+                            continue;
+                        st = target;
+                    }
+                }
+
+                const std::string path = join(item.path, name);
+                if (!grep) {
+                    addHit(w, path, st, false);
+                } else if (S_ISREG(st.st_mode) && st.st_size > 0) {
+                    int line = 0;
+                    QString text;
+                    if (w.content.matchFile(QFile::decodeName(path.c_str()), query->skipBinary,
+                                            &line, &text, cancel))
+                        addHit(w, path, st, false, line, text);
+                }
+                maybeFlush(w);
+            }
+            if (isCancelled(cancel))
+                break;
+        }
+
+        ::close(fd);
+
+        if (isCancelled(cancel))
+            return;
+        for (const std::string &child : children)
+            push(worker, { join(item.path, child.c_str()), item.dev });
+    }
+
+    void run(size_t worker, const ContentMatcher &content)
+    {
+        std::vector<char> buffer(64 * 1024);
+        Worker w;
+        w.content = content;
+        Item item;
+
+        while (!isCancelled(cancel)) {
+            if (!popOwn(worker, item) && !steal(worker, item)) {
+                // работы нет ни у кого и никто ничего не обрабатывает — конец
+                if (pending.load(std::memory_order_acquire) == 0)
+                    break;
+                // своё найденное не ждёт, пока другие потоки доделают каталоги
+                flush(w);
+                waitForWork();
+                continue;
+            }
+
+            processDir(worker, item, buffer, w);
+            // последний каталог — будим всех, чтобы разошлись
+            if (pending.fetch_sub(1) == 1)
+                wakeIdle(true);
+            maybeFlush(w);
+        }
+
+        if (!isCancelled(cancel))
+            flush(w);
+    }
+};
+
+#endif
+
+} // namespace
+
+bool FileSearch::validate(const SearchQuery &query, QString *error)
+{
+    const NameMatcher names(query);
+    if (!names.isValid()) {
+        if (error)
+            *error = QObject::tr("Имя: %1").arg(names.errorString());
+        return false;
+    }
+    const ContentMatcher content(query.content, query.contentRegex, query.caseSensitive);
+    if (!content.isValid()) {
+        if (error)
+            *error = QObject::tr("Содержимое: %1").arg(content.errorString());
+        return false;
+    }
+    return true;
+}
+
+void FileSearch::run(const SearchQuery &query, const Callback &onHits,
+                     const std::atomic<bool> *cancel, int threads)
+{
+    BELKIN_TRACE_SCOPE("search.run");
+
+    const NameMatcher names(query);
+    const ContentMatcher content(query.content, query.contentRegex, query.caseSensitive);
+    if (!names.isValid() || !content.isValid())
+        return;
+
+#ifdef Q_OS_LINUX
+    if (threads <= 0)
+        threads = qBound(1, QThread::idealThreadCount(), 8);
+
+    Walk walk;
+    walk.query = &query;
+    walk.names = &names;
+    walk.cancel = cancel;
+    walk.onHits = &onHits;
+    for (int i = 0; i < threads; ++i)
+        walk.queues.push_back(std::make_unique<WorkQueue>());
+
+    // корни раскладываем по очередям сразу — крадут их и так, но так быстрее
+    size_t next = 0;
+    for (const QString &root : query.roots) {
+        QByteArray encoded = QFile::encodeName(root);
+        while (encoded.size() > 1 && encoded.endsWith('/'))
+            encoded.chop(1);
+        struct stat st;
+        if (::stat(encoded.constData(), &st) != 0 || !S_ISDIR(st.st_mode))
+            continue;
+        walk.push(next++ % size_t(threads),
+                  { std::string(encoded.constData(), size_t(encoded.size())), st.st_dev, true });
+    }
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back([&walk, &content, i]() { walk.run(size_t(i), content); });
+    walk.run(0, content);
+    for (std::thread &t : pool)
+        t.join();
+#else
+    Q_UNUSED(threads);
+
+    Worker w;
+    w.content = content;
+    const auto flush = [&]() {
+        w.lastFlush = std::chrono::steady_clock::now();
+        if (!w.hits.empty()) {
+            onHits(w.hits);
+            w.hits.clear();
+        }
+    };
+
+    QDir::Filters filters = QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot;
+    if (query.hidden)
+        filters |= QDir::Hidden;
+    const bool grep = !content.isEmpty();
+
+    for (const QString &root : query.roots) {
+        QDirIterator it(root, filters, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            if (isCancelled(cancel))
+                return;
+
+            const QFileInfo fi = it.nextFileInfo();
+            if (!names.matches(fi.fileName().toUtf8()))
+                continue;
+            if (fi.isDir() && grep)
+                continue;
+
+            SearchHit hit;
+            hit.path = fi.filePath();
+            hit.dir = fi.isDir();
+            hit.size = hit.dir ? 0 : fi.size();
+            hit.mtime = fi.lastModified().toSecsSinceEpoch();
+            if (grep && (!fi.isFile() || fi.size() == 0
+                         || !w.content.matchFile(hit.path, query.skipBinary, &hit.line, &hit.text,
+                                                 cancel)))
+                continue;
+            w.hits.push_back(std::move(hit));
+
+            if (w.hits.size() >= MaxBatchHits
+                || std::chrono::steady_clock::now() - w.lastFlush >= MaxBatchDelay)
+                flush();
+        }
+    }
+    flush();
+#endif
+}
+
+void FileSearch::runOnFiles(const SearchQuery &query, const QStringList &files,
+                            const Callback &onHits, const std::atomic<bool> *cancel, int threads)
+{
+    BELKIN_TRACE_SCOPE("search.runOnFiles");
+
+    const NameMatcher names(query);
+    const ContentMatcher content(query.content, query.contentRegex, query.caseSensitive);
+    if (!names.isValid() || !content.isValid() || files.isEmpty())
+        return;
+
+    if (threads <= 0)
+        threads = qBound(1, QThread::idealThreadCount(), 8);
+    threads = int(qMin<qsizetype>(threads, files.size()));
+
+    std::atomic<qsizetype> next{0};
+    std::mutex emitMutex;
+
+    const auto work = [&]() {
+        Worker w;
+        w.content = content;
+        const auto flush = [&]() {
+            w.lastFlush = std::chrono::steady_clock::now();
+            if (w.hits.empty())
+                return;
+            std::lock_guard<std::mutex> lock(emitMutex);
+            onHits(w.hits);
+            w.hits.clear();
+        };
+
+        while (!isCancelled(cancel)) {
+            const qsizetype i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= files.size())
+                break;
+            const QFileInfo fi(files[i]);
+            if (!names.matches(fi.fileName().toUtf8()) || !fi.isFile() || fi.size() == 0)
+                continue;
+
+            SearchHit hit;
+            hit.path = fi.filePath();
+            hit.size = fi.size();
+            hit.mtime = fi.lastModified().toSecsSinceEpoch();
+            if (!content.isEmpty()
+                && !w.content.matchFile(hit.path, query.skipBinary, &hit.line, &hit.text, cancel))
+                continue;
+            w.hits.push_back(std::move(hit));
+
+            if (w.hits.size() >= MaxBatchHits
+                || std::chrono::steady_clock::now() - w.lastFlush >= MaxBatchDelay)
+                flush();
+        }
+        if (!isCancelled(cancel))
+            flush();
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &t : pool)
+        t.join();
+}
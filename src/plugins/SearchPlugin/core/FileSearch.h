@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Параметры поиска
+struct SearchQuery {
+    QStringList roots;
+    QString namePattern;            // пусто — любое имя; glob-шаблоны через ';'
+    bool    nameRegex = false;      // namePattern — регулярное выражение
+    QString content;                // пусто — без поиска по содержимому
+    bool    contentRegex = false;
+    bool    caseSensitive = false;  // для содержимого и регулярных выражений
+    bool    hidden = false;         // заходить в скрытые каталоги
+    bool    skipBinary = true;      // файлы с NUL в начале не читаются
+};
+
+struct SearchHit {
+    QString path;
+    qint64  size = 0;
+    qint64  mtime = 0;      // секунды от эпохи
+    bool    dir = false;
+    int     line = 0;       // номер строки первого совпадения; 0 — без содержимого
+    QString text;           // сама строка (обрезанная)
+};
+
+// Поиск файлов по имени и содержимому.
+// Корни обходятся параллельно, как в FolderSizeCalculator: у каждого потока
+// своя очередь каталогов с work stealing. Содержимое проверяется в том же
+// потоке, что нашёл файл, — чтение файлов распределяется вместе с каталогами.
+// Точки монтирования внутри корня не пересекаются, ссылки на каталоги не
+// раскрываются.
+class FileSearch
+{
+public:
+    // onHits вызывается из потоков поиска, но никогда одновременно
+    using Callback = std::function<void(std::vector<SearchHit> &hits)>;
+
+    // false — шаблон не компилируется (error — текст ошибки)
+    static bool validate(const SearchQuery &query, QString *error = nullptr);
+
+    // threads <= 0 — по числу ядер (не больше 8)
+    static void run(const SearchQuery &query, const Callback &onHits,
+                    const std::atomic<bool> *cancel = nullptr, int threads = 0);
+
+    // То же, но без обхода: проверяются только files (кандидаты из
+    // ContentIndex) — имя и содержимое, параллельно
+    static void runOnFiles(const SearchQuery &query, const QStringList &files,
+                           const Callback &onHits, const std::atomic<bool> *cancel = nullptr,
+                           int threads = 0);
+};